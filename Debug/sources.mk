@@ -39,4 +39,5 @@ src/classes \
 src/devices \
 src/drivers \
 src/drivers/uarts \
+src/gps \
 
@@ -4,18 +4,24 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
+../src/drivers/clock.cpp \
 ../src/drivers/gpio.cpp \
 ../src/drivers/i2c.cpp \
+../src/drivers/uart-reactor.cpp \
 ../src/drivers/uarts.cpp 
 
 CPP_DEPS += \
+./src/drivers/clock.d \
 ./src/drivers/gpio.d \
 ./src/drivers/i2c.d \
+./src/drivers/uart-reactor.d \
 ./src/drivers/uarts.d 
 
 OBJS += \
+./src/drivers/clock.o \
 ./src/drivers/gpio.o \
 ./src/drivers/i2c.o \
+./src/drivers/uart-reactor.o \
 ./src/drivers/uarts.o 
 
 
@@ -31,7 +37,7 @@ src/drivers/%.o: ../src/drivers/%.cpp src/drivers/subdir.mk
 clean: clean-src-2f-drivers
 
 clean-src-2f-drivers:
-	-$(RM) ./src/drivers/gpio.d ./src/drivers/gpio.o ./src/drivers/i2c.d ./src/drivers/i2c.o ./src/drivers/uarts.d ./src/drivers/uarts.o
+	-$(RM) ./src/drivers/clock.d ./src/drivers/clock.o ./src/drivers/gpio.d ./src/drivers/gpio.o ./src/drivers/i2c.d ./src/drivers/i2c.o ./src/drivers/uart-reactor.d ./src/drivers/uart-reactor.o ./src/drivers/uarts.d ./src/drivers/uarts.o
 
 .PHONY: clean-src-2f-drivers
 
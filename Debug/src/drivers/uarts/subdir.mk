@@ -4,13 +4,19 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
-../src/drivers/uarts/ms-timer.cpp 
+../src/drivers/uarts/framer.cpp \
+../src/drivers/uarts/ring-buffer.cpp \
+../src/drivers/uarts/statistics.cpp 
 
 CPP_DEPS += \
-./src/drivers/uarts/ms-timer.d 
+./src/drivers/uarts/framer.d \
+./src/drivers/uarts/ring-buffer.d \
+./src/drivers/uarts/statistics.d 
 
 OBJS += \
-./src/drivers/uarts/ms-timer.o 
+./src/drivers/uarts/framer.o \
+./src/drivers/uarts/ring-buffer.o \
+./src/drivers/uarts/statistics.o 
 
 
 # Each subdirectory must supply rules for building sources it contributes
@@ -25,7 +31,7 @@ src/drivers/uarts/%.o: ../src/drivers/uarts/%.cpp src/drivers/uarts/subdir.mk
 clean: clean-src-2f-drivers-2f-uarts
 
 clean-src-2f-drivers-2f-uarts:
-	-$(RM) ./src/drivers/uarts/ms-timer.d ./src/drivers/uarts/ms-timer.o
+	-$(RM) ./src/drivers/uarts/framer.d ./src/drivers/uarts/framer.o ./src/drivers/uarts/ring-buffer.d ./src/drivers/uarts/ring-buffer.o ./src/drivers/uarts/statistics.d ./src/drivers/uarts/statistics.o
 
 .PHONY: clean-src-2f-drivers-2f-uarts
 
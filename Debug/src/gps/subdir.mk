@@ -0,0 +1,58 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+CPP_SRCS += \
+../src/gps/filter.cpp \
+../src/gps/geofence.cpp \
+../src/gps/nmea-pty.cpp \
+../src/gps/nmea.cpp \
+../src/gps/quality.cpp \
+../src/gps/replay.cpp \
+../src/gps/state.cpp \
+../src/gps/stream.cpp \
+../src/gps/track-log.cpp \
+../src/gps/ubx.cpp 
+
+CPP_DEPS += \
+./src/gps/filter.d \
+./src/gps/geofence.d \
+./src/gps/nmea-pty.d \
+./src/gps/nmea.d \
+./src/gps/quality.d \
+./src/gps/replay.d \
+./src/gps/state.d \
+./src/gps/stream.d \
+./src/gps/track-log.d \
+./src/gps/ubx.d 
+
+OBJS += \
+./src/gps/filter.o \
+./src/gps/geofence.o \
+./src/gps/nmea-pty.o \
+./src/gps/nmea.o \
+./src/gps/quality.o \
+./src/gps/replay.o \
+./src/gps/state.o \
+./src/gps/stream.o \
+./src/gps/track-log.o \
+./src/gps/ubx.o 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+src/gps/%.o: ../src/gps/%.cpp src/gps/subdir.mk
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross G++ Compiler'
+	arm-linux-gnueabihf-g++ -std=c++17 -I"/home/liquidsnake/work/projects/airsoft-bot/control_unit/software/Airsoft/include" -O0 -g3 -Wall -c -fmessage-length=0 -pthread -MMD -MP -MF"$(@:%.o=%.d)" -MT"$@" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
+clean: clean-src-2f-gps
+
+clean-src-2f-gps:
+	-$(RM) ./src/gps/filter.d ./src/gps/filter.o ./src/gps/geofence.d ./src/gps/geofence.o ./src/gps/nmea-pty.d ./src/gps/nmea-pty.o ./src/gps/nmea.d ./src/gps/nmea.o ./src/gps/quality.d ./src/gps/quality.o ./src/gps/replay.d ./src/gps/replay.o ./src/gps/state.d ./src/gps/state.o ./src/gps/stream.d ./src/gps/stream.o ./src/gps/track-log.d ./src/gps/track-log.o ./src/gps/ubx.d ./src/gps/ubx.o
+
+.PHONY: clean-src-2f-gps
+
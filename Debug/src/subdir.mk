@@ -5,6 +5,7 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 CPP_SRCS += \
 ../src/airsoftmanager.cpp \
+../src/game-clock.cpp \
 ../src/gps.cpp \
 ../src/inout.cpp \
 ../src/main.cpp \
@@ -13,6 +14,7 @@ CPP_SRCS += \
 
 CPP_DEPS += \
 ./src/airsoftmanager.d \
+./src/game-clock.d \
 ./src/gps.d \
 ./src/inout.d \
 ./src/main.d \
@@ -21,6 +23,7 @@ CPP_DEPS += \
 
 OBJS += \
 ./src/airsoftmanager.o \
+./src/game-clock.o \
 ./src/gps.o \
 ./src/inout.o \
 ./src/main.o \
@@ -40,7 +43,7 @@ src/%.o: ../src/%.cpp src/subdir.mk
 clean: clean-src
 
 clean-src:
-	-$(RM) ./src/airsoftmanager.d ./src/airsoftmanager.o ./src/gps.d ./src/gps.o ./src/inout.d ./src/inout.o ./src/main.d ./src/main.o ./src/utility.d ./src/utility.o ./src/wireless.d ./src/wireless.o
+	-$(RM) ./src/airsoftmanager.d ./src/airsoftmanager.o ./src/game-clock.d ./src/game-clock.o ./src/gps.d ./src/gps.o ./src/inout.d ./src/inout.o ./src/main.d ./src/main.o ./src/utility.d ./src/utility.o ./src/wireless.d ./src/wireless.o
 
 .PHONY: clean-src
 
@@ -0,0 +1,518 @@
+/**
+ *******************************************************************************
+ * @file geo-bench.cpp
+ *
+ * @brief Correctness checks and benchmark of the geofence engine
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ *
+ * The geofence is first checked on hand made zones: hysteresis on the border,
+ * dwell, concave polygons, the configuration syntax and the fixes skipped for
+ * their trust. Then hundreds of random
+ * zones on a field and tens of targets walking on it are evaluated with the
+ * grid and with a single cell, which tests every zone: the events have to be
+ * the same, the time and the zones tested per position are compared.
+ * The distances and bearings of the local plane are compared with haversine
+ * on random pairs around the origin, then one point to N distances are timed
+ * with haversine, with the plane pair by pair and with the batches.
+ *
+ * Usage: geo-bench [--quick]
+ */
+#include <time.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include <gps/geofence.hpp>
+#include <gps/local-plane.hpp>
+#include <drivers/clock.hpp>
+
+using namespace Airsoft;
+using namespace Airsoft::Drivers;
+
+namespace {
+
+// Field of the random zones, a point of the walk recording
+constexpr int32_t FieldLatitude = 454642035;
+constexpr int32_t FieldLongitude = 91899816;
+constexpr float   FieldSize = 2000.0f;                    // Meters
+constexpr size_t  RandomZones = 500;
+constexpr size_t  RandomTargets = 50;
+constexpr int64_t PositionPeriodNS = 100 * NanosecondsPerMillisecond;
+constexpr size_t  BatchPoints = 256;                      // Players and objectives of a distance batch
+
+// Minimum run time of every measure
+constexpr int64_t MeasureNS = NanosecondsPerSecond / 2;
+constexpr int64_t QuickMeasureNS = NanosecondsPerSecond / 20;
+
+bool passed { true };
+volatile float sink {};                                   // Results of the measures, kept by the optimizer
+
+//-----------------------------------------------------------------------------
+int64_t ThreadCpu(void) {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return static_cast<int64_t>(time.tv_sec) * NanosecondsPerSecond + time.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char * what) {
+  if (!condition) {
+    printf("check failed: %s\n", what);
+    passed = false;
+  }
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Add a zone given in meters from the field origin.
+ */
+int32_t AddZone(Geofence & geofence, const LocalPlane & plane, const char * name, const std::vector<float> & points) {
+  std::vector<int32_t> latitudes;
+  std::vector<int32_t> longitudes;
+
+  for (size_t index = 0; index + 1 < points.size(); index += 2) {
+    int32_t latitude {};
+    int32_t longitude {};
+
+    plane.Unproject(points[index], points[index + 1], latitude, longitude);
+    latitudes.push_back(latitude);
+    longitudes.push_back(longitude);
+  }
+
+  return geofence.AddZone(name, GeofenceZoneType::Capture, latitudes.data(), longitudes.data(), latitudes.size());
+}
+//-----------------------------------------------------------------------------
+struct Recorded {
+  GeofenceEventType type;
+  uint16_t          zone;
+  uint16_t          target;
+  int64_t           time;
+
+  bool operator==(const Recorded & other) const {
+    return type == other.type && zone == other.zone && target == other.target && time == other.time;
+  }
+};
+//-----------------------------------------------------------------------------
+/**
+ * @brief Move a target along a list of points in meters, one position per second, recording the events.
+ */
+std::vector<Recorded> Walk(Geofence & geofence, const LocalPlane & plane, const std::vector<float> & points) {
+  std::vector<Recorded> events;
+
+  for (size_t index = 0; index + 1 < points.size(); index += 2) {
+    int32_t latitude {};
+    int32_t longitude {};
+    int64_t time { static_cast<int64_t>(index / 2) * NanosecondsPerSecond };
+
+    plane.Unproject(points[index], points[index + 1], latitude, longitude);
+    geofence.Update(0, latitude, longitude, time, [&](const GeofenceEvent & event) {
+      events.push_back({ event.type, event.zone, event.target, event.time });
+    });
+  }
+
+  return events;
+}
+//-----------------------------------------------------------------------------
+void CheckGeofence(void) {
+  LocalPlane  plane(FieldLatitude, FieldLongitude);
+  Geofence    square;
+  Geofence    concave;
+  Geofence    config;
+
+  // 100 m square, 3 m of hysteresis, dwell after 10 s
+  AddZone(square, plane, "square", { 0, 0, 100, 0, 100, 100, 0, 100 });
+  Check(square.Build(), "build");
+
+  // Along y = 50 from x = -19.5 one meter per second: enter at 3.5, dwell 10 s later, exit at 103.5
+  std::vector<float> path;
+  for (int32_t x = -20; x <= 120; x++) {
+    path.insert(path.end(), { x + 0.5f, 50.0f });
+  }
+
+  std::vector<Recorded> events { Walk(square, plane, path) };
+  Check(events.size() == 3 &&
+        events[0].type == GeofenceEventType::Enter && events[0].time == 23 * NanosecondsPerSecond &&
+        events[1].type == GeofenceEventType::Dwell && events[1].time == 33 * NanosecondsPerSecond &&
+        events[2].type == GeofenceEventType::Exit && events[2].time == 123 * NanosecondsPerSecond,
+        "enter, dwell, exit");
+
+  // Noise of 2 m across the border: no events
+  square.Reset(0);
+  path.clear();
+  for (size_t index = 0; index < 100; index++) {
+    path.insert(path.end(), { index % 2 ? 1.9f : -1.9f, 50.0f });
+  }
+  Check(Walk(square, plane, path).empty(), "hysteresis on the border");
+
+  // L shaped zone: the notch is outside
+  AddZone(concave, plane, "L", { 0, 0, 100, 0, 100, 30, 30, 30, 30, 100, 0, 100 });
+  concave.Build();
+  events = Walk(concave, plane, { 70, 70, 15, 70, 70, 70, 70, 15 });
+  Check(events.size() == 3 && events[0].type == GeofenceEventType::Enter && events[0].time == NanosecondsPerSecond &&
+        events[1].type == GeofenceEventType::Exit && events[1].time == 2 * NanosecondsPerSecond &&
+        events[2].type == GeofenceEventType::Enter, "concave zone");
+
+  // Configuration
+  Check(config.AddZone("alpha,capture,45.4642 9.1900;45.4650 9.1900;45.4650 9.1915;45.4642 9.1915") == 0,
+        "zone parsed");
+  Check(config.AddZone("beta,spawn,45.4660 9.1900;45.4665 9.1905;45.4660 9.1910") == 1, "triangle parsed");
+  Check(config.AddZone("gamma,base,45.4660 9.1900;45.4665 9.1905;45.4660 9.1910") == -1, "unknown type");
+  Check(config.AddZone("delta,out,45.4660 9.1900;45.4665 9.1905") == -1, "two vertices");
+  Check(config.AddZone("epsilon,out,45.4660 9.1900;45.4665 north;45.4660 9.1910") == -1, "bad coordinate");
+  Check(config.Build() && config.GetZone(1).type == GeofenceZoneType::Spawn &&
+        config.Contains(0, 454646000, 91907000) && !config.Contains(1, 454646000, 91907000), "configured zones");
+
+  // Fixes trusted less than the minimum don't move the target, those without trust do
+  GpsFix  fix;
+  size_t  count {};
+  auto    record = [&](const GeofenceEvent &) { count++; };
+
+  square.Reset(0);
+  fix.valid = FixHasPosition | FixHasTrust;
+  fix.quality = 1;
+  fix.trust = GpsTrustUsable - 1;
+  plane.Unproject(50.0f, 50.0f, fix.latitude, fix.longitude);
+  square.Update(0, fix, 0, record);
+  fix.trust = GpsTrustUsable;
+  square.Update(0, fix, NanosecondsPerSecond, record);
+  fix.valid = FixHasPosition;
+  plane.Unproject(-50.0f, 50.0f, fix.latitude, fix.longitude);
+  square.Update(0, fix, 2 * NanosecondsPerSecond, record);
+  Check(count == 2 && square.GetUntrusted() == 1, "fixes skipped for their trust");
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Random field
+
+//-----------------------------------------------------------------------------
+void AddRandomZones(Geofence & geofence, const LocalPlane & plane) {
+  std::mt19937                          random(7);
+  std::uniform_real_distribution<float> center(-FieldSize / 2, FieldSize / 2);
+  std::uniform_real_distribution<float> radius(10.0f, 60.0f);
+  std::uniform_int_distribution<int>    sides(3, 12);
+
+  for (size_t zone = 0; zone < RandomZones; zone++) {
+    std::vector<float>  points;
+    float               x { center(random) };
+    float               y { center(random) };
+    int                 count { sides(random) };
+
+    // Star shaped polygon around the center, concave in general
+    for (int side = 0; side < count; side++) {
+      float angle { static_cast<float>(2 * M_PI * side / count) };
+      float distance { radius(random) };
+
+      points.insert(points.end(), { x + distance * std::cos(angle), y + distance * std::sin(angle) });
+    }
+
+    AddZone(geofence, plane, "random", points);
+  }
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Random walks of the targets, jogging speed with the noise of a fix.
+ */
+std::vector<int32_t> RandomWalks(const LocalPlane & plane, size_t steps) {
+  std::mt19937                          random(11);
+  std::uniform_real_distribution<float> start(-FieldSize / 2, FieldSize / 2);
+  std::normal_distribution<float>       turn(0.0f, 0.3f);
+  std::normal_distribution<float>       noise(0.0f, 1.5f);
+  std::vector<int32_t>                  positions;
+  std::vector<float>                    x(RandomTargets), y(RandomTargets), heading(RandomTargets);
+
+  for (size_t target = 0; target < RandomTargets; target++) {
+    x[target] = start(random);
+    y[target] = start(random);
+    heading[target] = start(random);
+  }
+
+  for (size_t step = 0; step < steps; step++) {
+    for (size_t target = 0; target < RandomTargets; target++) {
+      int32_t latitude {};
+      int32_t longitude {};
+
+      heading[target] += turn(random);
+      x[target] = std::clamp(x[target] + 0.3f * std::cos(heading[target]), -FieldSize / 2, FieldSize / 2);
+      y[target] = std::clamp(y[target] + 0.3f * std::sin(heading[target]), -FieldSize / 2, FieldSize / 2);
+
+      plane.Unproject(x[target] + noise(random), y[target] + noise(random), latitude, longitude);
+      positions.push_back(latitude);
+      positions.push_back(longitude);
+    }
+  }
+
+  return positions;
+}
+//-----------------------------------------------------------------------------
+std::vector<Recorded> Run(Geofence & geofence, const std::vector<int32_t> & positions) {
+  std::vector<Recorded> events;
+
+  for (size_t index = 0; index < positions.size() / 2; index++) {
+    size_t  target { index % RandomTargets };
+    int64_t time { static_cast<int64_t>(index / RandomTargets) * PositionPeriodNS };
+
+    geofence.Update(target, positions[index * 2], positions[index * 2 + 1], time, [&](const GeofenceEvent & event) {
+      events.push_back({ event.type, event.zone, event.target, event.time });
+    });
+  }
+
+  return events;
+}
+//-----------------------------------------------------------------------------
+void MeasureField(int64_t durationNS) {
+  LocalPlane            plane(FieldLatitude, FieldLongitude);
+  Geofence              grid;
+  Geofence              single;
+  GeofenceSettings      settings;
+  std::vector<int32_t>  positions { RandomWalks(plane, 3000) };
+  size_t                count { positions.size() / 2 };
+
+  AddRandomZones(grid, plane);
+  AddRandomZones(single, plane);
+  grid.Build(settings);
+  settings.cellSize = 4 * FieldSize;
+  single.Build(settings);
+
+  std::vector<Recorded> gridEvents { Run(grid, positions) };
+  std::vector<Recorded> singleEvents { Run(single, positions) };
+
+  Check(!gridEvents.empty() && gridEvents == singleEvents, "grid and single cell events");
+
+  printf("%zu zones, %zu targets, %zu positions, %zu events\n\n", grid.GetZones(), RandomTargets, count,
+         gridEvents.size());
+  printf("%-12s %14s %12s %12s %12s\n", "index", "positions/s", "ns/position", "candidates", "tests");
+
+  for (Geofence * geofence : { &grid, &single }) {
+    size_t    rounds {};
+    int64_t   start { ThreadCpu() };
+    int64_t   elapsed {};
+
+    do {
+      geofence->Build(geofence == &grid ? GeofenceSettings() : settings);
+      Run(*geofence, positions);
+      rounds++;
+      elapsed = ThreadCpu() - start;
+    } while (elapsed < durationNS);
+
+    // Per position, counted since the last Build
+    printf("%-12s %14.0f %12.1f %12.2f %12.2f\n", geofence == &grid ? "grid" : "single cell",
+           rounds * count * 1e9 / elapsed, static_cast<double>(elapsed) / (rounds * count),
+           static_cast<double>(geofence->GetCandidates()) / count, static_cast<double>(geofence->GetTests()) / count);
+  }
+  fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Local plane
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Random positions within radius meters of the field origin.
+ */
+void RandomPositions(const LocalPlane & plane, float radius, size_t count, std::vector<int32_t> & latitudes,
+                     std::vector<int32_t> & longitudes) {
+  std::mt19937                          random(13);
+  std::uniform_real_distribution<float> offset(-radius, radius);
+
+  latitudes.resize(count);
+  longitudes.resize(count);
+  for (size_t index = 0; index < count; index++) {
+    plane.Unproject(offset(random), offset(random), latitudes[index], longitudes[index]);
+  }
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Largest errors of the plane from haversine over random pairs in a square of side 2 * radius.
+ */
+void PlaneErrors(float radius, double & distanceError, double & relativeError, double & bearingError) {
+  LocalPlane            plane(FieldLatitude, FieldLongitude);
+  std::vector<int32_t>  latitudes;
+  std::vector<int32_t>  longitudes;
+  size_t                count { 2000 };
+
+  RandomPositions(plane, radius, count, latitudes, longitudes);
+  distanceError = relativeError = bearingError = 0;
+
+  for (size_t index = 0; index + 1 < count; index++) {
+    double  reference { GpsHaversineDistance(latitudes[index], longitudes[index], latitudes[index + 1],
+                                             longitudes[index + 1]) };
+    double  distance { plane.Distance(latitudes[index], longitudes[index], latitudes[index + 1],
+                                      longitudes[index + 1]) };
+    double  bearing { GpsInitialBearing(latitudes[index], longitudes[index], latitudes[index + 1],
+                                        longitudes[index + 1]) };
+
+    bearing -= plane.Bearing(latitudes[index], longitudes[index], latitudes[index + 1], longitudes[index + 1]);
+    bearing = std::fabs(bearing > 180.0 ? bearing - 360.0 : bearing < -180.0 ? bearing + 360.0 : bearing);
+
+    distanceError = std::max(distanceError, std::fabs(distance - reference));
+    relativeError = std::max(relativeError, std::fabs(distance - reference) / reference);
+    if (reference > 10.0) {
+      bearingError = std::max(bearingError, bearing);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void CheckPlane(void) {
+  LocalPlane  plane(FieldLatitude, FieldLongitude);
+  float       distances[8];
+  float       bearings[8];
+  uint8_t     within[8];
+  float       xs[8] { 0, 10, 10, 0, -10, -10, -10, 0 };
+  float       ys[8] { 10, 10, 0, -10, -10, 0, 10, 0 };
+
+  // Compass points around the origin
+  LocalPlane::Distances(0, 0, xs, ys, distances, 8);
+  LocalPlane::Bearings(0, 0, xs, ys, bearings, 8);
+  Check(std::fabs(distances[1] - 10 * std::sqrt(2.0f)) < 1e-4f && distances[7] == 0, "batch distances");
+  Check(std::fabs(bearings[0]) < 1e-3f && std::fabs(bearings[1] - 45) < 1e-3f && std::fabs(bearings[2] - 90) < 1e-3f &&
+        std::fabs(bearings[4] - 225) < 1e-3f && std::fabs(bearings[6] - 315) < 1e-3f && bearings[7] == 0,
+        "batch bearings");
+  Check(LocalPlane::Within(0, 0, xs, ys, 12.0f, within, 8) == 5 && within[0] && !within[1], "within");
+
+  // The arctangent over the whole circle
+  double worst {};
+  for (int32_t step = 0; step < 36000; step++) {
+    double angle { step * M_PI / 18000.0 };
+    double bearing { PlaneBearing(static_cast<float>(std::sin(angle)), static_cast<float>(std::cos(angle))) };
+    double error { std::fabs(bearing - step / 100.0) };
+
+    worst = std::max(worst, std::min(error, 360.0 - error));
+  }
+  Check(worst < 1e-3, "bearing polynomial");
+
+  // Batch projection agrees with the single one
+  std::vector<int32_t>  latitudes;
+  std::vector<int32_t>  longitudes;
+  std::vector<float>    x(100), y(100);
+  bool                  same { true };
+
+  RandomPositions(plane, 5000.0f, 100, latitudes, longitudes);
+  plane.Project(latitudes.data(), longitudes.data(), x.data(), y.data(), 100);
+  for (size_t index = 0; index < 100; index++) {
+    float singleX {};
+    float singleY {};
+
+    plane.Project(latitudes[index], longitudes[index], singleX, singleY);
+    same = same && std::fabs(singleX - x[index]) < 1e-3f && std::fabs(singleY - y[index]) < 1e-3f;
+  }
+  Check(same, "batch projection");
+
+  // Accuracy against haversine
+  printf("%-10s %14s %14s %14s\n", "field", "distance (m)", "relative", "bearing (deg)");
+  for (float radius : { 500.0f, 1000.0f, 5000.0f }) {
+    double distanceError {};
+    double relativeError {};
+    double bearingError {};
+
+    PlaneErrors(radius, distanceError, relativeError, bearingError);
+    printf("%-10.0f %14.3f %14.2e %14.4f\n", 2 * radius, distanceError, relativeError, bearingError);
+
+    // A game field: centimeters and hundredths of degree
+    if (radius <= 1000.0f) {
+      Check(distanceError < 0.5 && bearingError < 0.05, "plane accuracy");
+    }
+  }
+  printf("\n");
+}
+//-----------------------------------------------------------------------------
+void MeasureDistances(int64_t durationNS) {
+  LocalPlane            plane(FieldLatitude, FieldLongitude);
+  std::vector<int32_t>  latitudes;
+  std::vector<int32_t>  longitudes;
+  std::vector<float>    x(BatchPoints), y(BatchPoints), distances(BatchPoints), bearings(BatchPoints);
+  std::vector<uint8_t>  within(BatchPoints);
+
+  RandomPositions(plane, FieldSize / 2, BatchPoints, latitudes, longitudes);
+
+  printf("%-28s %14s\n", "one to 256 positions", "ns/position");
+
+  for (int method = 0; method < 4; method++) {
+    size_t    rounds {};
+    int64_t   start { ThreadCpu() };
+    int64_t   elapsed {};
+
+    do {
+      // From the first position to all, as the display of a player
+      if (method == 0) {
+        double sum {};
+
+        for (size_t index = 0; index < BatchPoints; index++) {
+          sum += GpsHaversineDistance(latitudes[0], longitudes[0], latitudes[index], longitudes[index]);
+          sum += GpsInitialBearing(latitudes[0], longitudes[0], latitudes[index], longitudes[index]);
+        }
+        sink = static_cast<float>(sum);
+      } else if (method == 1) {
+        float sum {};
+
+        for (size_t index = 0; index < BatchPoints; index++) {
+          sum += plane.Distance(latitudes[0], longitudes[0], latitudes[index], longitudes[index]);
+          sum += plane.Bearing(latitudes[0], longitudes[0], latitudes[index], longitudes[index]);
+        }
+        sink = sum;
+      } else if (method == 2) {
+        plane.Project(latitudes.data(), longitudes.data(), x.data(), y.data(), BatchPoints);
+        LocalPlane::Distances(x[0], y[0], x.data(), y.data(), distances.data(), BatchPoints);
+        LocalPlane::Bearings(x[0], y[0], x.data(), y.data(), bearings.data(), BatchPoints);
+        sink = distances[BatchPoints - 1] + bearings[BatchPoints - 1];
+      } else {
+        plane.Project(latitudes.data(), longitudes.data(), x.data(), y.data(), BatchPoints);
+        sink = LocalPlane::Within(x[0], y[0], x.data(), y.data(), 100.0f, within.data(), BatchPoints);
+      }
+      rounds++;
+      elapsed = ThreadCpu() - start;
+    } while (elapsed < durationNS);
+
+    printf("%-28s %14.2f\n", method == 0 ? "haversine, distance+bearing" :
+           method == 1 ? "plane pairs, distance+bearing" : method == 2 ? "batch, distance+bearing" :
+           "batch, within 100 m", static_cast<double>(elapsed) / (rounds * BatchPoints));
+  }
+  printf("\n");
+  fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+  bool quick { argc > 1 && strcmp(argv[1], "--quick") == 0 };
+
+  CheckPlane();
+  MeasureDistances(quick ? QuickMeasureNS : MeasureNS);
+
+  CheckGeofence();
+  printf("Geofence checks: %s\n\n", passed ? "ok" : "FAILED");
+
+  MeasureField(quick ? QuickMeasureNS : MeasureNS);
+
+  return passed ? 0 : 1;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,1979 @@
+/**
+ *******************************************************************************
+ * @file gps-bench.cpp
+ *
+ * @brief Pseudo terminal test and benchmark of the Gps pipeline, NMEA and UBX
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ *
+ * The UBX parser is checked against built messages and broken input, then the
+ * cost per epoch and the occupancy of the uart are compared for the NMEA and
+ * the UBX recordings of the same walk. GameClock runs on simulated time for
+ * two devices with different crystals and delays, their agreement is checked
+ * with the fixes only, with the PPS and for a minute after the fixes stop.
+ *
+ * Then a Gps runs on the slave side of an openpty pair, with a fake receiver
+ * on the master side: it acknowledges the UBX configuration and plays the
+ * recording. Every fix of the recording has to be published and the last one
+ * has to match the one decoded offline, the harness fails (exit code 1)
+ * otherwise. The last runs save the state of the session to a file and check
+ * that the next start sends it to the receiver as aiding data.
+ *
+ * The track log is checked on synthetic walks: decoding, the ring reused,
+ * a log continued after a restart and power cuts simulated by mixing the
+ * sectors of two moments of the file. Its size and append cost are measured
+ * on the recording and the pty NMEA run has to log every epoch.
+ *
+ * Last the recordings are replayed through Gps by URI, "replay:path?speed=",
+ * at a multiple of real time, checked against the duration of the log, and
+ * as fast as possible for the throughput of the whole position pipeline. A
+ * short log with a GGA lost checks that an NMEA epoch is published once.
+ *
+ * The position filter is validated on a synthetic game: a player walking,
+ * stopping and running, fixes with correlated noise scaled by the HDOP, tree
+ * cover and reflections tens of meters away. The sentences are decoded and
+ * filtered, the errors from the true path are compared with those of the
+ * receiver; the same sentences replayed through Gps have to give the same
+ * result. The recordings are filtered too, and the cost per fix is measured.
+ *
+ * The fan out of the data of the port is checked with subscribers that keep
+ * up, that never read and that hold every chunk, while others subscribe and
+ * unsubscribe: no chunk changed, lost ones counted, none leaked. The cost of
+ * a publication is measured, then Gps runs on the fake receiver with a
+ * logger that has to get the recording byte for byte, a stalled subscriber
+ * and the sentences read back from the pseudo terminal, one that Gps rejects
+ * included, with UBX the RMC and GGA built from NAV-PVT: every fix has to be
+ * there, and the fixes of Gps have to be the same as without them.
+ *
+ * The trust of the fixes is checked on a synthetic sky: open, under trees
+ * with fewer and weaker satellites, open again and lost. The trust has to
+ * fall at once, rise slowly and never pass the usable level under the
+ * trees. A multi constellation epoch of NMEA 4.10 has to put the satellites
+ * used on their constellation. Then the recording gives the table of the
+ * satellites, the trust over the walk and the cost per sentence; the replays
+ * check the trust of the fixes published by Gps.
+ *
+ * Usage: gps-bench [--quick]
+ */
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <gps.hpp>
+#include <gps/nmea.hpp>
+#include <gps/ubx.hpp>
+#include <gps/state.hpp>
+#include <gps/track-log.hpp>
+#include <gps/replay.hpp>
+#include <gps/filter.hpp>
+#include <gps/local-plane.hpp>
+#include <gps/stream.hpp>
+#include <gps/nmea-pty.hpp>
+#include <gps/quality.hpp>
+#include <game-clock.hpp>
+#include <drivers/clock.hpp>
+#include <drivers/uart-reactor.hpp>
+
+using namespace Airsoft;
+using namespace Airsoft::Drivers;
+
+namespace {
+
+// Recordings of the same walk, relative to the build folder
+constexpr const char * NmeaLog = "../bench/data/walk-10hz.nmea";
+constexpr const char * UbxLog = "../bench/data/walk-10hz.ubx";
+
+// Time without progress before a test is declared failed
+constexpr int64_t StallTimeoutNS = 3 * NanosecondsPerSecond;
+
+// Playback: chunk written by the fake receiver and pause between them
+constexpr size_t  PlaybackChunk = 256;
+constexpr int64_t PlaybackPauseNS = 200 * NanosecondsPerMicrosecond;
+constexpr int64_t ConfigureNS = 100 * NanosecondsPerMillisecond;
+
+// Minimum run time of every measure
+constexpr int64_t MeasureNS = NanosecondsPerSecond / 2;
+constexpr int64_t QuickMeasureNS = NanosecondsPerSecond / 20;
+
+bool passed { true };
+
+//-----------------------------------------------------------------------------
+int64_t Now(void) {
+  return Clock::Monotonic().Now();
+}
+//-----------------------------------------------------------------------------
+int64_t ThreadCpu(void) {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return static_cast<int64_t>(time.tv_sec) * NanosecondsPerSecond + time.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char * what) {
+  if (!condition) {
+    printf("check failed: %s\n", what);
+    passed = false;
+  }
+}
+//-----------------------------------------------------------------------------
+std::string Load(const char * path) {
+  std::ifstream     file(path, std::ios::binary);
+  std::stringstream content;
+
+  if (!file) {
+    printf("gps-bench: can't open %s\n", path);
+    passed = false;
+    return std::string();
+  }
+  content << file.rdbuf();
+
+  return content.str();
+}
+//-----------------------------------------------------------------------------
+const uint8_t * Bytes(const std::string & data) {
+  return reinterpret_cast<const uint8_t*>(data.data());
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Decode a recording offline: the fixes a Gps publishes and the last one.
+ */
+size_t CountFixes(const std::string & log, GpsProtocol protocol, GpsFix & last) {
+  size_t fixes {};
+
+  if (protocol == GpsProtocol::Nmea) {
+    NmeaParser parser;
+    uint32_t   time { UINT32_MAX };
+
+    // Gps publishes once per epoch, RMC and GGA with the same time
+    parser.Feed(Bytes(log), log.size(), 0, [&](NmeaSentence sentence) {
+      if (sentence == NmeaSentence::Rmc || sentence == NmeaSentence::Gga) {
+        fixes += parser.GetFix().TimeOfDay() != time;
+        time = parser.GetFix().TimeOfDay();
+        last = parser.GetFix();
+      }
+    });
+  } else {
+    UbxParser parser;
+
+    parser.Feed(Bytes(log), log.size(), 0, [&](UbxMessage message) {
+      if (message == UbxMessage::NavPvt) {
+        fixes++;
+        last = parser.GetFix();
+      }
+    });
+  }
+
+  return fixes;
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// UBX parser
+
+//-----------------------------------------------------------------------------
+std::string MakeNavPvt(int32_t latitude, int32_t longitude, uint8_t fixType, uint8_t flags) {
+  uint8_t payload[UbxNavPvtLength] {};
+  uint8_t message[UbxNavPvtLength + UbxOverhead] {};
+
+  auto put32 = [&](size_t offset, uint32_t value) {
+    for (size_t index = 0; index < 4; index++) {
+      payload[offset + index] = static_cast<uint8_t>(value >> (8 * index));
+    }
+  };
+
+  put32(0, 345600250);                                    // iTOW, .250 s
+  payload[4] = 0xEA;                                      // 2026
+  payload[5] = 0x07;
+  payload[6] = 10;
+  payload[7] = 16;
+  payload[8] = 12;
+  payload[9] = 34;
+  payload[10] = 56;
+  payload[11] = 0x07;                                     // Date and time valid
+  payload[20] = fixType;
+  payload[21] = flags;
+  payload[23] = 14;                                       // Satellites
+  put32(24, static_cast<uint32_t>(longitude));
+  put32(28, static_cast<uint32_t>(latitude));
+  put32(32, 168700);                                      // Height over the ellipsoid, mm
+  put32(36, 121400);                                      // Height over the sea, mm
+  put32(40, 1800);                                        // Horizontal accuracy, mm
+  put32(60, 1450);                                        // Ground speed, mm/s
+  put32(64, 9000000);                                     // Heading, 90 degrees
+  payload[76] = 150;                                      // PDOP 1.50
+
+  size_t length { UbxParser::Build(UbxClassNav, UbxIdNavPvt, payload, sizeof(payload), message, sizeof(message)) };
+
+  return std::string(reinterpret_cast<const char*>(message), length);
+}
+//-----------------------------------------------------------------------------
+void CheckUbx(void) {
+  UbxParser       parser;
+  const GpsFix &  fix { parser.GetFix() };
+  std::string     pvt { MakeNavPvt(454642035, 91899816, 3, 0x01) };
+  size_t          decoded {};
+
+  auto feed = [&](const std::string & data, size_t chunk) {
+    for (size_t offset = 0; offset < data.size(); offset += chunk) {
+      parser.Feed(Bytes(data) + offset, std::min(chunk, data.size() - offset), 0, [&](UbxMessage message) {
+        decoded += message == UbxMessage::NavPvt;
+      });
+    }
+  };
+
+  feed(pvt, 1);
+  Check(decoded == 1 && fix.latitude == 454642035 && fix.longitude == 91899816, "NAV-PVT position");
+  Check(fix.year == 2026 && fix.month == 10 && fix.day == 16 && fix.hour == 12 && fix.minute == 34 &&
+        fix.second == 56 && fix.millisecond == 250, "NAV-PVT time");
+  Check(fix.quality == 1 && fix.mode == 3 && fix.satellitesUsed == 14 && fix.Has(FixHasPosition | FixHasAccuracy),
+        "NAV-PVT quality");
+  Check(std::abs(fix.altitude - 121.4f) < 1e-3f && std::abs(fix.geoidSeparation - 47.3f) < 1e-3f &&
+        std::abs(fix.horizontalAccuracy - 1.8f) < 1e-4f && std::abs(fix.speed - 1.45f) < 1e-4f &&
+        std::abs(fix.course - 90.0f) < 1e-3f && std::abs(fix.pdop - 1.5f) < 1e-4f, "NAV-PVT values");
+
+  // No fix: position dropped
+  feed(MakeNavPvt(0, 0, 0, 0), 7);
+  Check(decoded == 2 && !fix.Has(FixHasPosition) && fix.quality == 0, "NAV-PVT without fix");
+
+  // Corrupted checksum, a false sync before NMEA text and a message too long: the next one is decoded
+  std::string broken { pvt };
+  broken[20] ^= 0x55;
+
+  uint8_t long_message[UbxMaxPayload + 1 + UbxOverhead] {};
+  std::vector<uint8_t> long_payload(UbxMaxPayload + 1, UbxSync1);
+  size_t length { UbxParser::Build(0x02, 0x15, long_payload.data(), long_payload.size(), long_message, sizeof(long_message)) };
+
+  feed(broken + "\xB5\xB5\x62" + "$GPTXT,01,01,02,ANTSTATUS=OK*3B\r\n" +
+       std::string(reinterpret_cast<const char*>(long_message), length) + pvt, 13);
+  Check(decoded == 3 && parser.GetChecksumErrors() >= 1 && parser.GetOverflows() == 2, "UBX resync");
+
+  // Acknowledge
+  uint8_t ack[UbxOverhead + 2] {};
+  uint8_t acked[2] { UbxClassCfg, UbxIdCfgRate };
+  UbxMessage answer {};
+
+  length = UbxParser::Build(UbxClassAck, UbxIdAckAck, acked, sizeof(acked), ack, sizeof(ack));
+  parser.Feed(ack, length, 0, [&](UbxMessage message) { answer = message; });
+  Check(answer == UbxMessage::Ack && parser.GetAckClass() == UbxClassCfg && parser.GetAckId() == UbxIdCfgRate, "ACK");
+
+  // Both parsers on a mixed stream: each one skips the other protocol
+  NmeaParser  nmea;
+  std::string mixed;
+  size_t      sentences {};
+
+  for (size_t index = 0; index < 50; index++) {
+    mixed += pvt + "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n";
+  }
+  decoded = 0;
+  feed(mixed, 64);
+  nmea.Feed(Bytes(mixed), mixed.size(), 0, [&](NmeaSentence) { sentences++; });
+  Check(decoded == 50 && sentences == 50, "mixed stream");
+}
+//-----------------------------------------------------------------------------
+void CheckState(const std::string & path) {
+  GpsFix        fix;
+  GpsState      state;
+  GpsState      loaded;
+  GpsStateFile  file(path);
+  uint8_t       aid[UbxOverhead + 24] {};
+  int64_t       utc {};
+
+  fix.year = 2026;
+  fix.month = 10;
+  fix.day = 16;
+  fix.hour = 12;
+  fix.minute = 34;
+  fix.second = 56;
+  fix.millisecond = 250;
+  Check(GpsFixToUtc(fix) == 0, "UTC without date");
+
+  fix.valid = FixHasDate | FixHasTime;
+  utc = GpsFixToUtc(fix);
+  Check(utc == 1792154096250, "UTC of a fix");
+
+  // MGA-INI-TIME_UTC carries back the same date and time
+  Check(UbxParser::BuildAidTime(utc, 5, aid, sizeof(aid)) == sizeof(aid) && aid[2] == UbxClassMga &&
+        aid[3] == UbxIdMgaIni && aid[6] == 0x10 && (aid[10] | aid[11] << 8) == 2026 && aid[12] == 10 &&
+        aid[13] == 16 && aid[14] == 12 && aid[15] == 34 && aid[16] == 56 && aid[18] == 0x80 && aid[19] == 0xB2 &&
+        aid[20] == 0xE6 && aid[21] == 0x0E, "MGA-INI-TIME_UTC");
+  Check(UbxParser::BuildAidPosition(454642035, 91899816, 16870, 100000, aid, sizeof(aid)) == UbxOverhead + 20 &&
+        aid[6] == 0x01, "MGA-INI-POS_LLH");
+
+  // Save, load, and a damaged file is refused
+  state.utc = utc;
+  state.latitude = 454642035;
+  state.longitude = 91899816;
+  state.ttff = 27300;
+
+  Check(!file.Load(loaded), "missing state");
+  Check(file.Save(state) && file.Load(loaded) && loaded.utc == utc && loaded.latitude == state.latitude &&
+        loaded.ttff == state.ttff, "state saved and loaded");
+
+  FILE * damaged { fopen(path.c_str(), "r+b") };
+  if (damaged != nullptr) {
+    fseek(damaged, 12, SEEK_SET);
+    fputc(0x5A, damaged);
+    fclose(damaged);
+  }
+  Check(!file.Load(loaded), "damaged state");
+
+  ::unlink(path.c_str());
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Track log
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Points a Gps appends to its track for a recording.
+ */
+std::vector<TrackPoint> TrackPoints(const std::string & log, GpsProtocol protocol) {
+  std::vector<TrackPoint> points;
+  TrackPoint              point;
+  auto                    append = [&](const GpsFix & fix) {
+    point.utc = GpsFixToUtc(fix);
+    point.latitude = fix.latitude;
+    point.longitude = fix.longitude;
+    point.altitude = fix.Has(FixHasAltitude) ? static_cast<int32_t>(std::lround(fix.altitude * 10)) : point.altitude;
+
+    if (!fix.Has(FixHasPosition) || fix.quality == 0 || point.utc == 0) {
+      return;
+    }
+
+    // The sentences of an epoch make one point, with all their fields
+    if (points.empty() || point.utc > points.back().utc) {
+      points.push_back(point);
+    } else if (point.utc == points.back().utc) {
+      points.back() = point;
+    }
+  };
+
+  if (protocol == GpsProtocol::Nmea) {
+    NmeaParser parser;
+
+    parser.Feed(Bytes(log), log.size(), 0, [&](NmeaSentence sentence) {
+      if (sentence == NmeaSentence::Rmc || sentence == NmeaSentence::Gga) {
+        append(parser.GetFix());
+      }
+    });
+  } else {
+    UbxParser parser;
+
+    parser.Feed(Bytes(log), log.size(), 0, [&](UbxMessage message) {
+      if (message == UbxMessage::NavPvt) {
+        append(parser.GetFix());
+      }
+    });
+  }
+
+  return points;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief A walk at 10 Hz with the noise of a fix, utc from start.
+ */
+std::vector<TrackPoint> SyntheticWalk(size_t count, int64_t start, uint32_t seed) {
+  std::mt19937                    random(seed);
+  std::normal_distribution<float> noise(0.0f, 10.0f);
+  std::vector<TrackPoint>         points(count);
+
+  for (size_t index = 0; index < count; index++) {
+    // A second lost every 50 points
+    points[index].utc = start + static_cast<int64_t>(index) * 100 + static_cast<int64_t>(index / 50) * 1000;
+    points[index].latitude = 454642035 + static_cast<int32_t>(index * 12 + noise(random));
+    points[index].longitude = 91899816 + static_cast<int32_t>(index * 7 + noise(random));
+    points[index].altitude = 1214 + static_cast<int32_t>(noise(random) / 5);
+  }
+
+  return points;
+}
+//-----------------------------------------------------------------------------
+std::vector<TrackPoint> ReadTrack(const std::string & path, int64_t & count) {
+  std::vector<TrackPoint> points;
+
+  count = TrackLog::Read(path, [&](const TrackPoint & point) { points.push_back(point); });
+
+  return points;
+}
+//-----------------------------------------------------------------------------
+bool SamePoint(const TrackPoint & a, const TrackPoint & b) {
+  return a.utc == b.utc && a.latitude == b.latitude && a.longitude == b.longitude && a.altitude == b.altitude;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief True if read are points of written, in the same order: nothing invented, nothing mixed.
+ */
+bool Subsequence(const std::vector<TrackPoint> & read, const std::vector<TrackPoint> & written) {
+  size_t position {};
+
+  for (const TrackPoint & point : read) {
+    while (position < written.size() && written[position].utc != point.utc) {
+      position++;
+    }
+    if (position == written.size() || !SamePoint(point, written[position])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+std::string Snapshot(const std::string & path) {
+  std::ifstream     file(path, std::ios::binary);
+  std::stringstream content;
+
+  content << file.rdbuf();
+  return content.str();
+}
+//-----------------------------------------------------------------------------
+void CheckTrack(const std::string & path) {
+  constexpr size_t Blocks = 8;                            // Data blocks of the test log
+  constexpr size_t Size = (Blocks + 1) * TrackLogBlockSize;
+
+  TrackLog                log;
+  std::vector<TrackPoint> written { SyntheticWalk(20000, 1792154096250, 3) };
+  std::vector<TrackPoint> read;
+  int64_t                 count {};
+  size_t                  first { 100 };
+
+  ::unlink(path.c_str());
+
+  // Decoded as written, older points refused
+  Check(log.Open(path, Size), "track opened");
+  for (size_t index = 0; index < first; index++) {
+    log.Append(written[index]);
+  }
+  Check(!log.Append(written[10]), "older point refused");
+  log.Close();
+
+  read = ReadTrack(path, count);
+  Check(count == static_cast<int64_t>(first) && read.size() == first &&
+        std::equal(read.begin(), read.end(), written.begin(), SamePoint), "track decoded");
+
+  // Continued after a restart, then the ring reused: the newest points remain, in order
+  Check(log.Open(path, Size), "track reopened");
+  for (size_t index = first; index < written.size(); index++) {
+    log.Append(written[index]);
+  }
+  log.Close();
+
+  read = ReadTrack(path, count);
+  Check(!read.empty() && read.size() < written.size() && SamePoint(read.back(), written.back()) &&
+        std::equal(read.begin(), read.end(), written.end() - read.size(), SamePoint) &&
+        read.size() * 7 > Blocks * TrackLogBlockSize / 8, "ring reused");
+
+  // Power cuts: sectors of the file written back or not, the points read are always points written
+  std::mt19937  random(5);
+  bool          consistent { true };
+  size_t        recovered {};
+
+  ::unlink(path.c_str());
+  log.Open(path, Size);
+
+  for (size_t cut = 0; cut < 200; cut++) {
+    size_t      from { cut * 97 };
+    std::string before { Snapshot(path) };
+
+    // Enough to change several blocks, across a lap of the ring some times
+    for (size_t index = from; index < from + 97 + cut % 7 * 300 && index < written.size(); index++) {
+      log.Append(written[index]);
+    }
+
+    std::string after { Snapshot(path) };
+    std::string mixed { before };
+
+    for (size_t sector = 0; sector < mixed.size() / 512; sector++) {
+      if (random() % 2) {
+        mixed.replace(sector * 512, 512, after, sector * 512, 512);
+      }
+    }
+
+    std::ofstream(path + ".cut", std::ios::binary | std::ios::trunc) << mixed;
+    read = ReadTrack(path + ".cut", count);
+    consistent = consistent && count >= 0 && Subsequence(read, written);
+    recovered += read.size();
+  }
+  log.Close();
+  Check(consistent && recovered > 0, "power cuts");
+
+  // Not a track log
+  std::ofstream(path + ".cut", std::ios::binary | std::ios::trunc) << std::string(Size, 'x');
+  Check(ReadTrack(path + ".cut", count).empty() && count == -1, "not a track log");
+
+  ::unlink((path + ".cut").c_str());
+  ::unlink(path.c_str());
+}
+//-----------------------------------------------------------------------------
+void MeasureTrack(const std::string & nmeaLog, const std::string & path, int64_t durationNS) {
+  constexpr size_t  Size = 16 * 1024 * 1024;
+  constexpr double  DayPoints = 86400.0 * 10;
+
+  std::vector<TrackPoint> points { TrackPoints(nmeaLog, GpsProtocol::Nmea) };
+  std::vector<TrackPoint> synthetic { SyntheticWalk(100000, 1792154096250, 9) };
+  TrackLog                log;
+  size_t                  rounds {};
+  int64_t                 start {};
+  int64_t                 elapsed {};
+  int64_t                 span { points.back().utc - points.front().utc + 100 };
+
+  ::unlink(path.c_str());
+  log.Open(path, Size);
+
+  // The recording repeated, shifted in time
+  start = ThreadCpu();
+  do {
+    for (TrackPoint point : points) {
+      point.utc += static_cast<int64_t>(rounds) * span;
+      log.Append(point);
+    }
+    rounds++;
+    elapsed = ThreadCpu() - start;
+  } while (elapsed < durationNS);
+
+  double recording { static_cast<double>(log.GetBytes()) / log.GetPoints() };
+  double appendNS { static_cast<double>(elapsed) / log.GetPoints() };
+
+  log.Close();
+  ::unlink(path.c_str());
+
+  // Synthetic walk with 10 cm of noise
+  log.Open(path, Size);
+  for (const TrackPoint & point : synthetic) {
+    log.Append(point);
+  }
+  double walk { static_cast<double>(log.GetBytes()) / log.GetPoints() };
+  log.Close();
+  ::unlink(path.c_str());
+
+  printf("\n%-22s %12s %12s %14s\n", "track", "bytes/point", "ns/append", "day at 10 Hz");
+  printf("%-22s %12.2f %12.1f %11.1f MB\n", "recording", recording, appendNS, recording * DayPoints / 1e6);
+  printf("%-22s %12.2f %12s %11.1f MB\n", "synthetic walk", walk, "", walk * DayPoints / 1e6);
+  fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Cost and occupancy
+
+//-----------------------------------------------------------------------------
+template<typename Decode>
+double MeasureEpoch(size_t epochs, int64_t durationNS, Decode decode) {
+  size_t  rounds {};
+  int64_t start { ThreadCpu() };
+  int64_t elapsed {};
+
+  do {
+    decode();
+    rounds++;
+    elapsed = ThreadCpu() - start;
+  } while (elapsed < durationNS);
+
+  return static_cast<double>(elapsed) / (rounds * epochs);
+}
+//-----------------------------------------------------------------------------
+void Compare(const std::string & nmeaLog, const std::string & ubxLog, int64_t durationNS) {
+  GpsFix      last;
+  size_t      nmeaEpochs { CountFixes(nmeaLog, GpsProtocol::Nmea, last) };
+  size_t      ubxEpochs { CountFixes(ubxLog, GpsProtocol::Ubx, last) };
+  NmeaParser  nmea;
+  UbxParser   ubx;
+  NmeaParser  satellites;
+
+  if (nmeaEpochs == 0 || ubxEpochs == 0) {
+    Check(false, "recordings decoded");
+    return;
+  }
+
+  double nmeaNS { MeasureEpoch(nmeaEpochs, durationNS, [&] {
+    nmea.Feed(Bytes(nmeaLog), nmeaLog.size(), 0, [](NmeaSentence) { });
+  }) };
+
+  // With UBX the port carries also the sentences of the satellites, both parsers see all the data
+  double ubxNS { MeasureEpoch(ubxEpochs, durationNS, [&] {
+    ubx.Feed(Bytes(ubxLog), ubxLog.size(), 0, [](UbxMessage) { });
+    satellites.Feed(Bytes(ubxLog), ubxLog.size(), 0, [](NmeaSentence) { });
+  }) };
+
+  double nmeaBytes { static_cast<double>(nmeaLog.size()) / nmeaEpochs };
+  double ubxBytes { static_cast<double>(ubxLog.size()) / ubxEpochs };
+
+  printf("\n%-6s %8s %12s %12s %14s %14s\n", "proto", "epochs", "bytes/epoch", "ns/epoch", "uart @9600", "uart @115200");
+  // 10 bits per byte, 10 epochs per second
+  printf("%-6s %8zu %12.1f %12.1f %13.1f%% %13.1f%%\n", "NMEA", nmeaEpochs, nmeaBytes, nmeaNS,
+         nmeaBytes * 10 * 10 / 9600 * 100, nmeaBytes * 10 * 10 / 115200 * 100);
+  printf("%-6s %8zu %12.1f %12.1f %13.1f%% %13.1f%%\n", "UBX", ubxEpochs, ubxBytes, ubxNS,
+         ubxBytes * 10 * 10 / 9600 * 100, ubxBytes * 10 * 10 / 115200 * 100);
+  fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Game clock
+
+/**
+ * @brief A device on simulated time: its monotonic clock runs off the true time and the fixes arrive late.
+ */
+struct SimulatedDevice {
+  FakeClock   monotonic;
+  GameClock   clock { &monotonic };
+  double      drift {};                                   // Of the monotonic clock
+  int64_t     origin {};                                  // Monotonic time at true time 0
+  std::mt19937 random;
+
+  SimulatedDevice(double ppm, int64_t start, uint32_t seed) : drift(ppm * 1e-6), origin(start), random(seed) { }
+
+  int64_t Monotonic(int64_t time) const {
+    return origin + time + static_cast<int64_t>(time * drift);
+  }
+
+  void At(int64_t time) {
+    monotonic.Set(Monotonic(time));
+  }
+
+  /**
+   * @brief Error of the game time at a true time.
+   */
+  int64_t Error(int64_t time, int64_t utc) {
+    At(time);
+    return clock.Now() - (utc + time);
+  }
+};
+//-----------------------------------------------------------------------------
+/**
+ * @brief Two devices with different crystals and delays: the agreement of their game time after the lock.
+ * @param pps - Edges of the PPS in addition to the fixes.
+ * @param latencyNS - Epoch to arrival of the fix, the same for both receivers.
+ * @param jitterNS - Maximum extra delay of an arrival, from the port and the scheduler.
+ * @param holdoverNS - Time the devices go on without fixes and pulses, the sky lost.
+ */
+void SimulateClocks(const char * name, bool pps, int64_t latencyNS, int64_t jitterNS, int64_t agreementNS,
+                    int64_t holdoverNS = 0) {
+  constexpr int64_t Duration = 120 * NanosecondsPerSecond;
+  constexpr int64_t Epoch = 100 * NanosecondsPerMillisecond;
+  constexpr int64_t Check = 10 * NanosecondsPerMillisecond;
+  constexpr int64_t Locked = 60 * NanosecondsPerSecond;
+  constexpr int64_t Utc = 1792154096000000000;           // True UTC at time 0, a whole second
+
+  SimulatedDevice devices[2] { { 35.0, 5 * NanosecondsPerSecond, 1 }, { -20.0, 900 * NanosecondsPerSecond, 2 } };
+  int64_t         worst {};
+  int64_t         worstError {};
+
+  for (SimulatedDevice & device : devices) {
+    device.clock.Init();
+  }
+
+  for (int64_t time = 0; time < Duration + holdoverNS; time += Check) {
+    for (SimulatedDevice & device : devices) {
+      std::uniform_int_distribution<int64_t> jitter(0, jitterNS);
+
+      if (time >= Duration) {
+        break;
+      }
+
+      // Fix of the epoch, late by the latency and a random delay
+      if (time % Epoch == 0) {
+        int64_t arrival { time + latencyNS + jitter(device.random) };
+
+        device.At(arrival);
+        device.clock.OnTime(Utc + time, device.Monotonic(arrival));
+      }
+
+      // Edge at the start of the second, a few microseconds late
+      if (pps && time % NanosecondsPerSecond == 0) {
+        int64_t edge { time + 2000 + jitter(device.random) % 10000 };
+
+        device.At(edge);
+        device.clock.OnPulse(device.Monotonic(edge));
+      }
+    }
+
+    if (time >= Locked) {
+      int64_t first { devices[0].Error(time, Utc) };
+      int64_t second { devices[1].Error(time, Utc) };
+
+      worst = std::max(worst, std::abs(first - second));
+      worstError = std::max({ worstError, std::abs(first + latencyNS * !pps), std::abs(second + latencyNS * !pps) });
+    }
+  }
+
+  bool ok { worst < agreementNS };
+
+  printf("%-22s agreement %9.3f ms   error %9.3f ms   frequency %+7.1f %+7.1f ppm   %s\n", name, worst / 1e6,
+         worstError / 1e6, devices[0].clock.GetFrequency(), devices[1].clock.GetFrequency(), ok ? "ok" : "FAILED");
+  fflush(stdout);
+
+  passed = passed && ok;
+}
+//-----------------------------------------------------------------------------
+void MeasureClock(int64_t durationNS) {
+  GameClock clock;
+  int64_t   sum {};
+  size_t    calls {};
+  int64_t   start { ThreadCpu() };
+  int64_t   elapsed {};
+
+  clock.Init();
+  clock.OnTime(1792154096000000000, Now());
+
+  do {
+    for (size_t index = 0; index < 1000; index++) {
+      sum += clock.Now();
+    }
+    calls += 1000;
+    elapsed = ThreadCpu() - start;
+  } while (elapsed < durationNS);
+
+  printf("GameClock::Now        %7.1f ns/call%s\n", static_cast<double>(elapsed) / calls, sum == 0 ? " " : "");
+  fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Fake receiver on the master side of a pty
+
+//-----------------------------------------------------------------------------
+class FakeReceiver final {
+public:
+  FakeReceiver() {
+    char name[128] {};
+
+    if (openpty(&_master, &_slave, name, nullptr, nullptr) == -1) {
+      return;
+    }
+
+    termios options;
+    tcgetattr(_master, &options);
+    cfmakeraw(&options);
+    tcsetattr(_master, TCSANOW, &options);
+
+    fcntl(_master, F_SETFL, fcntl(_master, F_GETFL) | O_NONBLOCK);
+
+    _name = name;
+  }
+  ~FakeReceiver() {
+    Stop();
+
+    if (_master != -1) {
+      ::close(_master);
+    }
+    if (_slave != -1) {
+      ::close(_slave);
+    }
+  }
+
+  bool inline IsValid(void) const {
+    return !_name.empty();
+  }
+
+  const std::string & Name(void) const {
+    return _name;
+  }
+
+  size_t inline GetCommands(void) const {
+    return _commands;
+  }
+
+  size_t inline GetAiding(void) const {
+    return _aiding;
+  }
+
+  /**
+   * @brief Start the receiver: the UBX commands are acknowledged, the recording is played once the
+   *        configuration is complete (UBX) or immediately (NMEA).
+   */
+  void Start(const std::string & recording, GpsProtocol protocol, size_t commands) {
+    _thread = std::thread([this, &recording, protocol, commands] { Run(recording, protocol, commands); });
+  }
+
+  void Stop(void) {
+    _stop = true;
+
+    if (_thread.joinable()) {
+      _thread.join();
+    }
+  }
+
+private:
+  void Run(const std::string & recording, GpsProtocol protocol, size_t commands) {
+    UbxParser parser;
+    uint8_t   buffer[256];
+    size_t    offset {};
+    int64_t   configured {};
+
+    while (!_stop) {
+      // Answer the commands
+      ssize_t length { ::read(_master, buffer, sizeof(buffer)) };
+
+      if (length > 0) {
+        parser.Feed(buffer, static_cast<size_t>(length), 0, [&](UbxMessage) {
+          if (parser.GetClass() == UbxClassCfg) {
+            uint8_t ack[UbxOverhead + 2];
+            uint8_t acked[2] { parser.GetClass(), parser.GetId() };
+
+            Write(ack, UbxParser::Build(UbxClassAck, UbxIdAckAck, acked, sizeof(acked), ack, sizeof(ack)));
+            _commands++;
+          } else if (parser.GetClass() == UbxClassMga) {
+            _aiding++;
+          }
+        });
+      }
+
+      // Play the recording, leaving to Gps the time to complete the configuration
+      if (_commands >= commands && configured == 0) {
+        configured = Now();
+      }
+
+      if ((protocol == GpsProtocol::Nmea || (configured != 0 && Now() - configured > ConfigureNS)) &&
+          offset < recording.size()) {
+        size_t chunk { std::min(PlaybackChunk, recording.size() - offset) };
+
+        Write(Bytes(recording) + offset, chunk);
+        offset += chunk;
+      }
+
+      timespec pause { 0, static_cast<long>(PlaybackPauseNS) };
+      nanosleep(&pause, nullptr);
+    }
+  }
+
+  void Write(const uint8_t * data, size_t length) {
+    while (length > 0 && !_stop) {
+      pollfd fd { _master, POLLOUT, 0 };
+      if (poll(&fd, 1, 100) <= 0) {
+        continue;
+      }
+
+      ssize_t written { ::write(_master, data, length) };
+      if (written > 0) {
+        data += written;
+        length -= static_cast<size_t>(written);
+      }
+    }
+  }
+
+private:
+  int32_t             _master { -1 };
+  int32_t             _slave { -1 };
+  std::string         _name;
+  std::thread         _thread;
+  std::atomic<bool>   _stop {};
+  std::atomic<size_t> _commands {};
+  std::atomic<size_t> _aiding {};
+};
+//-----------------------------------------------------------------------------
+void RunPipeline(const char * name, const std::string & recording, GpsProtocol protocol,
+                 const std::string & stateFile = std::string(), const std::string & trackFile = std::string()) {
+  FakeReceiver  receiver;
+  UartReactor   reactor;
+  Gps           gps;
+  GpsSettings   settings;
+  GpsFix        expected;
+  GpsFix        fix;
+  GpsState      state;
+  bool          aided { GpsStateFile(stateFile).Load(state) };
+  size_t        fixes { CountFixes(recording, protocol, expected) };
+  uint64_t      generation {};
+  int64_t       start {};
+  int64_t       lastProgress {};
+
+  // CFG-RATE and the CFG-MSG of the seven messages
+  constexpr size_t UbxCommands = 8;
+
+  if (!receiver.IsValid() || !reactor.Init()) {
+    Check(false, "pty and reactor");
+    return;
+  }
+
+  settings.protocol = protocol;
+  settings.stateFile = stateFile;
+  settings.trackFile = trackFile;
+  receiver.Start(recording, protocol, UbxCommands + 1);
+
+  start = Now();
+  Check(gps.Init(receiver.Name(), reactor, settings), "Gps::Init");
+  Check(gps.GetProtocol() == protocol, "protocol negotiated");
+
+  lastProgress = Now();
+
+  while (gps.GetGeneration() < fixes && Now() - lastProgress < StallTimeoutNS) {
+    if (gps.GetFixIfChanged(fix, generation)) {
+      lastProgress = Now();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  int64_t wall { Now() - start };
+
+  gps.GetFix(fix);
+  gps.Terminate();
+  receiver.Stop();
+  reactor.Terminate();
+
+  bool ok { gps.GetGeneration() == fixes && fix.latitude == expected.latitude && fix.longitude == expected.longitude &&
+            fix.TimeOfDay() == expected.TimeOfDay() && gps.GetTimeToFirstFix() > 0 };
+
+  // The aiding is sent only with the state of a previous session, the last position is saved at Terminate
+  if (!stateFile.empty()) {
+    ok = ok && (receiver.GetAiding() > 0) == aided && GpsStateFile(stateFile).Load(state) &&
+         state.latitude == expected.latitude && state.longitude == expected.longitude &&
+         state.utc == GpsFixToUtc(expected) && state.ttff == gps.GetTimeToFirstFix();
+  }
+
+  // Every epoch in the track
+  if (!trackFile.empty()) {
+    std::vector<TrackPoint> points { TrackPoints(recording, protocol) };
+    std::vector<TrackPoint> read;
+    int64_t                 count {};
+
+    read = ReadTrack(trackFile, count);
+    ok = ok && read.size() == points.size() && std::equal(read.begin(), read.end(), points.begin(), SamePoint);
+  }
+
+  printf("%-16s %6zu fixes %6llu published %3zu commands %2zu aiding   ttff %6u ms   total %7.1f ms  %s\n", name,
+         fixes, static_cast<unsigned long long>(gps.GetGeneration()), receiver.GetCommands(), receiver.GetAiding(),
+         gps.GetTimeToFirstFix(), wall / 1e6, ok ? "ok" : "FAILED");
+  fflush(stdout);
+
+  passed = passed && ok;
+}
+//-----------------------------------------------------------------------------
+void CheckReplay(void) {
+  GpsReplay replay;
+  GpsReplay other;
+
+  Check(GpsReplay::IsReplay("replay:walk.nmea") && !GpsReplay::IsReplay("/dev/ttyS3"), "replay URI");
+  Check(!replay.Open("replay:missing.nmea"), "missing log");
+  Check(!replay.Open(std::string("replay:") + NmeaLog + "?speed=-1"), "negative speed");
+  Check(!replay.Open(std::string("replay:") + NmeaLog + "?speed=abc") &&
+        !replay.Open(std::string("replay:") + NmeaLog + "?speed=") &&
+        !replay.Open(std::string("replay:") + NmeaLog + "?speed=2x") &&
+        !replay.Open(std::string("replay:") + NmeaLog + "?speed=nan"), "malformed speed");
+  Check(replay.Open(std::string("replay:") + NmeaLog + "?speed=0.5") && replay.GetSpeed() == 0.5, "fractional speed");
+  replay.Close();
+  Check(!replay.Open(std::string("replay:") + NmeaLog + "?rate=2"), "unknown option");
+  Check(replay.Open(std::string("replay:") + UbxLog + "?speed=max") && replay.IsUbx() && replay.GetSpeed() == 0 &&
+        replay.GetEpochs() == 303, "UBX log");
+  // The same walk: the same epochs at the same times
+  Check(other.Open(std::string("replay:") + NmeaLog) && !other.IsUbx() && other.GetSpeed() == 1 &&
+        other.GetEpochs() == replay.GetEpochs() && other.GetDuration() == replay.GetDuration(), "NMEA log");
+  replay.Close();
+  other.Close();
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Replay a recording through Gps, all the fixes have to be published, at the pace of the speed.
+ */
+void RunReplay(const char * name, const char * path, const std::string & recording, GpsProtocol protocol,
+               const char * speed) {
+  UartReactor   reactor;
+  Gps           gps;
+  GpsFix        expected;
+  GpsFix        fix;
+  size_t        fixes { CountFixes(recording, protocol, expected) };
+  uint64_t      generation {};
+  int64_t       start {};
+  int64_t       lastProgress {};
+  size_t        handled {};                               // Fixes seen by the handler, reactor thread
+
+  if (!reactor.Init()) {
+    Check(false, "reactor");
+    return;
+  }
+
+  gps.SetFixHandler([&handled](const GpsFix &) { handled++; });
+
+  start = Now();
+  Check(gps.Init(std::string("replay:") + path + "?speed=" + speed, reactor), "Gps::Init replay");
+  lastProgress = Now();
+
+  while ((gps.GetGeneration() < fixes || !gps.GetReplay().IsFinished()) && Now() - lastProgress < StallTimeoutNS) {
+    if (gps.GetFixIfChanged(fix, generation)) {
+      lastProgress = Now();
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+
+  int64_t wall { Now() - start };
+  double  expectedNS { std::strcmp(speed, "max") == 0 ? 0.0 :
+                       gps.GetReplay().GetDuration() * 1e6 / std::strtod(speed, nullptr) };
+
+  gps.GetFix(fix);
+  gps.Terminate();
+  reactor.Terminate();
+
+  // On time within 20% and the start up, as fast as possible well ahead of real time
+  bool ok { gps.GetGeneration() == fixes && handled == fixes && fix.latitude == expected.latitude &&
+            fix.longitude == expected.longitude && fix.TimeOfDay() == expected.TimeOfDay() &&
+            fix.Has(FixHasTrust) && fix.trust >= GpsTrustUsable && gps.GetQuality().GetUsed() > 0 &&
+            (expectedNS > 0 ? std::fabs(wall - expectedNS) < expectedNS * 0.2 + 100e6 :
+                              wall < gps.GetReplay().GetDuration() * 1e6 / 20) };
+
+  printf("%-16s %6zu fixes %6llu published   log %6.1f s   wall %8.1f ms   %9.0f epochs/s  %s\n", name, fixes,
+         static_cast<unsigned long long>(gps.GetGeneration()), gps.GetReplay().GetDuration() / 1e3, wall / 1e6,
+         gps.GetReplay().GetEpochs() / (wall / 1e9), ok ? "ok" : "FAILED");
+  fflush(stdout);
+
+  passed = passed && ok;
+}
+//-----------------------------------------------------------------------------
+std::string Sentence(const std::string & body) {
+  char    checksum[8];
+  uint8_t sum {};
+
+  for (char character : body) {
+    sum ^= static_cast<uint8_t>(character);
+  }
+  snprintf(checksum, sizeof(checksum), "*%02X\r\n", sum);
+
+  return "$" + body + checksum;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief NMEA fixes published once per epoch with the fields of RMC and GGA, also when a GGA is lost.
+ */
+void CheckEpochs(const std::string & path) {
+  UartReactor reactor;
+  Gps         gps;
+  GpsFix      fix;
+  std::string sentences;
+  char        body[128];
+  int64_t     start { Now() };
+
+  for (uint32_t second = 0; second < 5; second++) {
+    snprintf(body, sizeof(body), "GPRMC,1200%02u.00,A,4527.8522,N,00911.3989,E,0.0,0.0,161026,,,A", second);
+    sentences += Sentence(body);
+
+    // The GGA of the fourth epoch is lost
+    if (second != 3) {
+      snprintf(body, sizeof(body), "GPGGA,1200%02u.00,4527.8522,N,00911.3989,E,1,08,0.9,%u.0,M,47.3,M,,", second,
+               100 + second);
+      sentences += Sentence(body);
+    }
+  }
+
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << sentences;
+
+  if (reactor.Init() && gps.Init("replay:" + path + "?speed=max", reactor)) {
+    while (!gps.GetReplay().IsFinished() && Now() - start < StallTimeoutNS) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    gps.GetFix(fix);
+    gps.Terminate();
+  }
+  reactor.Terminate();
+  ::unlink(path.c_str());
+
+  Check(gps.GetGeneration() == 5 && fix.second == 4 && fix.altitude == 104.0f, "one fix per epoch");
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Position filter
+
+//-----------------------------------------------------------------------------
+struct GamePoint {
+  float   x;                                              // True position, meters east of the field origin
+  float   y;
+  float   hdop;
+  bool    reflection;                                     // The fix is tens of meters off
+  int32_t latitude;                                       // Position of the receiver
+  int32_t longitude;
+};
+//-----------------------------------------------------------------------------
+/**
+ * @brief Ten minutes at 10 Hz of a player and of the fixes of its receiver.
+ */
+std::vector<GamePoint> SyntheticGame(const LocalPlane & plane, uint32_t seed) {
+  std::mt19937                          random(seed);
+  std::normal_distribution<float>       gauss(0.0f, 1.0f);
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  std::vector<GamePoint>                points;
+  float                                 x {}, y {}, heading {}, biasX {}, biasY {};
+
+  for (size_t index = 0; index < 6000; index++) {
+    float     t { index * 0.1f };
+    float     speed { t < 120 ? 1.4f : t < 150 ? 0.0f : t < 300 ? 3.5f : t < 330 ? 0.0f : 1.4f };
+    bool      trees { (t > 200 && t < 260) || (t > 420 && t < 500) };
+    GamePoint point {};
+
+    // Gentle turns, a sharp one every minute
+    heading += index % 600 == 300 ? 1.6f : 0.02f * gauss(random);
+    x += speed * 0.1f * std::sin(heading);
+    y += speed * 0.1f * std::cos(heading);
+
+    // Receiver: an error wandering with a time constant of 3 s plus white noise, larger under the trees
+    point.hdop = (trees ? 2.5f : 0.9f) + 0.1f * uniform(random);
+    biasX = biasX * 0.967f + 0.2f * point.hdop * gauss(random);
+    biasY = biasY * 0.967f + 0.2f * point.hdop * gauss(random);
+    point.reflection = uniform(random) < (trees ? 0.03f : 0.005f);
+
+    float errorX { biasX + 0.4f * point.hdop * gauss(random) + (point.reflection ? 40.0f : 0.0f) };
+    float errorY { biasY + 0.4f * point.hdop * gauss(random) + (point.reflection ? -25.0f : 0.0f) };
+
+    point.x = x;
+    point.y = y;
+    plane.Unproject(x + errorX, y + errorY, point.latitude, point.longitude);
+    points.push_back(point);
+  }
+
+  return points;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief GGA and RMC of the fixes of a game, from 12:00:00 UTC.
+ */
+std::string GameSentences(const std::vector<GamePoint> & points) {
+  std::string sentences;
+
+  for (size_t index = 0; index < points.size(); index++) {
+    char      time[16];
+    char      latitude[24];
+    char      longitude[24];
+    char      body[160];
+    uint32_t  ms { 12 * 3600000u + static_cast<uint32_t>(index) * 100 };
+    int32_t   lat { points[index].latitude };
+    int32_t   lon { points[index].longitude };
+
+    snprintf(time, sizeof(time), "%02u%02u%02u.%02u", ms / 3600000, ms / 60000 % 60, ms / 1000 % 60, ms % 1000 / 10);
+    snprintf(latitude, sizeof(latitude), "%02d%08.5f", lat / 10000000, lat % 10000000 * 60e-7);
+    snprintf(longitude, sizeof(longitude), "%03d%08.5f", lon / 10000000, lon % 10000000 * 60e-7);
+
+    snprintf(body, sizeof(body), "GNRMC,%s,A,%s,N,%s,E,0.0,0.0,161026,,,A", time, latitude, longitude);
+    sentences += Sentence(body);
+    snprintf(body, sizeof(body), "GNGGA,%s,%s,N,%s,E,1,12,%.2f,121.4,M,47.3,M,,", time, latitude, longitude,
+             points[index].hdop);
+    sentences += Sentence(body);
+  }
+
+  return sentences;
+}
+//-----------------------------------------------------------------------------
+struct FilterErrors {
+  double rms;
+  double p95;
+  double max;
+};
+//-----------------------------------------------------------------------------
+FilterErrors Errors(std::vector<float> errors) {
+  FilterErrors  result {};
+  double        sum {};
+
+  std::sort(errors.begin(), errors.end());
+  for (float error : errors) {
+    sum += static_cast<double>(error) * error;
+  }
+
+  result.rms = std::sqrt(sum / errors.size());
+  result.p95 = errors[errors.size() * 95 / 100];
+  result.max = errors.back();
+
+  return result;
+}
+//-----------------------------------------------------------------------------
+void CheckFilter(const std::string & path) {
+  LocalPlane              plane(454642035, 91899816);
+  std::vector<GamePoint>  game { SyntheticGame(plane, 17) };
+  std::string             sentences { GameSentences(game) };
+  NmeaParser              parser;
+  GpsFilter               filter;
+  GpsFix                  last;
+  std::vector<float>      raw;
+  std::vector<float>      filtered;
+  size_t                  reflections {};
+  size_t                  epoch {};
+
+  parser.Feed(Bytes(sentences), sentences.size(), 0, [&](NmeaSentence sentence) {
+    if (sentence != NmeaSentence::Gga && sentence != NmeaSentence::Rmc) {
+      return;
+    }
+
+    // Once per epoch as Gps does, at the GGA with the HDOP
+    if (sentence == NmeaSentence::Gga) {
+      GpsFix  fix { parser.GetFix() };
+      float   x {}, y {}, fx {}, fy {};
+
+      filter.Apply(fix);
+      last = fix;
+
+      plane.Project(fix.latitude, fix.longitude, x, y);
+      plane.Project(fix.filteredLatitude, fix.filteredLongitude, fx, fy);
+      raw.push_back(LocalPlane::Distance(x, y, game[epoch].x, game[epoch].y));
+      filtered.push_back(LocalPlane::Distance(fx, fy, game[epoch].x, game[epoch].y));
+      reflections += game[epoch].reflection;
+      epoch++;
+    }
+  });
+
+  FilterErrors receiver { Errors(raw) };
+  FilterErrors smoothed { Errors(filtered) };
+
+  printf("\n%-22s %10s %10s %10s %10s\n", "synthetic game", "rms (m)", "p95 (m)", "max (m)", "rejected");
+  printf("%-22s %10.2f %10.2f %10.2f %10zu\n", "receiver", receiver.rms, receiver.p95, receiver.max, reflections);
+  printf("%-22s %10.2f %10.2f %10.2f %10llu\n", "filtered", smoothed.rms, smoothed.p95, smoothed.max,
+         static_cast<unsigned long long>(filter.GetRejected()));
+
+  Check(epoch == game.size() && smoothed.rms < receiver.rms * 0.8 && smoothed.p95 < receiver.p95 &&
+        smoothed.max < receiver.max / 2 && filter.GetRejected() >= reflections * 9 / 10 && filter.GetResets() == 1,
+        "filter on the synthetic game");
+
+  // The same sentences through Gps
+  std::ofstream(path, std::ios::binary | std::ios::trunc) << sentences;
+
+  UartReactor reactor;
+  Gps         gps;
+  GpsFix      fix;
+  int64_t     start { Now() };
+
+  if (reactor.Init() && gps.Init("replay:" + path + "?speed=max", reactor)) {
+    while ((gps.GetGeneration() < game.size() || !gps.GetReplay().IsFinished()) &&
+           Now() - start < StallTimeoutNS) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    gps.GetFix(fix);
+    gps.Terminate();
+  }
+  reactor.Terminate();
+  ::unlink(path.c_str());
+
+  Check(fix.Has(FixHasFiltered) && fix.filteredLatitude == last.filteredLatitude &&
+        fix.filteredLongitude == last.filteredLongitude &&
+        gps.GetFilter().GetRejected() == filter.GetRejected(), "filter in Gps");
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief The recordings filtered: steps between fixes, the filter has to follow the receiver without resets.
+ */
+void FilterRecording(const char * name, const std::string & log, GpsProtocol protocol, int64_t durationNS) {
+  std::vector<GpsFix> fixes;
+  GpsFilter           filter;
+  LocalPlane          plane;
+  std::vector<float>  offsets;
+  double              rawJerk {};
+  double              filteredJerk {};
+  float               last[2][4] {};                      // Previous positions, raw and filtered
+  size_t              rounds {};
+  int64_t             start {};
+  int64_t             elapsed {};
+
+  if (protocol == GpsProtocol::Nmea) {
+    NmeaParser parser;
+
+    parser.Feed(Bytes(log), log.size(), 0, [&](NmeaSentence sentence) {
+      if (sentence == NmeaSentence::Gga) {
+        fixes.push_back(parser.GetFix());
+      }
+    });
+  } else {
+    UbxParser parser;
+
+    parser.Feed(Bytes(log), log.size(), 0, [&](UbxMessage message) {
+      if (message == UbxMessage::NavPvt) {
+        fixes.push_back(parser.GetFix());
+      }
+    });
+  }
+
+  for (GpsFix & fix : fixes) {
+    if (!filter.Apply(fix) || !fix.Has(FixHasFiltered)) {
+      continue;
+    }
+    if (plane.GetLatitude() == 0) {
+      plane.SetOrigin(fix.latitude, fix.longitude);
+    }
+
+    float position[2][2] {};
+
+    plane.Project(fix.latitude, fix.longitude, position[0][0], position[0][1]);
+    plane.Project(fix.filteredLatitude, fix.filteredLongitude, position[1][0], position[1][1]);
+    offsets.push_back(LocalPlane::Distance(position[0][0], position[0][1], position[1][0], position[1][1]));
+
+    // Second differences of the positions: how much the track shakes
+    for (size_t track = 0; track < 2; track++) {
+      double jerk { std::hypot(position[track][0] - 2 * last[track][0] + last[track][2],
+                               position[track][1] - 2 * last[track][1] + last[track][3]) };
+
+      (track == 0 ? rawJerk : filteredJerk) += offsets.size() > 2 ? jerk : 0.0;
+      last[track][2] = last[track][0];
+      last[track][3] = last[track][1];
+      last[track][0] = position[track][0];
+      last[track][1] = position[track][1];
+    }
+  }
+
+  FilterErrors offset { Errors(offsets) };
+  bool         steady { filter.GetResets() == 1 && filter.GetRejected() == 0 };
+
+  // Cost of a fix
+  start = ThreadCpu();
+  do {
+    filter.Reset();
+    for (GpsFix fix : fixes) {
+      filter.Apply(fix);
+    }
+    rounds++;
+    elapsed = ThreadCpu() - start;
+  } while (elapsed < durationNS);
+
+  printf("%-22s %6zu fixes   offset rms %5.2f m max %5.2f m   shake %5.2f -> %5.2f m   %6.1f ns/fix\n", name,
+         fixes.size(), offset.rms, offset.max, rawJerk / offsets.size(), filteredJerk / offsets.size(),
+         static_cast<double>(elapsed) / (rounds * fixes.size()));
+
+  Check(steady && filteredJerk < rawJerk && offset.max < 10.0, "filter on the recording");
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Stream fan out
+
+//-----------------------------------------------------------------------------
+uint8_t ChunkByte(uint64_t sequence, size_t index) {
+  return static_cast<uint8_t>(sequence * 31 + index);
+}
+//-----------------------------------------------------------------------------
+void PublishPattern(GpsStream & stream) {
+  GpsChunk * chunk { stream.Acquire() };
+  uint64_t   sequence { stream.GetPublished() };
+
+  chunk->length = 1 + sequence % GpsChunkSize;
+  for (size_t index = 0; index < chunk->length; index++) {
+    chunk->data[index] = ChunkByte(sequence, index);
+  }
+  stream.Publish(chunk);
+}
+//-----------------------------------------------------------------------------
+bool SamePattern(const GpsChunkRef & chunk) {
+  bool same { chunk.GetLength() == 1 + chunk.GetSequence() % GpsChunkSize };
+
+  for (size_t index = 0; same && index < chunk.GetLength(); index++) {
+    same = chunk.GetData()[index] == ChunkByte(chunk.GetSequence(), index);
+  }
+
+  return same;
+}
+//-----------------------------------------------------------------------------
+void CheckStream(void) {
+  constexpr uint64_t Chunks = 200000;
+
+  GpsStream                   stream;
+  GpsSubscription           * reader { stream.Subscribe() };
+  GpsSubscription           * stalled { stream.Subscribe() };
+  std::atomic<bool>           done {};
+  std::atomic<bool>           intact { true };
+  std::atomic<uint64_t>       read {};
+  std::atomic<uint64_t>       gaps {};
+  std::atomic<uint64_t>       next {};                    // Sequence after the last chunk read
+  std::atomic<uint64_t>       churns {};
+
+  Check(reader != nullptr && stalled != nullptr, "subscribe");
+
+  // A reader checking every chunk, the lost ones are the gaps in the sequence and the chunks after the last one
+  std::thread consumer([&] {
+    GpsChunkRef chunk;
+    uint64_t    expected {};
+
+    while (!done || reader->GetReceived() > read) {
+      if (!reader->Receive(chunk, 10)) {
+        continue;
+      }
+      intact = intact && SamePattern(chunk) && chunk.GetSequence() >= expected;
+      gaps += chunk.GetSequence() - expected;
+      expected = chunk.GetSequence() + 1;
+      next = expected;
+      read++;
+    }
+  });
+
+  // Subscribers coming and going, every queue released
+  std::thread churn([&] {
+    while (!done) {
+      GpsSubscription * subscription { stream.Subscribe() };
+      GpsChunkRef       chunk;
+
+      if (subscription != nullptr) {
+        for (size_t index = 0; index < 8 && subscription->TryReceive(chunk); index++) {
+          intact = intact && SamePattern(chunk);
+        }
+        chunk.Release();
+        stream.Unsubscribe(subscription);
+        churns++;
+      }
+      std::this_thread::yield();
+    }
+  });
+
+  for (uint64_t index = 0; index < Chunks; index++) {
+    PublishPattern(stream);
+  }
+
+  done = true;
+  consumer.join();
+  churn.join();
+
+  Check(intact && read == reader->GetReceived() && read + reader->GetDropped() == Chunks &&
+        gaps + Chunks - next == reader->GetDropped(), "subscriber keeping up");
+  Check(stalled->GetReceived() == GpsSubscriptionCapacity &&
+        stalled->GetDropped() == Chunks - GpsSubscriptionCapacity, "stalled subscriber");
+  Check(churns > 0 && stream.GetExhausted() == 0 && stream.GetPublished() == Chunks, "subscribers coming and going");
+
+  stream.Unsubscribe(stalled);
+  Check(stream.GetInUse() == 0, "chunks released");
+
+  // A subscriber holding every chunk: the pool runs out, the chunks are read in the spare and lost
+  {
+    std::vector<GpsChunkRef>  held;
+    GpsChunkRef               chunk;
+    uint64_t                  published { stream.GetPublished() };
+
+    for (size_t index = 0; index < GpsStreamPoolSize + 10; index++) {
+      PublishPattern(stream);
+      while (reader->TryReceive(chunk)) {
+        held.push_back(chunk);
+      }
+    }
+    chunk.Release();
+
+    Check(held.size() == GpsStreamPoolSize && stream.GetExhausted() == 10 &&
+          reader->GetDropped() == Chunks - read + 10 &&
+          std::all_of(held.begin(), held.end(), SamePattern) && held.front().GetSequence() == published,
+          "pool exhausted");
+    held.clear();
+  }
+
+  stream.Unsubscribe(reader);
+  Check(stream.GetInUse() == 0 && stream.Subscribe() != nullptr, "pool back");
+
+  // Unsubscribed by another thread while its consumer is receiving: every chunk released exactly once
+  {
+    GpsStream stream;
+    bool      released { true };
+
+    for (size_t round = 0; round < 500; round++) {
+      GpsSubscription * subscription { stream.Subscribe() };
+      std::atomic<bool> unsubscribed {};
+
+      std::thread consumer([&] {
+        GpsChunkRef chunk;
+
+        while (subscription->Receive(chunk, 1000) || !unsubscribed) {
+          chunk.Release();
+        }
+      });
+
+      for (size_t index = 0; index < round % 64; index++) {
+        PublishPattern(stream);
+      }
+
+      stream.Unsubscribe(subscription);
+      unsubscribed = true;
+      consumer.join();
+
+      released = released && stream.GetInUse() == 0;
+    }
+
+    Check(released, "unsubscribed while receiving");
+  }
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Cost of a chunk on the reader of the port: acquired, filled with a line and published.
+ */
+void MeasureStream(int64_t durationNS) {
+  constexpr size_t Length = 64;
+
+  printf("\n%-26s %10s %12s\n", "fan out", "ns/chunk", "reader lost");
+
+  for (size_t subscribers : { 0, 1, 4 }) {
+    GpsStream                       stream;
+    std::vector<GpsSubscription*>   subscriptions;
+    std::atomic<bool>               done {};
+    uint64_t                        chunks {};
+    int64_t                         start {};
+    int64_t                         elapsed {};
+
+    for (size_t index = 0; index < subscribers; index++) {
+      subscriptions.push_back(stream.Subscribe());
+    }
+
+    // The first one reads as fast as it can, the others are stalled
+    std::thread consumer([&] {
+      GpsChunkRef chunk;
+
+      while (!done && !subscriptions.empty()) {
+        subscriptions.front()->Receive(chunk, 10);
+        chunk.Release();
+      }
+    });
+
+    start = ThreadCpu();
+    do {
+      for (size_t index = 0; index < 1000; index++) {
+        GpsChunk * chunk { stream.Acquire() };
+
+        std::memset(chunk->data, '$', Length);
+        chunk->length = Length;
+        stream.Publish(chunk);
+      }
+      chunks += 1000;
+      elapsed = ThreadCpu() - start;
+    } while (elapsed < durationNS);
+
+    done = true;
+    consumer.join();
+
+    char name[32];
+    snprintf(name, sizeof(name), "subscribers %zu", subscribers);
+    printf("%-26s %10.1f %11.1f%%\n", name, static_cast<double>(elapsed) / chunks,
+           subscribers > 0 ? 100.0 * subscriptions.front()->GetDropped() / chunks : 0.0);
+  }
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Sentences with a valid checksum in data, decoded or not.
+ */
+size_t CountSentences(const std::string & data) {
+  NmeaParser      parser;
+  size_t          sentences {};
+  const uint8_t * bytes { Bytes(data) };
+  size_t          length { data.size() };
+
+  while (length > 0) {
+    size_t used { parser.Consume(bytes, length) };
+
+    bytes += used;
+    length -= used;
+    sentences += parser.IsChecksumValid();
+  }
+
+  return sentences;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Gps on the fake receiver with subscribers: one logging everything, one never reading, and a reader of
+ *        the pseudo terminal if read.
+ */
+void RunFanOut(const char * name, const std::string & recording, GpsProtocol protocol, const std::string & link,
+               bool read) {
+  constexpr size_t UbxCommands = 8;
+
+  FakeReceiver        receiver;
+  UartReactor         reactor;
+  Gps                 gps;
+  GpsSettings         settings;
+  GpsFix              expected;
+  GpsFix              fix;
+  size_t              fixes { CountFixes(recording, protocol, expected) };
+  // With UBX an RMC and a GGA for every NAV-PVT
+  size_t              sentences { CountSentences(recording) + (protocol == GpsProtocol::Ubx ? 2 * fixes : 0) };
+  GpsSubscription   * logger { gps.GetStream().Subscribe() };
+  GpsSubscription   * stalled { gps.GetStream().Subscribe() };
+  std::string         logged;
+  std::string         exported;
+  std::atomic<bool>   done {};
+  int64_t             lastProgress {};
+  uint64_t            generation {};
+
+  if (!receiver.IsValid() || !reactor.Init() || logger == nullptr || stalled == nullptr) {
+    Check(false, "pty, reactor and subscriptions");
+    return;
+  }
+
+  // The data of the port as received: everything but the UBX configuration, read before the stream starts
+  std::thread writer([&] {
+    GpsChunkRef chunk;
+
+    while (logger->Receive(chunk, 10) || !done) {
+      if (chunk) {
+        logged.append(reinterpret_cast<const char*>(chunk.GetData()), chunk.GetLength());
+        chunk.Release();
+      }
+    }
+  });
+
+  settings.protocol = protocol;
+  settings.nmeaPty = link;
+  receiver.Start(recording, protocol, UbxCommands + 1);
+  Check(gps.Init(receiver.Name(), reactor, settings) && gps.GetNmeaPty().IsOpen(), "Gps::Init with a pseudo terminal");
+
+  // The tool reading the GPS through the link
+  std::thread tool([&] {
+    int32_t fd { read ? ::open(link.c_str(), O_RDONLY | O_NOCTTY | O_NONBLOCK) : -1 };
+    char    buffer[512];
+
+    while (fd != -1 && !done) {
+      pollfd  descriptor { fd, POLLIN, 0 };
+      ssize_t length {};
+
+      if (poll(&descriptor, 1, 10) > 0 && (length = ::read(fd, buffer, sizeof(buffer))) > 0) {
+        exported.append(buffer, static_cast<size_t>(length));
+      }
+    }
+
+    if (fd != -1) {
+      ::close(fd);
+    }
+  });
+
+  lastProgress = Now();
+  while (gps.GetGeneration() < fixes && Now() - lastProgress < StallTimeoutNS) {
+    if (gps.GetFixIfChanged(fix, generation)) {
+      lastProgress = Now();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // The last sentences through the pseudo terminal and read
+  lastProgress = Now();
+  while (gps.GetNmeaPty().GetSentences() + gps.GetNmeaPty().GetDropped() < sentences &&
+         Now() - lastProgress < StallTimeoutNS) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  gps.GetFix(fix);
+  done = true;
+  tool.join();
+  writer.join();
+
+  uint64_t published { gps.GetStream().GetPublished() };
+  uint64_t written { gps.GetNmeaPty().GetSentences() };
+  uint64_t dropped { gps.GetNmeaPty().GetDropped() };
+  uint64_t lost { gps.GetNmeaPty().GetLost() };
+
+  gps.Terminate();
+  receiver.Stop();
+  reactor.Terminate();
+
+  GpsFix  piped;
+  size_t  received { CountSentences(exported) };
+  size_t  pipedFixes { CountFixes(exported, GpsProtocol::Nmea, piped) };
+  bool    ok { gps.GetGeneration() == fixes && fix.latitude == expected.latitude &&
+               fix.longitude == expected.longitude && fix.TimeOfDay() == expected.TimeOfDay() };
+
+  // Everything the receiver sent after its configuration, in order
+  ok = ok && logger->GetDropped() == 0 && logged.size() >= recording.size() &&
+       logged.compare(logged.size() - recording.size(), recording.size(), recording) == 0;
+  ok = ok && stalled->GetReceived() == GpsSubscriptionCapacity &&
+       stalled->GetDropped() == published - GpsSubscriptionCapacity;
+
+  // Read: every sentence and the positions of the fixes, not read: the sentences dropped or waiting in the terminal
+  ok = ok && lost == 0 && written + dropped == sentences &&
+       (read ? dropped == 0 && received == written : received == 0);
+  ok = ok && (!read || (pipedFixes == fixes && piped.latitude == expected.latitude &&
+                        piped.longitude == expected.longitude && piped.TimeOfDay() == expected.TimeOfDay()));
+  ok = ok && ::access(link.c_str(), F_OK) != 0;
+
+  printf("%-16s %6zu fixes %6llu chunks %6zu sentences %6llu on pty %6llu dropped   stalled %6llu lost  %s\n", name,
+         fixes, static_cast<unsigned long long>(published), sentences, static_cast<unsigned long long>(written),
+         static_cast<unsigned long long>(dropped), static_cast<unsigned long long>(stalled->GetDropped()),
+         ok ? "ok" : "FAILED");
+  fflush(stdout);
+
+  passed = passed && ok;
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Fix trust
+
+//-----------------------------------------------------------------------------
+struct Sky {
+  size_t  satellites;                                     // Used, all in view
+  int32_t snr;                                            // dBHz
+  size_t  low;                                            // Of them at 10 degrees
+  float   hdop;
+  bool    fix;
+};
+//-----------------------------------------------------------------------------
+/**
+ * @brief An epoch of a receiver: RMC, GGA, GSA and GSV of the GPS satellites from 1, at second seconds.
+ */
+std::string SkyEpoch(uint32_t second, const Sky & sky) {
+  char        time[16];
+  char        body[160];
+  std::string sentences;
+  std::string used;
+
+  snprintf(time, sizeof(time), "12%02u%02u.00", second / 60 % 60, second % 60);
+
+  snprintf(body, sizeof(body), "GPRMC,%s,%c,4527.8522,N,00911.3989,E,0.0,0.0,161026,,,A", time, sky.fix ? 'A' : 'V');
+  sentences += Sentence(body);
+  snprintf(body, sizeof(body), "GPGGA,%s,4527.8522,N,00911.3989,E,%d,%02zu,%.1f,121.4,M,47.3,M,,", time,
+           sky.fix ? 1 : 0, sky.fix ? sky.satellites : 0, sky.fix ? sky.hdop : 99.99f);
+  sentences += Sentence(body);
+
+  for (size_t index = 0; index < 12; index++) {
+    used += index < sky.satellites && sky.fix ? "," + std::to_string(index + 1) : ",";
+  }
+  snprintf(body, sizeof(body), "GPGSA,A,%d%s,%.2f,%.2f,%.2f", sky.fix ? 3 : 1, used.c_str(),
+           sky.fix ? sky.hdop * 1.4f : 99.99f, sky.fix ? sky.hdop : 99.99f, sky.fix ? sky.hdop : 99.99f);
+  sentences += Sentence(body);
+
+  // Four satellites per GSV
+  size_t messages { (sky.satellites + 3) / 4 };
+
+  for (size_t message = 0; message < messages; message++) {
+    int32_t length { snprintf(body, sizeof(body), "GPGSV,%zu,%zu,%02zu", messages, message + 1, sky.satellites) };
+
+    for (size_t index = message * 4; index < std::min(sky.satellites, message * 4 + 4); index++) {
+      length += snprintf(body + length, sizeof(body) - length, ",%02zu,%02zu,%03zu,%02d", index + 1,
+                         index < sky.low ? 10 : 30 + index * 5, index * 30, sky.snr + static_cast<int32_t>(index % 3));
+    }
+    sentences += Sentence(body);
+  }
+
+  return sentences;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Decode sentences as Gps does: the table follows every sentence, the trust is set on RMC and GGA.
+ * @return Trust of the last fix.
+ */
+uint8_t Evaluate(NmeaParser & parser, GpsQuality & quality, const std::string & sentences) {
+  uint8_t trust {};
+
+  parser.Feed(Bytes(sentences), sentences.size(), 0, [&](NmeaSentence sentence) {
+    quality.OnSentence(sentence, parser.GetFix());
+
+    if (sentence == NmeaSentence::Rmc || sentence == NmeaSentence::Gga) {
+      GpsFix fix { parser.GetFix() };
+
+      trust = quality.Evaluate(fix);
+    }
+  });
+
+  return trust;
+}
+//-----------------------------------------------------------------------------
+void CheckQuality(void) {
+  const Sky   open { 10, 42, 0, 0.9f, true };
+  const Sky   trees { 5, 25, 2, 3.5f, true };
+  const Sky   lost { 0, 0, 0, 0.0f, false };
+
+  NmeaParser            parser;
+  GpsQuality            quality;
+  std::vector<uint8_t>  trust;
+  float                 trend {};
+
+  Check(GpsQuality::Slot(GpsSystem::Gps, 5) == 5 && GpsQuality::Slot(GpsSystem::Unknown, 70) == 70 &&
+        GpsQuality::Slot(GpsSystem::Glonass, 65) == 65 && GpsQuality::Slot(GpsSystem::Glonass, 1) == 65 &&
+        GpsQuality::Slot(GpsSystem::Galileo, 1) == 211 && GpsQuality::Slot(GpsSystem::Galileo, 301) == 211 &&
+        GpsQuality::Slot(GpsSystem::Beidou, 1) == 97 && GpsQuality::Slot(GpsSystem::Beidou, 401) == 97 &&
+        GpsQuality::Slot(GpsSystem::Qzss, 1) == 193 && GpsQuality::Slot(GpsSystem::Qzss, 193) == 193 &&
+        GpsQuality::Slot(GpsSystem::Gps, 0) == -1 && GpsQuality::Slot(GpsSystem::Beidou, 300) == -1,
+        "satellite slots");
+
+  // A minute open, half under the trees, half open and ten seconds lost
+  for (uint32_t second = 0; second < 130; second++) {
+    trust.push_back(Evaluate(parser, quality, SkyEpoch(second, second < 60 ? open : second < 90 ? trees :
+                                                               second < 120 ? open : lost)));
+    if (second == 61) {
+      trend = quality.GetHdopTrend();
+    }
+    if (second == 59) {
+      Check(quality.GetInView() == 10 && quality.GetTracked() == 10 && quality.GetUsed() == 10 &&
+            quality.GetLowUsed() == 0 && std::fabs(quality.GetMeanSnr() - 42.9f) < 1.0f, "open sky table");
+    }
+    if (second == 89) {
+      Check(quality.GetInView() == 5 && quality.GetUsed() == 5 && quality.GetLowUsed() == 2 &&
+            quality.GetMeanSnr() < 28.0f, "trees table");
+    }
+  }
+
+  bool rising { std::is_sorted(trust.begin() + 90, trust.begin() + 120) };
+
+  printf("\n%-22s %8s %8s %8s %8s %8s\n", "trust", "open", "trees", "+1 s", "+5 s", "lost");
+  printf("%-22s %8u %8u %8u %8u %8u\n", "synthetic sky", trust[59], trust[89], trust[90], trust[94], trust[129]);
+
+  Check(trust[0] == 0 && trust[59] >= 90, "trusted in the open");
+  Check(trust[61] < GpsTrustUsable && trend > 0.5f &&
+        std::all_of(trust.begin() + 61, trust.begin() + 90, [](uint8_t value) { return value < GpsTrustUsable; }),
+        "not trusted under the trees");
+  Check(rising && trust[90] < GpsTrustUsable && trust[119] >= 90, "trusted again slowly");
+  Check(trust[129] == 0, "lost");
+
+  // NMEA 4.10: GN GSA with the system ID and the Galileo satellites numbered from 1, not the GPS ones
+  NmeaParser  multi;
+  GpsQuality  table;
+
+  Evaluate(multi, table, Sentence("GNGSA,A,3,05,11,,,,,,,,,,,1.2,0.8,0.9,1") +
+                         Sentence("GNGSA,A,3,01,07,,,,,,,,,,,1.2,0.8,0.9,3") +
+                         Sentence("GPGSV,1,1,02,05,60,045,44,11,40,120,42,1") +
+                         Sentence("GAGSV,1,1,02,01,55,200,40,07,12,300,30,7") +
+                         Sentence("GNRMC,120000.00,A,4527.8522,N,00911.3989,E,0.0,0.0,161026,,,A"));
+
+  Check(table.GetUsed() == 4 && table.GetInView() == 4 && table.GetLowUsed() == 1 &&
+        std::fabs(table.GetMeanSnr() - 39.0f) < 0.1f &&
+        table.GetSatellite(211).state == (SatelliteInView | SatelliteUsed) &&
+        table.GetSatellite(217).state == (SatelliteInView | SatelliteUsed) && table.GetSatellite(1).state == 0 &&
+        table.GetSatellite(7).state == 0, "NMEA 4.10 system ID");
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief The recording: table at the end, trust over the walk and cost of a sentence.
+ */
+void MeasureQuality(const std::string & log, int64_t durationNS) {
+  NmeaParser  parser;
+  GpsQuality  quality;
+  size_t      sentences {};
+  size_t      fixes {};
+  size_t      usable {};
+  uint32_t    sum {};
+  uint8_t     low { 100 };
+  int64_t     start {};
+  int64_t     elapsed {};
+  size_t      rounds {};
+
+  parser.Feed(Bytes(log), log.size(), 0, [&](NmeaSentence sentence) {
+    quality.OnSentence(sentence, parser.GetFix());
+
+    if ((sentence == NmeaSentence::Rmc || sentence == NmeaSentence::Gga) && parser.GetFix().quality != 0) {
+      GpsFix  fix { parser.GetFix() };
+      uint8_t trust { quality.Evaluate(fix) };
+
+      fixes++;
+      usable += trust >= GpsTrustUsable;
+      sum += trust;
+      low = std::min(low, trust);
+    }
+  });
+
+  // Sentences already decoded: the cost of the table and of the trust only
+  std::vector<std::pair<NmeaSentence, GpsFix>> decoded;
+  NmeaParser                                   again;
+
+  again.Feed(Bytes(log), log.size(), 0, [&](NmeaSentence sentence) {
+    decoded.emplace_back(sentence, again.GetFix());
+  });
+
+  start = ThreadCpu();
+  do {
+    GpsQuality measured;
+
+    for (std::pair<NmeaSentence, GpsFix> & sentence : decoded) {
+      measured.OnSentence(sentence.first, sentence.second);
+      if (sentence.first == NmeaSentence::Rmc || sentence.first == NmeaSentence::Gga) {
+        measured.Evaluate(sentence.second);
+      }
+    }
+    sentences += decoded.size();
+    rounds++;
+    elapsed = ThreadCpu() - start;
+  } while (elapsed < durationNS);
+
+  printf("%-22s %4u in view %4u used   snr %5.1f dBHz   hdop %4.2f   trust %3u min %3u mean %5.1f%% usable"
+         "   %5.1f ns/sentence\n", "recording NMEA", quality.GetInView(), quality.GetUsed(), quality.GetMeanSnr(),
+         quality.GetHdop(), low, fixes > 0 ? sum / static_cast<uint32_t>(fixes) : 0, 100.0 * usable / fixes,
+         static_cast<double>(elapsed) / sentences);
+
+  Check(quality.GetInView() == 14 && quality.GetUsed() == 12 && quality.GetTrust() >= GpsTrustUsable &&
+        usable > fixes * 9 / 10, "trust on the recording");
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+  bool        quick { argc > 1 && strcmp(argv[1], "--quick") == 0 };
+  std::string nmeaLog { Load(NmeaLog) };
+  std::string ubxLog { Load(UbxLog) };
+  std::string stateFile { "/tmp/gps-bench-" + std::to_string(getpid()) + ".state" };
+  std::string trackFile { "/tmp/gps-bench-" + std::to_string(getpid()) + ".track" };
+
+  CheckUbx();
+  CheckState(stateFile);
+  CheckTrack(trackFile);
+  CheckReplay();
+  printf("UBX, state, track and replay checks: %s\n", passed ? "ok" : "FAILED");
+
+  Compare(nmeaLog, ubxLog, quick ? QuickMeasureNS : MeasureNS);
+  MeasureTrack(nmeaLog, trackFile, quick ? QuickMeasureNS : MeasureNS);
+
+  printf("\n");
+  MeasureClock(quick ? QuickMeasureNS : MeasureNS);
+  SimulateClocks("sentences 9600", false, 60 * NanosecondsPerMillisecond, 30 * NanosecondsPerMillisecond,
+                 10 * NanosecondsPerMillisecond);
+  SimulateClocks("sentences 115200", false, 25 * NanosecondsPerMillisecond, 5 * NanosecondsPerMillisecond,
+                 10 * NanosecondsPerMillisecond);
+  SimulateClocks("PPS", true, 60 * NanosecondsPerMillisecond, 30 * NanosecondsPerMillisecond,
+                 100 * NanosecondsPerMicrosecond);
+  SimulateClocks("sentences, 60 s lost", false, 60 * NanosecondsPerMillisecond, 30 * NanosecondsPerMillisecond,
+                 10 * NanosecondsPerMillisecond, 60 * NanosecondsPerSecond);
+  SimulateClocks("PPS, 60 s lost", true, 60 * NanosecondsPerMillisecond, 30 * NanosecondsPerMillisecond,
+                 10 * NanosecondsPerMillisecond, 60 * NanosecondsPerSecond);
+
+  printf("\n");
+  RunPipeline("pty NMEA", nmeaLog, GpsProtocol::Nmea, std::string(), trackFile);
+  ::unlink(trackFile.c_str());
+  RunPipeline("pty UBX", ubxLog, GpsProtocol::Ubx);
+
+  // Cold start saving the state, then a start aided by it
+  RunPipeline("pty UBX cold", ubxLog, GpsProtocol::Ubx, stateFile);
+  RunPipeline("pty UBX aided", ubxLog, GpsProtocol::Ubx, stateFile);
+  ::unlink(stateFile.c_str());
+
+  printf("\n");
+  RunReplay("replay NMEA", NmeaLog, nmeaLog, GpsProtocol::Nmea, quick ? "20" : "10");
+  RunReplay("replay UBX", UbxLog, ubxLog, GpsProtocol::Ubx, quick ? "20" : "10");
+  RunReplay("replay NMEA max", NmeaLog, nmeaLog, GpsProtocol::Nmea, "max");
+  RunReplay("replay UBX max", UbxLog, ubxLog, GpsProtocol::Ubx, "max");
+
+  CheckEpochs("/tmp/gps-bench-" + std::to_string(getpid()) + ".nmea");
+  CheckFilter("/tmp/gps-bench-" + std::to_string(getpid()) + ".nmea");
+  FilterRecording("recording NMEA", nmeaLog, GpsProtocol::Nmea, quick ? QuickMeasureNS : MeasureNS);
+  FilterRecording("recording UBX", ubxLog, GpsProtocol::Ubx, quick ? QuickMeasureNS : MeasureNS);
+
+  CheckStream();
+  MeasureStream(quick ? QuickMeasureNS : MeasureNS);
+  printf("\n");
+  // With a sentence Gps rejects, its checksum valid: the tools on the pseudo terminal get it all the same
+  RunFanOut("fan out NMEA", nmeaLog + Sentence("GPGGA,123519.00,48O7.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,"),
+            GpsProtocol::Nmea, "/tmp/gps-bench-" + std::to_string(getpid()) + ".pty", true);
+  RunFanOut("fan out UBX", ubxLog, GpsProtocol::Ubx, "/tmp/gps-bench-" + std::to_string(getpid()) + ".pty", true);
+  RunFanOut("fan out unread", nmeaLog, GpsProtocol::Nmea, "/tmp/gps-bench-" + std::to_string(getpid()) + ".pty", false);
+
+  CheckQuality();
+  MeasureQuality(nmeaLog, quick ? QuickMeasureNS : MeasureNS);
+
+  return passed ? 0 : 1;
+}
+//-----------------------------------------------------------------------------
@@ -0,0 +1,358 @@
+/**
+ *******************************************************************************
+ * @file nmea-bench.cpp
+ *
+ * @brief Correctness checks and throughput benchmark of the NMEA parser
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ *
+ * The parser is first checked against hand decoded sentences and broken input,
+ * then every log is decoded over and over, fed in chunks of different sizes as
+ * a serial port delivers them. The same logs are decoded by a getline/split/
+ * stod parser, the way it is usually written, as a reference.
+ *
+ * The logs are NMEA as sent by a receiver, one sentence per line. The default
+ * one is a 10 Hz multi constellation walk, GN talkers and GSV every second.
+ *
+ * Usage: nmea-bench [--quick] [log.nmea ...]
+ */
+#include <time.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <gps/nmea.hpp>
+#include <drivers/clock.hpp>
+
+using namespace Airsoft;
+using namespace Airsoft::Drivers;
+
+namespace {
+
+// Default log, relative to the build folder
+constexpr const char * DefaultLog = "../bench/data/walk-10hz.nmea";
+
+// Minimum run time of every measure
+constexpr int64_t MeasureNS = NanosecondsPerSecond / 2;
+constexpr int64_t QuickMeasureNS = NanosecondsPerSecond / 20;
+
+bool passed { true };
+
+//-----------------------------------------------------------------------------
+int64_t ThreadCpu(void) {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return static_cast<int64_t>(time.tv_sec) * NanosecondsPerSecond + time.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char * what) {
+  if (!condition) {
+    printf("check failed: %s\n", what);
+    passed = false;
+  }
+}
+//-----------------------------------------------------------------------------
+size_t Feed(NmeaParser & parser, const std::string & data, size_t chunk = 0) {
+  size_t sentences {};
+
+  if (chunk == 0) {
+    chunk = data.size();
+  }
+
+  for (size_t offset = 0; offset < data.size(); offset += chunk) {
+    parser.Feed(reinterpret_cast<const uint8_t*>(data.data()) + offset, std::min(chunk, data.size() - offset), 0,
+                [&](NmeaSentence) { sentences++; });
+  }
+
+  return sentences;
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Correctness
+
+//-----------------------------------------------------------------------------
+void CheckDecoding(void) {
+  NmeaParser      parser;
+  const GpsFix &  fix { parser.GetFix() };
+
+  // Fields of the common NMEA examples
+  Feed(parser, "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n");
+  Check(parser.GetSentences() == 1, "GGA decoded");
+  Check(fix.latitude == 481173000 && fix.longitude == 115166667, "GGA position");
+  Check(fix.hour == 12 && fix.minute == 35 && fix.second == 19 && fix.millisecond == 0, "GGA time");
+  Check(fix.quality == 1 && fix.satellitesUsed == 8, "GGA quality");
+  Check(std::fabs(fix.altitude - 545.4f) < 1e-3f && std::fabs(fix.geoidSeparation - 46.9f) < 1e-3f, "GGA altitude");
+  Check(fix.Has(FixHasTime | FixHasPosition | FixHasAltitude), "GGA flags");
+
+  Feed(parser, "$GPRMC,225446.25,A,4916.45,N,12311.12,W,000.5,054.7,191124,020.3,E*4A\r\n");
+  Check(fix.latitude == 492741667 && fix.longitude == -1231853333, "RMC position");
+  Check(fix.millisecond == 250 && fix.day == 19 && fix.month == 11 && fix.year == 2024, "RMC time and date");
+  Check(std::fabs(fix.speed - 0.5f * 1852.0f / 3600.0f) < 1e-4f && std::fabs(fix.course - 54.7f) < 1e-3f, "RMC motion");
+
+  Feed(parser, "$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n");
+  Check(fix.mode == 3 && fix.usedCount == 5 && fix.used[0] == 4 && fix.used[4] == 24, "GSA satellites");
+  Check(std::fabs(fix.pdop - 2.5f) < 1e-4f && std::fabs(fix.hdop - 1.3f) < 1e-4f && fix.Has(FixHasDop), "GSA DOP");
+
+  Feed(parser, "$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n");
+  Check(std::fabs(fix.course - 54.7f) < 1e-3f && std::fabs(fix.speed - 10.2f / 3.6f) < 1e-4f, "VTG motion");
+
+  // NMEA 4.10: one GN GSA per constellation, the system ID after the VDOP
+  Feed(parser, "$GNGSA,A,3,05,11,,,,,,,,,,,1.8,1.0,1.5,1*38\r\n"
+               "$GNGSA,A,3,01,07,,,,,,,,,,,1.8,1.0,1.5,3*39\r\n");
+  Check(fix.usedCount == 4 && fix.used[2] == 1 && fix.usedSystem[0] == GpsSystem::Gps &&
+        fix.usedSystem[2] == GpsSystem::Galileo && fix.usedSystem[3] == GpsSystem::Galileo, "GSA system ID");
+
+  Feed(parser, "$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75\r\n"
+               "$GPGSV,2,2,08,15,,,,16,40,100,*47\r\n");
+  Check(fix.satelliteCount == 6 && fix.Has(FixHasSatellites), "GSV satellites");
+  Check(fix.satellites[0].prn == 1 && fix.satellites[0].elevation == 40 && fix.satellites[0].azimuth == 83 &&
+        fix.satellites[0].snr == 46 && fix.satellites[0].system == GpsSystem::Gps, "GSV first satellite");
+  Check(fix.satellites[4].prn == 15 && fix.satellites[4].snr == -1 && fix.satellites[5].snr == -1, "GSV untracked");
+
+  // No fix: the position is dropped, the time is kept
+  Feed(parser, "$GNRMC,095957.00,V,,,,,,,,,,N*64\r\n");
+  Check(!fix.Has(FixHasPosition) && fix.Has(FixHasTime) && fix.second == 57, "RMC without fix");
+
+  Check(parser.GetChecksumErrors() == 0 && parser.GetFieldErrors() == 0, "no errors on valid input");
+}
+//-----------------------------------------------------------------------------
+void CheckBrokenInput(void) {
+  NmeaParser      parser;
+  const GpsFix &  fix { parser.GetFix() };
+  std::string     valid { "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n" };
+
+  // Wrong checksum, missing checksum and a sentence truncated by the next one
+  Feed(parser, "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*48\r\n"
+               "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,\r\n"
+               "$GPGGA,123519,4807.0$GPTXT,01,01,02,ANTSTATUS=OK*3B\r\n");
+  Check(parser.GetChecksumErrors() == 3 && parser.GetSentences() == 0 && parser.GetUnknown() == 1, "checksum errors");
+
+  // Too long, then a valid sentence is still decoded
+  Feed(parser, "$GPGGA" + std::string(200, ',') + "*00\r\n" + valid);
+  Check(parser.GetOverflows() == 1 && parser.GetSentences() == 1, "overflow and resync");
+
+  // Malformed field with a valid checksum, the fix is untouched
+  Feed(parser, "$GPGGA,123519,48x7.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*0F\r\n");
+  Check(parser.GetFieldErrors() == 1 && fix.latitude == 481173000, "field errors");
+
+  // Byte by byte, the same result as a whole
+  NmeaParser whole;
+  NmeaParser single;
+  std::string stream;
+
+  for (size_t index = 0; index < 100; index++) {
+    stream += valid;
+  }
+  Check(Feed(whole, stream) == 100 && Feed(single, stream, 1) == 100, "chunked input");
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Reference parser, getline and a string per field
+
+//-----------------------------------------------------------------------------
+struct NaiveFix {
+  double latitude {};
+  double longitude {};
+  double altitude {};
+  double speed {};
+  double hdop {};
+};
+//-----------------------------------------------------------------------------
+double NaiveCoordinate(const std::string & value, const std::string & hemisphere) {
+  if (value.empty()) {
+    return 0;
+  }
+
+  double raw { std::stod(value) };
+  double degrees { std::floor(raw / 100) };
+  double result { degrees + (raw - degrees * 100) / 60 };
+
+  return hemisphere == "S" || hemisphere == "W" ? -result : result;
+}
+//-----------------------------------------------------------------------------
+size_t NaiveFeed(const std::string & data, NaiveFix & fix) {
+  std::istringstream stream(data);
+  std::string        line;
+  size_t             sentences {};
+
+  while (std::getline(stream, line)) {
+    size_t star { line.find('*') };
+    if (line.empty() || line[0] != '$' || star == std::string::npos) {
+      continue;
+    }
+
+    uint8_t checksum {};
+    for (size_t index = 1; index < star; index++) {
+      checksum ^= static_cast<uint8_t>(line[index]);
+    }
+    if (std::stoul(line.substr(star + 1, 2), nullptr, 16) != checksum) {
+      continue;
+    }
+
+    std::vector<std::string> fields;
+    std::istringstream       body(line.substr(1, star - 1));
+    std::string              field;
+
+    while (std::getline(body, field, ',')) {
+      fields.push_back(field);
+    }
+
+    if (fields.size() > 9 && fields[0].compare(2, 3, "GGA") == 0) {
+      fix.latitude = NaiveCoordinate(fields[2], fields[3]);
+      fix.longitude = NaiveCoordinate(fields[4], fields[5]);
+      fix.altitude = fields[9].empty() ? 0 : std::stod(fields[9]);
+      fix.hdop = fields[8].empty() ? 0 : std::stod(fields[8]);
+    } else if (fields.size() > 8 && fields[0].compare(2, 3, "RMC") == 0) {
+      fix.latitude = NaiveCoordinate(fields[3], fields[4]);
+      fix.longitude = NaiveCoordinate(fields[5], fields[6]);
+      fix.speed = fields[7].empty() ? 0 : std::stod(fields[7]);
+    }
+    sentences++;
+  }
+
+  return sentences;
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Benchmark
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Repeat decode over the log for at least durationNS, print the rate per sentence.
+ *        decode returns the number of sentences decoded.
+ */
+template<typename Decode>
+void Measure(const char * name, const std::string & log, size_t epochs, int64_t durationNS, Decode decode) {
+  size_t  sentences {};
+  size_t  rounds {};
+  int64_t start { ThreadCpu() };
+  int64_t elapsed {};
+
+  do {
+    sentences += decode();
+    rounds++;
+    elapsed = ThreadCpu() - start;
+  } while (elapsed < durationNS);
+
+  double nsPerSentence { sentences > 0 ? static_cast<double>(elapsed) / sentences : 0.0 };
+  double nsPerEpoch { epochs > 0 ? static_cast<double>(elapsed) / (rounds * epochs) : 0.0 };
+
+  // Share of a core used at 10 fixes per second
+  printf("%-22s %12.0f %10.1f %10.1f %12.1f %11.4f%%\n", name, nsPerSentence > 0 ? 1e9 / nsPerSentence : 0.0,
+         log.size() * rounds / (elapsed / 1e9) / 1e6, nsPerSentence, nsPerEpoch / 1e3, nsPerEpoch * 10 / 1e9 * 100);
+  fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+bool Benchmark(const char * path, int64_t durationNS) {
+  std::ifstream     file(path, std::ios::binary);
+  std::stringstream content;
+
+  if (!file) {
+    printf("nmea-bench: can't open %s\n", path);
+    return false;
+  }
+  content << file.rdbuf();
+
+  std::string log { content.str() };
+  NmeaParser  parser;
+  size_t      sentences { Feed(parser, log) };
+  size_t      epochs {};
+
+  // Epoch: a new second or tenth of second of the RMC
+  {
+    NmeaParser  epochParser;
+    uint32_t    last { UINT32_MAX };
+
+    epochParser.Feed(reinterpret_cast<const uint8_t*>(log.data()), log.size(), 0, [&](NmeaSentence sentence) {
+      if (sentence == NmeaSentence::Rmc && epochParser.GetFix().TimeOfDay() != last) {
+        last = epochParser.GetFix().TimeOfDay();
+        epochs++;
+      }
+    });
+  }
+
+  printf("\n%s: %zu bytes, %zu sentences, %zu epochs, %llu not decoded, %llu checksum errors, %llu field errors\n",
+         path, log.size(), sentences, epochs, static_cast<unsigned long long>(parser.GetUnknown()),
+         static_cast<unsigned long long>(parser.GetChecksumErrors()),
+         static_cast<unsigned long long>(parser.GetFieldErrors()));
+  printf("%-22s %12s %10s %10s %12s %12s\n", "parser", "sentences/s", "MB/s", "ns/sent", "us/epoch", "cpu @10Hz");
+
+  const size_t chunks[] { 1, 16, 64, 4096 };
+
+  for (size_t chunk : chunks) {
+    char name[32];
+
+    snprintf(name, sizeof(name), "NmeaParser %zu B", chunk);
+    Measure(name, log, epochs, durationNS, [&] { return Feed(parser, log, chunk); });
+  }
+
+  NaiveFix naive;
+  Measure("getline/split/stod", log, epochs, durationNS, [&] { return NaiveFeed(log, naive); });
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+  std::vector<const char *> logs;
+  bool                      quick {};
+
+  for (int index = 1; index < argc; index++) {
+    if (strcmp(argv[index], "--quick") == 0) {
+      quick = true;
+    } else {
+      logs.push_back(argv[index]);
+    }
+  }
+
+  if (logs.empty()) {
+    logs.push_back(DefaultLog);
+  }
+
+  CheckDecoding();
+  CheckBrokenInput();
+  printf("decoding checks: %s\n", passed ? "ok" : "FAILED");
+
+  for (const char * log : logs) {
+    if (!Benchmark(log, quick ? QuickMeasureNS : MeasureNS)) {
+      passed = false;
+    }
+  }
+
+  return passed ? 0 : 1;
+}
+//-----------------------------------------------------------------------------
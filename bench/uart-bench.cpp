@@ -0,0 +1,1308 @@
+/**
+ *******************************************************************************
+ * @file uart-bench.cpp
+ *
+ * @brief Pseudo terminal loopback test and benchmark of the Uarts driver
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ *
+ * Every test drives a Uarts opened on the slave side of an openpty pair, the
+ * other end is fed (or drained) by a second thread through the master side.
+ * The data is verified byte by byte, so the harness fails (exit code 1) on any
+ * loss or corruption, and the numbers are reproducible on any Linux box.
+ *
+ * The baudrate of a pty doesn't throttle the data, it only changes the byte
+ * time used by the driver to wait for the missing bytes of a read.
+ *
+ * First the checks: the framer encodes and decodes frames of every encoding
+ * fed in chunks of any size, with the corner cases of each (COBS blocks of 254
+ * bytes, SLIP escapes, empty, oversize and malformed frames followed by good
+ * ones), also through a port with GetFrame and ReadFrame. Then every error
+ * of the Try calls (not open, timeout with and without partial data, a write
+ * refused by a full transmit queue, a system error with its errno, a hang up)
+ * and the exception the throwing calls raise for the same failure. Last the
+ * reactor: asynchronous reads, lines and writes completing in order, on
+ * timeout with the partial data, failed by Unregister; delayed tasks; and the
+ * transmit queue of a registered port refusing whole frames, drained when the
+ * port becomes writable, not holding back what is received while a frame
+ * leaves at 9600 baud.
+ *
+ * Usage: uart-bench [--quick]
+ */
+#include <pty.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <time.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <iostream>
+
+#include <drivers/uarts.hpp>
+#include <drivers/uart-reactor.hpp>
+#include <drivers/uarts/framer.hpp>
+#include <drivers/clock.hpp>
+
+using namespace Airsoft::Drivers;
+
+namespace {
+
+// Time without progress before a test is declared failed
+constexpr int64_t StallTimeoutNS = 3 * NanosecondsPerSecond;
+
+// Size of the writes done by the feeder
+constexpr size_t FeedChunk = 4096;
+
+bool passed { true };
+
+struct TimeoutCase {
+  const char *  name;
+  Timeout       timeout;
+};
+
+struct Result {
+  std::string           test;
+  uint32_t              baudrate {};
+  const char *          timeout {};
+  size_t                bytes {};
+  size_t                lines {};
+  int64_t               wallNS {};
+  int64_t               cpuNS {};
+  std::vector<int64_t>  latencies;
+  bool                  passed {};
+};
+
+//-----------------------------------------------------------------------------
+int64_t Now(void) {
+  return Clock::Monotonic().Now();
+}
+//-----------------------------------------------------------------------------
+int64_t ThreadCpu(void) {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return static_cast<int64_t>(time.tv_sec) * NanosecondsPerSecond + time.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+void Check(bool condition, const char * what) {
+  if (!condition) {
+    printf("check failed: %s\n", what);
+    passed = false;
+  }
+}
+//-----------------------------------------------------------------------------
+const uint8_t * Bytes(const std::string & data) {
+  return reinterpret_cast<const uint8_t*>(data.data());
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Pseudo terminal pair, the master side is raw and non blocking
+
+//-----------------------------------------------------------------------------
+class Loopback final {
+public:
+  Loopback() {
+    char name[128] {};
+
+    if (openpty(&_master, &_slave, name, nullptr, nullptr) == -1) {
+      return;
+    }
+
+    // No echo or translation on the master side
+    termios options;
+    tcgetattr(_master, &options);
+    cfmakeraw(&options);
+    tcsetattr(_master, TCSANOW, &options);
+
+    fcntl(_master, F_SETFL, fcntl(_master, F_GETFL) | O_NONBLOCK);
+
+    _name = name;
+  }
+  ~Loopback() {
+    if (_master != -1) {
+      ::close(_master);
+    }
+    // The slave is held open for the whole test, so the master never sees a hang up
+    if (_slave != -1) {
+      ::close(_slave);
+    }
+  }
+
+  bool inline IsValid(void) const {
+    return !_name.empty();
+  }
+
+  const std::string & Name(void) const {
+    return _name;
+  }
+
+  /**
+   * @brief Close the master side, the port on the slave side sees a hang up.
+   */
+  void CloseMaster(void) {
+    if (_master != -1) {
+      ::close(_master);
+      _master = -1;
+    }
+  }
+
+  /**
+   * @brief Write all the data to the master side, optionally a line at a time with a pause between them.
+   *        Stops early when stop is set. The send time of every line is stored in sent.
+   */
+  void Feed(const std::string & data, const std::atomic<bool> & stop, size_t lineLength = 0,
+            int64_t intervalNS = 0, std::atomic<int64_t> * sent = nullptr) {
+    size_t offset {};
+    size_t line {};
+    size_t chunk { lineLength > 0 ? lineLength : FeedChunk };
+
+    while (offset < data.size() && !stop) {
+      size_t length { std::min(chunk, data.size() - offset) };
+
+      if (sent != nullptr) {
+        sent[line++].store(Now());
+      }
+
+      if (!WriteAll(data.data() + offset, length, stop)) {
+        return;
+      }
+      offset += length;
+
+      if (intervalNS > 0) {
+        timespec pause { 0, static_cast<long>(intervalNS) };
+        nanosleep(&pause, nullptr);
+      }
+    }
+  }
+
+  /**
+   * @brief Read from the master side comparing with the expected data, until all has been received,
+   *        a mismatch, nothing arrives for StallTimeoutNS or stop is set. Nothing past the expected data is read.
+   *        With byteNS the data is taken a byte at a time with a pause between them, as a slow line would.
+   */
+  bool Drain(const std::string & expected, const std::atomic<bool> & stop, int64_t byteNS = 0) {
+    std::vector<char> buffer(byteNS > 0 ? 1 : FeedChunk);
+    size_t            offset {};
+    int64_t           progress { Now() };
+
+    while (offset < expected.size() && !stop && Now() - progress < StallTimeoutNS) {
+      pollfd fd { _master, POLLIN, 0 };
+      if (poll(&fd, 1, 100) <= 0) {
+        continue;
+      }
+
+      ssize_t length { ::read(_master, buffer.data(), std::min(buffer.size(), expected.size() - offset)) };
+      if (length <= 0) {
+        continue;
+      }
+
+      if (byteNS > 0) {
+        timespec pause { 0, static_cast<long>(byteNS) };
+        nanosleep(&pause, nullptr);
+      }
+
+      if (offset + length > expected.size() || memcmp(buffer.data(), expected.data() + offset, length) != 0) {
+        return false;
+      }
+      offset += length;
+      progress = Now();
+    }
+
+    return offset == expected.size();
+  }
+
+private:
+  bool WriteAll(const char * data, size_t length, const std::atomic<bool> & stop) {
+    while (length > 0) {
+      if (stop) {
+        return false;
+      }
+
+      pollfd fd { _master, POLLOUT, 0 };
+      if (poll(&fd, 1, 100) <= 0) {
+        continue;
+      }
+
+      ssize_t written { ::write(_master, data, length) };
+      if (written > 0) {
+        data += written;
+        length -= written;
+      }
+    }
+
+    return true;
+  }
+
+private:
+  int32_t     _master { -1 };
+  int32_t     _slave { -1 };
+  std::string _name;
+};
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Test data
+
+//-----------------------------------------------------------------------------
+std::string MakeSentence(size_t index) {
+  char    sentence[96];
+  uint8_t checksum {};
+
+  // NMEA like sentence, 70-80 bytes as a receiver sends them
+  int32_t length = snprintf(sentence, sizeof(sentence), "$GPGGA,%06zu.00,4530.1234,N,00912.5678,E,1,08,0.9,%03zu.0,M,47.0,M,,",
+                            index % 240000, index % 1000);
+
+  for (int32_t i = 1; i < length; i++) {
+    checksum ^= static_cast<uint8_t>(sentence[i]);
+  }
+
+  snprintf(sentence + length, sizeof(sentence) - length, "*%02X\r\n", checksum);
+
+  return sentence;
+}
+//-----------------------------------------------------------------------------
+std::string MakeStream(size_t bytes, size_t & lines) {
+  std::string stream;
+
+  lines = 0;
+  stream.reserve(bytes + 96);
+
+  while (stream.size() < bytes) {
+    stream += MakeSentence(lines++);
+  }
+
+  return stream;
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Framer
+
+//-----------------------------------------------------------------------------
+std::string Encode(FrameEncoding encoding, const std::string & payload) {
+  std::vector<uint8_t> output(Framer::MaxEncodedSize(encoding, payload.size()));
+  size_t               length { Framer::Encode(encoding, Bytes(payload), payload.size(), output.data(),
+                                               output.size()) };
+
+  return std::string(reinterpret_cast<const char*>(output.data()), length);
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Decode data in chunks of chunk bytes.
+ */
+std::vector<std::string> Decode(Framer & framer, const std::string & data, size_t chunk) {
+  std::vector<std::string> frames;
+
+  for (size_t offset = 0; offset < data.size(); offset += chunk) {
+    framer.Feed(Bytes(data) + offset, std::min(chunk, data.size() - offset), [&](const uint8_t * frame,
+                                                                                   size_t length) {
+      frames.emplace_back(reinterpret_cast<const char*>(frame), length);
+    });
+  }
+
+  return frames;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Payload of length bytes, zeros and the SLIP bytes among them unless run, a block without zeros.
+ */
+std::string MakePayload(size_t length, uint32_t seed, bool run = false) {
+  const uint8_t special[] { 0x00, 0xC0, 0xDB, 0xDC, 0xDD, 0xFF };
+  std::string   payload(length, '\0');
+
+  for (size_t index = 0; index < length; index++) {
+    seed = seed * 1103515245 + 12345;
+    payload[index] = static_cast<char>(run ? 1 + (seed >> 16) % 255 :
+                                       ((seed >> 16) % 4 == 0 ? special[(seed >> 8) % sizeof(special)] : seed >> 24));
+  }
+
+  return payload;
+}
+//-----------------------------------------------------------------------------
+void CheckFramer(void) {
+  const FrameEncoding encodings[] { FrameEncoding::Length8, FrameEncoding::Length16, FrameEncoding::Cobs,
+                                    FrameEncoding::Slip };
+  const char *        names[] { "Length8", "Length16", "COBS", "SLIP" };
+  const size_t        chunks[] { 1, 2, 3, 7, 64, 1 << 16 };
+
+  for (size_t index = 0; index < 4; index++) {
+    FrameEncoding             encoding { encodings[index] };
+    size_t                    maxFrame { encoding == FrameEncoding::Length8 ? 255u : 600u };
+    std::vector<std::string>  payloads;
+    std::string               stream;
+    char                      what[96];
+
+    // Every size around the COBS blocks, the largest frame, runs of 254 and 508 bytes without zeros
+    for (size_t length : { 1, 2, 31, 253, 254, 255, 256, 300, 509, 600 }) {
+      if (length <= maxFrame) {
+        payloads.push_back(MakePayload(length, static_cast<uint32_t>(length)));
+      }
+    }
+    for (size_t length : { 253, 254, 255, 508 }) {
+      if (length < maxFrame) {
+        payloads.push_back(MakePayload(length, static_cast<uint32_t>(length), true));
+        payloads.push_back(MakePayload(length, static_cast<uint32_t>(length), true) + std::string(1, '\0'));
+      }
+    }
+    payloads.push_back(std::string(40, static_cast<char>(0xC0)) + std::string(40, static_cast<char>(0xDB)));
+    payloads.push_back(std::string(40, '\0'));
+
+    for (const std::string & payload : payloads) {
+      stream += Encode(encoding, payload);
+    }
+
+    // Same frames whatever the chunks
+    for (size_t chunk : chunks) {
+      Framer framer(encoding, maxFrame);
+
+      snprintf(what, sizeof(what), "%s round trip in chunks of %zu", names[index], chunk);
+      Check(Decode(framer, stream, chunk) == payloads && framer.GetFrames() == payloads.size() &&
+            framer.GetErrors() == 0 && framer.GetOverflows() == 0, what);
+    }
+
+    // Empty payload: encoded, skipped by the decoder
+    {
+      uint8_t output[4] {};
+      size_t  length { Framer::Encode(encoding, nullptr, 0, output, sizeof(output)) };
+      Framer  framer(encoding, maxFrame);
+
+      snprintf(what, sizeof(what), "%s empty frame", names[index]);
+      Check(length == Framer::MaxEncodedSize(encoding, 0) &&
+            Decode(framer, std::string(reinterpret_cast<const char*>(output), length) + Encode(encoding, "A"), 1) ==
+            std::vector<std::string> { "A" }, what);
+    }
+
+    // Output too small
+    {
+      std::string payload { MakePayload(100, 7) };
+      uint8_t     output[200] {};
+
+      snprintf(what, sizeof(what), "%s output too small", names[index]);
+      Check(Framer::Encode(encoding, Bytes(payload), payload.size(), output,
+                           Framer::MaxEncodedSize(encoding, payload.size()) - 1) == 0, what);
+    }
+
+    // Longer than the maximum, dropped: the next frame is decoded
+    {
+      Framer framer(encoding, 64);
+      std::string good { MakePayload(64, 3) };
+
+      snprintf(what, sizeof(what), "%s oversize frame", names[index]);
+      Check(Decode(framer, Encode(encoding, MakePayload(65, 2)) + Encode(encoding, good), 5) ==
+            std::vector<std::string> { good } && framer.GetOverflows() == 1, what);
+    }
+  }
+
+  // Length8 can't represent 256 bytes
+  {
+    std::string payload(256, 'x');
+    uint8_t     output[300] {};
+
+    Check(Framer::Encode(FrameEncoding::Length8, Bytes(payload), payload.size(), output, sizeof(output)) == 0,
+          "Length8 length over 255");
+  }
+
+  // Malformed: a COBS block cut by the delimiter, a SLIP escape of a plain byte and an escape before END,
+  // each one followed by a good frame
+  {
+    Framer      cobs(FrameEncoding::Cobs, 64);
+    std::string good { MakePayload(20, 5) };
+
+    Check(Decode(cobs, std::string("\x05\x01\x02\x00", 4) + Encode(FrameEncoding::Cobs, good), 3) ==
+          std::vector<std::string> { good } && cobs.GetErrors() == 1, "COBS truncated block");
+
+    Framer slip(FrameEncoding::Slip, 64);
+
+    Check(Decode(slip, "\xC0" "ab\xDB" "cde\xC0" "fg\xDB\xC0" + Encode(FrameEncoding::Slip, good), 2) ==
+          std::vector<std::string> { good } && slip.GetErrors() == 2, "SLIP bad escapes");
+  }
+
+  // Noise before the first delimiter is dropped by the delimited encodings, Reset resynchronizes the others
+  {
+    Framer      cobs(FrameEncoding::Cobs, 64);
+    Framer      length(FrameEncoding::Length16, 64);
+    std::string good { MakePayload(30, 9) };
+
+    Check(Decode(cobs, std::string("\x00\x09noise", 7) + std::string(1, '\0') + Encode(FrameEncoding::Cobs, good),
+                 4).back() == good, "COBS noise");
+
+    Decode(length, std::string("\x00\x05" "ab", 4), 1);
+    length.Reset();
+    Check(Decode(length, Encode(FrameEncoding::Length16, good), 4) == std::vector<std::string> { good },
+          "Length16 reset");
+  }
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Frames through a port: GetFrame takes only what is buffered, ReadFrame waits for the rest of a frame
+ *        cut in two writes, the partial frame stays in the framer across a timeout.
+ */
+void CheckFrameRead(void) {
+  Loopback                  loopback;
+  std::atomic<bool>         stop {};
+  Framer                    framer(FrameEncoding::Cobs, 512);
+  std::vector<std::string>  payloads { MakePayload(10, 1), MakePayload(300, 2), MakePayload(254, 3, true) };
+  std::string               stream;
+  std::vector<std::string>  received;
+
+  if (!loopback.IsValid()) {
+    Check(false, "openpty");
+    return;
+  }
+
+  Uarts uart(loopback.Name(), 115200, Timeout::SimpleTimeout(50));
+
+  for (const std::string & payload : payloads) {
+    stream += Encode(FrameEncoding::Cobs, payload);
+  }
+
+  try {
+    uart.Open();
+
+    Check(!uart.GetFrame(framer), "GetFrame with nothing received");
+
+    // The first frame and half of the second
+    size_t half { Encode(FrameEncoding::Cobs, payloads[0]).size() + 150 };
+
+    loopback.Feed(stream.substr(0, half), stop);
+    Check(uart.ReadFrame(framer) && std::string(reinterpret_cast<const char*>(framer.GetFrame()),
+                                                framer.GetFrameLength()) == payloads[0], "ReadFrame first frame");
+    Check(uart.TryReadFrame(framer).Error() == UartError::Timeout, "TryReadFrame partial frame");
+
+    // The rest, then all of it is buffered before the frames are taken
+    loopback.Feed(stream.substr(half), stop);
+    while (uart.ReadFrame(framer)) {
+      received.emplace_back(reinterpret_cast<const char*>(framer.GetFrame()), framer.GetFrameLength());
+      if (received.size() == 2) {
+        break;
+      }
+    }
+    Check(received.size() == 2 && received[0] == payloads[1] && received[1] == payloads[2],
+          "ReadFrame across a timeout");
+
+    loopback.Feed(stream, stop);
+    uart.Receive();
+    received.clear();
+    while (uart.GetFrame(framer)) {
+      received.emplace_back(reinterpret_cast<const char*>(framer.GetFrame()), framer.GetFrameLength());
+    }
+    Check(received == payloads, "GetFrame from the receive buffer");
+  } catch (const std::exception & e) {
+    printf("frame read: %s\n", e.what());
+    Check(false, "frame read exception");
+  }
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Try API
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief True when call throws an Exception, the exception is passed to inspect.
+ */
+template<typename Exception, typename Call, typename Inspect>
+bool Throws(Call call, Inspect inspect) {
+  try {
+    call();
+  } catch (const Exception & e) {
+    return inspect(e);
+  } catch (...) {
+  }
+  return false;
+}
+//-----------------------------------------------------------------------------
+template<typename Exception, typename Call>
+bool Throws(Call call) {
+  return Throws<Exception>(call, [](const Exception &) { return true; });
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Every UartError of the Try calls, with the errno of a system error, and the same failure through the
+ *        throwing calls: NotOpen and Disconnected throw PortNotOpenedException and UartException (Available
+ *        returns 0 on a closed port), System throws IOException with the errno, Timeout and Busy return the
+ *        count without throwing.
+ */
+void CheckTryErrors(void) {
+  Loopback          loopback;
+  std::atomic<bool> stop {};
+  uint8_t           buffer[64] {};
+  std::string       line;
+
+  if (!loopback.IsValid()) {
+    Check(false, "openpty");
+    return;
+  }
+
+  Uarts uart(loopback.Name(), 115200, Timeout::SimpleTimeout(20));
+
+  // Not open
+  Check(uart.TryRead(buffer, sizeof(buffer)).Error() == UartError::NotOpen &&
+        uart.TryReadLine(line).Error() == UartError::NotOpen &&
+        uart.TryWrite(buffer, sizeof(buffer)).Error() == UartError::NotOpen &&
+        uart.TryAvailable().Error() == UartError::NotOpen, "Try calls on a closed port");
+  Check(Throws<PortNotOpenedException>([&] { uart.Read(buffer, sizeof(buffer)); }) &&
+        Throws<PortNotOpenedException>([&] { uart.Write(buffer, sizeof(buffer)); }) &&
+        uart.Available() == 0, "throwing calls on a closed port");
+
+  try {
+    uart.Open();
+
+    // Timeout, with nothing and with part of the data
+    UartResult result { uart.TryRead(buffer, sizeof(buffer)) };
+
+    Check(result.Error() == UartError::Timeout && result.Value() == 0 && !result, "TryRead timeout");
+
+    loopback.Feed("abcd", stop);
+    result = uart.TryRead(buffer, sizeof(buffer));
+    Check(result.Error() == UartError::Timeout && result.Value() == 4 && memcmp(buffer, "abcd", 4) == 0,
+          "TryRead timeout with partial data");
+
+    loopback.Feed("ef", stop);
+    result = uart.TryReadLine(line);
+    Check(result.Error() == UartError::Timeout && line == "ef", "TryReadLine timeout with partial data");
+
+    loopback.Feed("gh", stop);
+    Check(uart.Read(buffer, sizeof(buffer)) == 2 && uart.Read(buffer, sizeof(buffer)) == 0,
+          "Read returns the partial count on timeout");
+
+    // Busy: the kernel buffer is full and the queue isn't empty, a write that doesn't fit is refused whole
+    const std::string frame(48, 'x');
+    const std::string block(64, 'y');
+    size_t            writes {};
+
+    uart.SetTransmitQueue(64);
+    uart.ResetStatistics();
+    while (uart.GetTransmitPending() == 0 && writes++ < 1000000) {
+      uart.TryWrite(Bytes(frame), frame.size());
+    }
+
+    size_t pending { uart.GetTransmitPending() };
+
+    result = uart.TryWrite(Bytes(block), block.size());
+    Check(pending > 0 && result.Error() == UartError::Busy && result.Value() == 0 &&
+          uart.GetTransmitPending() == pending, "TryWrite refused by a full transmit queue");
+    Check(uart.Write(Bytes(block), block.size()) == 0 && uart.GetTransmitPending() == pending &&
+          uart.GetStatistics().TransmitRefused == 2, "Write refused by a full transmit queue");
+    uart.SetTransmitQueue(0);
+
+    // System, with errno: the descriptor is replaced by one that isn't a terminal
+    {
+      int32_t null { ::open("/dev/null", O_RDWR) };
+      int32_t fd { uart.GetDescriptor() };
+      int32_t saved { ::dup(fd) };
+
+      ::dup2(null, fd);
+      result = uart.TryAvailable();
+      Check(result.Error() == UartError::System && result.SystemError() == ENOTTY, "TryAvailable system error");
+      Check(Throws<IOException>([&] { uart.Available(); },
+                                [](const IOException & e) { return e.GetErrorNumber() == ENOTTY; }),
+            "Available throws IOException with errno");
+
+      ::dup2(saved, fd);
+      ::close(saved);
+      ::close(null);
+    }
+
+    // Disconnected: the other side hangs up
+    loopback.CloseMaster();
+    Check(uart.TryRead(buffer, sizeof(buffer)).Error() == UartError::Disconnected, "TryRead disconnected");
+    Check(Throws<UartException>([&] { uart.Read(buffer, sizeof(buffer)); }), "Read throws when disconnected");
+
+    uart.Close();
+  } catch (const std::exception & e) {
+    printf("try errors: %s\n", e.what());
+    Check(false, "try errors exception");
+  }
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Reactor
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Wait until condition is true, false if it isn't within StallTimeoutNS.
+ */
+template<typename Condition>
+bool WaitFor(Condition condition) {
+  int64_t start { Now() };
+
+  while (!condition()) {
+    if (Now() - start > StallTimeoutNS) {
+      return false;
+    }
+    timespec pause { 0, 1000000 };
+    nanosleep(&pause, nullptr);
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Numbered frame of the transmit queue tests, the fill byte tells a frame from the next.
+ */
+std::string MakeFrame(size_t index, size_t length) {
+  std::string frame(length, static_cast<char>('a' + index % 26));
+
+  snprintf(&frame[0], length, "%06zu", index);
+  frame[6] = '|';
+
+  return frame;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Fill the kernel buffer of the port and its transmit queue with numbered frames, the first one that
+ *        doesn't fit is refused whole: nothing of it is queued.
+ * @return The frames accepted, in order.
+ */
+std::string FillTransmit(Uarts & uart, size_t frameLength, bool untilQueued) {
+  std::string accepted;
+
+  for (size_t index = 0; index < 1000000; index++) {
+    std::string frame { MakeFrame(index, frameLength) };
+    size_t      pending { uart.GetTransmitPending() };
+    UartResult  result { uart.TryWrite(Bytes(frame), frame.size()) };
+
+    if (result.Error() == UartError::Busy) {
+      Check(result.Value() == 0 && uart.GetTransmitPending() == pending, "transmit queue refusal is all or nothing");
+      break;
+    }
+    if (!result) {
+      Check(false, "transmit queue write");
+      break;
+    }
+
+    accepted += frame;
+    if (untilQueued && uart.GetTransmitPending() > 0) {
+      break;
+    }
+  }
+
+  return accepted;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Completions of the asynchronous operations, in the order they have run.
+ */
+class Completions final {
+public:
+  explicit Completions(UartReactor & reactor) : _reactor(reactor) {}
+
+  UartReactor::ReadHandler Read(size_t index) {
+    return [this, index](std::string & data, bool completed) {
+      Add(index, data, completed);
+    };
+  }
+
+  UartReactor::WriteHandler Write(size_t index) {
+    return [this, index](size_t written, bool completed) {
+      Add(index, std::to_string(written), completed);
+    };
+  }
+
+  bool Wait(size_t count) {
+    return WaitFor([this, count]() { return Count() >= count; });
+  }
+
+  /**
+   * @brief True when the completions are exactly the expected ones, index data and completed, in order.
+   */
+  bool Match(const std::vector<std::tuple<size_t, std::string, bool>> & expected) {
+    std::lock_guard<std::mutex> guard(_lock);
+
+    if (_entries.size() != expected.size() || !_onThread) {
+      return false;
+    }
+    for (size_t index = 0; index < expected.size(); index++) {
+      if (std::make_tuple(_entries[index].index, _entries[index].data, _entries[index].completed) !=
+          expected[index]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * @brief Time of a completion since start, -1 if it didn't run.
+   */
+  int64_t Elapsed(size_t position, int64_t start) {
+    std::lock_guard<std::mutex> guard(_lock);
+    return position < _entries.size() ? _entries[position].time - start : -1;
+  }
+
+  void Clear(void) {
+    std::lock_guard<std::mutex> guard(_lock);
+    _entries.clear();
+  }
+
+private:
+  struct Entry {
+    size_t      index {};
+    std::string data;
+    bool        completed {};
+    int64_t     time {};
+  };
+
+  void Add(size_t index, const std::string & data, bool completed) {
+    std::lock_guard<std::mutex> guard(_lock);
+
+    _onThread = _onThread && _reactor.IsReactorThread();
+    _entries.push_back(Entry { index, data, completed, Now() });
+  }
+
+  size_t Count(void) {
+    std::lock_guard<std::mutex> guard(_lock);
+    return _entries.size();
+  }
+
+private:
+  UartReactor &       _reactor;
+  std::mutex          _lock;
+  std::vector<Entry>  _entries;
+  bool                _onThread { true };
+};
+//-----------------------------------------------------------------------------
+/**
+ * @brief Asynchronous operations of a registered port:
+ *        - reads and lines complete in the order they have been started, whatever the chunks of the data,
+ *          the port handler doesn't see the data they take, writes complete in order too,
+ *        - on timeout a read completes with the data received so far,
+ *        - Unregister fails the pending operations with their partial data, on the reactor thread,
+ *          the operations started afterwards fail at once.
+ */
+void CheckAsyncOperations(void) {
+  Loopback            loopback;
+  UartReactor         reactor;
+  std::atomic<bool>   stop {};
+  std::atomic<size_t> notified {};
+
+  if (!loopback.IsValid() || !reactor.Init()) {
+    Check(false, "openpty and reactor init");
+    return;
+  }
+
+  Uarts       uart(loopback.Name(), 115200, Timeout::SimpleTimeout(20));
+  Completions completions(reactor);
+
+  try {
+    uart.Open();
+    reactor.Register(uart, [&]() {
+      notified++;
+      uart.Receive();
+    });
+
+    // Ordering
+    reactor.ReadAsync(uart, 5, 1000, completions.Read(0));
+    reactor.ReadLineAsync(uart, 1000, completions.Read(1));
+    reactor.ReadAsync(uart, 3, 1000, completions.Read(2));
+    reactor.ReadLineAsync(uart, 1000, completions.Read(3), 65536, "\r\n");
+
+    loopback.Feed("hel", stop);
+    loopback.Feed("lofirst line\nabc", stop);
+    loopback.Feed("second\r\n", stop);
+
+    Check(completions.Wait(4) && completions.Match({ { 0, "hello", true }, { 1, "first line\n", true },
+                                                     { 2, "abc", true }, { 3, "second\r\n", true } }) &&
+          notified == 0, "ReadAsync and ReadLineAsync in order");
+
+    completions.Clear();
+    reactor.WriteAsync(uart, "first ", 1000, completions.Write(0));
+    reactor.WriteAsync(uart, "second ", 1000, completions.Write(1));
+    reactor.WriteAsync(uart, "third", 1000, completions.Write(2));
+
+    Check(loopback.Drain("first second third", stop) && completions.Wait(3) &&
+          completions.Match({ { 0, "6", true }, { 1, "7", true }, { 2, "5", true } }), "WriteAsync in order");
+
+    // Timeout with part of the data
+    int64_t start { Now() };
+
+    completions.Clear();
+    reactor.ReadAsync(uart, 10, 100, completions.Read(0));
+    loopback.Feed("abcd", stop);
+
+    Check(completions.Wait(1) && completions.Match({ { 0, "abcd", false } }) &&
+          completions.Elapsed(0, start) >= 100 * NanosecondsPerMillisecond, "ReadAsync timeout with partial data");
+
+    start = Now();
+    reactor.ReadLineAsync(uart, 100, completions.Read(1));
+    loopback.Feed("no end", stop);
+
+    Check(completions.Wait(2) && completions.Match({ { 0, "abcd", false }, { 1, "no end", false } }) &&
+          completions.Elapsed(1, start) >= 100 * NanosecondsPerMillisecond, "ReadLineAsync timeout with partial data");
+
+    // Unregister, a read with part of its data and a write the other side doesn't take
+    std::string     large(1 << 20, 'z');
+    UartStatistics  before { uart.GetStatistics() };
+    size_t          written {};
+
+    completions.Clear();
+    reactor.ReadAsync(uart, 10, Timeout::Max(), completions.Read(0));
+    reactor.WriteAsync(uart, large, Timeout::Max(), [&](size_t count, bool completed) {
+      written = count;
+      completions.Write(1)(0, completed);
+    });
+    loopback.Feed("xy", stop);
+    WaitFor([&]() {
+      UartStatistics now { uart.GetStatistics() };
+      return now.BytesRead >= before.BytesRead + 2 && now.BytesWritten > before.BytesWritten;
+    });
+    reactor.Unregister(uart);
+
+    Check(completions.Wait(2) && completions.Match({ { 0, "xy", false }, { 1, "0", false } }) && written > 0 &&
+          written < large.size(), "Unregister fails the pending operations");
+
+    completions.Clear();
+    reactor.ReadAsync(uart, 1, Timeout::Max(), completions.Read(0));
+    reactor.WriteAsync(uart, "late", Timeout::Max(), completions.Write(1));
+    Check(completions.Wait(2) && completions.Match({ { 0, "", false }, { 1, "0", false } }),
+          "operations started after Unregister fail");
+
+    uart.Close();
+  } catch (const std::exception & e) {
+    printf("async operations: %s\n", e.what());
+    Check(false, "async operations exception");
+  }
+
+  reactor.Terminate();
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Delayed tasks run on the reactor thread in the order of their deadlines, never before the delay.
+ */
+void CheckPostAfter(void) {
+  UartReactor           reactor;
+  std::atomic<int64_t>  times[2] {};
+  std::atomic<bool>     onThread { true };
+  int64_t               start { Now() };
+
+  if (!reactor.Init()) {
+    Check(false, "reactor init");
+    return;
+  }
+
+  reactor.PostAfter(60, [&]() {
+    onThread = onThread && reactor.IsReactorThread();
+    times[1] = Now();
+  });
+  reactor.PostAfter(20, [&]() {
+    onThread = onThread && reactor.IsReactorThread();
+    times[0] = Now();
+  });
+  reactor.PostAfter(60000, [&]() {
+    Check(false, "PostAfter task run after Terminate");
+  });
+
+  Check(WaitFor([&]() { return times[1] != 0; }) && times[0] != 0 && times[0] < times[1] &&
+        times[0] - start >= 20 * NanosecondsPerMillisecond && times[1] - start >= 60 * NanosecondsPerMillisecond &&
+        onThread, "PostAfter order and delay");
+
+  reactor.Terminate();
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Transmit queue of a port registered to the reactor:
+ *        - with the kernel buffer full a frame that doesn't fit the queue is refused whole and counted,
+ *        - the reactor drains the queue when the port becomes writable, nobody else calls TryTransmit,
+ *        - at 9600 baud a 200 bytes frame takes about 200ms to leave, the lines received meanwhile are
+ *          delivered as they arrive.
+ */
+void CheckTransmitQueue(void) {
+  const int64_t         byteNS { 10 * NanosecondsPerSecond / 9600 };
+  const size_t          lineCount { 5 };
+  const int64_t         lineIntervalNS { 30 * NanosecondsPerMillisecond };
+
+  Loopback              loopback;
+  UartReactor           reactor;
+  std::atomic<bool>     stop {};
+  std::mutex            lock;
+  std::vector<int64_t>  arrivals;
+  std::vector<int64_t>  stale;
+  std::atomic<int64_t>  sent[lineCount] {};
+
+  if (!loopback.IsValid() || !reactor.Init()) {
+    Check(false, "openpty and reactor init");
+    return;
+  }
+
+  Uarts uart(loopback.Name(), 9600, Timeout::SimpleTimeout(20));
+
+  try {
+    uart.Open();
+    uart.SetTransmitQueue(4096);
+
+    reactor.Register(uart, [&]() {
+      std::string line;
+
+      uart.Receive();
+      while (uart.GetLine(line)) {
+        std::lock_guard<std::mutex> guard(lock);
+        arrivals.push_back(Now());
+      }
+    });
+
+    // Refused whole, then drained by the reactor once the other side reads
+    std::string accepted { FillTransmit(uart, 100, false) };
+
+    Check(uart.GetStatistics().TransmitRefused == 1, "transmit refusal counted");
+    Check(loopback.Drain(accepted, stop) && WaitFor([&]() { return uart.GetTransmitPending() == 0; }),
+          "transmit queue drained on EPOLLOUT");
+
+    // The kernel buffer full again, a 200 bytes frame waits in the queue and leaves at 9600 baud
+    std::string       filler { FillTransmit(uart, 100, true) };
+    std::string       frame { MakeFrame(999999, 200) };
+    std::atomic<bool> pacing {};
+    int64_t           frameDone {};
+    bool              drained {};
+
+    Check(uart.TryWrite(Bytes(frame), frame.size()).Value() == frame.size(), "200 bytes frame queued");
+
+    std::thread drainer([&]() {
+      drained = loopback.Drain(filler, stop);
+      pacing = true;
+      drained = drained && loopback.Drain(frame, stop, byteNS);
+      frameDone = Now();
+    });
+
+    std::string lines;
+
+    for (size_t index = 0; index < lineCount; index++) {
+      lines += MakeSentence(index);
+    }
+
+    WaitFor([&]() { return pacing.load(); });
+    loopback.Feed(lines, stop, MakeSentence(0).size(), lineIntervalNS, sent);
+    drainer.join();
+
+    std::lock_guard<std::mutex> guard(lock);
+    bool                        prompt { arrivals.size() == lineCount };
+
+    for (size_t index = 0; prompt && index < lineCount; index++) {
+      prompt = arrivals[index] - sent[index] < 20 * NanosecondsPerMillisecond && arrivals[index] < frameDone;
+    }
+
+    Check(drained, "200 bytes frame received whole");
+    Check(prompt, "lines received while the frame drains");
+
+    reactor.Unregister(uart);
+    uart.Close();
+  } catch (const std::exception & e) {
+    printf("transmit queue: %s\n", e.what());
+    Check(false, "transmit queue exception");
+  }
+
+  reactor.Terminate();
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Tests, the consumer runs on the calling thread and is the one measured
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Check a received piece against the stream, advancing the offset.
+ */
+bool Verify(const std::string & stream, size_t & offset, const char * data, size_t length) {
+  if (offset + length > stream.size() || memcmp(stream.data() + offset, data, length) != 0) {
+    return false;
+  }
+  offset += length;
+  return true;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Run a receive test: the feeder writes the stream, receive is called until all the stream is
+ *        verified or nothing arrives for StallTimeoutNS.
+ *        receive returns false on mismatch.
+ */
+template<typename Receive>
+void RunReceive(Result & result, Loopback & loopback, const std::string & stream, Receive receive,
+                size_t lineLength = 0, int64_t intervalNS = 0, std::atomic<int64_t> * sent = nullptr) {
+  std::atomic<bool> stop {};
+  size_t            offset {};
+  int64_t           lastProgress { Now() };
+
+  int64_t     startWall { Now() };
+  int64_t     startCpu { ThreadCpu() };
+  std::thread feeder([&] { loopback.Feed(stream, stop, lineLength, intervalNS, sent); });
+
+  result.passed = true;
+
+  while (offset < stream.size()) {
+    size_t before { offset };
+
+    if (!receive(offset)) {
+      result.passed = false;
+      break;
+    }
+
+    if (offset != before) {
+      lastProgress = Now();
+    } else if (Now() - lastProgress > StallTimeoutNS) {
+      result.passed = false;
+      break;
+    }
+  }
+
+  result.cpuNS = ThreadCpu() - startCpu;
+  result.wallNS = Now() - startWall;
+  result.bytes = offset;
+
+  stop = true;
+  feeder.join();
+}
+//-----------------------------------------------------------------------------
+void TestRead(Result & result, Loopback & loopback, Uarts & uart, const std::string & stream) {
+  std::vector<uint8_t> buffer(FeedChunk);
+
+  RunReceive(result, loopback, stream, [&](size_t & offset) {
+    size_t length { uart.Read(buffer.data(), std::min(buffer.size(), stream.size() - offset)) };
+    return Verify(stream, offset, reinterpret_cast<const char*>(buffer.data()), length);
+  });
+}
+//-----------------------------------------------------------------------------
+void TestReadLine(Result & result, Loopback & loopback, Uarts & uart, const std::string & stream) {
+  std::string line;
+
+  line.reserve(256);
+
+  RunReceive(result, loopback, stream, [&](size_t & offset) {
+    line.clear();
+    uart.ReadLine(line, 256, "\r\n");
+    if (!line.empty()) {
+      result.lines++;
+    }
+    return Verify(stream, offset, line.data(), line.size());
+  });
+}
+//-----------------------------------------------------------------------------
+void TestReadLines(Result & result, Loopback & loopback, Uarts & uart, const std::string & stream) {
+  RunReceive(result, loopback, stream, [&](size_t & offset) {
+    // Don't ask more than what is left, the last call would wait for the timeout
+    for (const std::string & line : uart.ReadLines(std::min(FeedChunk, stream.size() - offset), "\r\n")) {
+      if (!Verify(stream, offset, line.data(), line.size())) {
+        return false;
+      }
+      result.lines++;
+    }
+    return true;
+  });
+}
+//-----------------------------------------------------------------------------
+void TestLatency(Result & result, Loopback & loopback, Uarts & uart, const std::string & stream,
+                 size_t lineLength, int64_t intervalNS) {
+  size_t                            count { stream.size() / lineLength };
+  std::vector<std::atomic<int64_t>> sent(count);
+  std::string                       line;
+
+  // The feeder stores the send time before each line, the consumer reads it after the line
+  result.latencies.reserve(count);
+
+  RunReceive(result, loopback, stream, [&](size_t & offset) {
+    line.clear();
+    uart.ReadLine(line, 256, "\r\n");
+    if (line.empty()) {
+      return true;
+    }
+
+    int64_t received { Now() };
+
+    // Only whole lines are timed
+    if (line.size() == lineLength && result.lines < count) {
+      result.latencies.push_back(received - sent[result.lines].load());
+    }
+    result.lines++;
+
+    return Verify(stream, offset, line.data(), line.size());
+  }, lineLength, intervalNS, sent.data());
+}
+//-----------------------------------------------------------------------------
+void TestWrite(Result & result, Loopback & loopback, Uarts & uart, const std::string & stream, size_t chunk) {
+  std::atomic<bool> stop {};
+  bool              drained {};
+  std::thread       drainer([&] { drained = loopback.Drain(stream, stop); });
+
+  int64_t startWall { Now() };
+  int64_t startCpu { ThreadCpu() };
+  int64_t lastProgress { startWall };
+  size_t  offset {};
+
+  while (offset < stream.size()) {
+    size_t written { uart.Write(reinterpret_cast<const uint8_t*>(stream.data()) + offset,
+                                std::min(chunk, stream.size() - offset)) };
+
+    if (written > 0) {
+      offset += written;
+      lastProgress = Now();
+    } else if (Now() - lastProgress > StallTimeoutNS) {
+      break;
+    }
+  }
+
+  result.cpuNS = ThreadCpu() - startCpu;
+
+  // Wait for the drainer before stopping the clock, the data has to be received
+  if (offset < stream.size()) {
+    stop = true;
+  }
+  drainer.join();
+
+  result.wallNS = Now() - startWall;
+  result.bytes = offset;
+  result.passed = drained;
+}
+//-----------------------------------------------------------------------------
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Report
+
+//-----------------------------------------------------------------------------
+int64_t Percentile(std::vector<int64_t> & values, uint32_t percent) {
+  if (values.empty()) {
+    return 0;
+  }
+
+  size_t index { std::min(values.size() - 1, values.size() * percent / 100) };
+  std::nth_element(values.begin(), values.begin() + index, values.end());
+
+  return values[index];
+}
+//-----------------------------------------------------------------------------
+void PrintHeader(void) {
+  printf("%-10s %8s %-14s %10s %10s %10s %9s %9s %9s %9s  %s\n", "test", "baud", "timeout", "bytes", "MB/s",
+         "lines/s", "cpu ns/B", "p50 us", "p99 us", "max us", "result");
+}
+//-----------------------------------------------------------------------------
+void PrintResult(Result & result) {
+  double seconds { result.wallNS / 1e9 };
+
+  printf("%-10s %8u %-14s %10zu %10.2f %10.0f %9.1f", result.test.c_str(), result.baudrate, result.timeout,
+         result.bytes, seconds > 0 ? result.bytes / seconds / 1e6 : 0.0, seconds > 0 ? result.lines / seconds : 0.0,
+         result.bytes > 0 ? static_cast<double>(result.cpuNS) / result.bytes : 0.0);
+
+  if (result.latencies.empty()) {
+    printf(" %9s %9s %9s", "-", "-", "-");
+  } else {
+    int64_t p50 { Percentile(result.latencies, 50) };
+    int64_t p99 { Percentile(result.latencies, 99) };
+    int64_t max { *std::max_element(result.latencies.begin(), result.latencies.end()) };
+    printf(" %9.1f %9.1f %9.1f", p50 / 1e3, p99 / 1e3, max / 1e3);
+  }
+
+  printf("  %s\n", result.passed ? "ok" : "FAILED");
+  fflush(stdout);
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[]) {
+  bool quick { argc > 1 && strcmp(argv[1], "--quick") == 0 };
+
+  const uint32_t    baudrates[] { 9600, 115200, 921600 };
+  const TimeoutCase timeouts[] {
+    { "simple 10ms",   Timeout::SimpleTimeout(10) },
+    { "simple 100ms",  Timeout::SimpleTimeout(100) },
+    { "inter-byte 1ms", Timeout(1, 10, 0, 10, 0) },
+  };
+
+  size_t      lines {};
+  std::string stream { MakeStream(quick ? (64 << 10) : (1 << 20), lines) };
+  size_t      latencyLines { quick ? 100u : 1000u };
+  std::string latencyStream;
+
+  CheckFramer();
+  CheckFrameRead();
+  CheckTryErrors();
+  CheckAsyncOperations();
+  CheckPostAfter();
+  CheckTransmitQueue();
+  printf("framer, Try API and reactor checks: %s\n\n", passed ? "ok" : "FAILED");
+
+  for (size_t index = 0; index < latencyLines; index++) {
+    latencyStream += MakeSentence(index);
+  }
+
+  PrintHeader();
+
+  for (uint32_t baudrate : baudrates) {
+    for (const TimeoutCase & timeout : timeouts) {
+      const char * names[] { "Read", "ReadLine", "ReadLines", "latency", "Write" };
+
+      for (const char * name : names) {
+        Loopback  loopback;
+        Result    result;
+
+        result.test = name;
+        result.baudrate = baudrate;
+        result.timeout = timeout.name;
+
+        if (!loopback.IsValid()) {
+          std::cout << "uart-bench: openpty failed." << std::endl;
+          return 1;
+        }
+
+        Uarts uart(loopback.Name(), baudrate, timeout.timeout);
+
+        try {
+          uart.Open();
+
+          if (result.test == "Read") {
+            TestRead(result, loopback, uart, stream);
+          } else if (result.test == "ReadLine") {
+            TestReadLine(result, loopback, uart, stream);
+          } else if (result.test == "ReadLines") {
+            TestReadLines(result, loopback, uart, stream);
+          } else if (result.test == "latency") {
+            // All the sentences have the same length, one every millisecond
+            TestLatency(result, loopback, uart, latencyStream, MakeSentence(0).size(), NanosecondsPerMillisecond);
+          } else {
+            TestWrite(result, loopback, uart, stream, 256);
+          }
+        } catch (const std::exception & e) {
+          std::cout << name << ": " << e.what() << std::endl;
+          result.passed = false;
+        }
+
+        PrintResult(result);
+        passed &= result.passed;
+      }
+    }
+  }
+
+  return passed ? 0 : 1;
+}
+//-----------------------------------------------------------------------------
@@ -33,10 +33,14 @@
 #define AIRSOFTMANAGER_HPP_
 
 #include <thread>
+#include <ostream>
 #include <gps.hpp>
+#include <game-clock.hpp>
+#include <gps/geofence.hpp>
 #include <wireless.hpp>
 #include <inout.hpp>
 #include <devices/i2c-display.hpp>
+#include <drivers/uart-reactor.hpp>
 
 namespace Airsoft {
 
@@ -49,13 +53,21 @@ public:
   bool Init(void);
   void Terminate(void);
 
+  /**
+   * @brief Print the statistics of the serial ports in use.
+   */
+  void PrintStatistics(std::ostream & out) const;
+
 private:
   // Pointer to thread
   std::thread * _process {};
   // Running flag for thread
   bool          _threadRunning {};
 
+  Airsoft::Drivers::UartReactor   _reactor;
+  GameClock                       _clock;
   Gps                             _gps;
+  Geofence                        _geofence;                  // Updated by the reactor thread, see Gps::SetFixHandler
   Wireless                        _wireless;
   InOut                           _inout;
   Airsoft::Devices::I2CDisplay  * _display {};
@@ -66,6 +78,7 @@ private:
 
 private:
   bool LoadConfiguration(void);
+  static void PrintUartStatistics(std::ostream & out, const char * name, const Airsoft::Drivers::UartStatistics & statistics);
 
 
 };
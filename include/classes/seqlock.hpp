@@ -0,0 +1,151 @@
+/**
+ *******************************************************************************
+ * @file seqlock.hpp
+ *
+ * @brief Single writer, many readers publication of a value without locks
+ *
+ * @author  Cristian
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft project
+ * https://github.com/xxxx or http://xxx.github.io.
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+#ifndef CLASSES_SEQLOCK_HPP_
+#define CLASSES_SEQLOCK_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+
+namespace Airsoft::Classes {
+
+/**
+ * @brief Sequence lock: the last value stored by one writer thread is read by any number of reader threads.
+ *        The writer never waits and never allocates. A reader copies the value and retries only if a store
+ *        ran during the copy, so it never sees a torn value and never delays the writer.
+ *        The value is kept in relaxed atomic words, the copy has no data race.
+ *        Every store increments the generation: a reader can check it first and skip the copy when nothing
+ *        changed.
+ *        Store must be called by one thread at a time.
+ */
+template<typename T>
+class Seqlock final {
+  static_assert(std::is_trivially_copyable<T>::value, "Seqlock value must be trivially copyable");
+
+public:
+  Seqlock() = default;
+  ~Seqlock() = default;
+
+public:
+  /**
+   * @brief Publish a new value, wait free.
+   */
+  void Store(const T & value) {
+    // Function Variables
+    uint64_t  sequence { _sequence.load(std::memory_order_relaxed) };
+    uintptr_t words[Words] {};
+
+    memcpy(words, &value, sizeof(T));
+
+    // Odd while writing, the readers of this period retry
+    _sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t index = 0; index < Words; index++) {
+      _data[index].store(words[index], std::memory_order_relaxed);
+    }
+
+    _sequence.store(sequence + 2, std::memory_order_release);
+  }
+
+  /**
+   * @brief Copy the last value published.
+   * @return Generation of the value, 0 if nothing has been stored yet.
+   */
+  uint64_t Load(T & value) const {
+    // Function Variables
+    uintptr_t words[Words];
+
+    for (uint32_t attempt = 0; ; attempt++) {
+      uint64_t before { _sequence.load(std::memory_order_acquire) };
+
+      if ((before & 1) == 0) {
+        for (size_t index = 0; index < Words; index++) {
+          words[index] = _data[index].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (_sequence.load(std::memory_order_relaxed) == before) {
+          memcpy(&value, words, sizeof(T));
+          return before / 2;
+        }
+      }
+
+      // The writer has been preempted in the middle of a store
+      if (attempt >= SpinAttempts) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  /**
+   * @brief Copy the value only if it has been published after generation.
+   * @param generation - Generation known by the caller, updated when the value is copied.
+   * @return True if value has been updated.
+   */
+  bool LoadIfChanged(T & value, uint64_t & generation) const {
+    if (GetGeneration() == generation) {
+      return false;
+    }
+
+    generation = Load(value);
+
+    return true;
+  }
+
+  /**
+   * @brief Number of values published, the value read by Load has this generation or a later one.
+   */
+  uint64_t inline GetGeneration(void) const {
+    return _sequence.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  // Disable copy constructors
+  Seqlock(const Seqlock&);
+  Seqlock& operator=(const Seqlock&);
+
+  // Native words, a 64 bits atomic is a locked sequence on a 32 bits core
+  static constexpr size_t   Words = (sizeof(T) + sizeof(uintptr_t) - 1) / sizeof(uintptr_t);
+  static constexpr uint32_t SpinAttempts = 64;
+
+private:
+  std::atomic<uint64_t>  _sequence {};                    // Twice the generation, odd during a store
+  std::atomic<uintptr_t> _data[Words] {};
+};
+
+} // namespace Airsoft::Classes
+
+#endif // CLASSES_SEQLOCK_HPP_
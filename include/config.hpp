@@ -39,6 +39,9 @@ namespace Airsoft {
 struct AsmConfiguration {
   uint8_t AddressH;         // Wireless Address part high
   uint8_t AddressL;         // Wireless Address part low
+  float   ZoneHysteresis;   // Geofence meters beyond the border to enter or exit, 0 default
+  int32_t ZoneDwell;        // Geofence seconds in a zone for the dwell event, 0 default
+  int32_t ZoneTrust;        // Geofence trust of a fix to use it, 0 default, negative all
 };
 
 inline AsmConfiguration   Configuration {};
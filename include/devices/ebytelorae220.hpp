@@ -15,9 +15,12 @@
 #include <string>
 #include <cstring>
 #include <sstream>
+#include <memory>
+#include <functional>
 
 #include <devices/states_naming.hpp>
 #include <drivers/uarts.hpp>
+#include <drivers/uart-reactor.hpp>
 #include <drivers/gpio.hpp>
 
 #define LoRa_E220_DEBUG
@@ -199,6 +202,7 @@ struct __attribute__((packed)) ConfigurationMessage {
 };
 
 constexpr uint32_t MaxSizeTxPacket = 200;
+constexpr uint32_t MaxSizeRxPacket = 255;
 
 class EByteLoRaE220 final {
 public:
@@ -215,6 +219,29 @@ public:
   ResponseStructContainer GetConfiguration(void);
   ResponseStatus SetConfiguration(Configuration configuration, ProgramCommand saveType = ProgramCommand::WRITE_CFG_PWR_DWN_LOSE);
 
+  /**
+   * @brief Completion of an asynchronous configuration exchange, on the reactor thread: the status and the
+   *        configuration returned by the module, valid when the status is E220_SUCCESS.
+   */
+  using ConfigurationHandler = std::function<void(ResponseStatus status, Configuration & configuration)>;
+
+  /**
+   * @brief GetConfiguration without blocking: the mode changes, the command, the response and the waits for the
+   *        module are operations of the reactor, its thread keeps servicing the other ports meanwhile.
+   *        The port must be registered to the reactor, the response is read before the port handler sees it.
+   * @param reactor - The reactor the port is registered to
+   * @param handler - Completion handler, never called inside this call
+   */
+  void GetConfigurationAsync(Airsoft::Drivers::UartReactor & reactor, ConfigurationHandler handler);
+
+  /**
+   * @brief SetConfiguration without blocking, same rules of GetConfigurationAsync.
+   * @param handler - Completion handler, with the configuration returned by the module
+   */
+  void SetConfigurationAsync(Airsoft::Drivers::UartReactor & reactor, Configuration configuration,
+                             ConfigurationHandler handler,
+                             ProgramCommand saveType = ProgramCommand::WRITE_CFG_PWR_DWN_LOSE);
+
   ResponseStructContainer GetModuleInformation(void);
   ResponseStatus ResetModule(void);
 
@@ -231,9 +258,43 @@ public:
   ResponseContainer ReceiveMessage(void);
   ResponseContainer ReceiveMessageRSSI(void);
 
+  /**
+   * @brief Receive a message reading straight into the caller's string, its capacity is reused between
+   *        calls so polling a quiet module doesn't allocate.
+   * @param message - Filled with the message, empty when nothing has been received
+   * @param rssi - If not null the last byte is the RSSI and it is stored here
+   * @param timestamp - If not null the arrival time of the message is stored here (see Uarts::SetTimestamping)
+   * @return Status of the receive
+   */
+  ResponseStatus ReceiveMessage(std::string & message, uint8_t * rssi = nullptr, int64_t * timestamp = nullptr);
+
+  /**
+   * @brief Append to the message the bytes the port already has, without waiting. The module outputs a packet
+   *        over several milliseconds, so it arrives in pieces and the caller puts it together (see IsAuxHigh).
+   * @param message - The bytes are appended to it, up to MaxSizeRxPacket in all
+   * @param timestamp - If not null and the message was empty, the arrival time of its first bytes
+   * @return Status of the receive, ERR_E220_HARDWARE if the port has been disconnected
+   */
+  ResponseStatus ReceivePart(std::string & message, int64_t * timestamp = nullptr);
+
+  /**
+   * @brief True when the AUX pin is high: the module is idle, it has output the whole packet received.
+   *        Always false without the AUX pin.
+   */
+  bool IsAuxHigh(void);
+
   ResponseStatus SendFixedMessage(uint8_t addrH, uint8_t addrL, uint8_t Channel, const std::string message);
 
   ResponseStatus SendFixedMessage(uint8_t addrH,uint8_t addrL, uint8_t Channel, const void * message, const uint8_t size);
+
+  /**
+   * @brief Send a fixed transmission message whose payload is split in several buffers.
+   *        The address/channel header and the buffers are written with a single gather write.
+   * @param payload - Buffers of the payload, in order
+   * @param count - Number of buffers, less than 8
+   * @return Status of the transmission
+   */
+  ResponseStatus SendFixedMessage(uint8_t addrH, uint8_t addrL, uint8_t Channel, const struct iovec * payload, size_t count);
   ResponseStatus SendBroadcastFixedMessage(uint8_t Channel, const void *message, const uint8_t size);
   ResponseStatus SendBroadcastFixedMessage(uint8_t Channel, const std::string message);
 
@@ -267,10 +328,24 @@ private:
 
   uint64_t _halfKeyloqKey { 0x06660708 };
 
+  using StatusHandler = std::function<void(Status status)>;
+
+  struct ConfigurationExchange {
+    Airsoft::Drivers::UartReactor * reactor {};
+    ModeType                        previousMode {};      // Restored at the end of the exchange
+    Configuration                   configuration {};     // Returned by the module
+    Status                          status { E220_SUCCESS };  // First error of the send and of the response
+    uint32_t                        pending {};           // Completions still missing, the send and the response
+    ConfigurationHandler            handler;
+  };
+
 private:
   uint64_t Encrypt(uint64_t data);
   uint64_t Decrypt(uint64_t data);
 
+  Status WriteModePins(ModeType mode);
+  Status CheckConfigurationHeader(const Configuration & configuration);
+
   /**
    * @brief Utility method to wait until module is done transmitting a timeout is provided to avoid an infinite loop
    * @param timeout - Timeout in milliseconds
@@ -279,10 +354,34 @@ private:
    */
   Status WaitCompleteResponse(uint64_t timeout = 1000, uint32_t waitNoAux = 100);
 
+  /**
+   * @brief WaitCompleteResponse without blocking, AUX is checked from the reactor every millisecond.
+   */
+  void WaitCompleteAsync(Airsoft::Drivers::UartReactor & reactor, uint32_t timeout, uint32_t waitNoAux,
+                         StatusHandler handler);
+
+  /**
+   * @brief SetMode without blocking, the handler runs once the module has switched.
+   */
+  void SetModeAsync(Airsoft::Drivers::UartReactor & reactor, ModeType mode, StatusHandler handler);
+
+  /**
+   * @brief SendStruct without blocking: the data is written by the reactor, then the module is waited for.
+   *        The port isn't cleaned afterwards, what arrives belongs to the reads of the reactor.
+   */
+  void SendStructAsync(Airsoft::Drivers::UartReactor & reactor, std::string data, StatusHandler handler);
+
+  void ExchangeConfiguration(std::shared_ptr<ConfigurationExchange> exchange, std::string command, bool send);
+  void OnConfigurationResponse(std::shared_ptr<ConfigurationExchange> exchange, std::string & data, bool completed);
+  void ConfigurationReceived(std::shared_ptr<ConfigurationExchange> exchange);
+  void EndConfiguration(std::shared_ptr<ConfigurationExchange> exchange, Status status);
+  void FinishConfiguration(std::shared_ptr<ConfigurationExchange> exchange, Status status);
+
   void Flush(void);
   void CleanUARTBuffer(void);
 
   Status SendStruct(void * structureManaged, size_t size_);
+  Status SendStruct(const struct iovec * buffers, size_t count);
   Status ReceiveStruct(void * structureManaged, size_t size_);
   bool WriteProgramCommand(ProgramCommand cmd, RegisterAddress addr, PacketLength pl);
 
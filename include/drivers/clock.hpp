@@ -0,0 +1,183 @@
+/**
+ *******************************************************************************
+ * @file clock.hpp
+ *
+ * @brief Integer nanoseconds monotonic clock and deadlines
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+#ifndef _CLOCK_HPP_
+#define _CLOCK_HPP_
+
+#include <cstdint>
+#include <ctime>
+#include <atomic>
+
+namespace Airsoft::Drivers {
+
+constexpr int64_t NanosecondsPerMicrosecond = 1000;
+constexpr int64_t NanosecondsPerMillisecond = 1000000;
+constexpr int64_t NanosecondsPerSecond = 1000000000;
+
+/**
+ * @brief Source of the time in integer nanoseconds, it never goes back nor jumps when the wall time is set.
+ *        Drivers read the time through Clock::Default(), tests and benchmarks can replace it with a
+ *        FakeClock to run timing logic on virtual time. The deadlines of the kernel waits (select, epoll)
+ *        are bound to the real time and always use Clock::Monotonic().
+ */
+class Clock {
+public:
+  Clock() = default;
+  virtual ~Clock() = default;
+
+public:
+  /**
+   * @brief Current time in nanoseconds from an unspecified origin.
+   */
+  virtual int64_t Now(void) const = 0;
+
+  int64_t inline NowMS(void) const {
+    return Now() / NanosecondsPerMillisecond;
+  }
+
+  /**
+   * @brief The clock used by the drivers, the CLOCK_MONOTONIC one unless replaced.
+   */
+  static const Clock & Default(void);
+
+  /**
+   * @brief Replace the clock used by the drivers, nullptr restores the CLOCK_MONOTONIC one.
+   *        The clock must outlive its use.
+   */
+  static void SetDefault(const Clock * clock);
+
+  /**
+   * @brief The CLOCK_MONOTONIC clock.
+   */
+  static const Clock & Monotonic(void);
+
+private:
+  static std::atomic<const Clock*>  _default;
+};
+
+/**
+ * @brief CLOCK_MONOTONIC
+ */
+class MonotonicClock final : public Clock {
+public:
+  int64_t Now(void) const override;
+};
+
+/**
+ * @brief Virtual time, it changes only when set or advanced.
+ */
+class FakeClock final : public Clock {
+public:
+  explicit FakeClock(int64_t now = 0) : _now(now) { }
+
+public:
+  int64_t Now(void) const override {
+    return _now.load(std::memory_order_relaxed);
+  }
+
+  void inline Set(int64_t now) {
+    _now.store(now, std::memory_order_relaxed);
+  }
+
+  void inline Advance(int64_t nanoseconds) {
+    _now.fetch_add(nanoseconds, std::memory_order_relaxed);
+  }
+
+private:
+  std::atomic<int64_t> _now;
+};
+
+/**
+ * @brief A point in time of a clock, used for the timeouts. The default one never expires.
+ */
+class Deadline final {
+public:
+  Deadline() = default;
+
+  /**
+   * @brief Deadline timeout nanoseconds from now.
+   */
+  explicit Deadline(int64_t timeout, const Clock & clock = Clock::Default())
+    : _clock(&clock), _expiry(clock.Now() + timeout) { }
+
+  static Deadline FromMilliseconds(int64_t timeoutMS, const Clock & clock = Clock::Default()) {
+    return Deadline(timeoutMS * NanosecondsPerMillisecond, clock);
+  }
+
+public:
+  bool inline IsNever(void) const {
+    return _clock == nullptr;
+  }
+
+  /**
+   * @brief Expiry time on the clock, INT64_MAX for a deadline that never expires.
+   */
+  int64_t inline When(void) const {
+    return _clock == nullptr ? INT64_MAX : _expiry;
+  }
+
+  /**
+   * @brief Nanoseconds left, negative once expired.
+   */
+  int64_t inline Remaining(void) const {
+    return _clock == nullptr ? INT64_MAX : _expiry - _clock->Now();
+  }
+
+  /**
+   * @brief Milliseconds left rounded up, so that waiting them doesn't wake up before the deadline.
+   */
+  int64_t RemainingMS(void) const;
+
+  bool inline Expired(void) const {
+    return Remaining() <= 0;
+  }
+
+  /**
+   * @brief Time left as timespec for the system calls, zero once expired.
+   */
+  timespec RemainingTimespec(void) const;
+
+  bool inline operator<(const Deadline & other) const {
+    return When() < other.When();
+  }
+
+private:
+  const Clock * _clock {};
+  int64_t       _expiry {};
+};
+
+/**
+ * @brief Convert nanoseconds to timespec without floating point math.
+ */
+timespec ToTimespec(int64_t nanoseconds);
+
+} // namespace Airsoft::Drivers
+
+#endif // _CLOCK_HPP_
@@ -78,6 +78,16 @@ enum class Level {
   High
 };
 
+/**
+ * @brief Edges of an input reported by WaitEdge.
+ */
+enum class Edge {
+  None,
+  Rising,
+  Falling,
+  Both
+};
+
 
 class Gpio final {
 public:
@@ -94,6 +104,19 @@ public:
   void Toggle(void);
   bool Read(void);
 
+  /**
+   * @brief Select the edges of the input reported by WaitEdge, the pin must be open as input.
+   */
+  bool SetEdge(Edge edge);
+
+  /**
+   * @brief Wait for an edge selected by SetEdge.
+   * @param timestamp - Clock::Default() nanoseconds when the wait returned, set only on an edge.
+   * @param timeoutMS - Maximum wait, -1 forever.
+   * @return True on an edge, false on timeout or error.
+   */
+  bool WaitEdge(int64_t & timestamp, int32_t timeoutMS);
+
 public:
   static inline uint32_t CalculateGpioId(uint32_t bank, uint8_t group, uint32_t id) {
     return (bank * 32) + ((group * 8) + id);
@@ -109,6 +132,7 @@ private:
   Level         _currentLevel { Level::Low };
 
   bool          _outState {};
+  int32_t       _edgeFd { -1 };                           // Value file polled for the edges
 
 };
 
@@ -0,0 +1,230 @@
+/**
+ *******************************************************************************
+ * @file uart-reactor.hpp
+ *
+ * @brief Event loop servicing any number of uarts from a single thread
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+#ifndef _UART_REACTOR_HPP_
+#define _UART_REACTOR_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <map>
+#include <queue>
+#include <deque>
+#include <vector>
+#include <string>
+#include <drivers/uarts.hpp>
+#include <drivers/clock.hpp>
+
+namespace Airsoft::Drivers {
+
+/**
+ * @brief Single epoll set servicing the registered uarts from one thread.
+ *        Handlers run on the reactor thread, they must not block for long since every other port
+ *        waits for them to return.
+ *        Besides the readable/writable notifications the reactor runs asynchronous reads and writes with
+ *        a timeout: a protocol exchange becomes a chain of operations, each one started from the completion
+ *        of the previous, and any number of exchanges share the reactor thread without blocking it.
+ */
+class UartReactor final {
+public:
+  using Handler = std::function<void(void)>;
+
+  /**
+   * @brief Completion of an asynchronous read: the data received and true, or the data received so far
+   *        and false on timeout, error, disconnection or unregistration. The data can be moved away.
+   */
+  using ReadHandler = std::function<void(std::string & data, bool completed)>;
+
+  /**
+   * @brief Completion of an asynchronous write: the bytes written and true when all the data has been
+   *        written, false on timeout, error or unregistration.
+   */
+  using WriteHandler = std::function<void(size_t written, bool completed)>;
+
+public:
+  UartReactor() = default;
+  virtual ~UartReactor();
+
+public:
+  /**
+   * @brief Create the epoll set and start the reactor thread.
+   */
+  bool Init(void);
+
+  /**
+   * @brief Stop the reactor thread and release the epoll set, registrations and pending operations are dropped.
+   */
+  void Terminate(void);
+
+  bool inline IsReady(void) {
+    return _ready;
+  }
+
+  /**
+   * @brief Add an open uart to the epoll set.
+   * @param uart - The uart, it must stay open until Unregister is called.
+   * @param onReadable - Called when the port has data to read (or has been disconnected).
+   * @param onWritable - Called when the port can accept data, only while enabled with SetWritable.
+   *        The transmit queue of the port (see Uarts::SetTransmitQueue) is drained by the reactor before it.
+   * @return True if the port has been added.
+   */
+  bool Register(Uarts & uart, Handler onReadable, Handler onWritable = nullptr);
+
+  /**
+   * @brief Enable or disable the writable notifications of a registered uart.
+   */
+  bool SetWritable(Uarts & uart, bool enable);
+
+  /**
+   * @brief Remove a uart from the epoll set. When it returns no handler of the uart is running.
+   */
+  void Unregister(Uarts & uart);
+
+  /**
+   * @brief Run a task on the reactor thread.
+   */
+  void Post(Handler task);
+
+  /**
+   * @brief Run a task on the reactor thread once the delay has passed, e.g. to try again later what a device
+   *        was not ready for. Tasks not run yet are dropped by Terminate.
+   */
+  void PostAfter(uint32_t delayMS, Handler task);
+
+  /**
+   * @brief Read size bytes from a registered uart without blocking.
+   *        The operations of a port complete in order, the handler always runs on the reactor thread and
+   *        never inside this call. While reads are pending the onReadable handler of the port is not called.
+   * @param uart - A registered uart.
+   * @param size - Number of bytes to read.
+   * @param timeoutMS - Timeout of the whole operation, Timeout::Max() waits forever.
+   * @param handler - Completion handler.
+   */
+  void ReadAsync(Uarts & uart, size_t size, uint32_t timeoutMS, ReadHandler handler);
+
+  /**
+   * @brief Read a line from a registered uart without blocking, same rules of ReadAsync.
+   * @param uart - A registered uart.
+   * @param timeoutMS - Timeout of the whole operation, Timeout::Max() waits forever.
+   * @param handler - Completion handler, the line includes the delimiter.
+   * @param size - A maximum length of a line, defaults to 65536 (2^16)
+   * @param eol - A string to match against for the EOL.
+   */
+  void ReadLineAsync(Uarts & uart, uint32_t timeoutMS, ReadHandler handler, size_t size = 65536,
+                     std::string eol = "\n");
+
+  /**
+   * @brief Write to a registered uart without blocking, the rest is written when the port becomes writable.
+   *        The writes of a port complete in order, the handler always runs on the reactor thread.
+   * @param uart - A registered uart.
+   * @param data - Data to be written.
+   * @param timeoutMS - Timeout of the whole operation, Timeout::Max() waits forever.
+   * @param handler - Completion handler, can be null.
+   */
+  void WriteAsync(Uarts & uart, std::string data, uint32_t timeoutMS, WriteHandler handler = nullptr);
+
+  /**
+   * @brief True when called from the reactor thread.
+   */
+  bool IsReactorThread(void) const;
+
+private:
+  struct ReadOperation {
+    bool          line {};                                // Line or fixed size read
+    size_t        size {};
+    std::string   eol;
+    Deadline      deadline;
+    ReadHandler   handler;
+    std::string   data;                                   // Data received so far
+  };
+
+  struct WriteOperation {
+    std::string   data;
+    size_t        written {};                             // Bytes of data already written
+    Deadline      deadline;
+    WriteHandler  handler;
+  };
+
+  struct Timer {
+    Deadline      deadline;
+    Handler       task;
+  };
+
+  struct Registration {
+    Uarts *                     uart {};
+    Handler                     onReadable;
+    Handler                     onWritable;
+    bool                        writable {};              // onWritable notifications enabled
+    bool                        transmitting {};          // Transmit queue of the port not empty
+    uint32_t                    events {};
+    std::deque<ReadOperation>   reads;                    // Pending asynchronous reads
+    std::deque<WriteOperation>  writes;                   // Pending asynchronous writes
+  };
+
+private:
+  // Disable copy constructors
+  UartReactor(const UartReactor&);
+  UartReactor& operator=(const UartReactor&);
+
+private:
+  std::thread *                   _process {};            // Pointer to thread
+  bool                            _threadRunning {};      // Running flag for thread
+  bool                            _ready {};
+
+  int32_t                         _epoll { -1 };          // Epoll set
+  int32_t                         _wakeup { -1 };         // Event descriptor used to wake up the thread
+
+  std::recursive_mutex            _lock;                  // Registrations and dispatch lock
+  std::map<int32_t, Registration> _registrations;         // Registrations by file descriptor
+
+  std::mutex                      _tasksLock;
+  std::queue<Handler>             _tasks;                 // Tasks posted to the reactor thread
+  std::vector<Timer>              _timers;                // Tasks posted with a delay, under _tasksLock
+
+private:
+  void Engine(void);
+  void Wakeup(void);
+  void RunTasks(void);
+  void RunTimers(void);
+
+  bool UpdateEvents(int32_t fd, Registration & registration);
+  void StartRead(Uarts & uart, ReadOperation operation);
+  void ServiceReads(int32_t fd, bool readable);
+  void ServiceWrites(int32_t fd);
+  void ServiceTransmit(int32_t fd);
+  void FailOperations(Registration & registration);
+  void ExpireOperations(void);
+  int32_t NextTimeout(void);
+};
+
+} // namespace Airsoft::Drivers
+
+#endif // _UART_REACTOR_HPP_
@@ -38,9 +38,16 @@
 #include <sstream>
 #include <exception>
 #include <stdexcept>
+#include <memory>
+#include <functional>
+#include <sys/uio.h>
 #include <drivers/uarts/enumerators.hpp>
 #include <drivers/uarts/exceptions.hpp>
 #include <drivers/uarts/timeout.hpp>
+#include <drivers/uarts/ring-buffer.hpp>
+#include <drivers/uarts/statistics.hpp>
+#include <drivers/uarts/framer.hpp>
+#include <drivers/uarts/result.hpp>
 
 
 namespace Airsoft::Drivers {
@@ -50,6 +57,11 @@ namespace Airsoft::Drivers {
  */
 #define THROW(exceptionClass, message) throw exceptionClass(__FILE__, __LINE__, (message))
 
+/**
+ * @brief Number of received chunks whose arrival time is remembered
+ */
+constexpr size_t RxTimestampMarks = 64;
+
 /**
  * @brief Class that provides a portable uart port interface.
  */
@@ -108,7 +120,7 @@ public:   // Public Functions
   void Close(void);
 
   /**
-   * @brief Return the number of characters in the buffer.
+   * @brief Return the number of characters in the buffer, both the internal receive buffer and the kernel one.
    */
   size_t Available(void);
 
@@ -147,8 +159,34 @@ public:   // Public Functions
    */
   size_t Read(uint8_t * buffer, size_t size);
 
+  /**
+   * @brief Read a given amount of bytes from the serial port into a given buffer, returning also
+   *        the arrival time of the first byte.
+   * @param buffer - An uint8_t array of at least the requested size.
+   * @param size - A size_t defining how many bytes to be read.
+   * @param timestamp - Clock::Default() nanoseconds when the first byte has been read from the kernel,
+   *                    0 if nothing has been read or the timestamps are disabled.
+   * @return A size_t representing the number of bytes read as a result of the call to read.
+   * @see Serial::SetTimestamping
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::SerialException
+   */
+  size_t Read(uint8_t * buffer, size_t size, int64_t & timestamp);
+
+  /**
+   * @brief Read a given amount of bytes from the serial port straight into the free space of a ring buffer,
+   *        without intermediate copies or allocations. Same return conditions of Read(uint8_t *, size_t).
+   * @param buffer - A RingBuffer owned by the caller, at most its free space is read.
+   * @param size - A size_t defining how many bytes to be read.
+   * @return A size_t representing the number of bytes read and committed to the buffer.
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::SerialException
+   */
+  size_t Read(RingBuffer & buffer, size_t size);
+
   /**
    * @brief Read a given amount of bytes from the serial port into a give buffer.
+   *        Data is appended reading in place, reserve the capacity to avoid allocations.
    * @param buffer - A reference to a std::vector of uint8_t.
    * @param size - A size_t defining how many bytes to be read.
    * @return A size_t representing the number of bytes read as a result of the call to read.
@@ -159,6 +197,7 @@ public:   // Public Functions
 
   /**
    * @brief Read a given amount of bytes from the serial port into a give buffer.
+   *        Data is appended reading in place, reserve the capacity to avoid allocations.
    * @param buffer - A reference to a std::string.
    * @param size - A size_t defining how many bytes to be read.
    * @return A size_t representing the number of bytes read as a result of the call to read.
@@ -179,6 +218,8 @@ public:   // Public Functions
   /**
    * @brief Reads in a line or until a given delimiter has been processed.
    *        Reads from the serial port until a single line has been read.
+   *        Data is pulled from the kernel in chunks into the internal receive buffer, bytes following the
+   *        delimiter stay buffered for the next read.
    * @param buffer - A std::string reference used to store the data.
    * @param size - A maximum length of a line, defaults to 65536 (2^16)
    * @param eol - A string to match against for the EOL.
@@ -188,6 +229,21 @@ public:   // Public Functions
    */
   size_t ReadLine(std::string & buffer, size_t size = 65536, std::string eol = "\n");
 
+  /**
+   * @brief Reads in a line or until a given delimiter has been processed, returning also the arrival time
+   *        of the first byte of the line.
+   * @param buffer - A std::string reference used to store the data.
+   * @param timestamp - Clock::Default() nanoseconds when the first byte has been read from the kernel,
+   *                    0 if nothing has been read or the timestamps are disabled.
+   * @param size - A maximum length of a line, defaults to 65536 (2^16)
+   * @param eol - A string to match against for the EOL.
+   * @return A size_t representing the number of bytes read.
+   * @see Serial::SetTimestamping
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::SerialException
+   */
+  size_t ReadLine(std::string & buffer, int64_t & timestamp, size_t size = 65536, std::string eol = "\n");
+
   /**
    * @brief Reads in a line or until a given delimiter has been processed.
    *        Reads from the serial port until a single line has been read.
@@ -211,6 +267,79 @@ public:   // Public Functions
    */
   std::vector<std::string> ReadLines(size_t size = 65536, std::string eol = "\n");
 
+  /**
+   * @brief Move into the internal receive buffer whatever the kernel has, without waiting.
+   *        Intended for event driven consumers (see UartReactor) notified when the port becomes readable;
+   *        0 bytes after a readable notification means the device has been disconnected.
+   * @return A size_t representing the number of bytes moved into the receive buffer.
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::IOException
+   */
+  size_t Receive(void);
+
+  /**
+   * @brief Extract a complete line from the internal receive buffer, the port is not accessed.
+   *        A partial line is returned only when it fills the receive buffer or reaches size.
+   * @param buffer - A std::string reference where the line is appended.
+   * @param size - A maximum length of a line, defaults to 65536 (2^16)
+   * @param eol - A string to match against for the EOL.
+   * @return True if a line has been extracted.
+   */
+  bool GetLine(std::string & buffer, size_t size = 65536, std::string eol = "\n");
+
+  /**
+   * @brief Extract a complete line from the internal receive buffer, returning also the arrival time of its
+   *        first byte.
+   * @param buffer - A std::string reference where the line is appended.
+   * @param timestamp - Clock::Default() nanoseconds when the first byte has been read from the kernel,
+   *                    0 if the timestamps are disabled.
+   * @param size - A maximum length of a line, defaults to 65536 (2^16)
+   * @param eol - A string to match against for the EOL.
+   * @return True if a line has been extracted.
+   * @see Serial::SetTimestamping
+   */
+  bool GetLine(std::string & buffer, int64_t & timestamp, size_t size = 65536, std::string eol = "\n");
+
+  /**
+   * @brief Extract up to size bytes from the internal receive buffer, the port is not accessed.
+   * @param buffer - A std::string reference where the data is appended.
+   * @param size - Maximum number of bytes to extract.
+   * @return A size_t representing the number of bytes extracted.
+   */
+  size_t GetData(std::string & buffer, size_t size);
+
+  /**
+   * @brief Extract up to size bytes from the internal receive buffer, the port is not accessed. The data
+   *        stops at the end of the chunk read from the kernel with the first byte, so that all the bytes
+   *        returned share the same arrival time.
+   * @param buffer - Destination, at least size bytes.
+   * @param size - Maximum number of bytes to extract.
+   * @param timestamp - Clock::Default() nanoseconds when the bytes have been read from the kernel,
+   *                    0 if the timestamps are disabled.
+   * @return Number of bytes extracted, 0 if the receive buffer is empty.
+   * @see Serial::SetTimestamping
+   */
+  size_t GetData(uint8_t * buffer, size_t size, int64_t & timestamp);
+
+  /**
+   * @brief Read until the framer has a complete frame. The bytes are passed to the framer straight from the
+   *        receive buffer, and the call returns as soon as the last byte of the frame has arrived.
+   *        Each wait for more data is bounded by the read timeout (constant plus one byte multiplier), a
+   *        partial frame is kept by the framer and completed by the next call.
+   * @param framer - The framer of the stream, the frame is taken with Framer::GetFrame.
+   * @return True if a frame is ready.
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::SerialException
+   */
+  bool ReadFrame(Framer & framer);
+
+  /**
+   * @brief Pass the internal receive buffer to the framer until a frame is complete, the port is not accessed.
+   * @param framer - The framer of the stream, the frame is taken with Framer::GetFrame.
+   * @return True if a frame is ready.
+   */
+  bool GetFrame(Framer & framer);
+
   /**
    * @brief Write a string to the serial port.
    * @param data - A const reference containing the data to be written to the serial port.
@@ -242,6 +371,134 @@ public:   // Public Functions
    */
   size_t Write(const std::string & data);
 
+  /**
+   * @brief Write a sequence of buffers to the serial port with writev(2), e.g. a header followed by a payload,
+   *        without building a contiguous copy. The write timeout is computed on the total length.
+   * @param iov - Array of buffers to be written in order.
+   * @param count - Number of elements of iov.
+   * @return A size_t representing the number of bytes actually written to the serial port.
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::SerialException
+   * @throw Serial::IOException
+   */
+  size_t Write(const struct iovec * iov, size_t count);
+
+  /**
+   * @brief Write what the kernel accepts now, without waiting. Counterpart of Receive for event driven
+   *        producers (see UartReactor), the rest has to be sent when the port becomes writable.
+   * @param data - Data to be written.
+   * @param size - Number of bytes of data.
+   * @return A size_t representing the number of bytes written, 0 if the kernel buffer is full.
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::IOException
+   */
+  size_t Send(const uint8_t * data, size_t size);
+
+  /**
+   * @brief Sets the queued transmit mode. With a capacity the writes are copied into a transmit queue and
+   *        return right away, the queue is drained without blocking when the port becomes writable: by the
+   *        UartReactor the port is registered with, or by calling Transmit. A write is queued whole or refused
+   *        when the free space isn't enough, so a frame is never split: 0 returned is the backpressure signal,
+   *        the caller retries when the queue has drained (see GetTransmitFree).
+   *        The write timeouts are not used in this mode. Capacity 0 restores the blocking writes, the data
+   *        still queued is discarded.
+   * @param capacity - Size of the queue in bytes, rounded up to a power of two.
+   */
+  void SetTransmitQueue(size_t capacity);
+
+  /**
+   * @brief Gets the capacity of the transmit queue, 0 when the writes are blocking.
+   * @see Serial::SetTransmitQueue
+   */
+  size_t GetTransmitQueue(void);
+
+  /**
+   * @brief Gets the number of bytes waiting in the transmit queue.
+   */
+  size_t GetTransmitPending(void);
+
+  /**
+   * @brief Gets the number of bytes that can be queued now, the largest write that won't be refused.
+   */
+  size_t GetTransmitFree(void);
+
+  /**
+   * @brief Move what the kernel accepts now from the transmit queue to the port, without waiting.
+   * @return A size_t representing the number of bytes still queued, the port has to be written again
+   *         when it becomes writable.
+   * @throw Serial::PortNotOpenedException
+   * @throw Serial::IOException
+   */
+  size_t Transmit(void);
+
+  /**
+   * @brief Sets the function called when data is queued and the transmit queue was empty, the owner of the
+   *        event loop uses it to start draining the queue (UartReactor installs its own).
+   *        It's called by the writing thread with the write lock held, so it must not write to the port.
+   * @param notify - Function to call, nullptr to remove it.
+   */
+  void SetTransmitNotify(std::function<void(void)> notify);
+
+  /**
+   * Exception free interface: same behavior of the functions with the same name, the outcome is returned
+   * instead of thrown. Timeouts, disconnections and system errors cost no unwinding and no formatting,
+   * meant for the loops that poll a port which can be quiet or unplugged.
+   * UartResult::Value is the count of bytes moved, also when an error is returned; a read or write
+   * shorter than requested returns UartError::Timeout.
+   */
+
+  /**
+   * @brief Read like Read, without exceptions.
+   */
+  UartResult TryRead(uint8_t * buffer, size_t size);
+
+  /**
+   * @brief Read like the timestamped Read, without exceptions.
+   */
+  UartResult TryRead(uint8_t * buffer, size_t size, int64_t & timestamp);
+
+  /**
+   * @brief Read a line like ReadLine, without exceptions. A line without the EOL because of the timeout
+   *        returns UartError::Timeout.
+   */
+  UartResult TryReadLine(std::string & buffer, size_t size = 65536, std::string eol = "\n");
+
+  /**
+   * @brief Read a frame like ReadFrame, without exceptions. The value is the length of the frame.
+   */
+  UartResult TryReadFrame(Framer & framer);
+
+  /**
+   * @brief Move what the kernel has into the receive buffer like Receive, without exceptions.
+   */
+  UartResult TryReceive(void);
+
+  /**
+   * @brief Bytes available like Available, without exceptions.
+   */
+  UartResult TryAvailable(void);
+
+  /**
+   * @brief Write like Write, without exceptions. In queued transmit mode a write refused because the
+   *        queue is full returns UartError::Busy.
+   */
+  UartResult TryWrite(const uint8_t * data, size_t size);
+
+  /**
+   * @brief Gather write like Write, without exceptions.
+   */
+  UartResult TryWrite(const struct iovec * iov, size_t count);
+
+  /**
+   * @brief Write what the kernel accepts now like Send, without exceptions.
+   */
+  UartResult TrySend(const uint8_t * data, size_t size);
+
+  /**
+   * @brief Drain the transmit queue like Transmit, without exceptions. The value is the bytes still queued.
+   */
+  UartResult TryTransmit(void);
+
   /**
    * @brief Sets the serial port identifier.
    * @param port - A const std::string reference containing the address of the serial port, which would be something
@@ -257,6 +514,11 @@ public:   // Public Functions
    */
   std::string GetPort(void) const;
 
+  /**
+   * @brief Gets the file descriptor of the open port, -1 when closed.
+   */
+  int32_t GetDescriptor(void) const;
+
   /**
    * @brief Sets the timeout for reads and writes using the Timeout struct.
    *        There are two timeout conditions described here:
@@ -379,6 +641,50 @@ public:   // Public Functions
    */
   FlowControl GetFlowcontrol(void) const;
 
+  /**
+   * @brief Enable or disable the low latency mode.
+   *        In low latency mode the port asks the driver for ASYNC_LOW_LATENCY (when TIOCSSERIAL is supported,
+   *        otherwise the request is silently ignored) so received bytes are pushed to the tty layer immediately,
+   *        and multi-byte reads return what is available instead of waiting the transmission time of the
+   *        missing bytes. Intended for command/response exchanges, it costs more wake ups on streams.
+   * @param enable - True to enable the low latency mode.
+   */
+  void SetLowLatency(bool enable = true);
+
+  /**
+   * @brief Gets the low latency mode.
+   * @see Serial::SetLowLatency
+   */
+  bool GetLowLatency(void) const;
+
+  /**
+   * @brief Sets the receive timestamps. When enabled every chunk read from the kernel is stamped with
+   *        Clock::Default() (CLOCK_MONOTONIC unless replaced) as soon as read() returns, so the arrival time
+   *        of the data doesn't depend on when the consumer gets to it. The stamps are returned by the
+   *        timestamped Read/ReadLine/GetLine.
+   *        Only the last RxTimestampMarks chunks are remembered, older buffered data gets the oldest stamp.
+   * @param enable - True to enable the timestamps.
+   */
+  void SetTimestamping(bool enable = true);
+
+  /**
+   * @brief Gets the receive timestamps mode.
+   * @see Serial::SetTimestamping
+   */
+  bool GetTimestamping(void) const;
+
+  /**
+   * @brief Gets the statistics of the port: bytes moved, timeouts, exceptions, the line errors counted by
+   *        the driver and the histograms of the time spent reading and writing.
+   *        Can be called from any thread while the port is in use.
+   */
+  UartStatistics GetStatistics(void) const;
+
+  /**
+   * @brief Reset the statistics of the port, the driver counters are not affected.
+   */
+  void ResetStatistics(void);
+
   /**
    * @brief Flush the input and output buffers
    */
@@ -456,7 +762,7 @@ private:
 
 private:  // Private Variables
   std::string       _port;                                // Path to the file descriptor
-  int32_t           _fd {};                               // The current file descriptor
+  int32_t           _fd { -1 };                           // The current file descriptor
 
   bool              _is_open {};
   bool              _xonxoff {};
@@ -470,18 +776,49 @@ private:  // Private Variables
   ByteSize          _bytesize { ByteSize::Eight };        // Size of the bytes
   StopBits          _stopbits { StopBits::One };          // Stop Bits
   FlowControl       _flowcontrol { FlowControl::None };   // Flow Control
+  bool              _lowLatency {};                       // Low latency mode
 
   pthread_mutex_t   _readMutex;                           // Mutex used to lock the read functions
   pthread_mutex_t   _writeMutex;                          // Mutex used to lock the write functions
 
+  RingBuffer        _rxBuffer;                            // Receive buffer, filled a chunk at a time
+  std::unique_ptr<RingBuffer> _txBuffer;                  // Transmit queue, only in queued transmit mode
+  std::function<void(void)> _txNotify;                    // Called when the transmit queue becomes non empty
+  UartCounters      _counters;                            // Statistics counters
+
+  struct RxMark {
+    uint64_t  position;                                   // Receive buffer position of the first byte
+    int64_t   timestamp;                                  // Arrival time, Clock::Default() nanoseconds
+  };
+
+  bool              _timestamping {};                     // Receive timestamps mode
+  RxMark            _rxMarks[RxTimestampMarks] {};        // Arrival time of the last chunks received
+  size_t            _rxMarksCount {};                     // Number of chunks marked
+
 private:  // Private Functions
   void ReconfigurePort(void);
-
-  size_t _Read (uint8_t * buffer, size_t size);            // Read common function
+  void ConfigureLowLatency(void);
+
+  UartResult Fail(UartError error, size_t value = 0, int32_t systemError = 0);  // Count and return an error
+
+  UartResult _Read (uint8_t * buffer, size_t size, int64_t * timestamp = nullptr);  // Read common function
+  UartResult _ReadLine(std::string & buffer, size_t size, const std::string & eol, int64_t * timestamp);
+  UartResult _ReadFrame(Framer & framer);                  // Read until the framer has a frame
+  bool _GetLine(std::string & buffer, size_t size, const std::string & eol, int64_t * timestamp);
+  bool _GetFrame(Framer & framer);                         // Feed the receive buffer to a framer
+  int64_t RxTimestamp(void) const;                         // Arrival time of the first byte in _rxBuffer
+  UartResult FillRxBuffer(int64_t timeoutMS);              // Wait for data and move a chunk into _rxBuffer
+  UartResult ReadIntoRxBuffer(void);                       // Move what the kernel has into _rxBuffer
+  UartResult PollReadable(uint32_t timeoutMS);             // Select on the descriptor, value 1 if readable
   void ReadLock(void);
   void ReadUnlock(void);
 
-  size_t _Write (const uint8_t * data, size_t length);     // Write common function
+  UartResult _Write (const uint8_t * data, size_t length); // Write common function
+  UartResult _Writev (const struct iovec * iov, size_t count);  // Gather write common function
+  UartResult _Send(const uint8_t * data, size_t size);     // Non blocking write common function
+  UartResult _Transmit(void);                              // Transmit common function
+  UartResult QueueWritev(const struct iovec * iov, size_t count); // Gather write into the transmit queue
+  UartResult TransmitQueue(void);                          // Drain the transmit queue, value is the bytes left
   void WriteLock(void);
   void WriteUnlock(void);
 };
@@ -0,0 +1,166 @@
+/*
+ * framer.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _SERIAL_FRAMER_HPP_
+#define _SERIAL_FRAMER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Airsoft::Drivers {
+
+/**
+ * @brief Encodings of the binary frames on a byte stream.
+ */
+enum class FrameEncoding {
+  Length8,                                                // 1 byte length followed by the payload
+  Length16,                                               // 2 bytes length, big endian, followed by the payload
+  Cobs,                                                   // Consistent overhead byte stuffing, 0x00 delimited
+  Slip,                                                   // RFC 1055, 0xC0 delimited
+};
+
+/**
+ * @brief Incremental decoder of framed binary streams.
+ *        The bytes are fed in chunks of any size, as they arrive, and a frame is ready as soon as its last
+ *        byte has been consumed: there is no need to wait for a read timeout to find the end of a packet.
+ *        The state machine is resumable at every byte and the payload is decoded into a buffer allocated
+ *        once, so no allocation is done per frame.
+ *        Empty frames are skipped. Frames longer than the maximum size and malformed frames are dropped and
+ *        counted, the delimited encodings resynchronize on the next delimiter.
+ *        The class is not thread safe.
+ */
+class Framer final {
+public:
+  /**
+   * @param encoding - Encoding of the stream.
+   * @param maxFrame - Largest payload accepted.
+   */
+  explicit Framer(FrameEncoding encoding, size_t maxFrame = 256);
+  virtual ~Framer();
+
+public:
+  /**
+   * @brief Decode bytes until a frame is complete or all the data has been used. The frame returned by
+   *        a previous call is released first.
+   * @param data - Bytes received.
+   * @param length - Number of bytes of data.
+   * @return Number of bytes consumed, less than length when a frame is ready.
+   */
+  size_t Consume(const uint8_t * data, size_t length);
+
+  /**
+   * @brief Decode a chunk calling handler(const uint8_t * frame, size_t length) for every frame completed.
+   */
+  template<typename Handler>
+  void Feed(const uint8_t * data, size_t length, Handler && handler) {
+    while (length > 0) {
+      size_t used { Consume(data, length) };
+
+      data += used;
+      length -= used;
+
+      if (_ready) {
+        handler(static_cast<const uint8_t*>(_frame), _length);
+      }
+    }
+  }
+
+  bool inline IsFrameReady(void) const {
+    return _ready;
+  }
+
+  /**
+   * @brief Payload of the ready frame, valid until the next Consume or Reset.
+   */
+  const uint8_t * GetFrame(void) const {
+    return _frame;
+  }
+
+  size_t inline GetFrameLength(void) const {
+    return _ready ? _length : 0;
+  }
+
+  FrameEncoding inline GetEncoding(void) const {
+    return _encoding;
+  }
+
+  size_t inline GetMaxFrame(void) const {
+    return _maxFrame;
+  }
+
+  /**
+   * @brief Drop the frame being decoded, the next byte is the start of a new frame.
+   */
+  void Reset(void);
+
+  uint64_t inline GetFrames(void) const {                 // Frames decoded
+    return _frames;
+  }
+
+  uint64_t inline GetErrors(void) const {                 // Malformed frames dropped
+    return _errors;
+  }
+
+  uint64_t inline GetOverflows(void) const {              // Frames dropped because longer than the maximum
+    return _overflows;
+  }
+
+  /**
+   * @brief Largest encoded size of a payload, delimiters and prefixes included.
+   */
+  static size_t MaxEncodedSize(FrameEncoding encoding, size_t length);
+
+  /**
+   * @brief Encode a payload as a complete frame.
+   * @param output - Destination, at least MaxEncodedSize bytes.
+   * @param size - Size of output.
+   * @return Length of the encoded frame, 0 if output is too small or the length can't be represented.
+   */
+  static size_t Encode(FrameEncoding encoding, const uint8_t * payload, size_t length, uint8_t * output, size_t size);
+
+private:
+  // Disable copy constructors
+  Framer(const Framer&);
+  Framer& operator=(const Framer&);
+
+  enum class State {
+    Start,                                                // Waiting for the first byte of a frame
+    Header,                                               // Length prefix being received
+    Payload,                                              // Frame bytes being received
+    Escape,                                               // SLIP escape received
+    Discard,                                              // Dropping the rest of a bad frame
+  };
+
+private:
+  FrameEncoding _encoding;
+  size_t        _maxFrame {};
+  uint8_t *     _frame {};                                // Decoded payload, _maxFrame bytes
+  size_t        _length {};                               // Bytes of _frame used
+  bool          _ready {};                                // _frame holds a complete frame
+
+  State         _state { State::Start };
+  size_t        _expected {};                             // Length prefix: payload length, or bytes to skip
+  uint8_t       _header {};                               // Length prefix: header bytes received
+  uint8_t       _code {};                                 // COBS: code of the current block
+  uint8_t       _left {};                                 // COBS: bytes left in the current block
+
+  uint64_t      _frames {};
+  uint64_t      _errors {};
+  uint64_t      _overflows {};
+
+private:
+  size_t ConsumeLength(const uint8_t * data, size_t length);
+  size_t ConsumeCobs(const uint8_t * data, size_t length);
+  size_t ConsumeSlip(const uint8_t * data, size_t length);
+  bool Append(uint8_t byte);
+  void Restart(void);
+  void Complete(void);
+};
+
+} // namespace Airsoft::Drivers
+
+#endif // _SERIAL_FRAMER_HPP_
@@ -0,0 +1,99 @@
+/*
+ * result.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _SERIAL_RESULT_HPP_
+#define _SERIAL_RESULT_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Airsoft::Drivers {
+
+/**
+ * @brief Outcome of an exception free uart operation.
+ */
+enum class UartError : int32_t {
+  None = 0,                                               // Completed
+  NotOpen,                                                // The port is not open
+  Timeout,                                                // Less than requested before the timeout
+  Busy,                                                   // Transmit queue full, nothing has been queued
+  Disconnected,                                           // Ready without data, the device has gone
+  System,                                                 // A system call failed, see SystemError
+};
+
+/**
+ * @brief Result of the Try functions of Uarts: the number of bytes moved and the error, if any.
+ *        Unlike an exception the count is valid also on error, e.g. the bytes received before a timeout.
+ *        Building and testing a result costs no allocation and no formatting.
+ */
+class UartResult final {
+public:
+  UartResult(size_t value = 0, UartError error = UartError::None, int32_t systemError = 0)
+    : _value(value), _error(error), _systemError(systemError) {
+  }
+
+public:
+  /**
+   * @brief True when the operation completed, no error.
+   */
+  bool inline HasValue(void) const {
+    return _error == UartError::None;
+  }
+
+  explicit operator bool(void) const {
+    return HasValue();
+  }
+
+  /**
+   * @brief Number of bytes read or written, set also on error.
+   */
+  size_t inline Value(void) const {
+    return _value;
+  }
+
+  UartError inline Error(void) const {
+    return _error;
+  }
+
+  /**
+   * @brief The errno of the failed system call when Error is UartError::System, otherwise 0.
+   */
+  int32_t inline SystemError(void) const {
+    return _systemError;
+  }
+
+  /**
+   * @brief Static description of an error, for logs.
+   */
+  static const char * Describe(UartError error) {
+    switch (error) {
+      case UartError::None:
+        return "none";
+      case UartError::NotOpen:
+        return "port not open";
+      case UartError::Timeout:
+        return "timeout";
+      case UartError::Busy:
+        return "transmit queue full";
+      case UartError::Disconnected:
+        return "device disconnected";
+      case UartError::System:
+        return "system error";
+    }
+
+    return "unknown";
+  }
+
+private:
+  size_t    _value {};
+  UartError _error { UartError::None };
+  int32_t   _systemError {};
+};
+
+} // namespace Airsoft::Drivers
+
+#endif // _SERIAL_RESULT_HPP_
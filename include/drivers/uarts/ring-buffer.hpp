@@ -0,0 +1,146 @@
+/*
+ * ring-buffer.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _SERIAL_RING_BUFFER_HPP_
+#define _SERIAL_RING_BUFFER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace Airsoft::Drivers {
+
+/**
+ * @brief Byte ring buffer used to stage data between the kernel and the uart consumers.
+ *        The capacity is rounded up to a power of two so positions are masked instead of divided.
+ *        Read and write positions are free running 64 bit counters, so every byte keeps an absolute
+ *        position in the stream.
+ *        The class is not thread safe, the owner is in charge of the locking.
+ */
+class RingBuffer final {
+public:
+  /**
+   * @brief Value returned by Find when the pattern is not in the buffer.
+   */
+  static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+public:
+  explicit RingBuffer(size_t capacity = 4096);
+  virtual ~RingBuffer();
+
+public:
+  size_t inline Size(void) const {
+    return static_cast<size_t>(_head - _tail);
+  }
+
+  size_t inline Capacity(void) const {
+    return _capacity;
+  }
+
+  size_t inline Free(void) const {
+    return _capacity - Size();
+  }
+
+  bool inline Empty(void) const {
+    return _head == _tail;
+  }
+
+  /**
+   * @brief Absolute stream position of the first readable byte.
+   */
+  uint64_t inline ReadPosition(void) const {
+    return _tail;
+  }
+
+  /**
+   * @brief Absolute stream position of the next byte that will be written.
+   */
+  uint64_t inline WritePosition(void) const {
+    return _head;
+  }
+
+  /**
+   * @brief Discard all the buffered data.
+   */
+  void Clear(void);
+
+  /**
+   * @brief Largest contiguous free region, data can be written there directly (e.g. by read(2)) and
+   *        then published with Commit.
+   * @param length - Filled with the length of the region, 0 when the buffer is full.
+   * @return Pointer to the first free byte.
+   */
+  uint8_t * WriteRegion(size_t & length);
+
+  /**
+   * @brief Publish length bytes written into the region returned by WriteRegion.
+   */
+  void Commit(size_t length);
+
+  /**
+   * @brief Largest contiguous readable region starting at the read position.
+   * @param length - Filled with the length of the region, 0 when the buffer is empty.
+   * @return Pointer to the first readable byte.
+   */
+  const uint8_t * ReadRegion(size_t & length) const;
+
+  /**
+   * @brief Drop length bytes from the read side.
+   */
+  void Consume(size_t length);
+
+  /**
+   * @brief Copy data into the buffer.
+   * @return Number of bytes stored, less than length if the buffer is full.
+   */
+  size_t Write(const uint8_t * data, size_t length);
+
+  /**
+   * @brief Copy data out of the buffer without consuming it.
+   * @param offset - Offset from the read position of the first byte to copy.
+   * @return Number of bytes copied.
+   */
+  size_t Peek(uint8_t * data, size_t length, size_t offset = 0) const;
+
+  /**
+   * @brief Copy and consume data from the buffer.
+   * @return Number of bytes copied.
+   */
+  size_t Read(uint8_t * data, size_t length);
+
+  /**
+   * @brief Append and consume data from the buffer into a string.
+   * @return Number of bytes appended.
+   */
+  size_t Read(std::string & buffer, size_t length);
+
+  /**
+   * @brief Search a byte sequence inside the buffered data, first byte is located with memchr.
+   * @param pattern - Sequence to search.
+   * @param length - Length of the sequence, an empty sequence is never found.
+   * @param offset - Offset from the read position where the search starts.
+   * @return Offset of the first byte of the sequence from the read position or npos.
+   */
+  size_t Find(const uint8_t * pattern, size_t length, size_t offset = 0) const;
+
+private:
+  // Disable copy constructors
+  RingBuffer(const RingBuffer&);
+  RingBuffer& operator=(const RingBuffer&);
+
+private:
+  uint8_t * _data {};                                     // Storage
+  size_t    _capacity {};                                 // Storage size, power of two
+  size_t    _mask {};                                     // Mask for the positions
+  uint64_t  _head {};                                     // Write position
+  uint64_t  _tail {};                                     // Read position
+};
+
+} // namespace Airsoft::Drivers
+
+#endif // _SERIAL_RING_BUFFER_HPP_
@@ -0,0 +1,120 @@
+/*
+ * statistics.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _SERIAL_STATISTICS_HPP_
+#define _SERIAL_STATISTICS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+
+namespace Airsoft::Drivers {
+
+/**
+ * @brief Number of buckets of the duration histograms. Bucket 0 counts the calls shorter than 1 us,
+ *        bucket N the calls lasting [2^(N-1), 2^N) us, the last one everything longer (about 8 s).
+ */
+constexpr size_t StatisticsBuckets = 24;
+
+/**
+ * @brief Snapshot of the statistics of a uart port.
+ */
+struct UartStatistics {
+  uint64_t  BytesRead {};                                 // Bytes received from the kernel
+  uint64_t  BytesWritten {};                              // Bytes accepted by the kernel
+  uint64_t  ReadTimeouts {};                              // Reads returned before the requested size
+  uint64_t  WriteTimeouts {};                             // Writes returned before the requested size
+  uint64_t  Errors {};                                    // Errors of the read/write paths, thrown or returned
+  uint64_t  TransmitRefused {};                           // Writes refused because the transmit queue was full
+
+  // Driver counters (TIOCGICOUNT), zero when the driver doesn't provide them
+  uint32_t  Overruns {};                                  // Hardware FIFO overruns
+  uint32_t  BufferOverruns {};                            // Tty buffer overruns
+  uint32_t  FramingErrors {};
+  uint32_t  ParityErrors {};
+  uint32_t  Breaks {};
+
+  uint64_t  ReadTime[StatisticsBuckets] {};               // Histogram of the time spent in a read
+  uint64_t  WriteTime[StatisticsBuckets] {};              // Histogram of the time spent in a write
+};
+
+/**
+ * @brief Live counters of a uart port. Updates are relaxed atomic increments, cheap enough to be always on,
+ *        and can be done from any thread.
+ */
+class UartCounters final {
+public:
+  UartCounters() = default;
+  virtual ~UartCounters() = default;
+
+public:
+  void inline BytesRead(size_t count) {
+    _bytesRead.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void inline BytesWritten(size_t count) {
+    _bytesWritten.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void inline ReadTimeout(void) {
+    _readTimeouts.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void inline WriteTimeout(void) {
+    _writeTimeouts.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void inline Error(void) {
+    _errors.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void inline TransmitRefused(void) {
+    _transmitRefused.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void inline ReadTime(int64_t nanoseconds) {
+    _readTime[Bucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void inline WriteTime(int64_t nanoseconds) {
+    _writeTime[Bucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Copy the counters into a snapshot, the driver counters are left untouched.
+   */
+  void Snapshot(UartStatistics & statistics) const;
+
+  /**
+   * @brief Set all the counters to zero.
+   */
+  void Reset(void);
+
+  /**
+   * @brief Histogram bucket of a duration.
+   */
+  static size_t Bucket(int64_t nanoseconds);
+
+private:
+  // Disable copy constructors
+  UartCounters(const UartCounters&);
+  UartCounters& operator=(const UartCounters&);
+
+private:
+  std::atomic<uint64_t> _bytesRead {};
+  std::atomic<uint64_t> _bytesWritten {};
+  std::atomic<uint64_t> _readTimeouts {};
+  std::atomic<uint64_t> _writeTimeouts {};
+  std::atomic<uint64_t> _errors {};
+  std::atomic<uint64_t> _transmitRefused {};
+  std::atomic<uint64_t> _readTime[StatisticsBuckets] {};
+  std::atomic<uint64_t> _writeTime[StatisticsBuckets] {};
+};
+
+} // namespace Airsoft::Drivers
+
+#endif // _SERIAL_STATISTICS_HPP_
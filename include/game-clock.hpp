@@ -0,0 +1,207 @@
+/**
+ *******************************************************************************
+ * @file game-clock.hpp
+ *
+ * @brief UTC time shared by the devices of a game, disciplined from the GPS
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#ifndef GAME_CLOCK_HPP_
+#define GAME_CLOCK_HPP_
+
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+#include <drivers/clock.hpp>
+#include <drivers/gpio.hpp>
+#include <classes/seqlock.hpp>
+
+namespace Airsoft {
+
+constexpr int64_t GameClockStepNS = 500 * Airsoft::Drivers::NanosecondsPerMillisecond;  // Larger errors step the time
+
+/**
+ * @brief Reference the game clock is disciplined from.
+ */
+enum class GameClockSource : uint8_t {
+  None,                                                   // System time at Init, not synchronized
+  Sentences,                                              // GPS time of the fixes and their arrival time
+  Pps,                                                    // Pulse per second of the receiver on a GPIO
+};
+
+struct GameClockSettings {
+  int32_t ppsGpio { -1 };                                 // GPIO id of the PPS output, -1 without
+  bool    ppsFalling {};                                  // The second starts on the falling edge
+  int64_t sentenceLatencyNS {};                           // Epoch to arrival of its first byte, receiver and baudrate
+};
+
+/**
+ * @brief UTC time for game timers that agrees between devices.
+ *        The time is the monotonic time of Clock::Default() plus an offset, disciplined by a phase and frequency
+ *        loop from the GPS: every fix gives the UTC of its epoch and the arrival time of its data, the fastest
+ *        arrivals of the last samples are used since delays only make a sample late. With a PPS input the edges
+ *        give the start of each second with microseconds of jitter, the sentences only number the seconds.
+ *        The first sample, the first pulse and errors above GameClockStepNS step the time, the others are
+ *        slewed: between steps Now() never goes back and never jumps.
+ *        Without samples (holdover) the slew stops when the next sample was due and the frequency correction
+ *        fades out, a wrong estimate can only move the time by a bounded amount.
+ *        Now() and the conversions are lock-free and can be called by any thread; samples can come from any
+ *        thread too.
+ */
+class GameClock final {
+public:
+  /**
+   * @param clock - Monotonic time, Clock::Default() if nullptr.
+   */
+  explicit GameClock(const Airsoft::Drivers::Clock * clock = nullptr);
+  virtual ~GameClock();
+
+public:
+  /**
+   * @brief Start from the system time and start waiting for the PPS edges if configured.
+   */
+  bool Init(const GameClockSettings & settings = GameClockSettings());
+  void Terminate(void);
+
+  /**
+   * @brief UTC nanoseconds since the epoch.
+   */
+  int64_t Now(void) const {
+    return ToUtc(Monotonic());
+  }
+
+  int64_t inline NowMS(void) const {
+    return Now() / Airsoft::Drivers::NanosecondsPerMillisecond;
+  }
+
+  /**
+   * @brief UTC of a timestamp of the monotonic clock, e.g. the arrival time of data.
+   */
+  int64_t ToUtc(int64_t monotonic) const;
+
+  /**
+   * @brief Monotonic time of a UTC instant, e.g. to build a Deadline for the end of a countdown.
+   */
+  int64_t ToMonotonic(int64_t utc) const;
+
+  bool inline IsSynchronized(void) const {
+    return GetSource() != GameClockSource::None;
+  }
+
+  GameClockSource GetSource(void) const;
+
+  /**
+   * @brief Average of the phase errors measured, nanoseconds: the agreement expected with the reference.
+   */
+  int64_t inline GetError(void) const {
+    return _error.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Frequency correction of the monotonic clock, parts per million.
+   */
+  double GetFrequency(void) const;
+
+  uint64_t inline GetSamples(void) const {
+    return _samples.load(std::memory_order_relaxed);
+  }
+
+  uint64_t inline GetSteps(void) const {
+    return _steps.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Sample from a fix.
+   * @param utc - UTC nanoseconds of the epoch of the fix.
+   * @param arrival - Monotonic time of the arrival of the first byte of the fix.
+   */
+  void OnTime(int64_t utc, int64_t arrival);
+
+  /**
+   * @brief Sample from a PPS edge.
+   * @param edge - Monotonic time of the edge.
+   */
+  void OnPulse(int64_t edge);
+
+private:
+  // Disable copy constructors
+  GameClock(const GameClock&);
+  GameClock& operator=(const GameClock&);
+
+  /**
+   * @brief Published state: utc = base + (monotonic - origin) * (1 + frequency + slew) until hold, then the slew
+   *        stops and the frequency fades out.
+   */
+  struct Discipline {
+    int64_t         origin {};
+    int64_t         base {};
+    int64_t         hold {};                              // Monotonic time the next sample was due by
+    double          frequency {};
+    double          slew {};                              // Phase correction
+    GameClockSource source { GameClockSource::None };
+  };
+
+  static constexpr size_t FilterSamples = 8;
+
+private:
+  const Airsoft::Drivers::Clock *       _clock {};
+  GameClockSettings                     _settings;
+  Airsoft::Classes::Seqlock<Discipline> _discipline;
+
+  // Loop state, guarded by _lock
+  std::mutex                            _lock;
+  Discipline                            _state {};
+  int64_t                               _filter[FilterSamples] {};  // Offsets of the last sentences
+  size_t                                _filterCount {};
+  int64_t                               _lastUpdate {};             // Monotonic time of the last sample used
+  int64_t                               _lastPulse {};              // Monotonic time of the last PPS edge
+
+  std::atomic<int64_t>                  _error {};
+  std::atomic<uint64_t>                 _samples {};
+  std::atomic<uint64_t>                 _steps {};
+
+  // PPS
+  Airsoft::Drivers::Gpio              * _pps {};
+  std::thread                         * _process {};
+  std::atomic<bool>                     _threadRunning {};
+
+private:
+  int64_t inline Monotonic(void) const {
+    return (_clock != nullptr ? *_clock : Airsoft::Drivers::Clock::Default()).Now();
+  }
+
+  static double Correction(const Discipline & discipline, int64_t elapsed);
+  static int64_t ToUtc(const Discipline & discipline, int64_t monotonic);
+
+  void Update(int64_t offset, int64_t at, GameClockSource source);
+  void Engine(void);
+};
+
+} // namespace Airsoft
+
+#endif // GAME_CLOCK_HPP_
@@ -34,32 +34,252 @@
 
 #include <string>
 #include <cstring>
+#include <atomic>
+#include <functional>
+#include <mutex>
 #include <thread>
+#include <condition_variable>
+
+#include <drivers/uarts.hpp>
+#include <drivers/uart-reactor.hpp>
+#include <classes/seqlock.hpp>
+#include <gps/nmea.hpp>
+#include <gps/ubx.hpp>
+#include <gps/state.hpp>
+#include <gps/track-log.hpp>
+#include <gps/replay.hpp>
+#include <gps/filter.hpp>
+#include <gps/stream.hpp>
+#include <gps/nmea-pty.hpp>
+#include <gps/quality.hpp>
 
 namespace Airsoft {
 
+class GameClock;
+
+/**
+ * @brief Protocol spoken with the receiver.
+ */
+enum class GpsProtocol {
+  Nmea,                                                   // Text sentences at the power up settings of the receiver
+  Ubx,                                                    // u-blox binary NAV-PVT at a higher rate and baudrate
+};
+
+struct GpsSettings {
+  GpsProtocol protocol { GpsProtocol::Nmea };
+  uint32_t    baudrate { 9600 };                          // Baudrate of the receiver at power up
+  uint32_t    ubxBaudrate { 115200 };                     // UBX: baudrate set on the receiver
+  uint16_t    rate { 10 };                                // UBX: solutions per second, 1 to 10
+  std::string stateFile;                                  // Last position and receiver state, empty to disable
+  uint32_t    saveIntervalS { 60 };                       // Save of the state while running, 0 only at Terminate
+  std::string trackFile;                                  // History of the positions, empty to disable
+  size_t      trackSize { 8 * 1024 * 1024 };              // Bytes of the track file, the oldest points are reused
+  bool        filter { true };                            // Filtered position in the fixes published
+  GpsFilterSettings filterSettings;                       // Noise of the players and of the receiver
+  std::string nmeaPty;                                    // Link to a pseudo terminal with the sentences, e.g. for gpsd
+};
+
 class Gps final {
 public:
   Gps();
   virtual ~Gps();
 
 public:
-  bool Init(std::string port);
+  /**
+   * @brief Open the receiver port and add it to the reactor, sentences are processed on the reactor thread.
+   *        With GpsProtocol::Ubx the receiver is configured first, if it doesn't answer the NMEA sentences
+   *        at the power up baudrate are used.
+   *        With a state file the position and the time of the last session are sent to the receiver as
+   *        aiding data (UBX MGA-INI, ignored by receivers other than u-blox) and the state is saved again
+   *        every saveIntervalS seconds with a fix and at Terminate. The file is written on a thread of its own,
+   *        the reactor thread never waits for the storage.
+   *        With a track file every valid fix is appended to it, see TrackLog.
+   *        A port "replay:path[?speed=factor]" plays a recorded log in place of the receiver, see GpsReplay: the
+   *        protocol is the one of the log and the receiver is not configured.
+   *        With filter the fixes published carry the position smoothed by a GpsFilter too (FixHasFiltered), the
+   *        state file and the track keep the positions of the receiver.
+   *        The data read from the port is shared with the subscribers of GetStream(); with nmeaPty the sentences
+   *        are sent on a pseudo terminal linked there too, see GpsNmeaPty.
+   *        Every fix published carries its trust (FixHasTrust), from the satellites and the DOP, see GpsQuality:
+   *        below GpsTrustUsable the position should not drive the game.
+   */
+  bool Init(std::string port, Airsoft::Drivers::UartReactor & reactor, const GpsSettings & settings = GpsSettings());
   void Terminate(void);
 
+  /**
+   * @brief Clock disciplined with the time and the arrival of every valid fix, nullptr to stop. Set it before Init.
+   */
+  void inline SetGameClock(GameClock * clock) {
+    _gameClock = clock;
+  }
+
+  /**
+   * @brief Called on the reactor thread with every fix published, once per epoch: the place for the work that
+   *        has to see each fix, e.g. a Geofence. It must not block. Set it before Init.
+   */
+  void inline SetFixHandler(std::function<void(const GpsFix &)> handler) {
+    _fixHandler = std::move(handler);
+  }
+
   bool inline IsReady(void) {
     return _ready;
   }
 
+  /**
+   * @brief Protocol in use, valid after Init.
+   */
+  GpsProtocol inline GetProtocol(void) const {
+    return _protocol;
+  }
+
+  /**
+   * @brief Milliseconds from Init to the first valid position, 0 until then.
+   */
+  uint32_t inline GetTimeToFirstFix(void) const {
+    return _timeToFirstFix.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Arrival time of the last sentence received, Clock::Default() nanoseconds.
+   */
+  int64_t inline GetSentenceTime(void) {
+    return _sentenceTime;
+  }
+
+  /**
+   * @brief Copy of the last fix published, any thread. The reader never blocks the reactor thread and never
+   *        sees a fix half updated.
+   * @return Generation of the fix, 0 if no fix has been published yet.
+   */
+  uint64_t inline GetFix(GpsFix & fix) const {
+    return _published.Load(fix);
+  }
+
+  /**
+   * @brief Copy the last fix only if it is newer than generation, updating generation.
+   * @return True if fix has been updated.
+   */
+  bool inline GetFixIfChanged(GpsFix & fix, uint64_t & generation) const {
+    return _published.LoadIfChanged(fix, generation);
+  }
+
+  /**
+   * @brief Number of fixes published, increments once per epoch: NMEA when its RMC and GGA have arrived, UBX
+   *        on NAV-PVT.
+   */
+  uint64_t inline GetGeneration(void) const {
+    return _published.GetGeneration();
+  }
+
+  /**
+   * @brief Decoder of the sentences, for its counters. Fix and counters are updated by the reactor thread.
+   */
+  const NmeaParser & GetParser(void) const {
+    return _parser;
+  }
+
+  /**
+   * @brief Track of the session, points appended by the reactor thread.
+   */
+  const TrackLog & GetTrack(void) const {
+    return _track;
+  }
+
+  /**
+   * @brief Filter of the positions, for its counters. Updated by the reactor thread.
+   */
+  const GpsFilter & GetFilter(void) const {
+    return _filter;
+  }
+
+  /**
+   * @brief Satellites and trust of the fixes. Updated by the reactor thread.
+   */
+  const GpsQuality & GetQuality(void) const {
+    return _quality;
+  }
+
+  /**
+   * @brief Data read from the port, as it arrives: subscribe to read it along with the parsers. A subscriber
+   *        that doesn't keep up loses data, Gps is never slowed down.
+   */
+  GpsStream & GetStream(void) {
+    return _stream;
+  }
+
+  /**
+   * @brief Pseudo terminal with the sentences, open with nmeaPty.
+   */
+  const GpsNmeaPty & GetNmeaPty(void) const {
+    return _nmeaPty;
+  }
+
+  /**
+   * @brief Player of the log when the port is a replay, not open otherwise.
+   */
+  const GpsReplay & GetReplay(void) const {
+    return _replay;
+  }
+
+  /**
+   * @brief Statistics of the port, false if the port is not open.
+   */
+  bool GetStatistics(Airsoft::Drivers::UartStatistics & statistics) const;
+
 private:
-  std::thread * _process {};      // Pointer to thread
-  bool          _threadRunning {};         // Running flag for thread
-  std::string   _port;
+  std::string                       _port;
+  Airsoft::Drivers::Uarts         * _serial {};
+  Airsoft::Drivers::UartReactor   * _reactor {};
+  GpsSettings                       _settings;
+  GpsProtocol                       _protocol { GpsProtocol::Nmea };
+  uint8_t                           _chunk[256] {};    // Data taken from the receive buffer while configuring
+  int64_t                           _sentenceTime {};  // Arrival time of the last sentence
+  NmeaParser                        _parser;
+  UbxParser                         _ubx;
+  GpsFix                            _fix {};      // UBX: NAV-PVT merged with the satellites of the sentences
+  GpsFix                            _epochFix {}; // NMEA: fix at the last position sentence of the epoch
+  int64_t                           _epochTime {};      // NMEA: time of day of the epoch, -1 without time
+  uint8_t                           _epochSentences {}; // NMEA: position sentences of the epoch received
+  uint8_t                           _epochExpected {};  // NMEA: position sentences the receiver sends
+  uint8_t                           _epochPrevious {};  // NMEA: position sentences of the previous epoch
+  bool                              _epochPublished {};
+  Airsoft::Classes::Seqlock<GpsFix> _published;   // Last fix, written by the reactor thread only
+
+  GpsStateFile                      _stateFile;
+  GpsState                          _state {};    // Last position, updated by the reactor thread
+  bool                              _aided {};    // Aiding data sent at Init
+  int64_t                           _started {};  // Clock::Default() at Init
+  int64_t                           _saved {};    // Clock::Default() at the last save of the state
+  GpsState                          _saving {};   // Copy of the state for the save thread, guarded by _saveLock
+  bool                              _savePending {};
+  std::mutex                        _saveLock;
+  std::condition_variable           _saveSignal;
+  std::thread                     * _process {};  // Writes the state file
+  std::atomic<bool>                 _threadRunning {};
+  std::atomic<uint32_t>             _timeToFirstFix {};
+  TrackLog                          _track;
+  GpsReplay                         _replay;
+  GpsFilter                         _filter;
+  GpsQuality                        _quality;
+  GpsStream                         _stream;      // Chunks read by the reactor thread
+  GpsNmeaPty                        _nmeaPty;
+  GameClock                       * _gameClock {};
+  std::function<void(const GpsFix &)> _fixHandler;
 
   bool          _ready {};
 
 private:
+  void OnReadable(void);
+  void OnSentence(NmeaSentence sentence);
+  void OnMessage(UbxMessage message);
+  void OnPosition(NmeaSentence sentence);
+  void Publish(const GpsFix & fix);
+  void SendAiding(void);
+  void SaveState(void);
+  void StopSaving(void);
   void Engine(void);
+  bool ConfigureUbx(void);
+  bool SendUbx(const uint8_t * message, size_t length);
 
 };
 
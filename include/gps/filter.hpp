@@ -0,0 +1,98 @@
+/*
+ * filter.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_FILTER_HPP_
+#define _GPS_FILTER_HPP_
+
+#include <cstdint>
+
+#include <gps/fix.hpp>
+#include <gps/local-plane.hpp>
+
+namespace Airsoft {
+
+struct GpsFilterSettings {
+  float     acceleration { 1.5f };                        // m/s^2, changes of speed of a player, process noise
+  float     rangeError { 4.0f };                          // Meters, user range error: sigma of a fix is hdop times it
+  float     defaultError { 10.0f };                       // Meters, sigma of a fix without accuracy and hdop
+  float     gate { 16.0f };                               // Squared innovation over its variance to reject a fix
+  uint32_t  maxRejected { 5 };                            // Fixes rejected in a row before the filter is reset
+  uint32_t  maxGapMS { 5000 };                            // Time without fixes before the filter is reset
+};
+
+/**
+ * @brief Smoothing of the positions: a constant velocity Kalman filter in the local plane of the first fix.
+ *        The two axes share the same model and the same measurement noise, so they share the covariance: a
+ *        2x2 matrix and two states of position and velocity, float32, a few tens of operations per fix.
+ *        The noise of a fix is its horizontal accuracy when the receiver reports it (UBX), otherwise the HDOP
+ *        times the user range error. A fix whose innovation is beyond the gate, e.g. a reflection under the
+ *        trees, is rejected and the prediction is given instead; after maxRejected in a row the fix is taken as
+ *        the new position, the filter doesn't stay locked on a wrong track.
+ */
+class GpsFilter final {
+public:
+  explicit GpsFilter(const GpsFilterSettings & settings = GpsFilterSettings()) : _settings(settings) { }
+  virtual ~GpsFilter() = default;
+
+public:
+  void SetSettings(const GpsFilterSettings & settings) {
+    _settings = settings;
+  }
+
+  /**
+   * @brief Add a fix and set its filtered fields (FixHasFiltered). A fix with the time of the previous one
+   *        (RMC and GGA of the same epoch) only gets the estimate, fixes without position are left as they are.
+   * @return False if the position of the fix has been rejected.
+   */
+  bool Apply(GpsFix & fix);
+
+  /**
+   * @brief Start again from the next fix.
+   */
+  void Reset(void) {
+    _started = false;
+  }
+
+  uint64_t inline GetUpdates(void) const {
+    return _updates;
+  }
+
+  uint64_t inline GetRejected(void) const {
+    return _rejected;
+  }
+
+  uint64_t inline GetResets(void) const {
+    return _resets;
+  }
+
+private:
+  GpsFilterSettings _settings;
+  LocalPlane        _plane;
+  bool              _started {};
+  uint32_t          _time {};                             // Time of day of the last fix, milliseconds
+  uint32_t          _rejectedInRow {};
+
+  // State: position and velocity east, position and velocity north; covariance of each axis
+  float             _x[2] {};
+  float             _y[2] {};
+  float             _p00 {};
+  float             _p01 {};
+  float             _p11 {};
+
+  uint64_t          _updates {};
+  uint64_t          _rejected {};
+  uint64_t          _resets {};
+
+private:
+  void Start(const GpsFix & fix, float x, float y, float variance);
+  void Output(GpsFix & fix) const;
+  float Variance(const GpsFix & fix) const;
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_FILTER_HPP_
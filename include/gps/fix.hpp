@@ -0,0 +1,136 @@
+/*
+ * fix.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_FIX_HPP_
+#define _GPS_FIX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Airsoft {
+
+constexpr size_t GpsMaxSatellites = 48;                   // Satellites in view kept, all the constellations
+constexpr size_t GpsMaxUsed = 24;                         // Satellites used in the solution kept
+constexpr uint8_t GpsTrustUsable = 50;                    // Trust of a fix good enough for the game, see GpsQuality
+
+/**
+ * @brief Constellation of a satellite, from the talker of the sentence.
+ */
+enum class GpsSystem : uint8_t {
+  Unknown = 0,
+  Gps,                                                    // GP
+  Glonass,                                                // GL
+  Galileo,                                                // GA
+  Beidou,                                                 // GB, BD
+  Qzss,                                                   // GQ
+};
+
+/**
+ * @brief Fields of GpsFix set by at least one sentence, see GpsFix::valid.
+ */
+enum GpsFixFlags : uint16_t {
+  FixHasTime        = 0x0001,                             // hour, minute, second, millisecond
+  FixHasDate        = 0x0002,                             // year, month, day
+  FixHasPosition    = 0x0004,                             // latitude, longitude, the receiver reports a valid fix
+  FixHasAltitude    = 0x0008,                             // altitude, geoidSeparation
+  FixHasSpeed       = 0x0010,                             // speed
+  FixHasCourse      = 0x0020,                             // course
+  FixHasDop         = 0x0040,                             // pdop, hdop, vdop
+  FixHasSatellites  = 0x0080,                             // satellites in view
+  FixHasAccuracy    = 0x0100,                             // horizontalAccuracy, verticalAccuracy
+  FixHasFiltered    = 0x0200,                             // filtered position and velocity, set by GpsFilter
+  FixHasTrust       = 0x0400,                             // trust, set by GpsQuality
+};
+
+/**
+ * @brief A satellite in view, from GSV.
+ */
+struct GpsSatellite {
+  uint16_t  prn {};
+  uint16_t  azimuth {};                                   // Degrees from true north
+  int8_t    elevation {};                                 // Degrees, 90 at the zenith
+  int8_t    snr { -1 };                                   // dBHz, -1 when not tracked
+  GpsSystem system { GpsSystem::Unknown };
+};
+
+/**
+ * @brief Navigation solution decoded from the receiver.
+ *        The struct has a fixed size, it can be copied without allocations and published to other threads
+ *        as a plain value. Latitude and longitude are integers so that no precision is lost decoding the text.
+ */
+struct GpsFix {
+  uint16_t      valid {};                                 // GpsFixFlags of the fields set
+  int64_t       arrival {};                               // Clock::Default() nanoseconds, arrival of the last sentence
+
+  // UTC time and date
+  uint16_t      year {};
+  uint8_t       month {};
+  uint8_t       day {};
+  uint8_t       hour {};
+  uint8_t       minute {};
+  uint8_t       second {};
+  uint16_t      millisecond {};
+
+  // Position
+  int32_t       latitude {};                              // Degrees * 1e7, positive north
+  int32_t       longitude {};                             // Degrees * 1e7, positive east
+  float         altitude {};                              // Meters above the mean sea level
+  float         geoidSeparation {};                       // Meters, geoid above the ellipsoid
+
+  // Motion
+  float         speed {};                                 // Meters per second over ground
+  float         course {};                                // Degrees from true north
+
+  // Quality
+  uint8_t       quality {};                               // GGA fix quality, 0 invalid, 1 GPS, 2 DGPS, 4 RTK...
+  uint8_t       mode { 1 };                               // GSA fix type, 1 none, 2 2D, 3 3D
+  uint8_t       satellitesUsed {};                        // GGA satellites used
+  float         pdop {};
+  float         hdop {};
+  float         vdop {};
+  float         horizontalAccuracy {};                    // Meters, estimated by the receiver (UBX only)
+  float         verticalAccuracy {};                      // Meters, estimated by the receiver (UBX only)
+  uint8_t       trust {};                                 // 0 to 100, see GpsQuality
+
+  // Filtered, see GpsFilter
+  int32_t       filteredLatitude {};                      // Degrees * 1e7
+  int32_t       filteredLongitude {};                     // Degrees * 1e7
+  float         velocityEast {};                          // Meters per second
+  float         velocityNorth {};                         // Meters per second
+  float         filteredAccuracy {};                      // Meters, sigma of the filtered position
+
+  // Satellites
+  uint8_t       usedCount {};
+  uint16_t      used[GpsMaxUsed] {};                      // PRN of the satellites used, from GSA
+  GpsSystem     usedSystem[GpsMaxUsed] {};                // Constellation of each, Unknown with GN before NMEA 4.10
+  uint8_t       satelliteCount {};
+  GpsSatellite  satellites[GpsMaxSatellites] {};          // Satellites in view, from GSV
+
+public:
+  bool inline Has(uint16_t flags) const {
+    return (valid & flags) == flags;
+  }
+
+  double inline LatitudeDegrees(void) const {
+    return latitude * 1e-7;
+  }
+
+  double inline LongitudeDegrees(void) const {
+    return longitude * 1e-7;
+  }
+
+  /**
+   * @brief Milliseconds since midnight UTC.
+   */
+  uint32_t inline TimeOfDay(void) const {
+    return ((hour * 60u + minute) * 60u + second) * 1000u + millisecond;
+  }
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_FIX_HPP_
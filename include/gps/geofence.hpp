@@ -0,0 +1,230 @@
+/*
+ * geofence.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_GEOFENCE_HPP_
+#define _GPS_GEOFENCE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gps/fix.hpp>
+#include <gps/local-plane.hpp>
+
+namespace Airsoft {
+
+constexpr size_t GeofenceMaxZones = 1024;
+constexpr size_t GeofenceMaxVertices = 256;               // Per zone
+constexpr size_t GeofenceMaxTargets = 64;                 // Positions tracked
+constexpr size_t GeofenceMaxInside = 16;                  // Zones a target can be inside at the same time
+constexpr size_t GeofenceMaxCells = 65536;
+
+/**
+ * @brief Role of a zone in the game.
+ */
+enum class GeofenceZoneType : uint8_t {
+  Capture,
+  Spawn,
+  OutOfBounds,
+  Other,
+};
+
+enum class GeofenceEventType : uint8_t {
+  Enter,                                                  // Inside by the hysteresis
+  Exit,                                                   // Outside by the hysteresis
+  Dwell,                                                  // Inside for the dwell time, once per stay
+};
+
+struct GeofenceEvent {
+  GeofenceEventType type {};
+  uint16_t          zone {};                              // Index of the zone, see GetZone
+  uint16_t          target {};
+  int64_t           time {};                              // Time of the position
+  int64_t           since {};                             // Time of the enter
+};
+
+struct GeofenceSettings {
+  float   hysteresis { 3.0f };                            // Meters beyond the border to enter or exit
+  int64_t dwellNS { 10000000000 };                        // Stay for the dwell event, 0 disabled
+  float   cellSize {};                                    // Meters, 0 chosen from the zones
+  uint8_t minTrust { GpsTrustUsable };                    // Fixes trusted less are skipped, 0 none
+};
+
+/**
+ * @brief A zone: a simple polygon, closed implicitly, in the local plane of the engine.
+ */
+struct GeofenceZone {
+  std::string       name;
+  GeofenceZoneType  type { GeofenceZoneType::Other };
+  uint32_t          first {};                             // First vertex in the engine
+  uint32_t          count {};
+  float             minX {}, minY {}, maxX {}, maxY {};   // Bounding box
+};
+
+/**
+ * @brief Zones of the game evaluated for every position received.
+ *        The zones are added in degrees and projected once to a local plane centered on them. A uniform grid
+ *        keeps for every cell the zones whose box, grown by the hysteresis, overlaps it: a position is tested
+ *        only against the zones of its cell and those it is inside. A zone is entered when the position is inside
+ *        it by the hysteresis and left when it is outside by the hysteresis, so the noise of the fix on the
+ *        border doesn't produce events.
+ *        Zones are added before Build, positions are processed by one thread.
+ */
+class Geofence final {
+public:
+  Geofence() = default;
+  virtual ~Geofence() = default;
+
+public:
+  /**
+   * @brief Add a zone.
+   * @param latitudes - Degrees * 1e7.
+   * @param longitudes - Degrees * 1e7.
+   * @return Index of the zone, -1 if the zone is not valid or the limits are reached.
+   */
+  int32_t AddZone(const std::string & name, GeofenceZoneType type, const int32_t * latitudes,
+                  const int32_t * longitudes, size_t count);
+
+  /**
+   * @brief Add a zone from the configuration: "name,type,lat lon;lat lon;...", degrees, type one of capture,
+   *        spawn, out, other.
+   */
+  int32_t AddZone(const std::string & definition);
+
+  /**
+   * @brief Project the zones and build the grid, the state of the targets is cleared.
+   */
+  bool Build(const GeofenceSettings & settings = GeofenceSettings());
+
+  /**
+   * @brief Process a position of a target calling handler(const GeofenceEvent & event) for every event.
+   * @param target - Index of the target, less than GeofenceMaxTargets.
+   * @param latitude - Degrees * 1e7.
+   * @param longitude - Degrees * 1e7.
+   * @param time - Time of the position, e.g. GameClock::Now().
+   */
+  template<typename Handler>
+  void Update(size_t target, int32_t latitude, int32_t longitude, int64_t time, Handler && handler) {
+    // Function Variables
+    GeofenceEvent events[GeofenceMaxInside * 2];
+    size_t        count { Evaluate(target, latitude, longitude, time, events) };
+
+    for (size_t index = 0; index < count; index++) {
+      handler(events[index]);
+    }
+  }
+
+  /**
+   * @brief Process a fix, only with a valid position. The filtered position is used when the fix has it.
+   *        A fix with a trust below the minimum is skipped, the target stays where it was.
+   */
+  template<typename Handler>
+  void Update(size_t target, const GpsFix & fix, int64_t time, Handler && handler) {
+    if (fix.Has(FixHasTrust) && fix.trust < _settings.minTrust) {
+      _untrusted++;
+    } else if (fix.Has(FixHasFiltered)) {
+      Update(target, fix.filteredLatitude, fix.filteredLongitude, time, handler);
+    } else if (fix.Has(FixHasPosition) && fix.quality != 0) {
+      Update(target, fix.latitude, fix.longitude, time, handler);
+    }
+  }
+
+  /**
+   * @brief Forget a target, e.g. a player out of the game, without exit events.
+   */
+  void Reset(size_t target);
+
+  /**
+   * @brief True if the point is inside the zone, without hysteresis.
+   */
+  bool Contains(size_t zone, int32_t latitude, int32_t longitude) const;
+
+  size_t inline GetZones(void) const {
+    return _zones.size();
+  }
+
+  const GeofenceZone & GetZone(size_t zone) const {
+    return _zones[zone];
+  }
+
+  const LocalPlane & GetPlane(void) const {
+    return _plane;
+  }
+
+  /**
+   * @brief Zones taken from the grid cells since Build, for the efficiency of the grid.
+   */
+  uint64_t inline GetCandidates(void) const {
+    return _candidates;
+  }
+
+  /**
+   * @brief Fixes skipped for their trust since Build.
+   */
+  uint64_t inline GetUntrusted(void) const {
+    return _untrusted;
+  }
+
+  /**
+   * @brief Zones tested by point in polygon since Build.
+   */
+  uint64_t inline GetTests(void) const {
+    return _tests;
+  }
+
+  static const char * Describe(GeofenceEventType type);
+  static const char * Describe(GeofenceZoneType type);
+
+private:
+  // Disable copy constructors
+  Geofence(const Geofence&);
+  Geofence& operator=(const Geofence&);
+
+  struct Inside {
+    uint16_t  zone {};
+    bool      dwell {};                                   // Dwell event sent
+    int64_t   since {};
+  };
+
+  struct Target {
+    uint8_t   count {};
+    Inside    inside[GeofenceMaxInside] {};
+  };
+
+private:
+  GeofenceSettings          _settings;
+  LocalPlane                _plane;
+  std::vector<GeofenceZone> _zones;
+  std::vector<int32_t>      _latitudes;                   // Vertices as added
+  std::vector<int32_t>      _longitudes;
+  std::vector<float>        _x;                           // Vertices in the plane
+  std::vector<float>        _y;
+
+  // Grid
+  float                     _originX {};
+  float                     _originY {};
+  float                     _cellSize {};
+  uint32_t                  _columns {};
+  uint32_t                  _rows {};
+  std::vector<uint32_t>     _cellStart;                   // Zones of cell i from _cellStart[i] to _cellStart[i + 1]
+  std::vector<uint16_t>     _cellZones;
+
+  Target                    _targets[GeofenceMaxTargets] {};
+  uint64_t                  _candidates {};
+  mutable uint64_t          _tests {};
+  uint64_t                  _untrusted {};
+
+private:
+  size_t Evaluate(size_t target, int32_t latitude, int32_t longitude, int64_t time, GeofenceEvent * events);
+  bool InsidePolygon(size_t zone, float x, float y) const;
+  float BorderDistance(size_t zone, float x, float y) const;
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_GEOFENCE_HPP_
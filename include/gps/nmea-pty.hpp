@@ -0,0 +1,110 @@
+/*
+ * nmea-pty.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_NMEA_PTY_HPP_
+#define _GPS_NMEA_PTY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include <gps/stream.hpp>
+#include <gps/nmea.hpp>
+#include <gps/ubx.hpp>
+
+namespace Airsoft {
+
+/**
+ * @brief The NMEA sentences of the receiver on a pseudo terminal, for the tools reading a GPS from a serial port
+ *        (gpsd, mapping applications): the slave is reached through a symbolic link, e.g. /dev/gps0.
+ *        A thread subscribed to a GpsStream sends every sentence with a valid checksum, the binary messages
+ *        sharing the port (UBX) are left out: with UBX the receiver sends no RMC and GGA, so they are built from
+ *        every NAV-PVT (talker GN, HDOP from the last GSA). Sentences are written whole: when the reader doesn't
+ *        keep up the sentences still unread are flushed and the new one is dropped and counted, the reader gets
+ *        the recent data and never a sentence cut; a gap in the chunks lost by the subscription drops the sentence
+ *        across it. What the reader writes, e.g. the probes of gpsd, is read and dropped: the receiver is configured by
+ *        Gps only.
+ */
+class GpsNmeaPty final {
+public:
+  GpsNmeaPty() = default;
+  virtual ~GpsNmeaPty();
+
+public:
+  /**
+   * @brief Create the pseudo terminal and its link, replacing a link left by a previous run, and start sending.
+   * @param stream - The data of the receiver, it must outlive Close.
+   * @param link - Path of the symbolic link to the slave, empty for no link (see GetPort).
+   */
+  bool Open(GpsStream & stream, const std::string & link);
+
+  /**
+   * @brief Stop sending, remove the link and close the pseudo terminal.
+   */
+  void Close(void);
+
+  bool inline IsOpen(void) const {
+    return _master != -1;
+  }
+
+  /**
+   * @brief Name of the slave side.
+   */
+  const std::string & GetPort(void) const {
+    return _port;
+  }
+
+  uint64_t inline GetSentences(void) const {
+    return _sentences.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Sentences not written because the reader didn't keep up.
+   */
+  uint64_t inline GetDropped(void) const {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Chunks of the stream lost by the subscription.
+   */
+  uint64_t GetLost(void) const {
+    return _subscription != nullptr ? _subscription->GetDropped() : 0;
+  }
+
+private:
+  // Disable copy constructors
+  GpsNmeaPty(const GpsNmeaPty&);
+  GpsNmeaPty& operator=(const GpsNmeaPty&);
+
+private:
+  GpsStream               * _stream {};
+  GpsSubscription         * _subscription {};
+  std::string               _port;
+  std::string               _link;
+  int32_t                   _master { -1 };
+  int32_t                   _slave { -1 };                // Kept open: the master would see a hang up between opens
+  NmeaParser                _parser;                      // Used by the thread only
+  UbxParser                 _ubx;                         // Used by the thread only
+
+  std::thread             * _process {};
+  std::atomic<bool>         _threadRunning {};
+  std::atomic<uint64_t>     _sentences {};
+  std::atomic<uint64_t>     _dropped {};
+
+private:
+  void Send(const char * text, size_t length);
+  void SendPosition(const GpsFix & fix);
+  void Drain(void);
+  void Engine(void);
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_NMEA_PTY_HPP_
@@ -0,0 +1,206 @@
+/*
+ * nmea.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_NMEA_HPP_
+#define _GPS_NMEA_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gps/fix.hpp>
+
+namespace Airsoft {
+
+constexpr size_t NmeaMaxSentence = 120;                   // 82 by the standard, some receivers send longer ones
+constexpr size_t NmeaMaxFields = 32;                      // Fields decoded, the rest is ignored
+
+/**
+ * @brief A field of a sentence, [begin, end) in the text of the parser.
+ */
+struct NmeaField {
+  const char * begin;
+  const char * end;
+
+  bool inline Empty(void) const {
+    return begin == end;
+  }
+};
+
+/**
+ * @brief Sentences known by the parser.
+ */
+enum class NmeaSentence : uint8_t {
+  None = 0,
+  Gga,                                                    // Time, position, altitude and fix quality
+  Rmc,                                                    // Time, date, position, speed and course
+  Gsa,                                                    // Fix mode, satellites used and DOP
+  Vtg,                                                    // Speed and course
+  Gsv,                                                    // Satellites in view
+  Other,                                                  // Valid sentence not decoded, e.g. GLL, TXT or proprietary
+};
+
+/**
+ * @brief Streaming decoder of NMEA 0183 sentences.
+ *        The bytes are fed in chunks of any size, as they arrive. Every sentence is checked against its checksum
+ *        and decoded into a GpsFix as soon as the checksum has been received, the line end is not waited for.
+ *        The sentence is collected in a fixed buffer and the numbers are converted in place with from_chars,
+ *        so there is no allocation and no locale access per sentence.
+ *        Sentences without checksum, too long or with malformed fields are dropped and counted, the fix is
+ *        left untouched by a dropped sentence. A byte that can't be part of a sentence ends it silently, so
+ *        binary messages sharing the port are skipped.
+ *        The class is not thread safe.
+ */
+class NmeaParser final {
+public:
+  NmeaParser() = default;
+  virtual ~NmeaParser() = default;
+
+public:
+  /**
+   * @brief Decode bytes until a sentence is complete or all the data has been used. The sentence returned by
+   *        a previous call is released first.
+   * @param data - Bytes received.
+   * @param length - Number of bytes of data.
+   * @param timestamp - Arrival time of data, stored in GpsFix::arrival by the sentence starting in it.
+   * @return Number of bytes consumed, less than length when a sentence is ready or its checksum is valid.
+   */
+  size_t Consume(const uint8_t * data, size_t length, int64_t timestamp = 0);
+
+  /**
+   * @brief Decode a chunk calling handler(NmeaSentence sentence) for every sentence completed, the fix
+   *        is already updated when the handler runs.
+   */
+  template<typename Handler>
+  void Feed(const uint8_t * data, size_t length, int64_t timestamp, Handler && handler) {
+    while (length > 0) {
+      size_t used { Consume(data, length, timestamp) };
+
+      data += used;
+      length -= used;
+
+      if (_ready != NmeaSentence::None) {
+        handler(_ready);
+      }
+    }
+  }
+
+  bool inline IsSentenceReady(void) const {
+    return _ready != NmeaSentence::None;
+  }
+
+  /**
+   * @brief Type of the ready sentence, NmeaSentence::None if there isn't one.
+   */
+  NmeaSentence inline GetSentence(void) const {
+    return _ready;
+  }
+
+  /**
+   * @brief True when a sentence with a valid checksum has been completed, also when its fields have been rejected
+   *        and no sentence is ready: Consume stops after it too, for who passes the sentences on as received.
+   */
+  bool inline IsChecksumValid(void) const {
+    return _valid;
+  }
+
+  /**
+   * @brief Text of the sentence with a valid checksum between '$' and '*', not terminated, valid until the next
+   *        Consume.
+   */
+  const char * GetText(void) const {
+    return _text;
+  }
+
+  size_t inline GetTextLength(void) const {
+    return _valid ? _length : 0;
+  }
+
+  /**
+   * @brief Solution built from all the sentences decoded so far.
+   */
+  const GpsFix & GetFix(void) const {
+    return _fix;
+  }
+
+  /**
+   * @brief Drop the sentence being received and clear the fix.
+   */
+  void Reset(void);
+
+  uint64_t inline GetSentences(void) const {              // Sentences decoded into the fix
+    return _sentences;
+  }
+
+  uint64_t inline GetUnknown(void) const {                // Valid sentences not decoded
+    return _unknown;
+  }
+
+  uint64_t inline GetChecksumErrors(void) const {         // Sentences with a wrong or missing checksum
+    return _checksumErrors;
+  }
+
+  uint64_t inline GetFieldErrors(void) const {            // Sentences with malformed fields
+    return _fieldErrors;
+  }
+
+  uint64_t inline GetOverflows(void) const {              // Sentences longer than NmeaMaxSentence
+    return _overflows;
+  }
+
+private:
+  // Disable copy constructors
+  NmeaParser(const NmeaParser&);
+  NmeaParser& operator=(const NmeaParser&);
+
+  enum class State {
+    Start,                                                // Waiting for '$'
+    Body,                                                 // Address and fields
+    Checksum,                                             // Hex digits after '*'
+  };
+
+private:
+  GpsFix        _fix {};
+  NmeaSentence  _ready { NmeaSentence::None };
+  NmeaSentence  _previous { NmeaSentence::None };         // Last sentence decoded, groups GSA and GSV sequences
+  bool          _valid {};                                // Checksum of the text verified
+
+  State         _state { State::Start };
+  char          _text[NmeaMaxSentence] {};                // Sentence between '$' and '*'
+  size_t        _length {};
+  uint8_t       _checksum {};                             // XOR of the text
+  uint8_t       _received {};                             // Checksum sent
+  uint8_t       _digits {};                               // Checksum digits received
+  int64_t       _arrival {};                              // Timestamp of the chunk with the '$'
+
+  NmeaField     _fields[NmeaMaxFields] {};
+  size_t        _fieldCount {};
+
+  uint64_t      _sentences {};
+  uint64_t      _unknown {};
+  uint64_t      _checksumErrors {};
+  uint64_t      _fieldErrors {};
+  uint64_t      _overflows {};
+
+private:
+  void Complete(void);
+  NmeaSentence Decode(void);
+  void Split(void);
+  GpsSystem Talker(void) const;
+  bool DecodeGga(void);
+  bool DecodeRmc(void);
+  bool DecodeGsa(void);
+  bool DecodeVtg(void);
+  bool DecodeGsv(void);
+
+  NmeaField inline GetField(size_t index) const {
+    return index < _fieldCount ? _fields[index] : NmeaField { _text, _text };
+  }
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_NMEA_HPP_
@@ -0,0 +1,185 @@
+/*
+ * quality.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_QUALITY_HPP_
+#define _GPS_QUALITY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gps/fix.hpp>
+#include <gps/nmea.hpp>
+
+namespace Airsoft {
+
+constexpr size_t GpsQualitySlots = 256;                   // Satellites tracked, see GpsQuality::Slot
+
+/**
+ * @brief A satellite of the table, 6 bytes.
+ */
+struct GpsSatelliteTrack {
+  int8_t    snr { -1 };                                   // dBHz of the last GSV, -1 when not tracked
+  int8_t    elevation {};                                 // Degrees
+  uint8_t   state {};                                     // GpsSatelliteState
+  uint8_t   round {};                                     // Last GSV sequence listing it
+  uint16_t  average {};                                   // dBHz * 16, rolling average of the SNR
+};
+
+enum GpsSatelliteState : uint8_t {
+  SatelliteInView = 0x01,
+  SatelliteUsed   = 0x02,
+};
+
+struct GpsQualitySettings {
+  uint8_t   minElevation { 15 };                          // Degrees, satellites lower are weak, multipath
+  float     goodSnr { 35.0f };                            // dBHz, signal component at its best
+  float     poorSnr { 20.0f };                            // dBHz, signal component at zero
+  float     goodHdop { 1.0f };
+  float     poorHdop { 5.0f };
+  float     goodAccuracy { 2.0f };                        // Meters, horizontal accuracy of the receiver (UBX)
+  float     poorAccuracy { 20.0f };
+  uint32_t  staleMS { 5000 };                             // Satellites older are ignored, the receiver stopped GSV
+};
+
+/**
+ * @brief How far a fix can be trusted, from the satellites and the geometry of the solution.
+ *        A table of the satellites, fixed and indexed by number, is updated at the end of every sequence of GSV
+ *        (signal and elevation, an average of the signal per satellite) and of GSA (satellites used). At every
+ *        epoch the trust of the fix, 0 to 100, is a weighted mean of the satellites used, their mean signal with
+ *        the low ones weighted half, the HDOP and the accuracy of the receiver when present; the components
+ *        missing are left out. A 2D fix is trusted less and one with less than four satellites is never
+ *        usable, a rising DOP lowers it further.
+ *        The trust follows a worse fix at once and a better one slowly, an eighth of the difference per epoch,
+ *        so a position that has just been wrong is not trusted again at the first good fix.
+ *        The class is not thread safe.
+ */
+class GpsQuality final {
+public:
+  explicit GpsQuality(const GpsQualitySettings & settings = GpsQualitySettings()) : _settings(settings) { }
+  virtual ~GpsQuality() = default;
+
+public:
+  void SetSettings(const GpsQualitySettings & settings) {
+    _settings = settings;
+  }
+
+  /**
+   * @brief Forget the satellites and the trust.
+   */
+  void Reset(void);
+
+  /**
+   * @brief Follow the sentences decoded, the table is updated when a sequence of GSV or GSA has ended.
+   * @param sentence - The sentence just decoded.
+   * @param fix - The fix of the parser, with the satellites of the sentences so far.
+   */
+  void OnSentence(NmeaSentence sentence, const GpsFix & fix);
+
+  /**
+   * @brief Set the trust of a fix (FixHasTrust), once per epoch: a second fix with the same time gets the same.
+   * @return The trust.
+   */
+  uint8_t Evaluate(GpsFix & fix);
+
+  /**
+   * @brief Index of a satellite in the table, -1 if it has no place.
+   *        The numbers of NMEA 4.0 (1-32 GPS, 33-64 SBAS, 65-96 GLONASS, 193-202 QZSS, 211-246 Galileo) are
+   *        kept; BeiDou goes to 97-159. The numbers from 1 of NMEA 4.10 are moved there by the talker or the
+   *        system ID of GSA; a GN GSA without system ID (before NMEA 4.10) uses the numbers of NMEA 4.0.
+   */
+  static int32_t Slot(GpsSystem system, uint16_t prn);
+
+  const GpsSatelliteTrack & GetSatellite(size_t slot) const {
+    return _table[slot];
+  }
+
+  uint8_t inline GetTrust(void) const {
+    return _trust;
+  }
+
+  uint8_t inline GetInView(void) const {
+    return _inView;
+  }
+
+  /**
+   * @brief Satellites in view with a signal.
+   */
+  uint8_t inline GetTracked(void) const {
+    return _tracked;
+  }
+
+  uint8_t inline GetUsed(void) const {
+    return _used;
+  }
+
+  /**
+   * @brief Used below the minimum elevation.
+   */
+  uint8_t inline GetLowUsed(void) const {
+    return _lowUsed;
+  }
+
+  /**
+   * @brief dBHz, mean of the averages of the satellites used, 0 without them.
+   */
+  float inline GetMeanSnr(void) const {
+    return _meanSnr;
+  }
+
+  float inline GetHdop(void) const {
+    return _hdop;
+  }
+
+  float inline GetPdop(void) const {
+    return _pdop;
+  }
+
+  /**
+   * @brief Recent HDOP minus the HDOP of the last tens of epochs, positive when the geometry gets worse.
+   */
+  float inline GetHdopTrend(void) const {
+    return _hdopTrend;
+  }
+
+  float inline GetPdopTrend(void) const {
+    return _pdopTrend;
+  }
+
+private:
+  GpsQualitySettings  _settings;
+  GpsSatelliteTrack   _table[GpsQualitySlots];
+  NmeaSentence        _previous { NmeaSentence::None };
+  uint8_t             _round {};
+  int64_t             _updated {};                        // Arrival of the last GSV sequence
+  bool                _satellites {};                     // A GSV sequence has been received
+
+  uint8_t             _inView {};
+  uint8_t             _tracked {};
+  uint8_t             _used {};
+  uint8_t             _lowUsed {};
+  float               _meanSnr {};
+
+  bool                _started {};                        // An epoch has been evaluated
+  uint32_t            _time {};                           // Of the last epoch
+  uint8_t             _trust {};
+  float               _hdop {};                           // Recent
+  float               _pdop {};
+  float               _hdopTrend {};
+  float               _pdopTrend {};
+  float               _hdopSlow {};                       // Of the last tens of epochs
+  float               _pdopSlow {};
+
+private:
+  void UpdateSatellites(const GpsFix & fix);
+  void UpdateUsed(const GpsFix & fix);
+  void Summarize(void);
+  float Score(const GpsFix & fix) const;
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_QUALITY_HPP_
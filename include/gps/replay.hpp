@@ -0,0 +1,139 @@
+/*
+ * replay.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_REPLAY_HPP_
+#define _GPS_REPLAY_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+namespace Airsoft {
+
+constexpr const char * GpsReplayScheme = "replay:";
+
+/**
+ * @brief A recorded receiver: plays a log of NMEA sentences or UBX messages on a pseudo terminal, so that Gps
+ *        reads it through the same port, reactor and parsers as the real one.
+ *        The log is cut in epochs where the time of the positions (RMC and GGA, or NAV-PVT) changes, the epoch
+ *        is written at once at its time from the first one divided by the speed: the timing of the receiver
+ *        is kept, the arrival times are those of the pseudo terminal. Speed 0 writes as fast as Gps reads.
+ *        The data written by Gps to the receiver is read and dropped.
+ */
+class GpsReplay final {
+public:
+  GpsReplay() = default;
+  virtual ~GpsReplay();
+
+public:
+  /**
+   * @brief True for a port to replay, "replay:path[?speed=factor]".
+   */
+  static bool IsReplay(const std::string & port);
+
+  /**
+   * @brief Load the log and create the pseudo terminal.
+   * @param uri - "replay:path[?speed=factor]", factor 1 (default) for real time, 0 or max as fast as possible.
+   * @return False if the log can't be loaded or the factor is not "max" or a number not negative.
+   */
+  bool Open(const std::string & uri);
+
+  /**
+   * @brief Start playing, once the port is open and read.
+   */
+  bool Start(void);
+
+  /**
+   * @brief Stop playing and close the pseudo terminal.
+   */
+  void Close(void);
+
+  bool inline IsOpen(void) const {
+    return _master != -1;
+  }
+
+  /**
+   * @brief Name of the port to open in place of the receiver.
+   */
+  const std::string & GetPort(void) const {
+    return _port;
+  }
+
+  /**
+   * @brief True if the log holds NAV-PVT messages, NMEA sentences otherwise.
+   */
+  bool inline IsUbx(void) const {
+    return _ubx;
+  }
+
+  /**
+   * @brief Speed factor, 0 as fast as possible.
+   */
+  double inline GetSpeed(void) const {
+    return _speed;
+  }
+
+  size_t inline GetEpochs(void) const {
+    return _epochs.size();
+  }
+
+  /**
+   * @brief Epochs written so far.
+   */
+  size_t inline GetPlayed(void) const {
+    return _played.load(std::memory_order_relaxed);
+  }
+
+  bool inline IsFinished(void) const {
+    return _finished.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Milliseconds from the first epoch of the log to the last one.
+   */
+  int64_t GetDuration(void) const {
+    return _epochs.empty() ? 0 : _epochs.back().offset;
+  }
+
+private:
+  // Disable copy constructors
+  GpsReplay(const GpsReplay&);
+  GpsReplay& operator=(const GpsReplay&);
+
+  struct Epoch {
+    size_t  begin {};                                     // First byte in the log
+    int64_t offset {};                                    // Milliseconds from the first epoch
+  };
+
+private:
+  std::string               _port;
+  std::string               _log;
+  std::vector<Epoch>        _epochs;
+  double                    _speed { 1.0 };
+  bool                      _ubx {};
+  int32_t                   _master { -1 };
+  int32_t                   _slave { -1 };                // Kept open: the master would see a hang up between opens
+
+  std::thread             * _process {};
+  std::atomic<bool>         _threadRunning {};
+  std::atomic<size_t>       _played {};
+  std::atomic<bool>         _finished {};
+
+private:
+  bool Load(const std::string & path);
+  bool Write(const uint8_t * data, size_t length);
+  void Wait(int64_t until);
+  void Drain(void);
+  void Engine(void);
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_REPLAY_HPP_
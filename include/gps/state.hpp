@@ -0,0 +1,95 @@
+/*
+ * state.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_STATE_HPP_
+#define _GPS_STATE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <gps/fix.hpp>
+
+namespace Airsoft {
+
+constexpr uint32_t GpsStateMagic = 0x53504741;            // "AGPS"
+constexpr uint16_t GpsStateVersion = 1;
+
+/**
+ * @brief What is kept of a session for the next power up: the last position and its UTC time, the link
+ *        negotiated with the receiver and the time to first fix measured.
+ *        Plain fixed layout, written as is: the file is read back only by the same build of the device.
+ */
+struct GpsState {
+  uint32_t  magic { GpsStateMagic };
+  uint16_t  version { GpsStateVersion };
+  uint16_t  size { sizeof(GpsState) };
+
+  // Last position
+  int64_t   utc {};                                       // Milliseconds since the epoch of the fix, 0 if unknown
+  int32_t   latitude {};                                  // Degrees * 1e7
+  int32_t   longitude {};                                 // Degrees * 1e7
+  int32_t   altitude {};                                  // Centimeters above the ellipsoid
+  uint32_t  accuracy {};                                  // Centimeters, horizontal, 0 if unknown
+
+  // Receiver
+  uint8_t   protocol {};                                  // GpsProtocol in use
+  uint8_t   reserved[3] {};
+  uint32_t  baudrate {};                                  // Baudrate of the receiver
+  uint32_t  ttff {};                                      // Milliseconds to the first fix of the session
+
+  uint32_t  checksum {};                                  // Fletcher checksum of the fields above
+
+public:
+  bool inline HasPosition(void) const {
+    return utc != 0;
+  }
+};
+
+/**
+ * @brief UTC time of a fix with date and time in milliseconds since the epoch, 0 without them.
+ */
+int64_t GpsFixToUtc(const GpsFix & fix);
+
+/**
+ * @brief Storage of GpsState in a small file.
+ *        A save writes a temporary file, syncs it, renames it over the previous one and syncs the directory, so
+ *        a power cut at any point leaves either the old state or the new one. A load rejects files with a
+ *        different layout or a wrong checksum.
+ */
+class GpsStateFile final {
+public:
+  explicit GpsStateFile(std::string path = std::string()) : _path(std::move(path)) { }
+  virtual ~GpsStateFile() = default;
+
+public:
+  bool inline IsEnabled(void) const {
+    return !_path.empty();
+  }
+
+  const std::string & GetPath(void) const {
+    return _path;
+  }
+
+  bool Load(GpsState & state) const;
+
+  /**
+   * @brief Write the state, blocking for the syncs: tens to hundreds of ms on an SD card.
+   */
+  bool Save(const GpsState & state) const;
+
+private:
+  std::string _path;
+
+private:
+  static uint32_t Checksum(const GpsState & state);
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_STATE_HPP_
@@ -0,0 +1,246 @@
+/*
+ * stream.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_STREAM_HPP_
+#define _GPS_STREAM_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <utility>
+
+namespace Airsoft {
+
+constexpr size_t GpsChunkSize = 256;                      // Bytes taken from the receive buffer at once
+constexpr size_t GpsStreamMaxSubscribers = 4;
+constexpr size_t GpsSubscriptionCapacity = 32;            // Chunks queued per subscriber, a power of two
+// Every queue full and a chunk held by each subscriber, one more for the reader of the port
+constexpr size_t GpsStreamPoolSize = GpsStreamMaxSubscribers * (GpsSubscriptionCapacity + 1) + 1;
+
+/**
+ * @brief Data of the receiver as read from the port, shared by reference count.
+ */
+struct GpsChunk {
+  uint8_t               data[GpsChunkSize];
+  size_t                length {};
+  int64_t               arrival {};                       // Clock::Default() nanoseconds
+  uint64_t              sequence {};                      // Chunks published before this one
+  std::atomic<uint32_t> references {};
+};
+
+/**
+ * @brief A reference to a chunk, the chunk goes back to the pool of its stream when the last one is released.
+ *        The data is never written while a reference exists.
+ */
+class GpsChunkRef final {
+public:
+  GpsChunkRef() = default;
+  ~GpsChunkRef() {
+    Release();
+  }
+
+  GpsChunkRef(const GpsChunkRef & other) : _chunk(other._chunk) {
+    if (_chunk != nullptr) {
+      _chunk->references.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  GpsChunkRef(GpsChunkRef && other) noexcept : _chunk(other._chunk) {
+    other._chunk = nullptr;
+  }
+
+  GpsChunkRef & operator=(GpsChunkRef other) noexcept {
+    std::swap(_chunk, other._chunk);
+    return *this;
+  }
+
+public:
+  void Release(void) {
+    if (_chunk != nullptr) {
+      // The reads of the data happen before the chunk is reused
+      _chunk->references.fetch_sub(1, std::memory_order_release);
+      _chunk = nullptr;
+    }
+  }
+
+  explicit operator bool(void) const {
+    return _chunk != nullptr;
+  }
+
+  const uint8_t * GetData(void) const {
+    return _chunk->data;
+  }
+
+  size_t inline GetLength(void) const {
+    return _chunk->length;
+  }
+
+  int64_t inline GetArrival(void) const {
+    return _chunk->arrival;
+  }
+
+  uint64_t inline GetSequence(void) const {
+    return _chunk->sequence;
+  }
+
+private:
+  friend class GpsSubscription;
+
+  // Takes over a reference already counted
+  explicit GpsChunkRef(GpsChunk * chunk) : _chunk(chunk) { }
+
+private:
+  GpsChunk * _chunk {};
+};
+
+/**
+ * @brief Queue of the chunks for a subscriber: one producer, the reader of the port, and one consumer.
+ *        When the queue is full the new chunk is dropped and counted, the producer never waits.
+ *        Once unsubscribed the consumer receives nothing more; it has to stop using the subscription before a
+ *        new Subscribe can take its place.
+ */
+class GpsSubscription final {
+public:
+  /**
+   * @brief Take the oldest chunk queued without waiting.
+   * @return False if the queue is empty or the subscription is being closed.
+   */
+  bool TryReceive(GpsChunkRef & chunk);
+
+  /**
+   * @brief Take the oldest chunk queued, waiting up to timeoutMS for one.
+   * @return False on timeout or as soon as the subscription is being closed.
+   */
+  bool Receive(GpsChunkRef & chunk, uint32_t timeoutMS);
+
+  /**
+   * @brief Chunks queued for this subscriber.
+   */
+  uint64_t inline GetReceived(void) const {
+    return _received.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Chunks lost because the queue was full (or the pool empty), a gap in the sequence of the chunks.
+   */
+  uint64_t inline GetDropped(void) const {
+    return _dropped.load(std::memory_order_relaxed);
+  }
+
+private:
+  friend class GpsStream;
+
+  GpsSubscription() = default;
+  ~GpsSubscription();
+
+  // Disable copy constructors
+  GpsSubscription(const GpsSubscription&);
+  GpsSubscription& operator=(const GpsSubscription&);
+
+private:
+  // Indexes on their own cache lines, written by different threads
+  alignas(64) std::atomic<uint32_t> _head {};             // Next chunk written, producer
+  alignas(64) std::atomic<uint32_t> _tail {};             // Next chunk read, consumer
+  std::atomic<uint32_t> _consuming {};                    // The consumer is taking a chunk
+  std::atomic<bool>     _closing {};                      // Unsubscribe is draining the queue
+  std::atomic<bool>     _waiting {};                      // The consumer sleeps on the event
+  alignas(64) GpsChunk * _ring[GpsSubscriptionCapacity] {};
+  int32_t               _event { -1 };                    // eventfd waking up the consumer
+  std::atomic<bool>     _used {};                         // Slot given to a subscriber
+  std::atomic<bool>     _active {};                       // Chunks are queued
+  std::atomic<uint64_t> _received {};
+  std::atomic<uint64_t> _dropped {};
+
+private:
+  bool Open(void);
+  bool Pop(GpsChunkRef & chunk);
+  void Push(GpsChunk * chunk);
+  void Drop(void) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+  void Close(void);
+};
+
+/**
+ * @brief Fan out of the data of the receiver: the reader of the port takes a chunk from a fixed pool, reads the
+ *        data in it and publishes it; every subscriber gets a reference to the same chunk, the data is never
+ *        copied and nothing is allocated per chunk.
+ *        A subscriber that doesn't keep up loses chunks, counted in its subscription, the reader of the port and
+ *        the other subscribers go on. The pool holds enough chunks to fill every queue; if the subscribers hold
+ *        more references the chunk is read in a spare buffer and dropped for all of them.
+ *        Acquire and Publish are called by one thread, Subscribe and Unsubscribe by any thread.
+ */
+class GpsStream final {
+public:
+  GpsStream() = default;
+  virtual ~GpsStream();
+
+public:
+  /**
+   * @brief A free chunk to read the data of the port into, it stays free until it is published.
+   */
+  GpsChunk * Acquire(void);
+
+  /**
+   * @brief Queue the chunk to the subscribers, it goes back to the pool once they have released it.
+   */
+  void Publish(GpsChunk * chunk);
+
+  /**
+   * @brief Start queueing the chunks to a new subscriber.
+   * @return Nullptr if there are already GpsStreamMaxSubscribers.
+   */
+  GpsSubscription * Subscribe(void);
+
+  /**
+   * @brief Stop queueing the chunks, the chunks still queued are released. No chunk is queued when it returns.
+   *        A consumer still receiving gets false from then on, the queue is drained once it is out.
+   */
+  void Unsubscribe(GpsSubscription * subscription);
+
+  /**
+   * @brief Chunks published.
+   */
+  uint64_t inline GetPublished(void) const {
+    return _sequence.load(std::memory_order_relaxed);
+  }
+
+  uint64_t inline GetBytes(void) const {
+    return _bytes.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Chunks published while the pool was empty, lost by every subscriber.
+   */
+  uint64_t inline GetExhausted(void) const {
+    return _exhausted.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * @brief Chunks of the pool referenced by a subscriber.
+   */
+  size_t GetInUse(void) const;
+
+private:
+  // Disable copy constructors
+  GpsStream(const GpsStream&);
+  GpsStream& operator=(const GpsStream&);
+
+private:
+  GpsChunk              _pool[GpsStreamPoolSize];
+  GpsChunk              _spare;                           // Pool empty: read but not shared
+  size_t                _next {};                         // Where the search of a free chunk starts
+  GpsSubscription       _subscriptions[GpsStreamMaxSubscribers];
+  std::atomic<uint64_t> _publishing {};                   // Odd while the chunk is queued
+  std::atomic<uint64_t> _sequence {};
+  std::atomic<uint64_t> _bytes {};
+  std::atomic<uint64_t> _exhausted {};
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_STREAM_HPP_
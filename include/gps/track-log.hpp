@@ -0,0 +1,172 @@
+/*
+ * track-log.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_TRACK_LOG_HPP_
+#define _GPS_TRACK_LOG_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <functional>
+
+#include <gps/fix.hpp>
+
+namespace Airsoft {
+
+constexpr uint32_t TrackLogMagic = 0x4B525441;            // "ATRK"
+constexpr uint32_t TrackLogBlockMagic = 0x4B4C4254;       // "TBLK"
+constexpr uint16_t TrackLogVersion = 1;
+constexpr size_t   TrackLogBlockSize = 4096;              // A page: written back by the kernel as a unit
+constexpr size_t   TrackLogSectorSize = 512;              // Written by the card as a unit, records don't cross it
+constexpr size_t   TrackLogMinSize = 4 * TrackLogBlockSize;
+constexpr uint32_t TrackLogKeyframeInterval = 600;        // Records between keyframes, a minute at 10 Hz
+
+/**
+ * @brief A position of the track.
+ */
+struct TrackPoint {
+  int64_t utc {};                                         // Milliseconds since the epoch
+  int32_t latitude {};                                    // Degrees * 1e7
+  int32_t longitude {};                                   // Degrees * 1e7
+  int32_t altitude {};                                    // Decimeters above the mean sea level
+};
+
+/**
+ * @brief History of the positions in a file of fixed size, mapped in memory and used as a ring.
+ *        The file is a header block and data blocks of TrackLogBlockSize bytes. Every data block starts with its
+ *        sequence number and a keyframe, the points in full; the others are deltas from the previous point as
+ *        zigzag varints: the time as the change of the interval, so a steady rate takes a byte per field and a
+ *        point five to seven bytes, a day at 10 Hz 4 to 6 MB. A keyframe is repeated every TrackLogKeyframeInterval
+ *        points. When the last block is full the oldest one is reused.
+ *        An append only writes in the mapping, the kernel writes the pages back: no system call while the
+ *        block has room, Flush() asks for the write back without waiting.
+ *        After a power cut the blocks are ordered by sequence and decoded up to the first record not complete:
+ *        a record is written before its tag byte and doesn't cross a sector, so a page written back while a
+ *        record is appended or only in part shows the record whole or not at all; every tag carries the lap of
+ *        the ring, so the content of the previous lap of a block is not read as the new one.
+ *        Points are appended by one thread.
+ */
+class TrackLog final {
+public:
+  TrackLog() = default;
+  virtual ~TrackLog();
+
+public:
+  /**
+   * @brief Open the file, created or resized to size bytes (rounded down to blocks). An existing log of the
+   *        same size is continued in the block after its newest one.
+   */
+  bool Open(const std::string & path, size_t size);
+
+  /**
+   * @brief Write back the pages and unmap the file.
+   */
+  void Close(void);
+
+  bool inline IsOpen(void) const {
+    return _map != nullptr;
+  }
+
+  /**
+   * @brief Append a point, points older than the last one are ignored.
+   */
+  bool Append(const TrackPoint & point);
+
+  /**
+   * @brief Append the position of a fix with date and time.
+   */
+  bool Append(const GpsFix & fix);
+
+  /**
+   * @brief Start the write back of the pages modified, without waiting for it.
+   */
+  void Flush(void);
+
+  uint64_t inline GetPoints(void) const {
+    return _points;
+  }
+
+  /**
+   * @brief Bytes of the records appended since Open.
+   */
+  uint64_t inline GetBytes(void) const {
+    return _bytes;
+  }
+
+  /**
+   * @brief Read the points of a log in the order they were appended.
+   * @return Number of points, -1 if the file is not a track log.
+   */
+  static int64_t Read(const std::string & path, const std::function<void(const TrackPoint &)> & handler);
+
+private:
+  // Disable copy constructors
+  TrackLog(const TrackLog&);
+  TrackLog& operator=(const TrackLog&);
+
+  /**
+   * @brief First block of the file, written once at creation.
+   */
+  struct Header {
+    uint32_t  magic;
+    uint16_t  version;
+    uint16_t  size;
+    uint32_t  blockSize;
+    uint32_t  blocks;                                     // Data blocks after the header
+    uint32_t  checksum;                                   // Fletcher checksum of the fields above
+  };
+
+  struct BlockHeader {
+    uint32_t  magic;                                      // Written last, the block is valid with it
+    uint32_t  sequence;                                   // Blocks written before this one
+    uint32_t  check;                                      // ~sequence
+    uint32_t  reserved;
+  };
+
+  enum : uint8_t {
+    TagKeyframe = 1,
+    TagDelta    = 2,
+    TagPad      = 3,                                      // The records continue in the next sector
+    TagType     = 0x03,
+    TagLapShift = 2,                                      // Lap of the ring in the other bits
+  };
+
+  // A keyframe with the time on 10 bytes and three fields on 5 bytes, the tag apart
+  static constexpr size_t MaxRecord = 10 + 3 * 5;
+
+private:
+  int32_t     _fd { -1 };
+  uint8_t   * _map {};
+  size_t      _size {};
+  uint32_t    _blocks {};
+
+  uint8_t   * _block {};                                  // Block in use
+  size_t      _position {};                               // Next record in the block
+  uint32_t    _sequence {};                               // Of the block in use
+  uint32_t    _sinceKeyframe {};
+  TrackPoint  _last {};
+  int64_t     _interval {};                               // Of the last two points
+  bool        _started {};                                // _last is valid
+
+  uint64_t    _points {};
+  uint64_t    _bytes {};
+
+private:
+  size_t Encode(const TrackPoint & point, bool keyframe, uint8_t * record) const;
+  void StartBlock(uint32_t sequence);
+  bool Resume(void);
+
+  static uint8_t LapTag(uint8_t type, uint32_t sequence, uint32_t blocks) {
+    return static_cast<uint8_t>(type | ((sequence / blocks) & 0x3F) << TagLapShift);
+  }
+
+  static uint32_t Checksum(const Header & header);
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_TRACK_LOG_HPP_
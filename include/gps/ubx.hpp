@@ -0,0 +1,253 @@
+/*
+ * ubx.hpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+
+#ifndef _GPS_UBX_HPP_
+#define _GPS_UBX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gps/fix.hpp>
+
+namespace Airsoft {
+
+constexpr uint8_t UbxSync1 = 0xB5;
+constexpr uint8_t UbxSync2 = 0x62;
+constexpr size_t  UbxOverhead = 8;                        // Sync, class, id, length and checksum
+constexpr size_t  UbxMaxPayload = 512;                    // Longer messages are dropped
+
+// Classes and ids of the messages used
+constexpr uint8_t UbxClassNav = 0x01;
+constexpr uint8_t UbxClassAck = 0x05;
+constexpr uint8_t UbxClassCfg = 0x06;
+constexpr uint8_t UbxClassMga = 0x13;
+constexpr uint8_t UbxClassNmea = 0xF0;
+
+constexpr uint8_t UbxIdNavPvt = 0x07;
+constexpr uint8_t UbxIdAckNak = 0x00;
+constexpr uint8_t UbxIdAckAck = 0x01;
+constexpr uint8_t UbxIdCfgPrt = 0x00;
+constexpr uint8_t UbxIdCfgMsg = 0x01;
+constexpr uint8_t UbxIdCfgRate = 0x08;
+constexpr uint8_t UbxIdMgaIni = 0x40;
+
+// NMEA sentences as messages of class UbxClassNmea
+constexpr uint8_t UbxIdNmeaGga = 0x00;
+constexpr uint8_t UbxIdNmeaGll = 0x01;
+constexpr uint8_t UbxIdNmeaGsa = 0x02;
+constexpr uint8_t UbxIdNmeaGsv = 0x03;
+constexpr uint8_t UbxIdNmeaRmc = 0x04;
+constexpr uint8_t UbxIdNmeaVtg = 0x05;
+
+// Protocol masks of CFG-PRT
+constexpr uint16_t UbxProtocolUbx = 0x0001;
+constexpr uint16_t UbxProtocolNmea = 0x0002;
+
+constexpr size_t UbxNavPvtLength = 92;
+
+/**
+ * @brief Messages known by the parser.
+ */
+enum class UbxMessage : uint8_t {
+  None = 0,
+  NavPvt,                                                 // Navigation solution, decoded into the fix
+  Ack,                                                    // Configuration accepted, see GetAckClass/GetAckId
+  Nak,                                                    // Configuration refused, see GetAckClass/GetAckId
+  Other,                                                  // Valid message not decoded, see GetClass/GetId/GetPayload
+};
+
+/**
+ * @brief Streaming decoder of the u-blox UBX binary protocol.
+ *        Same model of NmeaParser: chunks of any size, a message is ready as soon as its checksum has been
+ *        received, the payload is collected in a fixed buffer and NAV-PVT is decoded into a GpsFix.
+ *        Everything outside a UBX message, e.g. NMEA sentences on the same port, is skipped.
+ *        The class is not thread safe.
+ */
+class UbxParser final {
+public:
+  UbxParser() = default;
+  virtual ~UbxParser() = default;
+
+public:
+  /**
+   * @brief Decode bytes until a message is complete or all the data has been used. The message returned by
+   *        a previous call is released first.
+   * @param data - Bytes received.
+   * @param length - Number of bytes of data.
+   * @param timestamp - Arrival time of data, stored in GpsFix::arrival by the message starting in it.
+   * @return Number of bytes consumed, less than length when a message is ready.
+   */
+  size_t Consume(const uint8_t * data, size_t length, int64_t timestamp = 0);
+
+  /**
+   * @brief Decode a chunk calling handler(UbxMessage message) for every message completed.
+   */
+  template<typename Handler>
+  void Feed(const uint8_t * data, size_t length, int64_t timestamp, Handler && handler) {
+    while (length > 0) {
+      size_t used { Consume(data, length, timestamp) };
+
+      data += used;
+      length -= used;
+
+      if (_ready != UbxMessage::None) {
+        handler(_ready);
+      }
+    }
+  }
+
+  bool inline IsMessageReady(void) const {
+    return _ready != UbxMessage::None;
+  }
+
+  UbxMessage inline GetMessage(void) const {
+    return _ready;
+  }
+
+  uint8_t inline GetClass(void) const {
+    return _class;
+  }
+
+  uint8_t inline GetId(void) const {
+    return _id;
+  }
+
+  /**
+   * @brief Payload of the ready message, valid until the next Consume.
+   */
+  const uint8_t * GetPayload(void) const {
+    return _payload;
+  }
+
+  size_t inline GetPayloadLength(void) const {
+    return _ready != UbxMessage::None ? _length : 0;
+  }
+
+  /**
+   * @brief Class and id of the message acknowledged by the ready Ack or Nak.
+   */
+  uint8_t inline GetAckClass(void) const {
+    return _ackClass;
+  }
+
+  uint8_t inline GetAckId(void) const {
+    return _ackId;
+  }
+
+  /**
+   * @brief Solution of the last NAV-PVT.
+   */
+  const GpsFix & GetFix(void) const {
+    return _fix;
+  }
+
+  /**
+   * @brief Drop the message being received and clear the fix.
+   */
+  void Reset(void);
+
+  uint64_t inline GetMessages(void) const {               // Valid messages
+    return _messages;
+  }
+
+  uint64_t inline GetChecksumErrors(void) const {
+    return _checksumErrors;
+  }
+
+  uint64_t inline GetOverflows(void) const {              // Headers longer than UbxMaxPayload
+    return _overflows;
+  }
+
+  /**
+   * @brief Build a complete message, sync and checksum included.
+   * @param output - Destination, at least length + UbxOverhead bytes.
+   * @return Length of the message, 0 if output is too small.
+   */
+  static size_t Build(uint8_t messageClass, uint8_t messageId, const uint8_t * payload, size_t length,
+                      uint8_t * output, size_t size);
+
+  /**
+   * @brief CFG-PRT of UART1: baudrate, 8N1, input and output protocols.
+   */
+  static size_t BuildConfigPort(uint32_t baudrate, uint16_t inProtocols, uint16_t outProtocols,
+                                uint8_t * output, size_t size);
+
+  /**
+   * @brief CFG-RATE: measurement period, one solution per measurement, aligned to GPS time.
+   */
+  static size_t BuildConfigRate(uint16_t periodMS, uint8_t * output, size_t size);
+
+  /**
+   * @brief CFG-MSG on the current port: a message every rate solutions, 0 to disable it.
+   */
+  static size_t BuildConfigMessage(uint8_t messageClass, uint8_t messageId, uint8_t rate,
+                                   uint8_t * output, size_t size);
+
+  /**
+   * @brief MGA-INI-POS_LLH: approximate position of the receiver, for the aiding at power up.
+   * @param latitude - Degrees * 1e7.
+   * @param longitude - Degrees * 1e7.
+   * @param altitude - Centimeters above the ellipsoid.
+   * @param accuracy - Centimeters, standard deviation of the position.
+   */
+  static size_t BuildAidPosition(int32_t latitude, int32_t longitude, int32_t altitude, uint32_t accuracy,
+                                 uint8_t * output, size_t size);
+
+  /**
+   * @brief MGA-INI-TIME_UTC: approximate UTC time, valid when the message is received.
+   * @param utc - Milliseconds since the epoch.
+   * @param accuracyS - Seconds, accuracy of the time.
+   */
+  static size_t BuildAidTime(int64_t utc, uint16_t accuracyS, uint8_t * output, size_t size);
+
+private:
+  // Disable copy constructors
+  UbxParser(const UbxParser&);
+  UbxParser& operator=(const UbxParser&);
+
+  enum class State {
+    Sync1,
+    Sync2,
+    Class,
+    Id,
+    Length1,
+    Length2,
+    Payload,
+    ChecksumA,
+    ChecksumB,
+  };
+
+private:
+  GpsFix        _fix {};
+  UbxMessage    _ready { UbxMessage::None };
+
+  State         _state { State::Sync1 };
+  uint8_t       _class {};
+  uint8_t       _id {};
+  size_t        _expected {};                             // Payload length of the header
+  uint8_t       _payload[UbxMaxPayload] {};
+  size_t        _length {};                               // Payload bytes received
+  uint8_t       _checksumA {};
+  uint8_t       _checksumB {};
+  int64_t       _arrival {};                              // Timestamp of the chunk with the sync
+
+  uint8_t       _ackClass {};
+  uint8_t       _ackId {};
+
+  uint64_t      _messages {};
+  uint64_t      _checksumErrors {};
+  uint64_t      _overflows {};
+
+private:
+  void Checksum(uint8_t byte);
+  void Complete(void);
+  void DecodeNavPvt(void);
+};
+
+} // namespace Airsoft
+
+#endif // _GPS_UBX_HPP_
@@ -49,7 +49,6 @@ public:
   static std::string TrimLeft(const std::string& str);
   static std::string TrimRight(const std::string& str);
   static std::string Trim(const std::string & source);
-  static uint64_t TimeSinceEpochMillisec(void);
 };
 
 }
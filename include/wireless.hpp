@@ -32,9 +32,14 @@
 #ifndef WIRELESS_HPP_
 #define WIRELESS_HPP_
 
-#include <thread>
+#include <string>
 #include <queue>
 #include <mutex>
+#include <condition_variable>
+
+#include <drivers/uarts.hpp>
+#include <drivers/uart-reactor.hpp>
+#include <devices/ebytelorae220.hpp>
 
 namespace Airsoft {
 
@@ -46,19 +51,39 @@ public:
   virtual ~Wireless();
 
 public:
-  bool Init(std::string port, int32_t auxPin = -1, int32_t m0Pin = -1, int32_t m1Pin = -1);
+  /**
+   * @brief Open the port of the LoRa module and add it to the reactor, then configure the module.
+   *        The configuration, the messages received and transmitted run on the reactor thread,
+   *        the engine is ready once the configuration has ended.
+   */
+  bool Init(std::string port, Airsoft::Drivers::UartReactor & reactor, int32_t auxPin = -1, int32_t m0Pin = -1,
+            int32_t m1Pin = -1);
   void Terminate(void);
 
   void SendMessage(std::string message);
   bool ReceiveMessage(std::string & message);
 
+  /**
+   * @brief Get a received message and its arrival time, Clock::Default() nanoseconds.
+   */
+  bool ReceiveMessage(std::string & message, int64_t & timestamp);
+
   bool inline IsReady(void) {
     return _ready;
   }
 
+  /**
+   * @brief Statistics of the port, false if the port is not open.
+   */
+  bool GetStatistics(Airsoft::Drivers::UartStatistics & statistics) const;
+
+private:
+  struct Received {
+    std::string message;
+    int64_t     timestamp;                                // Arrival time of the packet
+  };
+
 private:
-  std::thread * _process {};      // Pointer to thread
-  bool          _threadRunning {};         // Running flag for thread
   std::string   _port;
   int32_t       _auxPin {};
   int32_t       _m0Pin {};
@@ -68,10 +93,33 @@ private:
   std::mutex              _outLock;
   std::queue<std::string> _out;
   std::mutex              _inLock;
-  std::queue<std::string> _in;
+  std::queue<Received>    _in;
+
+  Airsoft::Drivers::Uarts         * _serial {};
+  Airsoft::Devices::EByteLoRaE220 * _lora {};
+  Airsoft::Drivers::UartReactor   * _reactor {};
+  std::string                       _rxMessage;   // Packet being received, reused between messages
+  int64_t                           _rxTimestamp {};  // Arrival time of the first bytes of the packet
+  bool                              _rxCollecting {}; // Waiting for the rest of the packet
+  bool                              _txPacing {};     // A packet is with the module, the next one waits
+  uint32_t                          _txPolls {};      // AUX checks since the packet has reached the module
+
+  std::mutex                        _configureLock;
+  std::condition_variable           _configureDone;
+  bool                              _configuring {};  // Configuration exchange with the module running
+  bool                              _terminating {};  // Terminate called, the configuration doesn't set ready
 
 private:
-  void Engine(void);
+  bool Configure(void);
+  void OnConfiguration(Airsoft::Devices::ResponseStatus status, Airsoft::Devices::Configuration & configuration);
+  void OnConfigurationSet(Airsoft::Devices::ResponseStatus status, Airsoft::Devices::Configuration & configuration);
+  void Configured(void);
+  void OnReadable(void);
+  void CollectPacket(void);
+  void OnPacketData(std::string & data, bool completed);
+  void DeliverPacket(void);
+  void Transmit(void);
+  void OnTransmitted(void);
 
 };
 
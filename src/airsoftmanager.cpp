@@ -36,6 +36,7 @@
 #include <regex>
 #include <filesystem>
 #include <string>
+#include <algorithm>
 
 #include <config.hpp>
 #include <drivers/gpio.hpp>
@@ -69,6 +70,19 @@ void AirsoftManager::Terminate(void) {
   }
 }
 //-----------------------------------------------------------------------------
+void AirsoftManager::PrintStatistics(std::ostream & out) const {
+  // Function Variables
+  Airsoft::Drivers::UartStatistics statistics;
+
+  if (_gps.GetStatistics(statistics)) {
+    PrintUartStatistics(out, "GPS", statistics);
+  }
+
+  if (_wireless.GetStatistics(statistics)) {
+    PrintUartStatistics(out, "Wireless", statistics);
+  }
+}
+//-----------------------------------------------------------------------------
 
 //-----------------------------------------------------------------------------
 bool AirsoftManager::LoadConfiguration(void) {
@@ -89,6 +103,16 @@ bool AirsoftManager::LoadConfiguration(void) {
           Configuration.AddressH = atoi(value.c_str());
         } else if (key == "address_low") {
           Configuration.AddressL = atoi(value.c_str());
+        } else if (key == "zone") {
+          if (_geofence.AddZone(value) < 0) {
+            std::cout << "Engine Manager: Invalid zone " << value << std::endl;
+          }
+        } else if (key == "zone_hysteresis") {
+          Configuration.ZoneHysteresis = static_cast<float>(atof(value.c_str()));
+        } else if (key == "zone_dwell") {
+          Configuration.ZoneDwell = atoi(value.c_str());
+        } else if (key == "zone_trust") {
+          Configuration.ZoneTrust = atoi(value.c_str());
         }
       }
     }
@@ -96,6 +120,31 @@ bool AirsoftManager::LoadConfiguration(void) {
   return true;
 }
 //-----------------------------------------------------------------------------
+void AirsoftManager::PrintUartStatistics(std::ostream & out, const char * name,
+                                         const Airsoft::Drivers::UartStatistics & statistics) {
+  out << name << " : read " << statistics.BytesRead << " bytes, written " << statistics.BytesWritten << " bytes" << std::endl;
+  out << name << " : read timeouts " << statistics.ReadTimeouts << ", write timeouts " << statistics.WriteTimeouts
+      << ", errors " << statistics.Errors << ", transmit refused " << statistics.TransmitRefused << std::endl;
+  out << name << " : overruns " << statistics.Overruns << ", buffer overruns " << statistics.BufferOverruns
+      << ", framing errors " << statistics.FramingErrors << ", parity errors " << statistics.ParityErrors
+      << ", breaks " << statistics.Breaks << std::endl;
+
+  // Only the used buckets, labeled with their upper bound in microseconds
+  for (size_t index = 0; index < Airsoft::Drivers::StatisticsBuckets; index++) {
+    if (statistics.ReadTime[index] == 0 && statistics.WriteTime[index] == 0) {
+      continue;
+    }
+
+    out << name << " : ";
+    if (index == Airsoft::Drivers::StatisticsBuckets - 1) {
+      out << ">= " << (1ULL << (index - 1)) << " us";
+    } else {
+      out << "< " << (1ULL << index) << " us";
+    }
+    out << " read " << statistics.ReadTime[index] << ", write " << statistics.WriteTime[index] << std::endl;
+  }
+}
+//-----------------------------------------------------------------------------
 
 //-----------------------------------------------------------------------------
 void AirsoftManager::Engine(void) {
@@ -107,13 +156,44 @@ void AirsoftManager::Engine(void) {
 
   LoadConfiguration();
 
+  // Zones of the game, projected once
+  GeofenceSettings zones;
+
+  if (Configuration.ZoneHysteresis > 0) {
+    zones.hysteresis = Configuration.ZoneHysteresis;
+  }
+  if (Configuration.ZoneDwell > 0) {
+    zones.dwellNS = Configuration.ZoneDwell * Airsoft::Drivers::NanosecondsPerSecond;
+  }
+  if (Configuration.ZoneTrust != 0) {
+    zones.minTrust = static_cast<uint8_t>(std::clamp(Configuration.ZoneTrust, 0, 100));
+  }
+  _geofence.Build(zones);
+
   led.Open(Airsoft::Drivers::Direction::Output);
 
+  // Initialize the reactor shared by the serial devices
+  if (!_reactor.Init()) {
+    std::cout << "Engine Manager: Error initializing uart reactor." << std::endl;
+  }
+
+  // Game time, from the system time until the GPS has a fix
+  _clock.Init();
+  _gps.SetGameClock(&_clock);
+
+  // Zones of the position of the device, every fix on the reactor thread at the time of its arrival
+  _gps.SetFixHandler([this](const GpsFix & fix) {
+    _geofence.Update(0, fix, _clock.ToUtc(fix.arrival), [this](const GeofenceEvent & event) {
+      std::cout << "Geofence : " << Geofence::Describe(event.type) << " " << _geofence.GetZone(event.zone).name
+                << std::endl;
+    });
+  });
+
   // Initialize GPS Module
-  //_gps.Init("/dev/ttyS3");
+  //_gps.Init("/dev/ttyS3", _reactor);
 
   // Initialize Wireless
-  /*_wireless.Init("/dev/ttyS0", Airsoft::Drivers::Gpio::CalculateGpioId(Airsoft::Drivers::BANK_1, Airsoft::Drivers::GROUP_C, Airsoft::Drivers::ID_1),
+  /*_wireless.Init("/dev/ttyS0", _reactor, Airsoft::Drivers::Gpio::CalculateGpioId(Airsoft::Drivers::BANK_1, Airsoft::Drivers::GROUP_C, Airsoft::Drivers::ID_1),
                                Airsoft::Drivers::Gpio::CalculateGpioId(Airsoft::Drivers::BANK_1, Airsoft::Drivers::GROUP_C, Airsoft::Drivers::ID_2),
                                Airsoft::Drivers::Gpio::CalculateGpioId(Airsoft::Drivers::BANK_1, Airsoft::Drivers::GROUP_C, Airsoft::Drivers::ID_3));
 */
@@ -159,6 +239,10 @@ void AirsoftManager::Engine(void) {
 
   // Terminate GPS
   _gps.Terminate();
+  _clock.Terminate();
+
+  // Terminate the reactor after its devices
+  _reactor.Terminate();
 
   std::cout << "Engine Manager: Terminated." << std::endl;
 }
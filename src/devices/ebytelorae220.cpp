@@ -10,30 +10,23 @@
 #include <thread>
 #include <iostream>
 #include <bitset>
+#include <algorithm>
 
 #include <devices/ebytelorae220.hpp>
 
 namespace Airsoft::Devices {
 
-typedef struct __attribute__((packed)) fixedStransmission {
-  uint8_t AddrH {};
-  uint8_t AddrL {};
-  uint8_t Channel {};
-  uint8_t message[];
-} FixedStransmission;
-
-//-----------------------------------------------------------------------------
-FixedStransmission * init_stack(size_t msgSize){
-  return (FixedStransmission*)new uint8_t[sizeof(FixedStransmission) + msgSize * sizeof(int32_t)];
-}
-//-----------------------------------------------------------------------------
-ConfigurationMessage * init_stack_conf(size_t msgSize){
-  return (ConfigurationMessage*)new uint8_t[sizeof(ConfigurationMessage) + msgSize * sizeof(int32_t)];
-}
-//-----------------------------------------------------------------------------
+// Maximum number of buffers of a fixed message, header included
+constexpr size_t MaxFixedMessageBuffers = 8;
 
 constexpr uint32_t KeeLoq_NLF = 0x3A5C742E;
 
+// Asynchronous exchanges: the delays of SetMode and WaitCompleteResponse, the timeouts of the port operations
+constexpr uint32_t ModeDelayMS = 40;
+constexpr uint32_t CompleteDelayMS = 2;
+constexpr uint32_t WriteTimeoutMS = 1000;
+constexpr uint32_t ResponseTimeoutMS = 1000;
+
 //-----------------------------------------------------------------------------
 EByteLoRaE220::EByteLoRaE220(Airsoft::Drivers::Uarts * serial, UartBpsRate bpsRate) {
   _serial = serial;
@@ -88,6 +81,26 @@ Status EByteLoRaE220::SetMode(ModeType mode) {
   // most of my projects uses 10 ms, but 40ms is safer
   std::this_thread::sleep_for(std::chrono::milliseconds(40));
 
+  Status res = WriteModePins(mode);
+  if (res != E220_SUCCESS) {
+    return res;
+  }
+
+  // Datasheet says 2ms later control is returned, let's give just a bit more time
+  // these modules can take time to activate pins
+  std::this_thread::sleep_for(std::chrono::milliseconds(40));
+
+  // Wait until aux pin goes back low
+  res = WaitCompleteResponse(1000);
+
+  if (res == E220_SUCCESS){
+    _mode = mode;
+  }
+
+  return res;
+}
+//-----------------------------------------------------------------------------
+Status EByteLoRaE220::WriteModePins(ModeType mode) {
   if (_m0Pin == -1 && _m1Pin == -1) {
 #ifdef LoRa_E220_DEBUG
     std::cout << "The M0 and M1 pins is not set, this mean that you are connect directly the pins as you need!" << std::endl;
@@ -117,18 +130,7 @@ Status EByteLoRaE220::SetMode(ModeType mode) {
     }
   }
 
-  // Datasheet says 2ms later control is returned, let's give just a bit more time
-  // these modules can take time to activate pins
-  std::this_thread::sleep_for(std::chrono::milliseconds(40));
-
-  // Wait until aux pin goes back low
-  Status res = WaitCompleteResponse(1000);
-
-  if (res == E220_SUCCESS){
-    _mode = mode;
-  }
-
-  return res;
+  return E220_SUCCESS;
 }
 //-----------------------------------------------------------------------------
 ModeType EByteLoRaE220::GetMode(){
@@ -170,14 +172,7 @@ ResponseStructContainer EByteLoRaE220::GetConfiguration(){
     return rc;
   }
 
-  if (((Configuration *)rc.data)->Command == static_cast<uint8_t>(ProgramCommand::WRONG_FORMAT)){
-    rc.status.code = ERR_E220_WRONG_FORMAT;
-  }
-  if (((Configuration *)rc.data)->Command != static_cast<uint8_t>(ProgramCommand::RETURNED_COMMAND) ||
-      ((Configuration *)rc.data)->StartAddress != static_cast<uint8_t>(RegisterAddress::REG_ADDRESS_CFG) ||
-      ((Configuration *)rc.data)->Lenght != static_cast<uint8_t>(PacketLength::PL_CONFIGURATION)){
-    rc.status.code = ERR_E220_HEAD_NOT_RECOGNIZED;
-  }
+  rc.status.code = CheckConfigurationHeader(*(Configuration *)rc.data);
 
   return rc;
 }
@@ -218,19 +213,41 @@ ResponseStatus EByteLoRaE220::SetConfiguration(Configuration configuration, Prog
     return rc;
   }
 
-  if (((Configuration*)&configuration)->Command == static_cast<uint8_t>(ProgramCommand::WRONG_FORMAT)){
-    rc.code = ERR_E220_WRONG_FORMAT;
-  }
-
-  if (((Configuration*)&configuration)->Command != static_cast<uint8_t>(ProgramCommand::RETURNED_COMMAND) ||
-      ((Configuration*)&configuration)->StartAddress != static_cast<uint8_t>(RegisterAddress::REG_ADDRESS_CFG) ||
-      ((Configuration*)&configuration)->Lenght != static_cast<uint8_t>(PacketLength::PL_CONFIGURATION)){
-    rc.code = ERR_E220_HEAD_NOT_RECOGNIZED;
-  }
+  rc.code = CheckConfigurationHeader(configuration);
 
   return rc;
 }
 //-----------------------------------------------------------------------------
+void EByteLoRaE220::GetConfigurationAsync(Airsoft::Drivers::UartReactor & reactor, ConfigurationHandler handler) {
+  // Function Variables
+  auto    exchange { std::make_shared<ConfigurationExchange>() };
+  uint8_t command[3] {
+    static_cast<uint8_t>(ProgramCommand::READ_CONFIGURATION),
+    static_cast<uint8_t>(RegisterAddress::REG_ADDRESS_CFG),
+    static_cast<uint8_t>(PacketLength::PL_CONFIGURATION)
+  };
+
+  exchange->reactor = &reactor;
+  exchange->handler = handler;
+
+  ExchangeConfiguration(exchange, std::string(reinterpret_cast<char*>(command), sizeof(command)), false);
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::SetConfigurationAsync(Airsoft::Drivers::UartReactor & reactor, Configuration configuration,
+                                          ConfigurationHandler handler, ProgramCommand saveType) {
+  // Function Variables
+  auto exchange { std::make_shared<ConfigurationExchange>() };
+
+  exchange->reactor = &reactor;
+  exchange->handler = handler;
+
+  configuration.Command = static_cast<uint8_t>(saveType);
+  configuration.StartAddress = static_cast<uint8_t>(RegisterAddress::REG_ADDRESS_CFG);
+  configuration.Lenght = static_cast<uint8_t>(PacketLength::PL_CONFIGURATION);
+
+  ExchangeConfiguration(exchange, std::string(reinterpret_cast<char*>(&configuration), sizeof(Configuration)), true);
+}
+//-----------------------------------------------------------------------------
 ResponseStructContainer EByteLoRaE220::GetModuleInformation(void){
   ResponseStructContainer rc;
 
@@ -303,27 +320,96 @@ ResponseContainer EByteLoRaE220::ReceiveMessageRSSI(){
 //-----------------------------------------------------------------------------
 ResponseContainer EByteLoRaE220::ReceiveMessageComplete(bool rssiEnabled){
   ResponseContainer rc;
-  rc.status.code = E220_SUCCESS;
-  std::string tmpData = _serial->Read(255);
+
+  rc.status = ReceiveMessage(rc.data, rssiEnabled ? &rc.rssi : nullptr);
+
+  return rc;
+}
+//-----------------------------------------------------------------------------
+ResponseStatus EByteLoRaE220::ReceiveMessage(std::string & message, uint8_t * rssi, int64_t * timestamp){
+  ResponseStatus status;
+  status.code = E220_SUCCESS;
+  int64_t arrival {};
+
+  // Read in place, the string keeps its capacity. Without exceptions: a quiet radio ends every read with a timeout
+  message.resize(MaxSizeRxPacket);
+  Airsoft::Drivers::UartResult result = _serial->TryRead(reinterpret_cast<uint8_t*>(&message[0]), MaxSizeRxPacket,
+                                                         arrival);
+  size_t len = result.Value();
+
+  if (result.Error() == Airsoft::Drivers::UartError::NotOpen) {
+    status.code = ERR_E220_NOT_INITIAL;
+  } else if (result.Error() == Airsoft::Drivers::UartError::Disconnected ||
+             result.Error() == Airsoft::Drivers::UartError::System) {
+    status.code = ERR_E220_HARDWARE;
+  }
+
+  if (timestamp != nullptr) {
+    *timestamp = arrival;
+  }
+
+  if (rssi != nullptr && len > 0) {
+    *rssi = static_cast<uint8_t>(message[--len]);
+  }
+
+  message.resize(len);
 
 #ifdef LoRa_E220_DEBUG
-  std::cout << tmpData << std::endl;
+  if (len > 0) {
+    std::cout << message << std::endl;
+  }
 #endif
 
-  if (rssiEnabled) {
-    rc.rssi = tmpData.at(tmpData.length() - 1);
-    rc.data = tmpData.substr(0, tmpData.length() - 1);
-  } else {
-    rc.data = tmpData;
+  return status;
+}
+//-----------------------------------------------------------------------------
+ResponseStatus EByteLoRaE220::ReceivePart(std::string & message, int64_t * timestamp){
+  // Function Variables
+  ResponseStatus                status;
+  Airsoft::Drivers::UartResult  received { _serial->TryReceive() };
+  size_t                        before { message.size() };
+  size_t                        available {};
+  int64_t                       arrival {};
+
+  status.code = E220_SUCCESS;
+
+  if (received) {
+    available = _serial->TryAvailable().Value();
+
+    // Readable with nothing to read, the device has been disconnected
+    if (received.Value() == 0 && available == 0) {
+      received = Airsoft::Drivers::UartResult(0, Airsoft::Drivers::UartError::Disconnected);
+    }
   }
 
-  CleanUARTBuffer();
+  if (received.Error() == Airsoft::Drivers::UartError::NotOpen) {
+    status.code = ERR_E220_NOT_INITIAL;
+    return status;
+  } else if (!received) {
+    status.code = ERR_E220_HARDWARE;
+    return status;
+  }
 
-  if (rc.status.code != E220_SUCCESS) {
-    return rc;
+  // No more than what is buffered, the read doesn't wait
+  available = std::min<size_t>(available, MaxSizeRxPacket - std::min<size_t>(before, MaxSizeRxPacket));
+  if (available == 0) {
+    return status;
   }
 
-  return rc;
+  message.resize(before + available);
+  Airsoft::Drivers::UartResult result = _serial->TryRead(reinterpret_cast<uint8_t*>(&message[before]), available,
+                                                         arrival);
+  message.resize(before + result.Value());
+
+  if (timestamp != nullptr && before == 0) {
+    *timestamp = arrival;
+  }
+
+  if (!result && result.Error() != Airsoft::Drivers::UartError::Timeout) {
+    status.code = ERR_E220_HARDWARE;
+  }
+
+  return status;
 }
 //-----------------------------------------------------------------------------
 ResponseContainer EByteLoRaE220::ReceiveMessageUntil(std::string delimiter){
@@ -391,8 +477,6 @@ ResponseStructContainer EByteLoRaE220::ReceiveMessageComplete(const uint8_t size
     rc.rssi = rssi[0];
   }
 
-  CleanUARTBuffer();
-
   return rc;
 }
 //-----------------------------------------------------------------------------
@@ -427,13 +511,9 @@ ResponseStatus EByteLoRaE220::SendMessage(const std::string message){
 }
 //-----------------------------------------------------------------------------
 ResponseStatus EByteLoRaE220::SendFixedMessage(uint8_t addrH, uint8_t addrL, uint8_t channel, const std::string message){
-  size_t size = message.length();
+  struct iovec payload { const_cast<char*>(message.data()), message.length() };
 
-  char messageFixed[size];
-
-  memcpy(messageFixed,message.c_str(),size);
-
-  return SendFixedMessage(addrH, addrL, channel, (uint8_t*)messageFixed, size);
+  return SendFixedMessage(addrH, addrL, channel, &payload, 1);
 }
 //-----------------------------------------------------------------------------
 ResponseStatus EByteLoRaE220::SendBroadcastFixedMessage(uint8_t CHAN, const std::string message){
@@ -441,23 +521,36 @@ ResponseStatus EByteLoRaE220::SendBroadcastFixedMessage(uint8_t CHAN, const std:
 }
 //-----------------------------------------------------------------------------
 ResponseStatus EByteLoRaE220::SendFixedMessage(uint8_t addrH, uint8_t addrL, uint8_t channel, const void * message, const uint8_t size){
+  struct iovec payload { const_cast<void*>(message), size };
+
+  return SendFixedMessage(addrH, addrL, channel, &payload, 1);
+}
+//-----------------------------------------------------------------------------
+ResponseStatus EByteLoRaE220::SendFixedMessage(uint8_t addrH, uint8_t addrL, uint8_t channel, const struct iovec * payload,
+                                               size_t count){
 #ifdef LoRa_E220_DEBUG
   std::cout << "Address H: " << addrH << std::endl;
 #endif
 
-  FixedStransmission *fixedStransmission = init_stack(size);
-
-  fixedStransmission->AddrH = addrH;
-  fixedStransmission->AddrL = addrL;
-  fixedStransmission->Channel = channel;
+  // Function Variables
+  uint8_t       header[3] { addrH, addrL, channel };
+  struct iovec  buffers[MaxFixedMessageBuffers];
+  size_t        bufferCount {};
 
+  // The header goes in front of the payload buffers, no contiguous copy is built
+  if (count >= MaxFixedMessageBuffers) {
+    ResponseStatus status;
+    status.code = ERR_E220_INVALID_PARAM;
+    return status;
+  }
 
-  memcpy(fixedStransmission->message, (unsigned char*)message, size);
+  buffers[bufferCount++] = { header, sizeof(header) };
+  for (size_t index = 0; index < count; index++) {
+    buffers[bufferCount++] = payload[index];
+  }
 
   ResponseStatus status;
-  status.code = SendStruct((uint8_t *)fixedStransmission, size+3);
-
-  delete fixedStransmission;
+  status.code = SendStruct(buffers, bufferCount);
 
   return status;
 }
@@ -469,18 +562,21 @@ ResponseStatus EByteLoRaE220::SendConfigurationMessage(uint8_t addrH, uint8_t ad
   configuration->StartAddress = static_cast<uint8_t>(RegisterAddress::REG_ADDRESS_CFG);
   configuration->Lenght = static_cast<uint8_t>(PacketLength::PL_CONFIGURATION);
 
-  ConfigurationMessage *fixedStransmission = init_stack_conf(sizeof(Configuration));
-
-  memcpy(fixedStransmission->message, (unsigned char*)configuration, sizeof(Configuration));
+  uint8_t specialCommand[2] {
+    static_cast<uint8_t>(ProgramCommand::SPECIAL_WIFI_CONF_COMMAND),
+    static_cast<uint8_t>(ProgramCommand::SPECIAL_WIFI_CONF_COMMAND)
+  };
 
-  fixedStransmission->specialCommand1 = static_cast<uint8_t>(ProgramCommand::SPECIAL_WIFI_CONF_COMMAND);
-  fixedStransmission->specialCommand2 = static_cast<uint8_t>(ProgramCommand::SPECIAL_WIFI_CONF_COMMAND);
+  struct iovec payload[2] {
+    { specialCommand, sizeof(specialCommand) },
+    { configuration, sizeof(Configuration) }
+  };
 
 #ifdef LoRa_E220_DEBUG
   std::cout << sizeof(Configuration) + 2 << std::endl;
 #endif
 
-  rc = SendFixedMessage(addrH, addrL, channel, fixedStransmission, sizeof(Configuration) + 2);
+  rc = SendFixedMessage(addrH, addrL, channel, payload, 2);
 
   return rc;
 }
@@ -530,28 +626,59 @@ Status EByteLoRaE220::WaitCompleteResponse(uint64_t timeout, uint32_t waitNoAux)
   return result;
 }
 //-----------------------------------------------------------------------------
+bool EByteLoRaE220::IsAuxHigh(void) {
+  return _auxGpio != nullptr && _auxGpio->Read();
+}
+//-----------------------------------------------------------------------------
 void EByteLoRaE220::Flush() {
   _serial->Flush();
 }
 //-----------------------------------------------------------------------------
 void EByteLoRaE220::CleanUARTBuffer() {
   // Function Variables
-  uint8_t dummy {};
+  uint8_t dummy[32];
+  size_t  available {};
 
-  // Loop all bytes
-  while (_serial->Available()) {
-    _serial->Read(&dummy, 1);
+  // Loop all bytes, stop on errors: the next read reports them
+  while ((available = _serial->TryAvailable().Value()) > 0) {
+    if (!_serial->TryRead(dummy, std::min(available, sizeof(dummy)))) {
+      break;
+    }
   }
 }
 //-----------------------------------------------------------------------------
 Status EByteLoRaE220::SendStruct(void *structureManaged, size_t size) {
+  struct iovec buffer { structureManaged, size };
+
+  return SendStruct(&buffer, 1);
+}
+//-----------------------------------------------------------------------------
+Status EByteLoRaE220::SendStruct(const struct iovec * buffers, size_t count) {
+  // Function Variables
+  size_t size {};
+
+  for (size_t index = 0; index < count; index++) {
+    size += buffers[index].iov_len;
+  }
+
   if (size > MaxSizeTxPacket + 2){
     return ERR_E220_PACKET_TOO_BIG;
   }
 
+  // Queued transmit mode, the frame trickles out from the port queue without waiting for the module, the caller
+  // paces the frames on AUX (see IsAuxHigh); a full queue refuses the whole frame and it has to be sent again later
+  if (_serial->GetTransmitQueue() > 0) {
+    Airsoft::Drivers::UartResult result = _serial->TryWrite(buffers, count);
+
+    if (result.Error() == Airsoft::Drivers::UartError::Busy) {
+      return ERR_E220_BUF_TOO_SMALL;
+    }
+    return result ? E220_SUCCESS : ERR_E220_HARDWARE;
+  }
+
   Status result = E220_SUCCESS;
 
-  size_t len = _serial->Write((uint8_t*)structureManaged, size);
+  size_t len = _serial->Write(buffers, count);
   if (len != size){
 #ifdef LoRa_E220_DEBUG
     std::cout << "Send... len: " << len << " size:" << size << std::endl;
@@ -608,6 +735,166 @@ Status EByteLoRaE220::ReceiveStruct(void * structureManaged, size_t size) {
   return WaitCompleteResponse(1000);
 }
 //-----------------------------------------------------------------------------
+void EByteLoRaE220::WaitCompleteAsync(Airsoft::Drivers::UartReactor & reactor, uint32_t timeout, uint32_t waitNoAux,
+                                      StatusHandler handler) {
+  // Without AUX the module is given the time it needs
+  if (_auxPin == -1) {
+    reactor.PostAfter(waitNoAux + CompleteDelayMS, [handler]() { handler(E220_SUCCESS); });
+    return;
+  }
+
+  // Control is back 2ms after AUX goes high
+  if (_auxGpio->Read()) {
+    reactor.PostAfter(CompleteDelayMS, [handler]() { handler(E220_SUCCESS); });
+    return;
+  }
+
+  if (timeout == 0) {
+#ifdef LoRa_E220_DEBUG
+    std::cout << "Timeout error!" << std::endl;
+#endif
+    reactor.Post([handler]() { handler(ERR_E220_TIMEOUT); });
+    return;
+  }
+
+  reactor.PostAfter(1, [this, &reactor, timeout, waitNoAux, handler]() {
+    WaitCompleteAsync(reactor, timeout - 1, waitNoAux, handler);
+  });
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::SetModeAsync(Airsoft::Drivers::UartReactor & reactor, ModeType mode, StatusHandler handler) {
+  // Same delays of SetMode, the thread isn't held meanwhile
+  reactor.PostAfter(ModeDelayMS, [this, &reactor, mode, handler]() {
+    Status status { WriteModePins(mode) };
+
+    if (status != E220_SUCCESS) {
+      handler(status);
+      return;
+    }
+
+    reactor.PostAfter(ModeDelayMS, [this, &reactor, mode, handler]() {
+      WaitCompleteAsync(reactor, 1000, 100, [this, mode, handler](Status status) {
+        if (status == E220_SUCCESS) {
+          _mode = mode;
+        }
+        handler(status);
+      });
+    });
+  });
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::SendStructAsync(Airsoft::Drivers::UartReactor & reactor, std::string data, StatusHandler handler) {
+  if (data.size() > MaxSizeTxPacket + 2){
+    reactor.Post([handler]() { handler(ERR_E220_PACKET_TOO_BIG); });
+    return;
+  }
+
+  reactor.WriteAsync(*_serial, std::move(data), WriteTimeoutMS, [this, &reactor, handler](size_t written,
+                                                                                          bool completed) {
+    if (!completed) {
+      handler(written == 0 ? ERR_E220_NO_RESPONSE_FROM_DEVICE : ERR_E220_DATA_SIZE_NOT_MATCH);
+      return;
+    }
+
+    WaitCompleteAsync(reactor, 5000, 5000, handler);
+  });
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::ExchangeConfiguration(std::shared_ptr<ConfigurationExchange> exchange, std::string command,
+                                          bool send) {
+  // Function Variables
+  Status status { CheckUARTConfiguration(ModeType::MODE_3_PROGRAM) };
+
+  if (status != E220_SUCCESS) {
+    exchange->reactor->Post(std::bind(&EByteLoRaE220::FinishConfiguration, this, exchange, status));
+    return;
+  }
+
+  exchange->previousMode = _mode;
+
+  SetModeAsync(*exchange->reactor, ModeType::MODE_3_PROGRAM, [this, exchange, command, send](Status status) {
+    if (status != E220_SUCCESS) {
+      FinishConfiguration(exchange, status);
+      return;
+    }
+
+    // The response is waited for before the command goes out, the port handler never gets it
+    exchange->pending = send ? 2 : 1;
+    exchange->reactor->ReadAsync(*_serial, sizeof(Configuration), ResponseTimeoutMS,
+                                 std::bind(&EByteLoRaE220::OnConfigurationResponse, this, exchange,
+                                           std::placeholders::_1, std::placeholders::_2));
+
+    if (!send) {
+      exchange->reactor->WriteAsync(*_serial, command, WriteTimeoutMS);
+      return;
+    }
+
+    SendStructAsync(*exchange->reactor, command, [this, exchange](Status status) {
+      if (exchange->status == E220_SUCCESS) {
+        exchange->status = status;
+      }
+      if (--exchange->pending == 0) {
+        ConfigurationReceived(exchange);
+      }
+    });
+  });
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::OnConfigurationResponse(std::shared_ptr<ConfigurationExchange> exchange, std::string & data,
+                                            bool completed) {
+  memcpy(&exchange->configuration, data.data(), std::min(data.size(), sizeof(Configuration)));
+
+#ifdef LoRa_E220_DEBUG
+  std::cout << "Available buffer: " << data.size() << " structure size: " << sizeof(Configuration) << std::endl;
+#endif
+
+  if (exchange->status == E220_SUCCESS && !completed) {
+    exchange->status = data.empty() ? ERR_E220_NO_RESPONSE_FROM_DEVICE : ERR_E220_DATA_SIZE_NOT_MATCH;
+  }
+
+  if (--exchange->pending == 0) {
+    ConfigurationReceived(exchange);
+  }
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::ConfigurationReceived(std::shared_ptr<ConfigurationExchange> exchange) {
+  if (exchange->status != E220_SUCCESS) {
+    EndConfiguration(exchange, exchange->status);
+    return;
+  }
+
+#ifdef LoRa_E220_DEBUG
+  PrintParameters(&exchange->configuration);
+#endif
+
+  // As ReceiveStruct, the module is given the time to complete
+  WaitCompleteAsync(*exchange->reactor, 1000, 100, std::bind(&EByteLoRaE220::EndConfiguration, this, exchange,
+                                                             std::placeholders::_1));
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::EndConfiguration(std::shared_ptr<ConfigurationExchange> exchange, Status status) {
+  // Back to the previous mode whatever the outcome, an error of the exchange is reported before one of the mode
+  SetModeAsync(*exchange->reactor, exchange->previousMode, [this, exchange, status](Status modeStatus) {
+    if (status != E220_SUCCESS) {
+      FinishConfiguration(exchange, status);
+    } else if (modeStatus != E220_SUCCESS) {
+      FinishConfiguration(exchange, modeStatus);
+    } else {
+      FinishConfiguration(exchange, CheckConfigurationHeader(exchange->configuration));
+    }
+  });
+}
+//-----------------------------------------------------------------------------
+void EByteLoRaE220::FinishConfiguration(std::shared_ptr<ConfigurationExchange> exchange, Status status) {
+  // Function Variables
+  ResponseStatus response;
+
+  response.code = status;
+
+  // Last use of the module, the handler may release it
+  exchange->handler(response, exchange->configuration);
+}
+//-----------------------------------------------------------------------------
 bool EByteLoRaE220::WriteProgramCommand(ProgramCommand cmd, RegisterAddress addr, PacketLength pl){
     uint8_t command[3] = { static_cast<uint8_t>(cmd), static_cast<uint8_t>(addr), static_cast<uint8_t>(pl)};
     size_t size = _serial->Write(command, 3);
@@ -629,6 +916,22 @@ RESPONSE_STATUS EByteLoRaE220::CheckUARTConfiguration(ModeType mode){
   return E220_SUCCESS;
 }
 //-----------------------------------------------------------------------------
+Status EByteLoRaE220::CheckConfigurationHeader(const Configuration & configuration){
+  // Function Variables
+  Status result { E220_SUCCESS };
+
+  if (configuration.Command == static_cast<uint8_t>(ProgramCommand::WRONG_FORMAT)){
+    result = ERR_E220_WRONG_FORMAT;
+  }
+  if (configuration.Command != static_cast<uint8_t>(ProgramCommand::RETURNED_COMMAND) ||
+      configuration.StartAddress != static_cast<uint8_t>(RegisterAddress::REG_ADDRESS_CFG) ||
+      configuration.Lenght != static_cast<uint8_t>(PacketLength::PL_CONFIGURATION)){
+    result = ERR_E220_HEAD_NOT_RECOGNIZED;
+  }
+
+  return result;
+}
+//-----------------------------------------------------------------------------
 #define bitRead(value, bit) (((value) >> (bit)) & 0x01)
 uint64_t EByteLoRaE220::Encrypt(uint64_t data) {
   uint64_t x = data;
@@ -29,7 +29,7 @@
  *******************************************************************************
  */
 
-#include <utility.hpp>
+#include <drivers/clock.hpp>
 #include <devices/i2ckeypad.hpp>
 
 namespace Airsoft::Devices {
@@ -59,10 +59,11 @@ bool I2CKeyPad::IsConnected() {
 }
 //------------------------------------------------------------------------------
 uint8_t I2CKeyPad::GetKey(void) {
-  uint64_t now = Utility::TimeSinceEpochMillisec();
+  // Monotonic, setting the wall time doesn't break the debounce
+  uint64_t now = static_cast<uint64_t>(Airsoft::Drivers::Clock::Default().NowMS());
 
-  if (_debounceThreshold > 0) {
-    if (now - _debounceThreshold < _lastTimeRead) {
+  if (_debounceThreshold > 0 && _lastTimeRead != 0) {
+    if (now - _lastTimeRead < _debounceThreshold) {
       return I2C_KEYPAD_THRESHOLD;
     }
   }
@@ -0,0 +1,98 @@
+/**
+ *******************************************************************************
+ * @file clock.cpp
+ *
+ * @brief Integer nanoseconds monotonic clock and deadlines, implementation
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+#include <time.h>
+#include <drivers/clock.hpp>
+
+namespace Airsoft::Drivers {
+
+std::atomic<const Clock*> Clock::_default {};
+
+//-----------------------------------------------------------------------------
+const Clock & Clock::Default(void) {
+  // Function Variables
+  const Clock * clock { _default.load(std::memory_order_acquire) };
+
+  // The monotonic clock when no other has been set
+  return clock != nullptr ? *clock : Monotonic();
+}
+//-----------------------------------------------------------------------------
+void Clock::SetDefault(const Clock * clock) {
+  _default.store(clock, std::memory_order_release);
+}
+//-----------------------------------------------------------------------------
+const Clock & Clock::Monotonic(void) {
+  // Local, safe to use during the static initialization
+  static const MonotonicClock clock;
+  return clock;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+int64_t MonotonicClock::Now(void) const {
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return static_cast<int64_t>(time.tv_sec) * NanosecondsPerSecond + time.tv_nsec;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+int64_t Deadline::RemainingMS(void) const {
+  // Function Variables
+  int64_t remaining { Remaining() };
+
+  if (remaining == INT64_MAX) {
+    return INT64_MAX;
+  }
+
+  return remaining <= 0 ? 0 : (remaining + NanosecondsPerMillisecond - 1) / NanosecondsPerMillisecond;
+}
+//-----------------------------------------------------------------------------
+timespec Deadline::RemainingTimespec(void) const {
+  // Function Variables
+  int64_t remaining { Remaining() };
+
+  return ToTimespec(remaining > 0 ? remaining : 0);
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+timespec ToTimespec(int64_t nanoseconds) {
+  // Function Variables
+  timespec time;
+
+  time.tv_sec = static_cast<time_t>(nanoseconds / NanosecondsPerSecond);
+  time.tv_nsec = static_cast<long>(nanoseconds % NanosecondsPerSecond);
+
+  return time;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft::Drivers
@@ -29,7 +29,11 @@
  *******************************************************************************
  */
 
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <drivers/gpio.hpp>
+#include <drivers/clock.hpp>
 
 namespace Airsoft::Drivers {
 
@@ -131,6 +135,11 @@ void Gpio::Close(void) {
     _valueOutput.flush();
     _valueOutput.close();
 
+    if (_edgeFd != -1) {
+      ::close(_edgeFd);
+      _edgeFd = -1;
+    }
+
     // Open 'unexport' control and disable GPIO
     std::ofstream unexportStream("/sys/class/gpio/unexport", std::ofstream::trunc);
     if (unexportStream.is_open()) {
@@ -196,5 +205,61 @@ bool Gpio::Read(void) {
   return _currentLevel == Level::High;
 }
 //-----------------------------------------------------------------------------
+bool Gpio::SetEdge(Edge edge) {
+  // Only if input
+  if (!_isOpen || _direction != Direction::Input) {
+    return false;
+  }
+
+  // Edge of the GPIO
+  const std::string edgePath = "/sys/class/gpio/gpio" + std::to_string(_gpioPin) + "/edge";
+  static const char * const names[] { "none", "rising", "falling", "both" };
+
+  std::ofstream edgeStream(edgePath.c_str(), std::ofstream::trunc);
+  if (!edgeStream.is_open()) {
+    perror("Failed to open GPIO edge file");
+    return false;
+  }
+
+  edgeStream << names[static_cast<size_t>(edge)];
+  edgeStream.flush();
+  edgeStream.close();
+
+  // The value file signals the edges as an exceptional condition
+  if (_edgeFd == -1 && (_edgeFd = ::open(_valuePath.c_str(), O_RDONLY | O_CLOEXEC)) == -1) {
+    perror("Failed to open GPIO value file");
+    return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool Gpio::WaitEdge(int64_t & timestamp, int32_t timeoutMS) {
+  // Function Variables
+  pollfd  fd { _edgeFd, POLLPRI | POLLERR, 0 };
+  char    value[4] {};
+  int32_t result {};
+
+  if (_edgeFd == -1) {
+    return false;
+  }
+
+  // Read the value to clear the pending condition, the next poll waits for a new edge
+  ::lseek(_edgeFd, 0, SEEK_SET);
+  if (::read(_edgeFd, value, sizeof(value)) < 0) {
+    return false;
+  }
+
+  result = ::poll(&fd, 1, timeoutMS);
+
+  if (result <= 0 || (fd.revents & POLLPRI) == 0) {
+    return false;
+  }
+
+  timestamp = Clock::Default().Now();
+
+  return true;
+}
+//-----------------------------------------------------------------------------
 
 } // namespace Airsoft::Drivers
@@ -0,0 +1,683 @@
+/**
+ *******************************************************************************
+ * @file uart-reactor.cpp
+ *
+ * @brief Event loop servicing any number of uarts from a single thread, implementation
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <drivers/uart-reactor.hpp>
+
+namespace Airsoft::Drivers {
+
+// Maximum number of events handled for each epoll_wait
+constexpr int32_t MaxEvents = 16;
+
+//-----------------------------------------------------------------------------
+static Deadline deadline_from_ms (uint32_t timeoutMS) {
+  // Bound to epoll_wait, so on the real time
+  return timeoutMS == Timeout::Max() ? Deadline() : Deadline::FromMilliseconds(timeoutMS, Clock::Monotonic());
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+UartReactor::~UartReactor() {
+  Terminate();
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool UartReactor::Init(void) {
+  // Check if already running
+  if (_process != nullptr) {
+    return false;
+  }
+
+  // Create epoll set
+  if ((_epoll = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+    return false;
+  }
+
+  // Create the wake up event and add it to the set
+  if ((_wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1) {
+    ::close(_epoll);
+    _epoll = -1;
+    return false;
+  }
+
+  epoll_event event {};
+  event.events = EPOLLIN;
+  event.data.fd = _wakeup;
+
+  if (epoll_ctl(_epoll, EPOLL_CTL_ADD, _wakeup, &event) == -1) {
+    ::close(_wakeup);
+    ::close(_epoll);
+    _wakeup = _epoll = -1;
+    return false;
+  }
+
+  // Set flag of thread running
+  _threadRunning = true;
+
+  // Create Engine Thread
+  return ((_process = new std::thread(std::bind(&UartReactor::Engine, this))) != nullptr);
+}
+//-----------------------------------------------------------------------------
+void UartReactor::Terminate(void) {
+  // Check valid thread
+  if (_process != nullptr) {
+    // Reset thread flag and wake up the thread
+    _threadRunning = false;
+    Wakeup();
+
+    // Called from a handler the thread can't wait for itself
+    if (IsReactorThread()) {
+      _process->detach();
+    } else {
+      _process->join();
+    }
+
+    delete _process;
+    _process = nullptr;
+  }
+
+  _tasksLock.lock();
+  _timers.clear();
+  _tasksLock.unlock();
+
+  // Release resources
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+
+  // The ports could outlive the reactor
+  for (auto & registration : _registrations) {
+    registration.second.uart->SetTransmitNotify(nullptr);
+  }
+
+  _registrations.clear();
+
+  if (_wakeup != -1) {
+    ::close(_wakeup);
+    _wakeup = -1;
+  }
+
+  if (_epoll != -1) {
+    ::close(_epoll);
+    _epoll = -1;
+  }
+
+  _ready = false;
+}
+//-----------------------------------------------------------------------------
+bool UartReactor::Register(Uarts & uart, Handler onReadable, Handler onWritable) {
+  // Function Variables
+  int32_t fd { uart.GetDescriptor() };
+
+  // Check valid port and reactor
+  if (fd == -1 || _epoll == -1) {
+    return false;
+  }
+
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+
+  // Check if already registered
+  if (_registrations.find(fd) != _registrations.end()) {
+    return false;
+  }
+
+  epoll_event event {};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+
+  if (epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) == -1) {
+    return false;
+  }
+
+  Registration & registration { _registrations[fd] };
+
+  registration.uart = &uart;
+  registration.onReadable = onReadable;
+  registration.onWritable = onWritable;
+  registration.events = event.events;
+
+  // Queued data is drained from the reactor thread
+  uart.SetTransmitNotify([this, fd]() {
+    Post(std::bind(&UartReactor::ServiceTransmit, this, fd));
+  });
+
+  if (uart.GetTransmitPending() > 0) {
+    Post(std::bind(&UartReactor::ServiceTransmit, this, fd));
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool UartReactor::SetWritable(Uarts & uart, bool enable) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+
+  // Function Variables
+  auto registration { _registrations.find(uart.GetDescriptor()) };
+
+  if (registration == _registrations.end()) {
+    return false;
+  }
+
+  registration->second.writable = enable;
+
+  return UpdateEvents(registration->first, registration->second);
+}
+//-----------------------------------------------------------------------------
+void UartReactor::Unregister(Uarts & uart) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+
+  // Function Variables
+  auto registration { _registrations.find(uart.GetDescriptor()) };
+
+  if (registration == _registrations.end()) {
+    return;
+  }
+
+  epoll_ctl(_epoll, EPOLL_CTL_DEL, registration->first, nullptr);
+
+  uart.SetTransmitNotify(nullptr);
+
+  // Pending operations fail, their handlers run on the reactor thread
+  FailOperations(registration->second);
+
+  _registrations.erase(registration);
+}
+//-----------------------------------------------------------------------------
+void UartReactor::Post(Handler task) {
+  _tasksLock.lock();
+  _tasks.push(task);
+  _tasksLock.unlock();
+
+  Wakeup();
+}
+//-----------------------------------------------------------------------------
+void UartReactor::PostAfter(uint32_t delayMS, Handler task) {
+  _tasksLock.lock();
+  _timers.push_back(Timer { deadline_from_ms(delayMS), task });
+  _tasksLock.unlock();
+
+  // The thread could be waiting with a later timeout
+  Wakeup();
+}
+//-----------------------------------------------------------------------------
+void UartReactor::ReadAsync(Uarts & uart, size_t size, uint32_t timeoutMS, ReadHandler handler) {
+  // Function Variables
+  ReadOperation operation;
+
+  operation.size = size;
+  operation.deadline = deadline_from_ms(timeoutMS);
+  operation.handler = handler;
+
+  StartRead(uart, std::move(operation));
+}
+//-----------------------------------------------------------------------------
+void UartReactor::ReadLineAsync(Uarts & uart, uint32_t timeoutMS, ReadHandler handler, size_t size, std::string eol) {
+  // Function Variables
+  ReadOperation operation;
+
+  operation.line = true;
+  operation.size = size;
+  operation.eol = eol;
+  operation.deadline = deadline_from_ms(timeoutMS);
+  operation.handler = handler;
+
+  StartRead(uart, std::move(operation));
+}
+//-----------------------------------------------------------------------------
+void UartReactor::WriteAsync(Uarts & uart, std::string data, uint32_t timeoutMS, WriteHandler handler) {
+  // Function Variables
+  int32_t         fd { uart.GetDescriptor() };
+  WriteOperation  operation;
+
+  operation.data = std::move(data);
+  operation.deadline = deadline_from_ms(timeoutMS);
+  operation.handler = handler;
+
+  // Queued from the reactor thread, so the handler never runs inside this call
+  Post([this, fd, operation]() mutable {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    auto registration { _registrations.find(fd) };
+
+    if (registration == _registrations.end()) {
+      if (operation.handler) {
+        operation.handler(0, false);
+      }
+      return;
+    }
+
+    registration->second.writes.push_back(std::move(operation));
+    ServiceWrites(fd);
+  });
+}
+//-----------------------------------------------------------------------------
+bool UartReactor::IsReactorThread(void) const {
+  return _process != nullptr && _process->get_id() == std::this_thread::get_id();
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void UartReactor::Wakeup(void) {
+  // Function Variables
+  uint64_t value { 1 };
+
+  if (_wakeup != -1) {
+    [[maybe_unused]] ssize_t r = ::write(_wakeup, &value, sizeof(value));
+  }
+}
+//-----------------------------------------------------------------------------
+void UartReactor::RunTasks(void) {
+  // Function Variables
+  std::queue<Handler> tasks;
+
+  _tasksLock.lock();
+  std::swap(tasks, _tasks);
+  _tasksLock.unlock();
+
+  while (!tasks.empty()) {
+    tasks.front()();
+    tasks.pop();
+  }
+}
+//-----------------------------------------------------------------------------
+void UartReactor::RunTimers(void) {
+  // Function Variables
+  std::vector<Handler> tasks;
+
+  _tasksLock.lock();
+  for (auto timer = _timers.begin(); timer != _timers.end();) {
+    if (timer->deadline.Expired()) {
+      tasks.push_back(std::move(timer->task));
+      timer = _timers.erase(timer);
+    } else {
+      ++timer;
+    }
+  }
+  _tasksLock.unlock();
+
+  // Without the lock, a task may post again
+  for (Handler & task : tasks) {
+    task();
+  }
+}
+//-----------------------------------------------------------------------------
+bool UartReactor::UpdateEvents(int32_t fd, Registration & registration) {
+  // Function Variables
+  uint32_t events { (registration.writable || registration.transmitting || !registration.writes.empty()) ?
+                      (EPOLLIN | EPOLLOUT) : EPOLLIN };
+
+  // Nothing changes
+  if (registration.events == events) {
+    return true;
+  }
+
+  epoll_event event {};
+  event.events = events;
+  event.data.fd = fd;
+
+  if (epoll_ctl(_epoll, EPOLL_CTL_MOD, fd, &event) == -1) {
+    return false;
+  }
+
+  registration.events = events;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void UartReactor::StartRead(Uarts & uart, ReadOperation operation) {
+  // Function Variables
+  int32_t fd { uart.GetDescriptor() };
+
+  // Queued from the reactor thread, so the handler never runs inside the call
+  Post([this, fd, operation]() mutable {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    auto registration { _registrations.find(fd) };
+
+    if (registration == _registrations.end()) {
+      operation.handler(operation.data, false);
+      return;
+    }
+
+    registration->second.reads.push_back(std::move(operation));
+
+    // Data could be already buffered by the port
+    ServiceReads(fd, false);
+  });
+}
+//-----------------------------------------------------------------------------
+void UartReactor::ServiceReads(int32_t fd, bool readable) {
+  // Function Variables
+  auto  registration { _registrations.find(fd) };
+  bool  progress {};
+  bool  disconnected {};
+
+  if (registration == _registrations.end()) {
+    return;
+  }
+
+  // Function Variables
+  Uarts & uart { *registration->second.uart };
+
+  // Readable without data, the device has been disconnected (unless the receive buffer is full)
+  if (readable) {
+    UartResult received { uart.TryReceive() };
+
+    if (!received || received.Value() == 0) {
+      disconnected = true;
+    }
+  }
+
+  // Complete the operations in order, a handler may start new ones or unregister the port
+  while ((registration = _registrations.find(fd)) != _registrations.end() && !registration->second.reads.empty()) {
+    ReadOperation & operation { registration->second.reads.front() };
+    size_t          before { operation.data.size() };
+    bool            done {};
+
+    if (operation.line) {
+      done = uart.GetLine(operation.data, operation.size, operation.eol);
+    } else {
+      uart.GetData(operation.data, operation.size - operation.data.size());
+      done = operation.data.size() == operation.size;
+    }
+
+    progress |= done || operation.data.size() != before;
+
+    if (!done) {
+      break;
+    }
+
+    ReadOperation completed { std::move(operation) };
+    registration->second.reads.pop_front();
+    completed.handler(completed.data, true);
+  }
+
+  if (disconnected && !progress && (registration = _registrations.find(fd)) != _registrations.end()) {
+    FailOperations(registration->second);
+  }
+}
+//-----------------------------------------------------------------------------
+void UartReactor::ServiceWrites(int32_t fd) {
+  // Function Variables
+  auto registration { _registrations.find(fd) };
+
+  if (registration == _registrations.end()) {
+    return;
+  }
+
+  // Function Variables
+  Uarts & uart { *registration->second.uart };
+
+  while ((registration = _registrations.find(fd)) != _registrations.end() && !registration->second.writes.empty()) {
+    WriteOperation & operation { registration->second.writes.front() };
+    UartResult       sent { uart.TrySend(reinterpret_cast<const uint8_t*>(operation.data.data()) + operation.written,
+                                         operation.data.size() - operation.written) };
+
+    if (!sent) {
+      FailOperations(registration->second);
+      break;
+    }
+
+    operation.written += sent.Value();
+
+    // Kernel buffer full, continue when writable
+    if (operation.written < operation.data.size()) {
+      break;
+    }
+
+    WriteOperation completed { std::move(operation) };
+    registration->second.writes.pop_front();
+    if (completed.handler) {
+      completed.handler(completed.written, true);
+    }
+  }
+
+  // Writable notifications only while there is something to write
+  if ((registration = _registrations.find(fd)) != _registrations.end()) {
+    UpdateEvents(fd, registration->second);
+  }
+}
+//-----------------------------------------------------------------------------
+void UartReactor::ServiceTransmit(int32_t fd) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+
+  // Function Variables
+  auto registration { _registrations.find(fd) };
+
+  if (registration == _registrations.end()) {
+    return;
+  }
+
+  // Whatever the kernel takes now, the rest when writable; on error the readable handler finds out
+  UartResult pending { registration->second.uart->TryTransmit() };
+
+  registration->second.transmitting = pending && pending.Value() > 0;
+
+  UpdateEvents(fd, registration->second);
+}
+//-----------------------------------------------------------------------------
+void UartReactor::FailOperations(Registration & registration) {
+  // Function Variables
+  std::deque<ReadOperation>   reads;
+  std::deque<WriteOperation>  writes;
+
+  if (registration.reads.empty() && registration.writes.empty()) {
+    return;
+  }
+
+  std::swap(reads, registration.reads);
+  std::swap(writes, registration.writes);
+
+  // As on timeout, the first read gets the partial line
+  if (!reads.empty() && reads.front().line) {
+    registration.uart->GetData(reads.front().data, reads.front().size - reads.front().data.size());
+  }
+
+  // Called with the registration being changed, the handlers run later
+  Post([reads, writes]() mutable {
+    for (ReadOperation & operation : reads) {
+      operation.handler(operation.data, false);
+    }
+    for (WriteOperation & operation : writes) {
+      if (operation.handler) {
+        operation.handler(operation.written, false);
+      }
+    }
+  });
+}
+//-----------------------------------------------------------------------------
+void UartReactor::ExpireOperations(void) {
+  // Function Variables
+  std::vector<ReadOperation>  reads;
+  std::vector<WriteOperation> writes;
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(_lock);
+
+    for (auto & registration : _registrations) {
+      for (auto operation = registration.second.reads.begin(); operation != registration.second.reads.end();) {
+        if (operation->deadline.Expired()) {
+          // The partial line of the first read is still in the port, it is the data received so far
+          if (operation == registration.second.reads.begin() && operation->line) {
+            registration.second.uart->GetData(operation->data, operation->size - operation->data.size());
+          }
+          reads.push_back(std::move(*operation));
+          operation = registration.second.reads.erase(operation);
+        } else {
+          ++operation;
+        }
+      }
+
+      for (auto operation = registration.second.writes.begin(); operation != registration.second.writes.end();) {
+        if (operation->deadline.Expired()) {
+          writes.push_back(std::move(*operation));
+          operation = registration.second.writes.erase(operation);
+        } else {
+          ++operation;
+        }
+      }
+
+      UpdateEvents(registration.first, registration.second);
+    }
+  }
+
+  // Handlers run without the lock, they may start new operations
+  for (ReadOperation & operation : reads) {
+    operation.handler(operation.data, false);
+  }
+  for (WriteOperation & operation : writes) {
+    if (operation.handler) {
+      operation.handler(operation.written, false);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+int32_t UartReactor::NextTimeout(void) {
+  std::lock_guard<std::recursive_mutex> lock(_lock);
+
+  // Function Variables
+  Deadline deadline;
+
+  for (auto & registration : _registrations) {
+    for (const ReadOperation & operation : registration.second.reads) {
+      deadline = std::min(deadline, operation.deadline);
+    }
+    for (const WriteOperation & operation : registration.second.writes) {
+      deadline = std::min(deadline, operation.deadline);
+    }
+  }
+
+  _tasksLock.lock();
+  for (const Timer & timer : _timers) {
+    deadline = std::min(deadline, timer.deadline);
+  }
+  _tasksLock.unlock();
+
+  // Nothing to expire, wait for the events
+  if (deadline.IsNever()) {
+    return -1;
+  }
+
+  // Rounded up, waking up before the deadline would spin
+  return static_cast<int32_t>(std::min<int64_t>(deadline.RemainingMS(), INT32_MAX));
+}
+//-----------------------------------------------------------------------------
+void UartReactor::Engine(void) {
+  // Thread Variables
+  epoll_event events[MaxEvents];
+
+  std::cout << "Uart Reactor: Started." << std::endl;
+
+  // Set ready flag
+  _ready = true;
+
+  // Thread loop
+  while(_threadRunning) {
+    int32_t count { epoll_wait(_epoll, events, MaxEvents, NextTimeout()) };
+
+    if (count < 0) {
+      // Interrupted, try again
+      if (errno == EINTR) {
+        continue;
+      }
+
+      std::cout << "Uart Reactor: epoll_wait error " << errno << "." << std::endl;
+      break;
+    }
+
+    for (int32_t index = 0; index < count && _threadRunning; index++) {
+      // Wake up request, run the posted tasks
+      if (events[index].data.fd == _wakeup) {
+        uint64_t value {};
+        [[maybe_unused]] ssize_t r = ::read(_wakeup, &value, sizeof(value));
+        RunTasks();
+        continue;
+      }
+
+      // Hold the lock while the handler runs, so Unregister waits for it
+      std::lock_guard<std::recursive_mutex> lock(_lock);
+
+      // The port could have been removed by a previous handler
+      auto registration { _registrations.find(events[index].data.fd) };
+      if (registration == _registrations.end()) {
+        continue;
+      }
+
+      // Function Variables
+      int32_t fd { events[index].data.fd };
+
+      // Copy the handlers, a handler may unregister its own port
+      Handler onReadable { registration->second.onReadable };
+      Handler onWritable { registration->second.onWritable };
+
+      // Pending reads take the data, otherwise the port handler is notified
+      if (events[index].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        if (!registration->second.reads.empty()) {
+          ServiceReads(fd, true);
+        } else if (onReadable) {
+          onReadable();
+        }
+      }
+
+      if (events[index].events & EPOLLOUT) {
+        // The transmit queue first, it holds the oldest data
+        if ((registration = _registrations.find(fd)) != _registrations.end() && registration->second.transmitting) {
+          ServiceTransmit(fd);
+        }
+
+        if ((registration = _registrations.find(fd)) != _registrations.end() && !registration->second.writes.empty()) {
+          ServiceWrites(fd);
+        }
+
+        if ((registration = _registrations.find(fd)) != _registrations.end() && registration->second.writable &&
+            onWritable) {
+          onWritable();
+        }
+      }
+    }
+
+    // Operations past their deadline fail, delayed tasks due run
+    ExpireOperations();
+    RunTimers();
+  }
+
+  _ready = false;
+
+  std::cout << "Uart Reactor: Terminated." << std::endl;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft::Drivers
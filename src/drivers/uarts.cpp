@@ -41,7 +41,7 @@
 #include <termios.h>
 #include <sys/param.h>
 #include <pthread.h>
-#include <drivers/uarts/ms-timers.hpp>
+#include <drivers/clock.hpp>
 #include <drivers/uarts.hpp>
 #include <sys/ioctl.h>
 #include <linux/serial.h>
@@ -51,6 +51,7 @@
 #include <time.h>
 
 #include <memory>
+#include <algorithm>
 
 #ifndef TIOCINQ
 #ifdef FIONREAD
@@ -62,17 +63,8 @@
 
 namespace Airsoft::Drivers {
 
-//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-// Time conversion function
-
-//-----------------------------------------------------------------------------
-static timespec timespec_from_ms (const uint32_t millis) {
-  timespec time;
-  time.tv_sec = millis / 1e3;
-  time.tv_nsec = (millis - (time.tv_sec * 1e3)) * 1e6;
-  return time;
-}
-//-----------------------------------------------------------------------------
+// Maximum number of buffers passed to a single writev
+constexpr int32_t MaxWriteBuffers = 16;
 
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Class ScopeReadLock for uart
@@ -117,6 +109,50 @@ private:
 };
 //-----------------------------------------------------------------------------
 
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+// Class ScopedDuration for uart statistics
+
+//-----------------------------------------------------------------------------
+class ScopedDuration final {
+public:
+  using Record = void (UartCounters::*)(int64_t);
+
+  ScopedDuration(UartCounters & counters, Record record)
+    : _counters(counters), _record(record), _start(Clock::Monotonic().Now()) {
+  }
+  ~ScopedDuration() {
+    (_counters.*_record)(Clock::Monotonic().Now() - _start);
+  }
+private:
+  // Disable copy constructors
+  ScopedDuration(const ScopedDuration&);
+  const ScopedDuration& operator=(ScopedDuration);
+
+private:
+  UartCounters &  _counters;
+  Record          _record;
+  int64_t         _start;
+};
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+static size_t value_or_throw (const UartResult & result, const char * where) {
+  // Timeouts are not errors for the throwing interface, the count tells what has been done
+  switch (result.Error()) {
+    case UartError::NotOpen:
+      throw PortNotOpenedException (where);
+    case UartError::Disconnected:
+      // Disconnected devices, at least on Linux, show the behavior that they are always
+      // ready immediately but reading or writing returns nothing.
+      throw UartException ("device reports readiness but returned no data (device disconnected?)");
+    case UartError::System:
+      THROW (IOException, result.SystemError());
+    default:
+      return result.Value();
+  }
+}
+//-----------------------------------------------------------------------------
+
 //+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
 // Constructor / Destructor Uarts
 
@@ -124,7 +160,16 @@ private:
 Uarts::Uarts (const std::string &port, uint32_t baudrate, Timeout timeout, ByteSize bytesize, Parity parity,
                 StopBits stopbits, FlowControl flowcontrol) {
   _port = port;
+  _baudrate = baudrate;
+  _bytesize = bytesize;
+  _parity = parity;
+  _stopbits = stopbits;
+  _flowcontrol = flowcontrol;
   SetTimeout(timeout);
+
+  // Initialize the locks
+  pthread_mutex_init(&_readMutex, nullptr);
+  pthread_mutex_init(&_writeMutex, nullptr);
 }
 //-----------------------------------------------------------------------------
 
@@ -179,6 +224,11 @@ void Uarts::Close(void) {
     }
 
     _is_open = false;
+
+    // Nothing to send it to anymore
+    if (_txBuffer) {
+      _txBuffer->Clear();
+    }
   }
 }
 //-----------------------------------------------------------------------------
@@ -187,101 +237,144 @@ bool Uarts::IsOpen(void) const {
 }
 //-----------------------------------------------------------------------------
 size_t Uarts::Available(void) {
-  // If the port is not open, throw
+  // If the port is not open, nothing is available
   if (!_is_open) {
     return 0;
   }
 
+  return value_or_throw(TryAvailable(), "Uarts::Available");
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryAvailable(void) {
   // Function Variables
   int32_t count {};
 
+  if (!_is_open) {
+    return UartResult(0, UartError::NotOpen);
+  }
+
   if (ioctl(_fd, TIOCINQ, &count) == -1) {
-    THROW (IOException, errno);
+    return Fail(UartError::System, 0, errno);
   }
 
-  return static_cast<size_t>(count);
+  return UartResult(_rxBuffer.Size() + static_cast<size_t>(count));
 }
 //-----------------------------------------------------------------------------
 bool Uarts::WaitReadable(void) {
+  // Data already buffered
+  if (!_rxBuffer.Empty()) {
+    return true;
+  }
+
+  return value_or_throw(PollReadable(_timeout.ReadTimeoutConstant), "Uarts::WaitReadable") > 0;
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::PollReadable(uint32_t timeoutMS) {
   // Setup a select call to block for serial data or a timeout
   fd_set readfds;
   FD_ZERO(&readfds);
   FD_SET(_fd, &readfds);
 
-  timespec timeout_ts (timespec_from_ms (_timeout.ReadTimeoutConstant));
+  timespec timeout_ts (ToTimespec(timeoutMS * NanosecondsPerMillisecond));
   int32_t r { pselect (_fd + 1, &readfds, nullptr, nullptr, &timeout_ts, nullptr) };
 
   if (r < 0) {
-    // Select was interrupted
+    // Select was interrupted, the caller checks its deadline and waits again
     if (errno == EINTR) {
-      return false;
+      return UartResult(0, UartError::Timeout);
     }
     // Otherwise there was some error
-    THROW (IOException, errno);
+    return Fail(UartError::System, 0, errno);
   }
 
   // Timeout occurred
-  if (r == 0) {
-    return false;
-  }
-
-  // This shouldn't happen, if r > 0 our fd has to be in the list!
-  if (!FD_ISSET (_fd, &readfds)) {
-    THROW (IOException, "select reports ready to read, but our fd isn't in the list, this shouldn't happen!");
+  if (r == 0 || !FD_ISSET (_fd, &readfds)) {
+    return UartResult(0, UartError::Timeout);
   }
 
   // Data available to read.
-  return true;
+  return UartResult(1);
 }
 //-----------------------------------------------------------------------------
 void Uarts::WaitByteTimes (size_t count) {
-  timespec wait_time;
-  wait_time.tv_sec = 0;
-  wait_time.tv_nsec = static_cast<int64_t>(_byteTime_ns * count);
+  timespec wait_time (ToTimespec(static_cast<int64_t>(_byteTime_ns) * static_cast<int64_t>(count)));
   pselect (0, nullptr, nullptr, nullptr, &wait_time, nullptr);
 }
 //-----------------------------------------------------------------------------
 size_t Uarts::Read (uint8_t * buffer, size_t size) {
-  ScopedReadLock(this);
-  return _Read (buffer, size);
+  ScopedReadLock lock(this);
+  return value_or_throw(_Read (buffer, size), "Uarts::Read");
 }
 //-----------------------------------------------------------------------------
-size_t Uarts::Read(std::vector<uint8_t> & buffer, size_t size) {
+size_t Uarts::Read (uint8_t * buffer, size_t size, int64_t & timestamp) {
+  ScopedReadLock lock(this);
+  return value_or_throw(_Read (buffer, size, &timestamp), "Uarts::Read");
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::Read(RingBuffer & buffer, size_t size) {
   // Read lock
-  ScopedReadLock(this);
+  ScopedReadLock lock(this);
 
   // Function Variables
-  std::unique_ptr<uint8_t>  bufferRD(new uint8_t(size));
-  size_t                    bytesRead {};
+  size_t bytesRead {};
 
-  try {
-    bytesRead = _Read(bufferRD.get(), size);
-  } catch (const std::exception &e) {
-    throw;
-  }
+  size = std::min(size, buffer.Free());
+
+  // At most two regions, before and after the wrap
+  while (bytesRead < size) {
+    size_t    regionLength {};
+    uint8_t * region { buffer.WriteRegion(regionLength) };
+
+    regionLength = std::min(regionLength, size - bytesRead);
 
-  buffer.insert(buffer.end (), bufferRD.get(), bufferRD.get() + bytesRead);
+    UartResult bytesReadNow { _Read(region, regionLength) };
+
+    buffer.Commit(bytesReadNow.Value());
+    bytesRead += value_or_throw(bytesReadNow, "Uarts::Read");
+
+    // Timeout occurred
+    if (bytesReadNow.Value() < regionLength) {
+      break;
+    }
+  }
 
   return bytesRead;
 }
 //-----------------------------------------------------------------------------
+size_t Uarts::Read(std::vector<uint8_t> & buffer, size_t size) {
+  // Read lock
+  ScopedReadLock lock(this);
+
+  // Function Variables
+  size_t offset { buffer.size() };
+
+  // Read in place after the current content
+  buffer.resize(offset + size);
+
+  UartResult result { _Read(buffer.data() + offset, size) };
+
+  // The bytes received before an error are kept
+  buffer.resize(offset + result.Value());
+
+  return value_or_throw(result, "Uarts::Read");
+}
+//-----------------------------------------------------------------------------
 size_t Uarts::Read(std::string & buffer, size_t size) {
   // Lock mutex
-  ScopedReadLock(this);
+  ScopedReadLock lock(this);
 
   // Function Variables
-  std::unique_ptr<uint8_t> bufferRD(new uint8_t(size));
-  size_t bytesRead {};
+  size_t offset { buffer.size() };
 
-  try {
-    bytesRead = _Read(bufferRD.get(), size);
-  } catch (const std::exception &e) {
-    throw;
-  }
+  // Read in place after the current content
+  buffer.resize(offset + size);
 
-  buffer.append(reinterpret_cast<const char*>(bufferRD.get()), bytesRead);
+  UartResult result { _Read(reinterpret_cast<uint8_t*>(&buffer[offset]), size) };
 
-  return bytesRead;
+  // The bytes received before an error are kept
+  buffer.resize(offset + result.Value());
+
+  return value_or_throw(result, "Uarts::Read");
 }
 //-----------------------------------------------------------------------------
 std::string Uarts::Read(size_t size) {
@@ -295,38 +388,60 @@ std::string Uarts::Read(size_t size) {
 //-----------------------------------------------------------------------------
 size_t Uarts::ReadLine(std::string & buffer, size_t size, std::string eol) {
   // Read lock
-  ScopedReadLock(this);
-
+  ScopedReadLock lock(this);
+  return value_or_throw(_ReadLine(buffer, size, eol, nullptr), "Uarts::ReadLine");
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::ReadLine(std::string & buffer, int64_t & timestamp, size_t size, std::string eol) {
+  // Read lock
+  ScopedReadLock lock(this);
+  return value_or_throw(_ReadLine(buffer, size, eol, &timestamp), "Uarts::ReadLine");
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::_ReadLine(std::string & buffer, size_t size, const std::string & eol, int64_t * timestamp) {
   // Function Variables
-  size_t    eolLen { eol.length () };
-  uint8_t * bufferRead = static_cast<uint8_t*> (alloca(size * sizeof(uint8_t)));
-  size_t    readSoFar {};
+  const uint8_t * eolData { reinterpret_cast<const uint8_t*>(eol.data()) };
+  size_t          eolLen { eol.length () };
+  int64_t         chunkTimeoutMS { _timeout.ReadTimeoutConstant };
+  size_t          scanFrom {};
+  size_t          lineLen {};
+  UartResult      failed;
 
-  while (true) {
-    size_t bytes_read { _Read(bufferRead + readSoFar, 1) };
+  chunkTimeoutMS += _timeout.ReadTimeoutMultiplier;
 
-    readSoFar += bytes_read;
+  while (true) {
+    // An empty delimiter terminates the line on every byte
+    size_t found { eolLen == 0 ? (_rxBuffer.Empty() ? RingBuffer::npos : 0) :
+                                 _rxBuffer.Find(eolData, eolLen, scanFrom) };
 
-    if (bytes_read == 0) {
-      break; // Timeout occurred on reading 1 byte
+    if (found != RingBuffer::npos && found + eolLen <= size) {
+      lineLen = std::max<size_t>(found + eolLen, 1);
+      break; // EOL found
     }
 
-    if (readSoFar < eolLen) {
-      continue;
+    if (_rxBuffer.Size() >= size || _rxBuffer.Free() == 0) {
+      lineLen = std::min(_rxBuffer.Size(), size);
+      break; // Reached the maximum read length
     }
 
-    if (std::string(reinterpret_cast<const char*> (bufferRead + readSoFar - eolLen), eolLen) == eol) {
-      break; // EOL found
-    }
+    // Don't scan again what has been already checked
+    scanFrom = _rxBuffer.Size() >= eolLen ? _rxBuffer.Size() - eolLen + 1 : 0;
 
-    if (readSoFar == size) {
-      break; // Reached the maximum read length
+    UartResult filled { FillRxBuffer(chunkTimeoutMS) };
+
+    if (filled.Value() == 0) {
+      lineLen = _rxBuffer.Size();
+      failed = filled.HasValue() ? UartResult(0, UartError::Timeout) : filled;
+      break; // Timeout or error occurred
     }
   }
 
-  buffer.append(reinterpret_cast<const char*>(bufferRead), readSoFar);
+  if (timestamp != nullptr) {
+    *timestamp = lineLen > 0 ? RxTimestamp() : 0;
+  }
 
-  return readSoFar;
+  // A line cut by the timeout is returned with the error
+  return UartResult(_rxBuffer.Read(buffer, lineLen), failed.Error(), failed.SystemError());
 }
 //-----------------------------------------------------------------------------
 std::string Uarts::ReadLine(size_t size, std::string eol) {
@@ -340,69 +455,306 @@ std::string Uarts::ReadLine(size_t size, std::string eol) {
 //-----------------------------------------------------------------------------
 std::vector<std::string> Uarts::ReadLines(size_t size, std::string eol) {
   // Lock mutex
-  ScopedReadLock(this);
+  ScopedReadLock lock(this);
 
   // Function Variables
   std::vector<std::string>  lines;
+  const uint8_t *           eolData { reinterpret_cast<const uint8_t*>(eol.data()) };
   size_t                    eolLen { eol.length () };
-  uint8_t       *           buffer { static_cast<uint8_t*>(alloca(size * sizeof(uint8_t))) };
+  int64_t                   chunkTimeoutMS { _timeout.ReadTimeoutConstant };
   size_t                    readSoFar {};
-  size_t                    startOfLine {};
+  size_t                    scanFrom {};
+
+  chunkTimeoutMS += _timeout.ReadTimeoutMultiplier;
 
   while (readSoFar < size) {
-    size_t bytes_read { _Read(buffer + readSoFar, 1) };
-    readSoFar += bytes_read;
-    if (bytes_read == 0) {
-      if (startOfLine != readSoFar) {
-        lines.push_back (std::string(reinterpret_cast<const char*>(buffer + startOfLine), readSoFar - startOfLine));
-      }
+    size_t found { _rxBuffer.Find(eolData, eolLen, scanFrom) };
 
-      break; // Timeout occurred on reading 1 byte
+    if (found != RingBuffer::npos && readSoFar + found + eolLen <= size) {
+      // EOL found
+      lines.emplace_back();
+      readSoFar += _rxBuffer.Read(lines.back(), found + eolLen);
+      scanFrom = 0;
+      continue;
     }
 
-    if (readSoFar < eolLen) {
+    if (readSoFar + _rxBuffer.Size() >= size || _rxBuffer.Free() == 0) {
+      // Reached the maximum read length or a line longer than the receive buffer
+      lines.emplace_back();
+      readSoFar += _rxBuffer.Read(lines.back(), size - readSoFar);
+      scanFrom = 0;
       continue;
     }
 
-    if (std::string (reinterpret_cast<const char*>(buffer + readSoFar - eolLen), eolLen) == eol) {
-      // EOL found
-      lines.push_back (std::string (reinterpret_cast<const char*> (buffer + startOfLine), readSoFar - startOfLine));
-      startOfLine = readSoFar;
-    }
+    // Don't scan again what has been already checked
+    scanFrom = _rxBuffer.Size() >= eolLen ? _rxBuffer.Size() - eolLen + 1 : 0;
+
+    UartResult filled { FillRxBuffer(chunkTimeoutMS) };
 
-    if (readSoFar == size) {
-      if (startOfLine != readSoFar) {
-        lines.push_back (std::string (reinterpret_cast<const char*> (buffer + startOfLine), readSoFar - startOfLine));
+    if (filled.Value() == 0) {
+      if (!_rxBuffer.Empty()) {
+        lines.emplace_back();
+        _rxBuffer.Read(lines.back(), _rxBuffer.Size());
       }
-      break; // Reached the maximum read length
+
+      value_or_throw(filled, "Uarts::ReadLines");
+      break; // Timeout occurred
     }
   }
 
   return lines;
 }
 //-----------------------------------------------------------------------------
+size_t Uarts::Receive(void) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return value_or_throw(FillRxBuffer(0), "Uarts::Receive");
+}
+//-----------------------------------------------------------------------------
+bool Uarts::GetLine(std::string & buffer, size_t size, std::string eol) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _GetLine(buffer, size, eol, nullptr);
+}
+//-----------------------------------------------------------------------------
+bool Uarts::GetLine(std::string & buffer, int64_t & timestamp, size_t size, std::string eol) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _GetLine(buffer, size, eol, &timestamp);
+}
+//-----------------------------------------------------------------------------
+bool Uarts::_GetLine(std::string & buffer, size_t size, const std::string & eol, int64_t * timestamp) {
+  // Function Variables
+  size_t found { _rxBuffer.Find(reinterpret_cast<const uint8_t*>(eol.data()), eol.length()) };
+  size_t lineLen {};
+
+  if (found != RingBuffer::npos && found + eol.length() <= size) {
+    lineLen = found + eol.length();
+  } else if (!_rxBuffer.Empty() && (_rxBuffer.Size() >= size || _rxBuffer.Free() == 0)) {
+    lineLen = size;
+  } else {
+    return false;
+  }
+
+  if (timestamp != nullptr) {
+    *timestamp = RxTimestamp();
+  }
+
+  _rxBuffer.Read(buffer, lineLen);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool Uarts::ReadFrame(Framer & framer) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+
+  // Function Variables
+  UartResult result { _ReadFrame(framer) };
+
+  value_or_throw(result, "Uarts::ReadFrame");
+
+  return result.HasValue();
+}
+//-----------------------------------------------------------------------------
+bool Uarts::GetFrame(Framer & framer) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _GetFrame(framer);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::_ReadFrame(Framer & framer) {
+  // Function Variables
+  int64_t chunkTimeoutMS { _timeout.ReadTimeoutConstant };
+
+  chunkTimeoutMS += _timeout.ReadTimeoutMultiplier;
+
+  while (!_GetFrame(framer)) {
+    UartResult filled { FillRxBuffer(chunkTimeoutMS) };
+
+    if (filled.Value() == 0) {
+      // The partial frame stays in the framer
+      return filled.HasValue() ? UartResult(0, UartError::Timeout) : filled;
+    }
+  }
+
+  return UartResult(framer.GetFrameLength());
+}
+//-----------------------------------------------------------------------------
+bool Uarts::_GetFrame(Framer & framer) {
+  while (!_rxBuffer.Empty()) {
+    // Function Variables
+    size_t          length {};
+    const uint8_t * data { _rxBuffer.ReadRegion(length) };
+
+    _rxBuffer.Consume(framer.Consume(data, length));
+
+    if (framer.IsFrameReady()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::GetData(std::string & buffer, size_t size) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _rxBuffer.Read(buffer, size);
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::GetData(uint8_t * buffer, size_t size, int64_t & timestamp) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+
+  // Function Variables
+  uint64_t position { _rxBuffer.ReadPosition() };
+  size_t   count { std::min(_rxMarksCount, RxTimestampMarks) };
+
+  timestamp = RxTimestamp();
+
+  // Stop before the next chunk, its bytes arrived later
+  for (size_t index = 1; index <= count; index++) {
+    const RxMark & mark { _rxMarks[(_rxMarksCount - index) % RxTimestampMarks] };
+
+    if (mark.position <= position) {
+      break;
+    }
+    size = std::min<size_t>(size, mark.position - position);
+  }
+
+  return _rxBuffer.Read(buffer, size);
+}
+//-----------------------------------------------------------------------------
 size_t Uarts::Write(const std::string &data) {
   // Lock mutex
-  ScopedWriteLock(this);
-  return _Write(reinterpret_cast<const uint8_t*> (data.c_str ()), data.length ());
+  ScopedWriteLock lock(this);
+  return value_or_throw(_Write(reinterpret_cast<const uint8_t*> (data.c_str ()), data.length ()), "Uarts::Write");
 }
 //-----------------------------------------------------------------------------
 size_t Uarts::Write (const std::vector<uint8_t> & data) {
   // Lock mutex
-  ScopedWriteLock(this);
-  return _Write(&data[0], data.size ());
+  ScopedWriteLock lock(this);
+  return value_or_throw(_Write(&data[0], data.size ()), "Uarts::Write");
 }
 //-----------------------------------------------------------------------------
 size_t Uarts::Write (const uint8_t * data, size_t size) {
   // Lock mutex
-  ScopedWriteLock(this);
+  ScopedWriteLock lock(this);
+  return value_or_throw(_Write(data, size), "Uarts::Write");
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::Write (const struct iovec * iov, size_t count) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return value_or_throw(_Writev(iov, count), "Uarts::Write");
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::Send(const uint8_t * data, size_t size) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return value_or_throw(_Send(data, size), "Uarts::Send");
+}
+//-----------------------------------------------------------------------------
+void Uarts::SetTransmitQueue(size_t capacity) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+
+  if (capacity > 0) {
+    _txBuffer.reset(new RingBuffer(capacity));
+  } else {
+    _txBuffer.reset();
+  }
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::GetTransmitQueue(void) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return _txBuffer ? _txBuffer->Capacity() : 0;
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::GetTransmitPending(void) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return _txBuffer ? _txBuffer->Size() : 0;
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::GetTransmitFree(void) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return _txBuffer ? _txBuffer->Free() : 0;
+}
+//-----------------------------------------------------------------------------
+size_t Uarts::Transmit(void) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return value_or_throw(_Transmit(), "Uarts::Transmit");
+}
+//-----------------------------------------------------------------------------
+void Uarts::SetTransmitNotify(std::function<void(void)> notify) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  _txNotify = std::move(notify);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryRead(uint8_t * buffer, size_t size) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _Read(buffer, size);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryRead(uint8_t * buffer, size_t size, int64_t & timestamp) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _Read(buffer, size, &timestamp);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryReadLine(std::string & buffer, size_t size, std::string eol) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _ReadLine(buffer, size, eol, nullptr);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryReadFrame(Framer & framer) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return _ReadFrame(framer);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryReceive(void) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+  return FillRxBuffer(0);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryWrite(const uint8_t * data, size_t size) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
   return _Write(data, size);
 }
 //-----------------------------------------------------------------------------
+UartResult Uarts::TryWrite(const struct iovec * iov, size_t count) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return _Writev(iov, count);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TrySend(const uint8_t * data, size_t size) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return _Send(data, size);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TryTransmit(void) {
+  // Lock mutex
+  ScopedWriteLock lock(this);
+  return _Transmit();
+}
+//-----------------------------------------------------------------------------
 void Uarts::SetPort (const std::string & port) {
   // Lock mutex
-  ScopedReadLock(this);
-  ScopedWriteLock(this);
+  ScopedReadLock  readLock(this);
+  ScopedWriteLock writeLock(this);
 
   // Function Variables
   bool was_open { _is_open };
@@ -421,6 +773,10 @@ std::string Uarts::GetPort(void) const {
   return _port;
 }
 //-----------------------------------------------------------------------------
+int32_t Uarts::GetDescriptor(void) const {
+  return _fd;
+}
+//-----------------------------------------------------------------------------
 void Uarts::SetTimeout(Timeout & timeout) {
   _timeout = timeout;
 }
@@ -494,6 +850,58 @@ FlowControl Uarts::GetFlowcontrol(void) const {
   return _flowcontrol;
 }
 //-----------------------------------------------------------------------------
+void Uarts::SetLowLatency(bool enable) {
+  _lowLatency = enable;
+
+  // Check if is open
+  if (_is_open) {
+    ConfigureLowLatency();
+  }
+}
+//-----------------------------------------------------------------------------
+bool Uarts::GetLowLatency(void) const {
+  return _lowLatency;
+}
+//-----------------------------------------------------------------------------
+void Uarts::SetTimestamping(bool enable) {
+  // Lock mutex
+  ScopedReadLock lock(this);
+
+  // Marks left by a previous session would stamp data received while disabled
+  _rxMarksCount = 0;
+  _timestamping = enable;
+}
+//-----------------------------------------------------------------------------
+bool Uarts::GetTimestamping(void) const {
+  return _timestamping;
+}
+//-----------------------------------------------------------------------------
+UartStatistics Uarts::GetStatistics(void) const {
+  // Function Variables
+  UartStatistics statistics;
+
+  _counters.Snapshot(statistics);
+
+#if defined(__linux__) && defined(TIOCGICOUNT)
+  struct serial_icounter_struct icount {};
+
+  // Pseudo terminals and some usb adapters don't count the line errors, leave them to zero
+  if (_is_open && ioctl(_fd, TIOCGICOUNT, &icount) == 0) {
+    statistics.Overruns = static_cast<uint32_t>(icount.overrun);
+    statistics.BufferOverruns = static_cast<uint32_t>(icount.buf_overrun);
+    statistics.FramingErrors = static_cast<uint32_t>(icount.frame);
+    statistics.ParityErrors = static_cast<uint32_t>(icount.parity);
+    statistics.Breaks = static_cast<uint32_t>(icount.brk);
+  }
+#endif
+
+  return statistics;
+}
+//-----------------------------------------------------------------------------
+void Uarts::ResetStatistics(void) {
+  _counters.Reset();
+}
+//-----------------------------------------------------------------------------
 void Uarts::Flush(void) {
   // If the port is not open, throw
   if (!_is_open) {
@@ -515,6 +923,7 @@ void Uarts::FlushInput(void) {
 
   ReadLock();
   tcflush(_fd, TCIFLUSH);
+  _rxBuffer.Clear();
   ReadUnlock();
 }
 //-----------------------------------------------------------------------------
@@ -526,6 +935,9 @@ void Uarts::FlushOutput(void) {
 
   WriteLock();
   tcflush(_fd, TCOFLUSH);
+  if (_txBuffer) {
+    _txBuffer->Clear();
+  }
   WriteUnlock();
 }
 //-----------------------------------------------------------------------------
@@ -976,7 +1388,9 @@ void Uarts::ReconfigurePort(void) {
   // http://www.unixwiz.net/techtips/termios-vmin-vtime.html
   // this basically sets the read call up to be a polling read,
   // but we are using select to ensure there is data available
-  // to read before each call, so we should never needlessly poll
+  // to read before each call, so we should never needlessly poll.
+  // It is also what the low latency mode needs: read returns
+  // immediately with whatever the tty layer holds.
   options.c_cc[VMIN] = 0;
   options.c_cc[VTIME] = 0;
 
@@ -1007,45 +1421,91 @@ void Uarts::ReconfigurePort(void) {
 #endif
   }
 
+  // Apply the driver latency setting
+  ConfigureLowLatency();
+
   // Update byte_time_ based on the new settings.
-  uint32_t bit_time_ns = 1e9 / _baudrate;
+  uint32_t bit_time_ns = static_cast<uint32_t>(NanosecondsPerSecond / _baudrate);
   _byteTime_ns = bit_time_ns * (1 + (uint32_t)_bytesize + (uint32_t)_parity + (uint32_t)_stopbits);
 
   // Compensate for the stopbits_one_point_five enum being equal to int 3,
   // and not 1.5.
   if (_stopbits == StopBits::OnePointFive) {
-    _byteTime_ns += ((1.5 - (uint32_t)StopBits::OnePointFive) * bit_time_ns);
+    _byteTime_ns -= (3 * bit_time_ns) / 2;
   }
 }
 //-----------------------------------------------------------------------------
-size_t Uarts::_Write (const uint8_t * data, size_t length) {
-  // If the port is not open, throw
+void Uarts::ConfigureLowLatency(void) {
+#if defined(__linux__) && defined (TIOCSSERIAL) && defined (ASYNC_LOW_LATENCY)
+  struct serial_struct ser;
+
+  // Not every driver (e.g. pseudo terminals, usb adapters) supports it, so it's a best effort request
+  if (ioctl(_fd, TIOCGSERIAL, &ser) == -1) {
+    return;
+  }
+
+  // Nothing to change
+  if (((ser.flags & ASYNC_LOW_LATENCY) != 0) == _lowLatency) {
+    return;
+  }
+
+  if (_lowLatency) {
+    ser.flags |= ASYNC_LOW_LATENCY;
+  } else {
+    ser.flags &= ~ASYNC_LOW_LATENCY;
+  }
+
+  ioctl(_fd, TIOCSSERIAL, &ser);
+#endif
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::_Write (const uint8_t * data, size_t length) {
+  // Function Variables
+  struct iovec iov { const_cast<uint8_t*>(data), length };
+
+  return _Writev(&iov, 1);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::_Writev (const struct iovec * iov, size_t count) {
+  // If the port is not open, fail
   if (!_is_open) {
-    throw PortNotOpenedException ("Uarts::Write");
+    return UartResult(0, UartError::NotOpen);
+  }
+
+  // Queued transmit mode, never waits
+  if (_txBuffer) {
+    return QueueWritev(iov, count);
   }
 
   // Function Variables
-  fd_set  writefds;
-  size_t  bytesWritten {};
-  bool    firstIteration { true };
+  ScopedDuration duration(_counters, &UartCounters::WriteTime);
+  fd_set        writefds;
+  size_t        length {};
+  size_t        bytesWritten {};
+  bool          firstIteration { true };
+  size_t        index {};                                 // First buffer not completely written
+  size_t        offset {};                                // Bytes of iov[index] already written
+  struct iovec  window[MaxWriteBuffers];                  // Buffers left, passed to writev
+
+  for (size_t i = 0; i < count; i++) {
+    length += iov[i].iov_len;
+  }
 
   // Calculate total timeout in milliseconds t_c + (t_m * N)
   int64_t totalTimeoutMS { _timeout.WriteTimeoutConstant };
   totalTimeoutMS += _timeout.WriteTimeoutMultiplier * static_cast<int64_t>(length);
-  MillisecondTimer totalTimeout(totalTimeoutMS);
+  Deadline totalTimeout(Deadline::FromMilliseconds(totalTimeoutMS, Clock::Monotonic()));
 
   // Loop all bytes length
   while (bytesWritten < length) {
-    int64_t timeoutRemainingMS { totalTimeout.Remaining() };
-
     // Only consider the timeout if it's not the first iteration of the loop
     // otherwise a timeout of 0 won't be allowed through
-    if (!firstIteration && (timeoutRemainingMS <= 0)) {
+    if (!firstIteration && totalTimeout.Expired()) {
       break; // Timed out
     }
     firstIteration = false;
 
-    timespec timeout(timespec_from_ms(timeoutRemainingMS));
+    timespec timeout(totalTimeout.RemainingTimespec());
 
     FD_ZERO (&writefds);
     FD_SET (_fd, &writefds);
@@ -1060,7 +1520,7 @@ size_t Uarts::_Write (const uint8_t * data, size_t length) {
         continue;
       }
       // Otherwise there was some error
-      THROW (IOException, errno);
+      return Fail(UartError::System, bytesWritten, errno);
     }
 
     if (r == 0) { // Timeout
@@ -1071,8 +1531,22 @@ size_t Uarts::_Write (const uint8_t * data, size_t length) {
     if (r > 0) {
       // Make sure our file descriptor is in the ready to write list
       if (FD_ISSET (_fd, &writefds)) {
+        // Skip the buffers already written (and the empty ones)
+        while (index < count && offset == iov[index].iov_len) {
+          index++;
+          offset = 0;
+        }
+
+        // Build the list of the buffers left
+        int32_t windowCount {};
+        for (size_t i = index; i < count && windowCount < MaxWriteBuffers; i++, windowCount++) {
+          window[windowCount] = iov[i];
+        }
+        window[0].iov_base = static_cast<uint8_t*>(window[0].iov_base) + offset;
+        window[0].iov_len -= offset;
+
         // This will write some
-        ssize_t bytesWrittenNow = ::write (_fd, data + bytesWritten, length - bytesWritten);
+        ssize_t bytesWrittenNow = ::writev (_fd, window, windowCount);
 
         // even though pselect returned readiness the call might still be
         // interrupted. In that case simply retry.
@@ -1086,65 +1560,189 @@ size_t Uarts::_Write (const uint8_t * data, size_t length) {
           // Disconnected devices, at least on Linux, show the
           // behavior that they are always ready to write immediately
           // but writing returns nothing.
-          std::stringstream strs;
-          strs << "device reports readiness to write but returned no data (device disconnected?)";
-          strs << " errno =" << errno;
-          strs << " bytesWrittenNow = " << bytesWrittenNow;
-          strs << " bytesWritten =" << bytesWritten;
-          strs << " length =" << length;
-          throw UartException(strs.str().c_str());
+          return Fail(bytesWrittenNow == 0 || errno == EIO ? UartError::Disconnected : UartError::System,
+                      bytesWritten, errno);
         }
 
         // Update bytes_written
         bytesWritten += static_cast<size_t>(bytesWrittenNow);
-
-        // If bytes_written == size then we have written everything we need to
-        if (bytesWritten == length) {
-          break;
-        }
-
-        // If bytes_written < size then we have more to write
-        if (bytesWritten < length) {
-          continue;
+        _counters.BytesWritten(static_cast<size_t>(bytesWrittenNow));
+
+        // Move the position over the buffers that have been written
+        size_t advance { static_cast<size_t>(bytesWrittenNow) };
+        while (advance > 0 && index < count) {
+          size_t left { iov[index].iov_len - offset };
+          if (advance < left) {
+            offset += advance;
+            break;
+          }
+          advance -= left;
+          index++;
+          offset = 0;
         }
 
-        // If bytes_written > size then we have over written, which shouldn't happen
-        if (bytesWritten > length) {
-          throw UartException ("write over wrote, too many bytes where written, this shouldn't happen, might be a logical error!");
-        }
+        // Written everything or more to write
+        continue;
       }
+    }
+  }
+
+  if (bytesWritten < length) {
+    _counters.WriteTimeout();
+    return UartResult(bytesWritten, UartError::Timeout);
+  }
+
+  return UartResult(bytesWritten);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::QueueWritev(const struct iovec * iov, size_t count) {
+  // Function Variables
+  size_t  length {};
+  bool    wasEmpty { _txBuffer->Empty() };
+
+  for (size_t i = 0; i < count; i++) {
+    length += iov[i].iov_len;
+  }
+
+  // All or nothing, a frame is never split between two writes
+  if (length > _txBuffer->Free()) {
+    _counters.TransmitRefused();
+    return UartResult(0, UartError::Busy);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    _txBuffer->Write(static_cast<const uint8_t*>(iov[i].iov_base), iov[i].iov_len);
+  }
+
+  // Start right away, most of the times a short frame fits the kernel buffer
+  UartResult pending { TransmitQueue() };
+
+  if (!pending) {
+    return UartResult(length, pending.Error(), pending.SystemError());
+  }
+
+  if (wasEmpty && pending.Value() > 0 && _txNotify) {
+    _txNotify();
+  }
+
+  return UartResult(length);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::TransmitQueue(void) {
+  while (!_txBuffer->Empty()) {
+    // Function Variables
+    size_t          length {};
+    const uint8_t * data { _txBuffer->ReadRegion(length) };
+    ssize_t         bytesWritten { ::write(_fd, data, length) };
+
+    if (bytesWritten > 0) {
+      _txBuffer->Consume(static_cast<size_t>(bytesWritten));
+      _counters.BytesWritten(static_cast<size_t>(bytesWritten));
+      continue;
+    }
 
-      // This shouldn't happen, if r > 0 our fd has to be in the list!
-      THROW (IOException, "select reports ready to write, but our fd isn't in the list, this shouldn't happen!");
+    // Interrupted, try again
+    if (bytesWritten < 0 && errno == EINTR) {
+      continue;
+    }
+    // Kernel buffer full, wait for the port to be writable
+    if (bytesWritten == 0 || errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
     }
+    return Fail(UartError::System, _txBuffer->Size(), errno);
   }
-  return bytesWritten;
+
+  return UartResult(_txBuffer->Size());
 }
 //-----------------------------------------------------------------------------
-size_t Uarts::_Read (uint8_t * buffer, size_t size) {
-  // If the port is not open, throw
+UartResult Uarts::_Transmit(void) {
+  // If the port is not open, fail
+  if (!_is_open) {
+    return UartResult(0, UartError::NotOpen);
+  }
+
+  return _txBuffer ? TransmitQueue() : UartResult(0);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::_Send(const uint8_t * data, size_t size) {
+  // If the port is not open, fail
+  if (!_is_open) {
+    return UartResult(0, UartError::NotOpen);
+  }
+
+  // What is queued goes first, keep the order of the bytes
+  if (_txBuffer) {
+    UartResult pending { TransmitQueue() };
+
+    if (!pending || pending.Value() > 0) {
+      return UartResult(0, pending.Error(), pending.SystemError());
+    }
+  }
+
+  while (size > 0) {
+    ssize_t bytesWritten { ::write(_fd, data, size) };
+
+    if (bytesWritten >= 0) {
+      _counters.BytesWritten(static_cast<size_t>(bytesWritten));
+      return UartResult(static_cast<size_t>(bytesWritten));
+    }
+
+    // Interrupted, try again
+    if (errno == EINTR) {
+      continue;
+    }
+    // Kernel buffer full
+    if (errno == EAGAIN || errno == EWOULDBLOCK) {
+      break;
+    }
+    return Fail(UartError::System, 0, errno);
+  }
+
+  return UartResult(0);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::Fail(UartError error, size_t value, int32_t systemError) {
+  _counters.Error();
+  return UartResult(value, error, systemError);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::_Read (uint8_t * buffer, size_t size, int64_t * timestamp) {
+  // If the port is not open, fail
   if (!_is_open) {
-    throw PortNotOpenedException ("Uarts::read");
+    return UartResult(0, UartError::NotOpen);
   }
 
   // Function Variables
+  ScopedDuration duration(_counters, &UartCounters::ReadTime);
   size_t bytesRead = 0;
 
   // Calculate total timeout in milliseconds t_c + (t_m * N)
   int64_t totalTimeoutMS = _timeout.ReadTimeoutConstant;
   totalTimeoutMS += _timeout.ReadTimeoutMultiplier * static_cast<int64_t>(size);
-  MillisecondTimer totalTimeout(totalTimeoutMS);
+  Deadline totalTimeout(Deadline::FromMilliseconds(totalTimeoutMS, Clock::Monotonic()));
+
+  // Data left in the receive buffer by a line read comes first
+  if (timestamp != nullptr) {
+    *timestamp = _rxBuffer.Empty() ? 0 : RxTimestamp();
+  }
+  bytesRead = _rxBuffer.Read(buffer, size);
+  if (bytesRead == size) {
+    return UartResult(bytesRead);
+  }
 
   // Pre-fill buffer with available bytes
-  ssize_t bytesReadNow = ::read(_fd, buffer, size);
+  ssize_t bytesReadNow = ::read(_fd, buffer + bytesRead, size - bytesRead);
   if (bytesReadNow > 0) {
-    bytesRead = bytesReadNow;
+    if (timestamp != nullptr && bytesRead == 0 && _timestamping) {
+      *timestamp = Clock::Default().Now();
+    }
+    bytesRead += bytesReadNow;
+    _counters.BytesRead(static_cast<size_t>(bytesReadNow));
   }
 
   // Loop all bytes size
   while (bytesRead < size) {
-    int64_t timeoutRemainingMS = totalTimeout.Remaining();
-    if (timeoutRemainingMS <= 0) {
+    if (totalTimeout.Expired()) {
       // Timed out
       break;
     }
@@ -1153,50 +1751,171 @@ size_t Uarts::_Read (uint8_t * buffer, size_t size) {
     //uint32_t timeout = std::min(static_cast<uint32_t>(timeoutRemainingMS), _timeout.InterByteTimeout);
 
     // Wait for the device to be readable, and then attempt to read.
-    if (WaitReadable()) {
+    UartResult readable { PollReadable(_timeout.ReadTimeoutConstant) };
+
+    if (readable.Error() == UartError::System) {
+      return UartResult(bytesRead, readable.Error(), readable.SystemError());
+    }
+
+    if (readable.Value() > 0) {
       // If it's a fixed-length multi-byte read, insert a wait here so that
       // we can attempt to grab the whole thing in a single IO call. Skip
-      // this wait if a non-max inter_byte_timeout is specified.
-      if (size > 1 && _timeout.InterByteTimeout == Timeout::Max()) {
-        size_t bytesAvailable = Available();
-        if (bytesAvailable + bytesRead < size) {
-          WaitByteTimes(size - (bytesAvailable + bytesRead));
+      // this wait if a non-max inter_byte_timeout is specified or in low
+      // latency mode.
+      if (size > 1 && _timeout.InterByteTimeout == Timeout::Max() && !_lowLatency) {
+        int32_t bytesAvailable {};
+        if (ioctl(_fd, TIOCINQ, &bytesAvailable) == 0 && static_cast<size_t>(bytesAvailable) + bytesRead < size) {
+          WaitByteTimes(size - (static_cast<size_t>(bytesAvailable) + bytesRead));
         }
       }
       // This should be non-blocking returning only what is available now
       //  Then returning so that select can block again.
       ssize_t bytesReadNow = ::read (_fd, buffer + bytesRead, size - bytesRead);
 
+      // Interrupted, wait again
+      if (bytesReadNow < 0 && errno == EINTR) {
+        continue;
+      }
+
       // read should always return some data as select reported it was
       // ready to read when we get to this point.
       if (bytesReadNow < 1) {
         // Disconnected devices, at least on Linux, show the
         // behavior that they are always ready to read immediately
         // but reading returns nothing.
-        throw UartException ("device reports readiness to read but returned no data (device disconnected?)");
+        return Fail(bytesReadNow == 0 || errno == EIO ? UartError::Disconnected : UartError::System, bytesRead, errno);
+      }
+
+      // First bytes of this read, stamp their arrival
+      if (timestamp != nullptr && bytesRead == 0 && _timestamping) {
+        *timestamp = Clock::Default().Now();
       }
 
       // Update bytes_read
       bytesRead += static_cast<size_t>(bytesReadNow);
+      _counters.BytesRead(static_cast<size_t>(bytesReadNow));
 
-      // If bytes_read == size then we have read everything we need
-      if (bytesRead == size) {
-        break;
-      }
+      // Read everything or more to read
+      continue;
+    }
+  }
+
+  if (bytesRead < size) {
+    _counters.ReadTimeout();
+    return UartResult(bytesRead, UartError::Timeout);
+  }
 
-      // If bytes_read < size then we have more to read
-      if (bytesRead < size) {
+  return UartResult(bytesRead);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::FillRxBuffer(int64_t timeoutMS) {
+  // If the port is not open, fail
+  if (!_is_open) {
+    return UartResult(0, UartError::NotOpen);
+  }
+
+  // Function Variables
+  ScopedDuration duration(_counters, &UartCounters::ReadTime);
+
+  // Take whatever is already queued in the kernel
+  UartResult bytesRead { ReadIntoRxBuffer() };
+
+  if (bytesRead.Value() > 0 || !bytesRead || timeoutMS <= 0 || _rxBuffer.Free() == 0) {
+    return bytesRead;
+  }
+
+  // Function Variables
+  Deadline totalTimeout(Deadline::FromMilliseconds(timeoutMS, Clock::Monotonic()));
+
+  while (!totalTimeout.Expired()) {
+    // Wait for the device to be readable, select could be interrupted
+    UartResult readable { PollReadable(static_cast<uint32_t>(totalTimeout.RemainingMS())) };
+
+    if (readable.Error() == UartError::System) {
+      return readable;
+    }
+
+    if (readable.Value() == 0) {
+      continue;
+    }
+
+    // read should always return some data as select reported it was
+    // ready to read when we get to this point.
+    if ((bytesRead = ReadIntoRxBuffer()).Value() == 0) {
+      // Disconnected devices, at least on Linux, show the
+      // behavior that they are always ready to read immediately
+      // but reading returns nothing.
+      return bytesRead ? Fail(UartError::Disconnected) : bytesRead;
+    }
+
+    return bytesRead;
+  }
+
+  _counters.ReadTimeout();
+
+  return UartResult(0, UartError::Timeout);
+}
+//-----------------------------------------------------------------------------
+UartResult Uarts::ReadIntoRxBuffer(void) {
+  // Function Variables
+  size_t bytesRead {};
+
+  // One read per contiguous free region, two at most when the buffer wraps
+  while (_rxBuffer.Free() > 0) {
+    size_t    regionLength {};
+    uint8_t * region { _rxBuffer.WriteRegion(regionLength) };
+    ssize_t   bytesReadNow { ::read(_fd, region, regionLength) };
+
+    if (bytesReadNow < 0) {
+      // Interrupted, try again
+      if (errno == EINTR) {
         continue;
       }
-
-      // If bytes_read > size then we have over read, which shouldn't happen
-      if (bytesRead > size) {
-        throw UartException ("read over read, too many bytes where read, this shouldn't happen, might be a logical error!");
+      // Nothing more to read
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        break;
       }
+      return Fail(errno == EIO ? UartError::Disconnected : UartError::System, bytesRead, errno);
+    }
+
+    // Stamp the chunk as soon as it has been read
+    if (_timestamping && bytesReadNow > 0) {
+      _rxMarks[_rxMarksCount++ % RxTimestampMarks] = RxMark { _rxBuffer.WritePosition(), Clock::Default().Now() };
+    }
+
+    _rxBuffer.Commit(static_cast<size_t>(bytesReadNow));
+    _counters.BytesRead(static_cast<size_t>(bytesReadNow));
+    bytesRead += static_cast<size_t>(bytesReadNow);
+
+    // The kernel buffer has been drained
+    if (static_cast<size_t>(bytesReadNow) < regionLength) {
+      break;
     }
   }
 
-  return bytesRead;
+  return UartResult(bytesRead);
+}
+//-----------------------------------------------------------------------------
+int64_t Uarts::RxTimestamp(void) const {
+  // Function Variables
+  uint64_t position { _rxBuffer.ReadPosition() };
+  size_t   count { std::min(_rxMarksCount, RxTimestampMarks) };
+
+  if (!_timestamping || count == 0) {
+    return 0;
+  }
+
+  // The newest chunk starting at or before the first byte contains it
+  for (size_t index = 1; index <= count; index++) {
+    const RxMark & mark { _rxMarks[(_rxMarksCount - index) % RxTimestampMarks] };
+
+    if (mark.position <= position) {
+      return mark.timestamp;
+    }
+  }
+
+  // Its chunk has been forgotten, the oldest known is the closest
+  return _rxMarks[(_rxMarksCount - count) % RxTimestampMarks].timestamp;
 }
 //-----------------------------------------------------------------------------
 
@@ -0,0 +1,357 @@
+/*
+ * framer.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <cstring>
+#include <algorithm>
+#include <drivers/uarts/framer.hpp>
+
+namespace Airsoft::Drivers {
+
+// SLIP special characters
+constexpr uint8_t SlipEnd = 0xC0;
+constexpr uint8_t SlipEsc = 0xDB;
+constexpr uint8_t SlipEscEnd = 0xDC;
+constexpr uint8_t SlipEscEsc = 0xDD;
+
+//-----------------------------------------------------------------------------
+Framer::Framer(FrameEncoding encoding, size_t maxFrame) : _encoding(encoding), _maxFrame(maxFrame) {
+  // The length prefix can't describe a longer frame
+  if (_encoding == FrameEncoding::Length8) {
+    _maxFrame = std::min<size_t>(_maxFrame, UINT8_MAX);
+  } else if (_encoding == FrameEncoding::Length16) {
+    _maxFrame = std::min<size_t>(_maxFrame, UINT16_MAX);
+  }
+
+  _frame = new uint8_t[_maxFrame > 0 ? _maxFrame : 1];
+}
+//-----------------------------------------------------------------------------
+Framer::~Framer() {
+  delete[] _frame;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+size_t Framer::Consume(const uint8_t * data, size_t length) {
+  // Release the frame returned by the previous call
+  if (_ready) {
+    _ready = false;
+    _length = 0;
+  }
+
+  switch (_encoding) {
+    case FrameEncoding::Length8:
+    case FrameEncoding::Length16:
+      return ConsumeLength(data, length);
+    case FrameEncoding::Cobs:
+      return ConsumeCobs(data, length);
+    case FrameEncoding::Slip:
+      return ConsumeSlip(data, length);
+  }
+
+  return length;
+}
+//-----------------------------------------------------------------------------
+void Framer::Reset(void) {
+  _ready = false;
+  Restart();
+}
+//-----------------------------------------------------------------------------
+size_t Framer::MaxEncodedSize(FrameEncoding encoding, size_t length) {
+  switch (encoding) {
+    case FrameEncoding::Length8:
+      return length + 1;
+    case FrameEncoding::Length16:
+      return length + 2;
+    case FrameEncoding::Cobs:
+      // A code byte every 254 bytes, the first code and the delimiter
+      return length + length / 254 + 2;
+    case FrameEncoding::Slip:
+      // Every byte escaped, a leading and a trailing END
+      return 2 * length + 2;
+  }
+
+  return 0;
+}
+//-----------------------------------------------------------------------------
+size_t Framer::Encode(FrameEncoding encoding, const uint8_t * payload, size_t length, uint8_t * output, size_t size) {
+  // Function Variables
+  size_t out {};
+
+  if (size < MaxEncodedSize(encoding, length)) {
+    return 0;
+  }
+
+  switch (encoding) {
+    case FrameEncoding::Length8:
+      if (length > UINT8_MAX) {
+        return 0;
+      }
+      output[out++] = static_cast<uint8_t>(length);
+      if (length > 0) {
+        memcpy(output + out, payload, length);
+      }
+      return out + length;
+
+    case FrameEncoding::Length16:
+      if (length > UINT16_MAX) {
+        return 0;
+      }
+      output[out++] = static_cast<uint8_t>(length >> 8);
+      output[out++] = static_cast<uint8_t>(length);
+      if (length > 0) {
+        memcpy(output + out, payload, length);
+      }
+      return out + length;
+
+    case FrameEncoding::Cobs: {
+      // Function Variables
+      size_t  codeIndex {};
+      uint8_t code { 1 };
+
+      out = 1;
+
+      for (size_t index = 0; index < length; index++) {
+        if (payload[index] == 0) {
+          output[codeIndex] = code;
+          codeIndex = out++;
+          code = 1;
+          continue;
+        }
+
+        output[out++] = payload[index];
+
+        // Block of 254 bytes without zeros
+        if (++code == 0xFF) {
+          output[codeIndex] = code;
+          codeIndex = out++;
+          code = 1;
+        }
+      }
+
+      output[codeIndex] = code;
+      output[out++] = 0;
+      return out;
+    }
+
+    case FrameEncoding::Slip:
+      // Leading END flushes the noise received by the other side
+      output[out++] = SlipEnd;
+
+      for (size_t index = 0; index < length; index++) {
+        if (payload[index] == SlipEnd) {
+          output[out++] = SlipEsc;
+          output[out++] = SlipEscEnd;
+        } else if (payload[index] == SlipEsc) {
+          output[out++] = SlipEsc;
+          output[out++] = SlipEscEsc;
+        } else {
+          output[out++] = payload[index];
+        }
+      }
+
+      output[out++] = SlipEnd;
+      return out;
+  }
+
+  return 0;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+size_t Framer::ConsumeLength(const uint8_t * data, size_t length) {
+  // Function Variables
+  size_t  used {};
+  uint8_t headerSize { static_cast<uint8_t>(_encoding == FrameEncoding::Length8 ? 1 : 2) };
+
+  while (used < length) {
+    switch (_state) {
+      case State::Start:
+      case State::Header:
+        _expected = (_header == 0 ? 0 : _expected << 8) | data[used++];
+        _state = State::Header;
+
+        if (++_header < headerSize) {
+          break;
+        }
+        _header = 0;
+
+        if (_expected == 0) {
+          _state = State::Start;      // Empty frame
+        } else if (_expected > _maxFrame) {
+          _overflows++;
+          _state = State::Discard;    // The payload is skipped, _length counts it
+        } else {
+          _state = State::Payload;
+        }
+        break;
+
+      case State::Payload: {
+        // Function Variables
+        size_t count { std::min(_expected - _length, length - used) };
+
+        memcpy(_frame + _length, data + used, count);
+        _length += count;
+        used += count;
+
+        if (_length == _expected) {
+          Complete();
+          return used;
+        }
+        break;
+      }
+
+      default: {
+        // Function Variables
+        size_t count { std::min(_expected - _length, length - used) };
+
+        _length += count;
+        used += count;
+
+        if (_length == _expected) {
+          Restart();
+        }
+        break;
+      }
+    }
+  }
+
+  return used;
+}
+//-----------------------------------------------------------------------------
+size_t Framer::ConsumeCobs(const uint8_t * data, size_t length) {
+  // Function Variables
+  size_t used {};
+
+  while (used < length) {
+    uint8_t byte { data[used++] };
+
+    // Delimiter, the frame ends whatever the state
+    if (byte == 0) {
+      if (_state == State::Payload) {
+        if (_left != 0) {
+          _errors++;                  // Truncated block
+        } else if (_length > 0) {
+          Complete();
+          return used;
+        }
+      }
+
+      Restart();
+      continue;
+    }
+
+    if (_state == State::Discard) {
+      continue;
+    }
+
+    if (_left == 0) {
+      // Code byte, the previous block (unless a full one) ended with a zero
+      if (_code != 0 && _code != 0xFF && !Append(0)) {
+        continue;
+      }
+
+      _code = byte;
+      _left = byte - 1;
+      _state = State::Payload;
+    } else if (Append(byte)) {
+      _left--;
+    }
+  }
+
+  return used;
+}
+//-----------------------------------------------------------------------------
+size_t Framer::ConsumeSlip(const uint8_t * data, size_t length) {
+  // Function Variables
+  size_t used {};
+
+  while (used < length) {
+    uint8_t byte { data[used++] };
+
+    if (byte == SlipEnd) {
+      if (_state == State::Payload && _length > 0) {
+        Complete();
+        return used;
+      }
+
+      // END right after ESC
+      if (_state == State::Escape) {
+        _errors++;
+      }
+
+      Restart();
+      continue;
+    }
+
+    switch (_state) {
+      case State::Discard:
+        break;
+
+      case State::Escape:
+        if (byte == SlipEscEnd) {
+          byte = SlipEnd;
+        } else if (byte == SlipEscEsc) {
+          byte = SlipEsc;
+        } else {
+          _errors++;
+          _state = State::Discard;
+          break;
+        }
+
+        _state = State::Payload;
+        Append(byte);
+        break;
+
+      default:
+        if (byte == SlipEsc) {
+          _state = State::Escape;
+          break;
+        }
+
+        _state = State::Payload;
+        Append(byte);
+        break;
+    }
+  }
+
+  return used;
+}
+//-----------------------------------------------------------------------------
+bool Framer::Append(uint8_t byte) {
+  if (_length == _maxFrame) {
+    _overflows++;
+    _state = State::Discard;
+    return false;
+  }
+
+  _frame[_length++] = byte;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void Framer::Restart(void) {
+  _state = State::Start;
+  _length = 0;
+  _expected = 0;
+  _header = 0;
+  _code = 0;
+  _left = 0;
+}
+//-----------------------------------------------------------------------------
+void Framer::Complete(void) {
+  _ready = true;
+  _frames++;
+
+  // The payload stays in _frame until the next Consume
+  _state = State::Start;
+  _expected = 0;
+  _header = 0;
+  _code = 0;
+  _left = 0;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft::Drivers
@@ -0,0 +1,165 @@
+/*
+ * ring-buffer.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <cstring>
+#include <algorithm>
+#include <drivers/uarts/ring-buffer.hpp>
+
+namespace Airsoft::Drivers {
+
+//-----------------------------------------------------------------------------
+RingBuffer::RingBuffer(size_t capacity) {
+  // Round up to a power of two
+  _capacity = 1;
+  while (_capacity < capacity) {
+    _capacity <<= 1;
+  }
+
+  _mask = _capacity - 1;
+  _data = new uint8_t[_capacity];
+}
+//-----------------------------------------------------------------------------
+RingBuffer::~RingBuffer() {
+  delete[] _data;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void RingBuffer::Clear(void) {
+  _tail = _head;
+}
+//-----------------------------------------------------------------------------
+uint8_t * RingBuffer::WriteRegion(size_t & length) {
+  // Function Variables
+  size_t start { static_cast<size_t>(_head) & _mask };
+
+  length = std::min(Free(), _capacity - start);
+
+  return _data + start;
+}
+//-----------------------------------------------------------------------------
+void RingBuffer::Commit(size_t length) {
+  _head += std::min(length, Free());
+}
+//-----------------------------------------------------------------------------
+const uint8_t * RingBuffer::ReadRegion(size_t & length) const {
+  // Function Variables
+  size_t start { static_cast<size_t>(_tail) & _mask };
+
+  length = std::min(Size(), _capacity - start);
+
+  return _data + start;
+}
+//-----------------------------------------------------------------------------
+void RingBuffer::Consume(size_t length) {
+  _tail += std::min(length, Size());
+}
+//-----------------------------------------------------------------------------
+size_t RingBuffer::Write(const uint8_t * data, size_t length) {
+  // Function Variables
+  size_t written {};
+
+  // At most two regions, before and after the wrap
+  while (written < length) {
+    size_t    regionLength {};
+    uint8_t * region { WriteRegion(regionLength) };
+
+    if (regionLength == 0) {
+      break; // Buffer full
+    }
+
+    regionLength = std::min(regionLength, length - written);
+    memcpy(region, data + written, regionLength);
+    Commit(regionLength);
+    written += regionLength;
+  }
+
+  return written;
+}
+//-----------------------------------------------------------------------------
+size_t RingBuffer::Peek(uint8_t * data, size_t length, size_t offset) const {
+  // Check offset
+  if (offset >= Size()) {
+    return 0;
+  }
+
+  // Function Variables
+  size_t count { std::min(length, Size() - offset) };
+  size_t start { static_cast<size_t>(_tail + offset) & _mask };
+  size_t first { std::min(count, _capacity - start) };
+
+  memcpy(data, _data + start, first);
+  memcpy(data + first, _data, count - first);
+
+  return count;
+}
+//-----------------------------------------------------------------------------
+size_t RingBuffer::Read(uint8_t * data, size_t length) {
+  // Function Variables
+  size_t count { Peek(data, length) };
+
+  Consume(count);
+
+  return count;
+}
+//-----------------------------------------------------------------------------
+size_t RingBuffer::Read(std::string & buffer, size_t length) {
+  // Function Variables
+  size_t count { std::min(length, Size()) };
+  size_t start { static_cast<size_t>(_tail) & _mask };
+  size_t first { std::min(count, _capacity - start) };
+
+  buffer.append(reinterpret_cast<const char*>(_data + start), first);
+  buffer.append(reinterpret_cast<const char*>(_data), count - first);
+
+  Consume(count);
+
+  return count;
+}
+//-----------------------------------------------------------------------------
+size_t RingBuffer::Find(const uint8_t * pattern, size_t length, size_t offset) const {
+  // Function Variables
+  size_t size { Size() };
+
+  // Check parameters
+  if (length == 0 || offset >= size || length > size - offset) {
+    return npos;
+  }
+
+  // Only positions where the whole pattern fits are candidates
+  size_t last { size - length };
+
+  while (offset <= last) {
+    // Search the first byte in the contiguous part starting at offset
+    size_t          start { static_cast<size_t>(_tail + offset) & _mask };
+    size_t          span { std::min(last - offset + 1, _capacity - start) };
+    const uint8_t * hit { static_cast<const uint8_t*>(memchr(_data + start, pattern[0], span)) };
+
+    if (hit == nullptr) {
+      offset += span;
+      continue;
+    }
+
+    offset += static_cast<size_t>(hit - (_data + start));
+
+    // Compare the remaining bytes, they may cross the wrap
+    size_t index { 1 };
+    while (index < length && _data[(_tail + offset + index) & _mask] == pattern[index]) {
+      index++;
+    }
+
+    if (index == length) {
+      return offset;
+    }
+
+    offset++;
+  }
+
+  return npos;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft::Drivers
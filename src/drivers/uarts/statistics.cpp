@@ -0,0 +1,55 @@
+/*
+ * statistics.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <drivers/uarts/statistics.hpp>
+
+namespace Airsoft::Drivers {
+
+//-----------------------------------------------------------------------------
+void UartCounters::Snapshot(UartStatistics & statistics) const {
+  statistics.BytesRead = _bytesRead.load(std::memory_order_relaxed);
+  statistics.BytesWritten = _bytesWritten.load(std::memory_order_relaxed);
+  statistics.ReadTimeouts = _readTimeouts.load(std::memory_order_relaxed);
+  statistics.WriteTimeouts = _writeTimeouts.load(std::memory_order_relaxed);
+  statistics.Errors = _errors.load(std::memory_order_relaxed);
+  statistics.TransmitRefused = _transmitRefused.load(std::memory_order_relaxed);
+
+  for (size_t index = 0; index < StatisticsBuckets; index++) {
+    statistics.ReadTime[index] = _readTime[index].load(std::memory_order_relaxed);
+    statistics.WriteTime[index] = _writeTime[index].load(std::memory_order_relaxed);
+  }
+}
+//-----------------------------------------------------------------------------
+void UartCounters::Reset(void) {
+  _bytesRead.store(0, std::memory_order_relaxed);
+  _bytesWritten.store(0, std::memory_order_relaxed);
+  _readTimeouts.store(0, std::memory_order_relaxed);
+  _writeTimeouts.store(0, std::memory_order_relaxed);
+  _errors.store(0, std::memory_order_relaxed);
+  _transmitRefused.store(0, std::memory_order_relaxed);
+
+  for (size_t index = 0; index < StatisticsBuckets; index++) {
+    _readTime[index].store(0, std::memory_order_relaxed);
+    _writeTime[index].store(0, std::memory_order_relaxed);
+  }
+}
+//-----------------------------------------------------------------------------
+size_t UartCounters::Bucket(int64_t nanoseconds) {
+  // Function Variables
+  uint64_t microseconds { nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) / 1000 : 0 };
+
+  if (microseconds == 0) {
+    return 0;
+  }
+
+  // Position of the highest bit set, 1 for 1 us
+  size_t bucket { static_cast<size_t>(64 - __builtin_clzll(microseconds)) };
+
+  return bucket < StatisticsBuckets ? bucket : StatisticsBuckets - 1;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft::Drivers
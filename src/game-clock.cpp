@@ -0,0 +1,285 @@
+/**
+ *******************************************************************************
+ * @file game-clock.cpp
+ *
+ * @brief UTC time shared by the devices of a game, disciplined from the GPS
+ *
+ * @author  Cristian Croci
+ *
+ * @version 1.00
+ *
+ * @date Oct 16, 2026
+ *
+ *******************************************************************************
+ * This file is part of the Airsoft Game Machine project
+ * https://github.com/ccdevelop-net/AirsoftGameMachine
+ * Copyright (c) 2024 CCDevelop.NET
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, version 3.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <http://www.gnu.org/licenses/>.
+ *******************************************************************************
+ */
+
+#include <time.h>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+#include <game-clock.hpp>
+
+namespace Airsoft {
+
+// Loop: time constant of the phase correction, the frequency is integrated in twice the time (critically damped).
+// The arrival of the sentences jitters by milliseconds, they are averaged for longer than the pulses
+constexpr double  PpsPhaseTimeNS = 4.0 * Airsoft::Drivers::NanosecondsPerSecond;
+constexpr double  SentencesPhaseTimeNS = 16.0 * Airsoft::Drivers::NanosecondsPerSecond;
+constexpr int64_t MaxIntervalNS = 2 * Airsoft::Drivers::NanosecondsPerSecond;  // Longer gaps aren't integrated
+constexpr double  MaxFrequency = 500e-6;                 // Crystal tolerance
+constexpr double  MaxSlew = 5000e-6;                     // 10 ms corrected in 2 s
+constexpr double  HoldoverTimeNS = 30.0 * Airsoft::Drivers::NanosecondsPerSecond;  // Fade out of the frequency
+
+// PPS: the sentences don't discipline the time while pulses arrive, a pulse must be near a whole second
+constexpr int64_t PpsHoldNS = 2 * Airsoft::Drivers::NanosecondsPerSecond;
+constexpr int64_t PpsMaxDistanceNS = 400 * Airsoft::Drivers::NanosecondsPerMillisecond;
+constexpr int32_t PpsWaitMS = 500;
+
+//------------------------------------------------------------------------------
+GameClock::GameClock(const Airsoft::Drivers::Clock * clock) : _clock(clock) {
+
+}
+//------------------------------------------------------------------------------
+GameClock::~GameClock() {
+  Terminate();
+}
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+bool GameClock::Init(const GameClockSettings & settings) {
+  // Function Variables
+  timespec system;
+
+  Terminate();
+
+  std::lock_guard<std::mutex> lock(_lock);
+
+  _settings = settings;
+
+  // Until the first sample the time is the system one
+  clock_gettime(CLOCK_REALTIME, &system);
+  _state = Discipline {};
+  _state.origin = Monotonic();
+  _state.hold = _state.origin;
+  _state.base = static_cast<int64_t>(system.tv_sec) * Airsoft::Drivers::NanosecondsPerSecond + system.tv_nsec;
+  _discipline.Store(_state);
+
+  _filterCount = 0;
+  _lastUpdate = 0;
+  _lastPulse = 0;
+  _error = 0;
+  _samples = 0;
+  _steps = 0;
+
+  if (_settings.ppsGpio >= 0) {
+    _pps = new Airsoft::Drivers::Gpio(static_cast<uint32_t>(_settings.ppsGpio));
+
+    if (!_pps->Open(Airsoft::Drivers::Direction::Input) ||
+        !_pps->SetEdge(_settings.ppsFalling ? Airsoft::Drivers::Edge::Falling : Airsoft::Drivers::Edge::Rising)) {
+      std::cout << "Game Clock: Error opening the PPS input, using the sentences." << std::endl;
+      delete _pps;
+      _pps = nullptr;
+    } else {
+      // Edges are waited on their own thread
+      _threadRunning = true;
+      _process = new std::thread(&GameClock::Engine, this);
+    }
+  }
+
+  std::cout << "Game Clock: Started." << std::endl;
+
+  return true;
+}
+//------------------------------------------------------------------------------
+void GameClock::Terminate(void) {
+  if (_process != nullptr) {
+    _threadRunning = false;
+    _process->join();
+    delete _process;
+    _process = nullptr;
+  }
+
+  if (_pps != nullptr) {
+    delete _pps;
+    _pps = nullptr;
+  }
+}
+//------------------------------------------------------------------------------
+int64_t GameClock::ToUtc(int64_t monotonic) const {
+  // Function Variables
+  Discipline discipline;
+
+  _discipline.Load(discipline);
+
+  return ToUtc(discipline, monotonic);
+}
+//------------------------------------------------------------------------------
+int64_t GameClock::ToMonotonic(int64_t utc) const {
+  // Function Variables
+  Discipline  discipline;
+  int64_t     elapsed {};
+
+  _discipline.Load(discipline);
+
+  // The correction changes by less than 1% of the time, a few rounds converge to the nanosecond
+  elapsed = utc - discipline.base;
+  for (size_t round = 0; round < 3; round++) {
+    elapsed = utc - discipline.base - std::llround(Correction(discipline, elapsed));
+  }
+
+  return discipline.origin + elapsed;
+}
+//------------------------------------------------------------------------------
+GameClockSource GameClock::GetSource(void) const {
+  // Function Variables
+  Discipline discipline;
+
+  _discipline.Load(discipline);
+
+  return discipline.source;
+}
+//------------------------------------------------------------------------------
+double GameClock::GetFrequency(void) const {
+  // Function Variables
+  Discipline discipline;
+
+  _discipline.Load(discipline);
+
+  return discipline.frequency * 1e6;
+}
+//------------------------------------------------------------------------------
+void GameClock::OnTime(int64_t utc, int64_t arrival) {
+  // Function Variables
+  int64_t offset { utc + _settings.sentenceLatencyNS - arrival };
+
+  if (utc <= 0 || arrival <= 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_lock);
+
+  // A late arrival only makes the offset smaller: the largest of the last samples is the least delayed
+  _filter[_filterCount++ % FilterSamples] = offset;
+  offset = *std::max_element(_filter, _filter + std::min(_filterCount, FilterSamples));
+
+  // With the PPS the sentences only number the seconds
+  if (_lastPulse != 0 && arrival - _lastPulse < PpsHoldNS) {
+    return;
+  }
+
+  Update(offset, arrival, GameClockSource::Sentences);
+}
+//------------------------------------------------------------------------------
+void GameClock::OnPulse(int64_t edge) {
+  std::lock_guard<std::mutex> lock(_lock);
+
+  // The second of the edge comes from the time so far, it has to be synchronized
+  if (_state.source == GameClockSource::None) {
+    return;
+  }
+
+  // Function Variables
+  int64_t utc { ToUtc(edge) };
+  int64_t second { (utc + Airsoft::Drivers::NanosecondsPerSecond / 2) / Airsoft::Drivers::NanosecondsPerSecond *
+                   Airsoft::Drivers::NanosecondsPerSecond };
+
+  // Noise on the input or a time too wrong to number the pulse
+  if (std::llabs(utc - second) > PpsMaxDistanceNS) {
+    return;
+  }
+
+  _lastPulse = edge;
+
+  Update(second - edge, edge, GameClockSource::Pps);
+}
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+double GameClock::Correction(const Discipline & discipline, int64_t elapsed) {
+  // Function Variables
+  double hold { static_cast<double>(discipline.hold - discipline.origin) };
+
+  if (elapsed <= hold) {
+    return elapsed * (discipline.frequency + discipline.slew);
+  }
+
+  // Holdover: the slew has stopped, the frequency fades out
+  return hold * (discipline.frequency + discipline.slew) +
+         discipline.frequency * HoldoverTimeNS * -std::expm1((hold - elapsed) / HoldoverTimeNS);
+}
+//------------------------------------------------------------------------------
+int64_t GameClock::ToUtc(const Discipline & discipline, int64_t monotonic) {
+  // Function Variables
+  int64_t elapsed { monotonic - discipline.origin };
+
+  return discipline.base + elapsed + std::llround(Correction(discipline, elapsed));
+}
+//------------------------------------------------------------------------------
+void GameClock::Update(int64_t offset, int64_t at, GameClockSource source) {
+  // Function Variables
+  int64_t now { Monotonic() };
+  int64_t error { offset - (ToUtc(_state, at) - at) };
+
+  if (_state.source == GameClockSource::None || std::llabs(error) > GameClockStepNS ||
+      (source == GameClockSource::Pps && _state.source != GameClockSource::Pps)) {
+    // First sample, first pulse or time far off: step
+    _state.base = now + offset;
+    _state.slew = 0.0;
+    _error = 0;
+    _steps++;
+  } else {
+    // Phase corrected in the time constant, frequency integrated: the rate only changes, the time is continuous
+    double  phaseTime { source == GameClockSource::Pps ? PpsPhaseTimeNS : SentencesPhaseTimeNS };
+    double  frequencyTime { 2.0 * phaseTime };
+    int64_t interval { std::clamp<int64_t>(at - _lastUpdate, 0, MaxIntervalNS) };
+
+    _state.frequency = std::clamp(_state.frequency + error * static_cast<double>(interval) /
+                                  (frequencyTime * frequencyTime), -MaxFrequency, MaxFrequency);
+    _state.base = ToUtc(_state, now);
+    _state.slew = std::clamp(error / phaseTime, -MaxSlew, MaxSlew);
+
+    _error = _error + (std::llabs(error) - _error) / 8;
+  }
+
+  // The correction holds until the next sample is due, a missing one doesn't leave it running
+  _state.origin = now;
+  _state.hold = now + MaxIntervalNS;
+
+  _state.source = source;
+  _lastUpdate = at;
+  _samples++;
+
+  _discipline.Store(_state);
+}
+//------------------------------------------------------------------------------
+void GameClock::Engine(void) {
+  // Function Variables
+  int64_t edge {};
+
+  while (_threadRunning) {
+    if (_pps->WaitEdge(edge, PpsWaitMS)) {
+      OnPulse(edge);
+    }
+  }
+}
+//------------------------------------------------------------------------------
+
+} // namespace Airsoft
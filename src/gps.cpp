@@ -29,14 +29,18 @@
  *******************************************************************************
  */
 
+#include <time.h>
 #include <iostream>
 #include <chrono>
 #include <functional>
+#include <algorithm>
+#include <thread>
 
 #include <drivers/uarts.hpp>
-#include <utility.hpp>
+#include <drivers/clock.hpp>
 
 #include <gps.hpp>
+#include <game-clock.hpp>
 
 using namespace std::chrono_literals;
 
@@ -44,81 +48,560 @@ using namespace std::chrono_literals;
 
 namespace Airsoft {
 
+// UBX configuration: wait for data in slices, answer expected within
+constexpr uint32_t UbxPollMS = 20;
+constexpr int64_t UbxAckTimeoutMS = 500;
+
+// Aiding: floor of the accuracy of the last position, the device may have been moved while off, and
+// accuracy of the system time
+constexpr uint32_t AidPositionAccuracyCM = 100000;
+constexpr uint16_t AidTimeAccuracyS = 5;
+
+// NMEA: position sentences of an epoch, it is published once both have arrived
+constexpr uint8_t EpochRmc = 0x01;
+constexpr uint8_t EpochGga = 0x02;
+
+namespace {
+
+//------------------------------------------------------------------------------
+int64_t system_utc(void) {
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+//------------------------------------------------------------------------------
+
+} // namespace
+
 //------------------------------------------------------------------------------
 Gps::Gps() {
 
 }
 //------------------------------------------------------------------------------
 Gps::~Gps() {
-
+  StopSaving();
 }
 //------------------------------------------------------------------------------
 
 //------------------------------------------------------------------------------
-bool Gps::Init(std::string port) {
+bool Gps::Init(std::string port, Airsoft::Drivers::UartReactor & reactor, const GpsSettings & settings) {
   // Check valid port
   if (port.empty()) {
     return false;
   }
 
+  // A save thread of a previous Init without Terminate reads the state file replaced below
+  StopSaving();
+
+  // A recorded receiver in place of the port
+  if (GpsReplay::IsReplay(port)) {
+    if (!_replay.Open(port)) {
+      std::cout << "GPS : Error loading the replay " << port << "." << std::endl;
+      return false;
+    }
+    port = _replay.GetPort();
+  }
+
   // Set port
   _port = port;
+  _reactor = &reactor;
+  _settings = settings;
+  _protocol = GpsProtocol::Nmea;
+  _started = Airsoft::Drivers::Clock::Default().Now();
+  _saved = _started;
+  _timeToFirstFix = 0;
+  _aided = false;
+  _stateFile = GpsStateFile(_settings.stateFile);
+  _state = GpsState {};
+
+  // State of the last session
+  if (_stateFile.Load(_state)) {
+    std::cout << "GPS : State loaded, previous time to first fix " << _state.ttff / 1000 << "."
+              << _state.ttff % 1000 / 100 << " s." << std::endl;
+  } else {
+    _state = GpsState {};
+  }
+
+  _serial = new Airsoft::Drivers::Uarts(_port, _settings.baudrate);
+  // Sentences are stamped when read, not when processed
+  _serial->SetTimestamping();
+  _parser.Reset();
+  _ubx.Reset();
+  _fix = GpsFix {};
+  _epochTime = -1;
+  _epochSentences = 0;
+  _epochExpected = EpochRmc | EpochGga;
+  _epochPrevious = 0;
+  _epochPublished = false;
+  _filter.SetSettings(_settings.filterSettings);
+  _filter.Reset();
+  _quality.Reset();
 
-  // Set flag of thread running
-  _threadRunning = true;
+  try {
+    // Open serial
+    _serial->Open();
+  } catch (...) {
+    std::cout << "GPS : Error open serial port." << std::endl;
+    delete _serial;
+    _serial = nullptr;
+    _replay.Close();
+    return false;
+  }
 
-  // Create Engine Thread
-  return ((_process = new std::thread(std::bind(&Gps::Engine, this))) != nullptr);
+  if (_replay.IsOpen()) {
+    // The protocol of the log, there is no receiver to configure
+    _protocol = _replay.IsUbx() ? GpsProtocol::Ubx : GpsProtocol::Nmea;
+    std::cout << "GPS : Replay of " << _replay.GetEpochs() << " epochs at ";
+    if (_replay.GetSpeed() > 0) {
+      std::cout << _replay.GetSpeed() << "x." << std::endl;
+    } else {
+      std::cout << "maximum speed." << std::endl;
+    }
+  } else if (_settings.protocol == GpsProtocol::Ubx) {
+    if (ConfigureUbx()) {
+      _protocol = GpsProtocol::Ubx;
+      std::cout << "GPS : UBX at " << _settings.ubxBaudrate << " baud, " << _settings.rate << " Hz." << std::endl;
+    } else {
+      std::cout << "GPS : UBX configuration failed, using NMEA." << std::endl;
+    }
+  }
+
+  _state.protocol = static_cast<uint8_t>(_protocol);
+  _state.baudrate = _protocol == GpsProtocol::Ubx ? _settings.ubxBaudrate : _settings.baudrate;
+
+  SendAiding();
+
+  // Positions of the session after those of the previous ones
+  if (!_settings.trackFile.empty() && !_track.Open(_settings.trackFile, _settings.trackSize)) {
+    std::cout << "GPS : Error opening the track " << _settings.trackFile << "." << std::endl;
+  }
+
+  // Sentences for the other readers of a GPS, from the first one
+  if (!_settings.nmeaPty.empty()) {
+    if (_nmeaPty.Open(_stream, _settings.nmeaPty)) {
+      std::cout << "GPS : Sentences on " << _settings.nmeaPty << " (" << _nmeaPty.GetPort() << ")." << std::endl;
+    } else {
+      std::cout << "GPS : Error creating the pseudo terminal " << _settings.nmeaPty << "." << std::endl;
+    }
+  }
+
+  // Sentences are read when the port becomes readable
+  if (!_reactor->Register(*_serial, std::bind(&Gps::OnReadable, this))) {
+    std::cout << "GPS : Error register serial port." << std::endl;
+    _nmeaPty.Close();
+    _track.Close();
+    _serial->Close();
+    delete _serial;
+    _serial = nullptr;
+    _replay.Close();
+    return false;
+  }
+
+  // The state file is written away from the reactor thread, a sync on the SD card takes hundreds of ms
+  if (_stateFile.IsEnabled()) {
+    _savePending = false;
+    _threadRunning = true;
+    _process = new std::thread(&Gps::Engine, this);
+  }
+
+  // The log is played once its port is read
+  if (_replay.IsOpen()) {
+    _replay.Start();
+  }
+
+  std::cout << "GPS Engine: Started." << std::endl;
+
+  // Set ready flag
+  _ready = true;
+
+  return true;
 }
 //------------------------------------------------------------------------------
 void Gps::Terminate(void) {
-  // Check valid thread
-  if (_process != nullptr) {
-    // Reset thread flag
-    _threadRunning = false;
+  // Check valid port
+  if (_serial != nullptr) {
+    // Reset ready flag
+    _ready = false;
 
-    // Wait 1.5 second for thread terminate
-    std::this_thread::sleep_for(1500ms);
+    // Remove from the reactor, no handler is running after this
+    _reactor->Unregister(*_serial);
 
-    _process = nullptr;
+    if (_state.HasPosition()) {
+      SaveState();
+    }
+
+    // Waits for the last save
+    StopSaving();
+
+    _serial->Close();
+    delete _serial;
+    _serial = nullptr;
+
+    _nmeaPty.Close();
+    _track.Close();
+    _replay.Close();
+
+    std::cout << "GPS Engine: Terminated." << std::endl;
+  }
+}
+//------------------------------------------------------------------------------
+bool Gps::GetStatistics(Airsoft::Drivers::UartStatistics & statistics) const {
+  // Check valid port
+  if (_serial == nullptr || !_serial->IsOpen()) {
+    return false;
+  }
+
+  statistics = _serial->GetStatistics();
+
+  return true;
+}
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+void Gps::OnReadable(void) {
+  // Readable without data, the receiver has been disconnected
+  Airsoft::Drivers::UartResult received { _serial->TryReceive() };
+
+  if (!received || received.Value() == 0) {
+    std::cout << "GPS : Serial port disconnected (" << Airsoft::Drivers::UartResult::Describe(received.Error())
+              << ")." << std::endl;
+    _reactor->Unregister(*_serial);
+    _ready = false;
+    return;
+  }
+
+  // Function Variables
+  GpsChunk * chunk {};
+
+  // Decode the data as received, each chunk with its arrival time. Binary and text share the port:
+  // each parser skips the data of the other protocol. The subscribers get the chunk once decoded
+  for (chunk = _stream.Acquire(); (chunk->length = _serial->GetData(chunk->data, GpsChunkSize, chunk->arrival)) > 0;
+       chunk = _stream.Acquire()) {
+    _parser.Feed(chunk->data, chunk->length, chunk->arrival, [this](NmeaSentence sentence) { OnSentence(sentence); });
+
+    if (_protocol == GpsProtocol::Ubx) {
+      _ubx.Feed(chunk->data, chunk->length, chunk->arrival, [this](UbxMessage message) { OnMessage(message); });
+    }
+
+    _stream.Publish(chunk);
   }
 }
 //------------------------------------------------------------------------------
+void Gps::OnSentence(NmeaSentence sentence) {
+  _sentenceTime = _parser.GetFix().arrival;
 
+  // Satellites and DOP, in both protocols
+  _quality.OnSentence(sentence, _parser.GetFix());
 
+#if DEBUG_GPS
+  std::cout << std::string(_parser.GetText(), _parser.GetTextLength()) << " (arrived " << _sentenceTime / 1000
+            << " us, processed after " << (Airsoft::Drivers::Clock::Default().Now() - _sentenceTime) / 1000 << " us)"
+            << std::endl;
+#endif  // DEBUG_GPS
+
+  // With UBX the sentences only bring the satellites, the position comes from NAV-PVT
+  if (_protocol == GpsProtocol::Nmea && (sentence == NmeaSentence::Rmc || sentence == NmeaSentence::Gga)) {
+    OnPosition(sentence);
+  }
+}
+//------------------------------------------------------------------------------
+void Gps::OnPosition(NmeaSentence sentence) {
+  // Function Variables
+  const GpsFix  & fix { _parser.GetFix() };
+  int64_t         time { fix.Has(FixHasTime) ? static_cast<int64_t>(fix.TimeOfDay()) : -1 };
+  uint8_t         received { sentence == NmeaSentence::Rmc ? EpochRmc : EpochGga };
+
+  // Another time or a sentence already received: a new epoch
+  if (time != _epochTime || (_epochSentences & received) != 0) {
+    // A sentence of the previous epoch was lost, it is published as it was
+    if (_epochSentences != 0 && !_epochPublished) {
+      Publish(_epochFix);
+    }
+
+    // The sentences the receiver sends, from the last two epochs: a single one lost doesn't change them
+    if (_epochSentences != 0) {
+      _epochExpected = _epochSentences | _epochPrevious;
+      _epochPrevious = _epochSentences;
+    }
+
+    _epochTime = time;
+    _epochSentences = 0;
+    _epochPublished = false;
+  }
+
+  _epochSentences |= received;
+  _epochFix = fix;
+
+  // Once per epoch, with the fields of all its position sentences
+  if (!_epochPublished && (_epochSentences & _epochExpected) == _epochExpected) {
+    Publish(fix);
+    _epochPublished = true;
+  }
+}
+//------------------------------------------------------------------------------
+void Gps::OnMessage(UbxMessage message) {
+  if (message != UbxMessage::NavPvt) {
+    return;
+  }
+
+  // Function Variables
+  const GpsFix & sentences { _parser.GetFix() };
+  uint16_t       fromSentences { static_cast<uint16_t>(FixHasDop | FixHasSatellites) };
+
+  _fix = _ubx.GetFix();
+  _sentenceTime = _fix.arrival;
+
+  // NAV-PVT has no satellites and only the PDOP, they come from GSA and GSV
+  _fix.hdop = sentences.hdop;
+  _fix.vdop = sentences.vdop;
+  _fix.usedCount = sentences.usedCount;
+  std::copy(sentences.used, sentences.used + GpsMaxUsed, _fix.used);
+  std::copy(sentences.usedSystem, sentences.usedSystem + GpsMaxUsed, _fix.usedSystem);
+  _fix.satelliteCount = sentences.satelliteCount;
+  std::copy(sentences.satellites, sentences.satellites + GpsMaxSatellites, _fix.satellites);
+  _fix.valid = static_cast<uint16_t>((_fix.valid & ~fromSentences) | (sentences.valid & fromSentences));
+
+  Publish(_fix);
+}
+//------------------------------------------------------------------------------
+void Gps::Publish(const GpsFix & fix) {
+  // Function Variables
+  GpsFix  published { fix };
+  int64_t now {};
+  int64_t utc { GpsFixToUtc(fix) };
+
+  if (_settings.filter) {
+    _filter.Apply(published);
+  }
+
+  _quality.Evaluate(published);
+
+  _published.Store(published);
+
+  if (_fixHandler) {
+    _fixHandler(published);
+  }
+
+  if (!fix.Has(FixHasPosition) || fix.quality == 0 || utc == 0) {
+    return;
+  }
+
+  now = Airsoft::Drivers::Clock::Default().Now();
+
+  // Time of the epoch and arrival of its data
+  if (_gameClock != nullptr && fix.arrival != 0) {
+    _gameClock->OnTime(utc * Airsoft::Drivers::NanosecondsPerMillisecond, fix.arrival);
+  }
+
+  if (_timeToFirstFix == 0) {
+    int64_t elapsed { (now - _started) / Airsoft::Drivers::NanosecondsPerMillisecond };
+
+    _state.ttff = static_cast<uint32_t>(std::max<int64_t>(elapsed, 1));
+    _timeToFirstFix = _state.ttff;
+
+    std::cout << "GPS : First fix in " << _state.ttff / 1000 << "." << _state.ttff % 1000 / 100 << " s ("
+              << (_aided ? "aided" : "not aided") << ")." << std::endl;
+  }
+
+  _track.Append(fix);
+
+  // Position kept for the next power up
+  _state.utc = utc;
+  _state.latitude = fix.latitude;
+  _state.longitude = fix.longitude;
+  _state.altitude = fix.Has(FixHasAltitude) ? static_cast<int32_t>((fix.altitude + fix.geoidSeparation) * 100) : 0;
+  _state.accuracy = fix.Has(FixHasAccuracy) ? static_cast<uint32_t>(fix.horizontalAccuracy * 100) : 0;
+
+  if (_settings.saveIntervalS > 0 &&
+      now - _saved >= static_cast<int64_t>(_settings.saveIntervalS) * Airsoft::Drivers::NanosecondsPerSecond) {
+    SaveState();
+  }
+}
+//------------------------------------------------------------------------------
+void Gps::SendAiding(void) {
+  // Function Variables
+  uint8_t message[UbxOverhead + 24] {};
+  size_t  length {};
+  int64_t utc { system_utc() };
+
+  if (!_state.HasPosition()) {
+    return;
+  }
+
+  // A system time before the last fix is not set, e.g. no RTC: the receiver is left without time
+  if (utc >= _state.utc && (length = UbxParser::BuildAidTime(utc, AidTimeAccuracyS, message, sizeof(message))) > 0) {
+    _serial->TryWrite(message, length);
+  }
+
+  length = UbxParser::BuildAidPosition(_state.latitude, _state.longitude, _state.altitude,
+                                       std::max(_state.accuracy, AidPositionAccuracyCM), message, sizeof(message));
+  _aided = _serial->TryWrite(message, length).Value() == length;
+}
+//------------------------------------------------------------------------------
+void Gps::SaveState(void) {
+  _saved = Airsoft::Drivers::Clock::Default().Now();
+
+  // Pages of the track written back with the state, the kernel does it anyway within its expire time
+  _track.Flush();
+
+  if (_process == nullptr) {
+    return;
+  }
+
+  // A save still running is replaced by the newer state
+  {
+    std::lock_guard<std::mutex> lock(_saveLock);
+
+    _saving = _state;
+    _savePending = true;
+  }
+  _saveSignal.notify_one();
+}
+//------------------------------------------------------------------------------
+void Gps::StopSaving(void) {
+  if (_process != nullptr) {
+    {
+      std::lock_guard<std::mutex> lock(_saveLock);
+
+      _threadRunning = false;
+    }
+    _saveSignal.notify_one();
+    _process->join();
+    delete _process;
+    _process = nullptr;
+  }
+}
 //------------------------------------------------------------------------------
 void Gps::Engine(void) {
   // Thread Variables
-  Airsoft::Drivers::Uarts serial(_port, 9600);
-  std::string gpsData;
+  GpsState state;
 
-  std::cout << "GPS Engine: Started." << std::endl;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_saveLock);
+
+      _saveSignal.wait(lock, [this] { return _savePending || !_threadRunning; });
+
+      // A state queued before the stop is still written
+      if (!_savePending) {
+        return;
+      }
+
+      state = _saving;
+      _savePending = false;
+    }
+
+    if (!_stateFile.Save(state)) {
+      std::cout << "GPS : Error saving the state to " << _stateFile.GetPath() << "." << std::endl;
+    }
+  }
+}
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+bool Gps::ConfigureUbx(void) {
+  // Function Variables
+  Airsoft::Drivers::Timeout timeout { _serial->GetTimeout() };
+  Airsoft::Drivers::Timeout polling { Airsoft::Drivers::Timeout::SimpleTimeout(UbxPollMS) };
+  uint8_t                   port[UbxOverhead + 20] {};
+  uint8_t                   command[UbxOverhead + 20] {};
+  size_t                    portLength {};
+  bool                      configured {};
+  uint8_t                   rate { static_cast<uint8_t>(std::clamp<uint16_t>(_settings.rate, 1, 10)) };
+
+  // Messages on this port: NAV-PVT every solution, GSA and GSV once per second for the satellites
+  const uint8_t messages[][3] {
+    { UbxClassNav, UbxIdNavPvt, 1 },
+    { UbxClassNmea, UbxIdNmeaGga, 0 },
+    { UbxClassNmea, UbxIdNmeaGll, 0 },
+    { UbxClassNmea, UbxIdNmeaRmc, 0 },
+    { UbxClassNmea, UbxIdNmeaVtg, 0 },
+    { UbxClassNmea, UbxIdNmeaGsa, rate },
+    { UbxClassNmea, UbxIdNmeaGsv, rate },
+  };
+
+  portLength = UbxParser::BuildConfigPort(_settings.ubxBaudrate, UbxProtocolUbx | UbxProtocolNmea,
+                                          UbxProtocolUbx | UbxProtocolNmea, port, sizeof(port));
+
+  _serial->SetTimeout(polling);
 
   try {
-    // Open serial
-    serial.Open();
+    // The receiver changes baudrate after the answer, that is lost: the port is verified at the new
+    // speed by the next command. After a warm start it may already be at the new speed.
+    // The baudrate of the last session is tried first
+    bool      fast { _state.protocol == static_cast<uint8_t>(GpsProtocol::Ubx) &&
+                     _state.baudrate == _settings.ubxBaudrate };
+    uint32_t  first { fast ? _settings.ubxBaudrate : _settings.baudrate };
+    uint32_t  second { fast ? _settings.baudrate : _settings.ubxBaudrate };
+
+    for (uint32_t baudrate : { first, second }) {
+      _serial->SetBaudrate(baudrate);
+      _serial->TryWrite(port, portLength);
+      _serial->Flush();
+      std::this_thread::sleep_for(std::chrono::milliseconds(UbxPollMS));
+
+      _serial->SetBaudrate(_settings.ubxBaudrate);
+      _serial->FlushInput();
+
+      if (SendUbx(command, UbxParser::BuildConfigRate(static_cast<uint16_t>(1000 / rate), command, sizeof(command)))) {
+        configured = true;
+        break;
+      }
+    }
+
+    for (size_t index = 0; configured && index < sizeof(messages) / sizeof(messages[0]); index++) {
+      configured = SendUbx(command, UbxParser::BuildConfigMessage(messages[index][0], messages[index][1],
+                                                                   messages[index][2], command, sizeof(command)));
+    }
   } catch (...) {
-    std::cout << "GPS : Error open serial port." << std::endl;
+    configured = false;
   }
 
-  // Set ready flag
-  _ready = true;
+  // Back to the sentences at the power up speed
+  if (!configured) {
+    try {
+      _serial->SetBaudrate(_settings.baudrate);
+    } catch (...) {
+    }
+  }
 
-  // Thread loop
-  while(_threadRunning) {
-    gpsData = serial.ReadLine();
+  _serial->SetTimeout(timeout);
+  _ubx.Reset();
 
-    if (gpsData.length() > 0) {
-#if DEBUG_GPS
-      std::cout << Utility::Trim(gpsData) << std::endl;
-#endif  // DEBUG_GPS
+  return configured;
+}
+//------------------------------------------------------------------------------
+bool Gps::SendUbx(const uint8_t * message, size_t length) {
+  // Function Variables
+  Airsoft::Drivers::Deadline  deadline { Airsoft::Drivers::Deadline::FromMilliseconds(UbxAckTimeoutMS) };
+  UbxMessage                  answer { UbxMessage::None };
+  size_t                      received {};
+  int64_t                     arrival {};
+
+  if (length < UbxOverhead || !_serial->TryWrite(message, length)) {
+    return false;
+  }
+
+  // Wait for the ACK or NAK of this message, the other data is dropped
+  while (answer == UbxMessage::None && !deadline.Expired()) {
+    if (!_serial->WaitReadable() || !_serial->TryReceive()) {
+      continue;
     }
 
-    std::this_thread::sleep_for(100ms);
+    while (answer == UbxMessage::None && (received = _serial->GetData(_chunk, sizeof(_chunk), arrival)) > 0) {
+      _ubx.Feed(_chunk, received, arrival, [&](UbxMessage reply) {
+        if ((reply == UbxMessage::Ack || reply == UbxMessage::Nak) &&
+            _ubx.GetAckClass() == message[2] && _ubx.GetAckId() == message[3]) {
+          answer = reply;
+        }
+      });
+    }
   }
 
-  std::cout << "GPS Engine: Terminated." << std::endl;
+  return answer == UbxMessage::Ack;
 }
 //------------------------------------------------------------------------------
+//------------------------------------------------------------------------------
 
 } // namespace Airsoft
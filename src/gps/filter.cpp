@@ -0,0 +1,149 @@
+/*
+ * filter.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <cmath>
+#include <gps/filter.hpp>
+
+namespace Airsoft {
+
+constexpr uint32_t MillisecondsPerDay = 86400000;
+constexpr float    StartSpeedError = 2.0f;                // m/s, sigma of the velocity at a start without speed
+constexpr float    CourseSpeedError = 0.5f;               // m/s, the same with the speed and course of the receiver
+constexpr float    MaxOriginDistance = 10000.0f;          // Meters, farther the plane is moved to the fix
+
+//-----------------------------------------------------------------------------
+bool GpsFilter::Apply(GpsFix & fix) {
+  // Function Variables
+  float     x {};
+  float     y {};
+  float     r {};
+  float     dt {};
+  uint32_t  elapsed {};
+
+  if (!fix.Has(FixHasPosition | FixHasTime) || fix.quality == 0) {
+    return true;
+  }
+
+  // The second sentence of the epoch: the estimate only
+  if (_started && fix.TimeOfDay() == _time) {
+    Output(fix);
+    return true;
+  }
+
+  elapsed = (fix.TimeOfDay() + MillisecondsPerDay - _time) % MillisecondsPerDay;
+  r = Variance(fix);
+
+  if (!_started || elapsed > _settings.maxGapMS) {
+    _plane.SetOrigin(fix.latitude, fix.longitude);
+    Start(fix, 0.0f, 0.0f, r);
+    Output(fix);
+    return true;
+  }
+
+  _plane.Project(fix.latitude, fix.longitude, x, y);
+  _time = fix.TimeOfDay();
+
+  // Prediction, white acceleration noise
+  {
+    float q { _settings.acceleration * _settings.acceleration };
+
+    dt = elapsed * 1e-3f;
+    _x[0] += dt * _x[1];
+    _y[0] += dt * _y[1];
+    _p00 += dt * (2.0f * _p01 + dt * _p11) + q * dt * dt * dt / 3.0f;
+    _p01 += dt * _p11 + q * dt * dt / 2.0f;
+    _p11 += q * dt;
+  }
+
+  // Innovation of both axes against its variance: chi-square with two degrees of freedom
+  {
+    float s { _p00 + r };
+    float ix { x - _x[0] };
+    float iy { y - _y[0] };
+
+    if ((ix * ix + iy * iy) / s > _settings.gate) {
+      _rejected++;
+
+      if (++_rejectedInRow > _settings.maxRejected) {
+        // Far from the origin the plane is moved, the precision of the floats is kept
+        if (ix * ix + iy * iy > MaxOriginDistance * MaxOriginDistance || std::fabs(x) > MaxOriginDistance ||
+            std::fabs(y) > MaxOriginDistance) {
+          _plane.SetOrigin(fix.latitude, fix.longitude);
+          x = y = 0.0f;
+        }
+        Start(fix, x, y, r);
+        Output(fix);
+        return true;
+      }
+
+      Output(fix);
+      return false;
+    }
+
+    // Gain and update
+    float k0 { _p00 / s };
+    float k1 { _p01 / s };
+
+    _x[0] += k0 * ix;
+    _x[1] += k1 * ix;
+    _y[0] += k0 * iy;
+    _y[1] += k1 * iy;
+    _p11 -= k1 * _p01;
+    _p01 *= 1.0f - k0;
+    _p00 *= 1.0f - k0;
+  }
+
+  _rejectedInRow = 0;
+  _updates++;
+  Output(fix);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void GpsFilter::Start(const GpsFix & fix, float x, float y, float variance) {
+  // Function Variables
+  bool  velocity { fix.Has(FixHasSpeed | FixHasCourse) };
+  float course { fix.course * static_cast<float>(M_PI) / 180.0f };
+  float speedError { velocity ? CourseSpeedError : StartSpeedError };
+
+  _x[0] = x;
+  _x[1] = velocity ? fix.speed * std::sin(course) : 0.0f;
+  _y[0] = y;
+  _y[1] = velocity ? fix.speed * std::cos(course) : 0.0f;
+  _p00 = variance;
+  _p01 = 0.0f;
+  _p11 = speedError * speedError;
+  _time = fix.TimeOfDay();
+  _rejectedInRow = 0;
+  _started = true;
+  _resets++;
+}
+//-----------------------------------------------------------------------------
+void GpsFilter::Output(GpsFix & fix) const {
+  _plane.Unproject(_x[0], _y[0], fix.filteredLatitude, fix.filteredLongitude);
+  fix.velocityEast = _x[1];
+  fix.velocityNorth = _y[1];
+  fix.filteredAccuracy = std::sqrt(_p00);
+  fix.valid |= FixHasFiltered;
+}
+//-----------------------------------------------------------------------------
+float GpsFilter::Variance(const GpsFix & fix) const {
+  // Function Variables
+  float sigma { _settings.defaultError };
+
+  if (fix.Has(FixHasAccuracy) && fix.horizontalAccuracy > 0) {
+    sigma = fix.horizontalAccuracy;
+  } else if (fix.Has(FixHasDop) && fix.hdop > 0) {
+    sigma = fix.hdop * _settings.rangeError;
+  }
+
+  return sigma * sigma;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
@@ -0,0 +1,388 @@
+/*
+ * geofence.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <algorithm>
+#include <gps/geofence.hpp>
+
+namespace Airsoft {
+
+// Automatic cell size: about one zone per cell, not smaller than
+constexpr float MinCellSize = 10.0f;
+
+namespace {
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Squared distance of a point from the segment a-b.
+ */
+float segment_distance2(float x, float y, float ax, float ay, float bx, float by) {
+  // Function Variables
+  float dx { bx - ax };
+  float dy { by - ay };
+  float length2 { dx * dx + dy * dy };
+  float t { length2 > 0.0f ? ((x - ax) * dx + (y - ay) * dy) / length2 : 0.0f };
+
+  t = std::clamp(t, 0.0f, 1.0f);
+  dx = ax + t * dx - x;
+  dy = ay + t * dy - y;
+
+  return dx * dx + dy * dy;
+}
+//-----------------------------------------------------------------------------
+bool parse_type(const std::string & text, GeofenceZoneType & type) {
+  if (text == "capture") {
+    type = GeofenceZoneType::Capture;
+  } else if (text == "spawn") {
+    type = GeofenceZoneType::Spawn;
+  } else if (text == "out") {
+    type = GeofenceZoneType::OutOfBounds;
+  } else if (text == "other") {
+    type = GeofenceZoneType::Other;
+  } else {
+    return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+int32_t Geofence::AddZone(const std::string & name, GeofenceZoneType type, const int32_t * latitudes,
+                          const int32_t * longitudes, size_t count) {
+  // Function Variables
+  GeofenceZone zone;
+
+  if (count < 3 || count > GeofenceMaxVertices || _zones.size() >= GeofenceMaxZones) {
+    return -1;
+  }
+
+  zone.name = name;
+  zone.type = type;
+  zone.first = static_cast<uint32_t>(_latitudes.size());
+  zone.count = static_cast<uint32_t>(count);
+
+  _latitudes.insert(_latitudes.end(), latitudes, latitudes + count);
+  _longitudes.insert(_longitudes.end(), longitudes, longitudes + count);
+  _zones.push_back(zone);
+
+  return static_cast<int32_t>(_zones.size() - 1);
+}
+//-----------------------------------------------------------------------------
+int32_t Geofence::AddZone(const std::string & definition) {
+  // Function Variables
+  std::istringstream    input(definition);
+  std::string           name;
+  std::string           type;
+  std::string           vertex;
+  GeofenceZoneType      zoneType {};
+  std::vector<int32_t>  latitudes;
+  std::vector<int32_t>  longitudes;
+
+  if (!std::getline(input, name, ',') || !std::getline(input, type, ',') || !parse_type(type, zoneType)) {
+    return -1;
+  }
+
+  while (std::getline(input, vertex, ';')) {
+    std::istringstream  coordinates(vertex);
+    double              latitude {};
+    double              longitude {};
+
+    if (!(coordinates >> latitude >> longitude) || std::fabs(latitude) > 90.0 || std::fabs(longitude) > 180.0) {
+      return -1;
+    }
+
+    latitudes.push_back(static_cast<int32_t>(std::lround(latitude * 1e7)));
+    longitudes.push_back(static_cast<int32_t>(std::lround(longitude * 1e7)));
+  }
+
+  return AddZone(name, zoneType, latitudes.data(), longitudes.data(), latitudes.size());
+}
+//-----------------------------------------------------------------------------
+bool Geofence::Build(const GeofenceSettings & settings) {
+  // Function Variables
+  int64_t latitudeMin { INT32_MAX }, latitudeMax { INT32_MIN };
+  int64_t longitudeMin { INT32_MAX }, longitudeMax { INT32_MIN };
+  float   margin {};
+  float   width {};
+  float   height {};
+
+  _settings = settings;
+  _cellStart.clear();
+  _cellZones.clear();
+  _columns = 0;
+  _rows = 0;
+  _candidates = 0;
+  _tests = 0;
+  _untrusted = 0;
+
+  for (Target & target : _targets) {
+    target.count = 0;
+  }
+
+  if (_zones.empty()) {
+    return false;
+  }
+
+  // Plane centered on the zones
+  for (size_t index = 0; index < _latitudes.size(); index++) {
+    latitudeMin = std::min<int64_t>(latitudeMin, _latitudes[index]);
+    latitudeMax = std::max<int64_t>(latitudeMax, _latitudes[index]);
+    longitudeMin = std::min<int64_t>(longitudeMin, _longitudes[index]);
+    longitudeMax = std::max<int64_t>(longitudeMax, _longitudes[index]);
+  }
+
+  _plane.SetOrigin(static_cast<int32_t>((latitudeMin + latitudeMax) / 2),
+                   static_cast<int32_t>((longitudeMin + longitudeMax) / 2));
+
+  _x.resize(_latitudes.size());
+  _y.resize(_latitudes.size());
+
+  for (size_t index = 0; index < _latitudes.size(); index++) {
+    _plane.Project(_latitudes[index], _longitudes[index], _x[index], _y[index]);
+  }
+
+  // Boxes of the zones and of the grid, grown by the hysteresis
+  margin = std::max(_settings.hysteresis, 0.0f);
+  _originX = std::numeric_limits<float>::max();
+  _originY = std::numeric_limits<float>::max();
+  width = std::numeric_limits<float>::lowest();
+  height = std::numeric_limits<float>::lowest();
+
+  for (GeofenceZone & zone : _zones) {
+    auto x = _x.begin() + zone.first;
+    auto y = _y.begin() + zone.first;
+
+    zone.minX = *std::min_element(x, x + zone.count);
+    zone.maxX = *std::max_element(x, x + zone.count);
+    zone.minY = *std::min_element(y, y + zone.count);
+    zone.maxY = *std::max_element(y, y + zone.count);
+
+    _originX = std::min(_originX, zone.minX - margin);
+    _originY = std::min(_originY, zone.minY - margin);
+    width = std::max(width, zone.maxX + margin);
+    height = std::max(height, zone.maxY + margin);
+  }
+
+  width -= _originX;
+  height -= _originY;
+
+  // About a zone per cell, within the number of cells
+  _cellSize = _settings.cellSize > 0.0f ? _settings.cellSize :
+              std::max(MinCellSize, std::sqrt(width * height / static_cast<float>(_zones.size())));
+
+  while (static_cast<size_t>(std::ceil(width / _cellSize)) * static_cast<size_t>(std::ceil(height / _cellSize)) >
+         GeofenceMaxCells) {
+    _cellSize *= 1.5f;
+  }
+
+  _columns = std::max(1u, static_cast<uint32_t>(std::ceil(width / _cellSize)));
+  _rows = std::max(1u, static_cast<uint32_t>(std::ceil(height / _cellSize)));
+  _cellStart.assign(static_cast<size_t>(_columns) * _rows + 1, 0);
+
+  // Two passes: zones per cell, then the zones in the cells
+  auto cells = [&](const GeofenceZone & zone, auto && visit) {
+    uint32_t column1 { static_cast<uint32_t>((zone.minX - margin - _originX) / _cellSize) };
+    uint32_t column2 { std::min(_columns - 1, static_cast<uint32_t>((zone.maxX + margin - _originX) / _cellSize)) };
+    uint32_t row1 { static_cast<uint32_t>((zone.minY - margin - _originY) / _cellSize) };
+    uint32_t row2 { std::min(_rows - 1, static_cast<uint32_t>((zone.maxY + margin - _originY) / _cellSize)) };
+
+    for (uint32_t row = row1; row <= row2; row++) {
+      for (uint32_t column = column1; column <= column2; column++) {
+        visit(static_cast<size_t>(row) * _columns + column);
+      }
+    }
+  };
+
+  for (const GeofenceZone & zone : _zones) {
+    cells(zone, [&](size_t cell) { _cellStart[cell + 1]++; });
+  }
+
+  for (size_t cell = 1; cell < _cellStart.size(); cell++) {
+    _cellStart[cell] += _cellStart[cell - 1];
+  }
+
+  std::vector<uint32_t> fill(_cellStart.begin(), _cellStart.end() - 1);
+  _cellZones.resize(_cellStart.back());
+
+  for (size_t index = 0; index < _zones.size(); index++) {
+    cells(_zones[index], [&](size_t cell) { _cellZones[fill[cell]++] = static_cast<uint16_t>(index); });
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void Geofence::Reset(size_t target) {
+  if (target < GeofenceMaxTargets) {
+    _targets[target].count = 0;
+  }
+}
+//-----------------------------------------------------------------------------
+bool Geofence::Contains(size_t zone, int32_t latitude, int32_t longitude) const {
+  // Function Variables
+  float x {};
+  float y {};
+
+  if (zone >= _zones.size() || _x.size() != _latitudes.size()) {
+    return false;
+  }
+
+  _plane.Project(latitude, longitude, x, y);
+
+  return InsidePolygon(zone, x, y);
+}
+//-----------------------------------------------------------------------------
+const char * Geofence::Describe(GeofenceEventType type) {
+  switch (type) {
+    case GeofenceEventType::Enter:  return "enter";
+    case GeofenceEventType::Exit:   return "exit";
+    case GeofenceEventType::Dwell:  return "dwell";
+  }
+
+  return "unknown";
+}
+//-----------------------------------------------------------------------------
+const char * Geofence::Describe(GeofenceZoneType type) {
+  switch (type) {
+    case GeofenceZoneType::Capture:     return "capture";
+    case GeofenceZoneType::Spawn:       return "spawn";
+    case GeofenceZoneType::OutOfBounds: return "out";
+    case GeofenceZoneType::Other:       return "other";
+  }
+
+  return "unknown";
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+size_t Geofence::Evaluate(size_t target, int32_t latitude, int32_t longitude, int64_t time, GeofenceEvent * events) {
+  if (target >= GeofenceMaxTargets || _cellStart.empty()) {
+    return 0;
+  }
+
+  // Function Variables
+  Target &  state { _targets[target] };
+  float     hysteresis { _settings.hysteresis };
+  float     x {};
+  float     y {};
+  size_t    count {};
+  size_t    kept {};
+
+  _plane.Project(latitude, longitude, x, y);
+
+  // Zones the target is inside: exit when out by the hysteresis, dwell once per stay
+  for (size_t index = 0; index < state.count; index++) {
+    Inside &              inside { state.inside[index] };
+    const GeofenceZone &  zone { _zones[inside.zone] };
+    bool                  out { x < zone.minX - hysteresis || x > zone.maxX + hysteresis ||
+                                y < zone.minY - hysteresis || y > zone.maxY + hysteresis };
+
+    if (!out && !InsidePolygon(inside.zone, x, y)) {
+      out = BorderDistance(inside.zone, x, y) >= hysteresis;
+    }
+
+    if (out) {
+      events[count++] = { GeofenceEventType::Exit, inside.zone, static_cast<uint16_t>(target), time, inside.since };
+      continue;
+    }
+
+    if (!inside.dwell && _settings.dwellNS > 0 && time - inside.since >= _settings.dwellNS) {
+      inside.dwell = true;
+      events[count++] = { GeofenceEventType::Dwell, inside.zone, static_cast<uint16_t>(target), time, inside.since };
+    }
+
+    state.inside[kept++] = inside;
+  }
+
+  state.count = static_cast<uint8_t>(kept);
+
+  // Zones of the cell: enter when in by the hysteresis
+  if (x < _originX || y < _originY) {
+    return count;
+  }
+
+  uint32_t column { static_cast<uint32_t>((x - _originX) / _cellSize) };
+  uint32_t row { static_cast<uint32_t>((y - _originY) / _cellSize) };
+
+  if (column >= _columns || row >= _rows) {
+    return count;
+  }
+
+  size_t cell { static_cast<size_t>(row) * _columns + column };
+
+  _candidates += _cellStart[cell + 1] - _cellStart[cell];
+
+  for (uint32_t candidate = _cellStart[cell]; candidate < _cellStart[cell + 1]; candidate++) {
+    uint16_t              index { _cellZones[candidate] };
+    const GeofenceZone &  zone { _zones[index] };
+    bool                  known {};
+
+    if (x < zone.minX + hysteresis || x > zone.maxX - hysteresis ||
+        y < zone.minY + hysteresis || y > zone.maxY - hysteresis) {
+      continue;
+    }
+
+    for (size_t inside = 0; inside < state.count && !known; inside++) {
+      known = state.inside[inside].zone == index;
+    }
+
+    // Also a zone just left is entered again only by the hysteresis
+    for (size_t event = 0; event < count && !known; event++) {
+      known = events[event].zone == index && events[event].type == GeofenceEventType::Exit;
+    }
+
+    if (known || state.count >= GeofenceMaxInside || !InsidePolygon(index, x, y) ||
+        BorderDistance(index, x, y) < hysteresis) {
+      continue;
+    }
+
+    state.inside[state.count++] = { index, false, time };
+    events[count++] = { GeofenceEventType::Enter, index, static_cast<uint16_t>(target), time, time };
+  }
+
+  return count;
+}
+//-----------------------------------------------------------------------------
+bool Geofence::InsidePolygon(size_t zone, float x, float y) const {
+  // Function Variables
+  const GeofenceZone &  polygon { _zones[zone] };
+  const float *         px { _x.data() + polygon.first };
+  const float *         py { _y.data() + polygon.first };
+  bool                  inside {};
+
+  _tests++;
+
+  // Crossing number of a ray to the east
+  for (size_t current = 0, previous = polygon.count - 1; current < polygon.count; previous = current++) {
+    if ((py[current] > y) != (py[previous] > y) &&
+        x < (px[previous] - px[current]) * (y - py[current]) / (py[previous] - py[current]) + px[current]) {
+      inside = !inside;
+    }
+  }
+
+  return inside;
+}
+//-----------------------------------------------------------------------------
+float Geofence::BorderDistance(size_t zone, float x, float y) const {
+  // Function Variables
+  const GeofenceZone &  polygon { _zones[zone] };
+  const float *         px { _x.data() + polygon.first };
+  const float *         py { _y.data() + polygon.first };
+  float                 distance2 { std::numeric_limits<float>::max() };
+
+  for (size_t current = 0, previous = polygon.count - 1; current < polygon.count; previous = current++) {
+    distance2 = std::min(distance2, segment_distance2(x, y, px[previous], py[previous], px[current], py[current]));
+  }
+
+  return std::sqrt(distance2);
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
@@ -0,0 +1,272 @@
+/*
+ * nmea-pty.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <gps/nmea-pty.hpp>
+
+namespace Airsoft {
+
+// Longest wait for a chunk, to see a stop request
+constexpr uint32_t NmeaPtyPollMS = 50;
+
+constexpr double KnotsPerMeterPerSecond = 3600.0 / 1852.0;
+
+namespace {
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Latitude or longitude of a fix as ddmm.mmmmmm or dddmm.mmmmmm and its hemisphere, exact: a millionth
+ *        of minute is 6 units of 1e-7 degrees.
+ */
+int32_t format_coordinate(char * text, size_t size, int32_t value, int32_t degreeDigits, char positive,
+                          char negative) {
+  // Function Variables
+  int64_t micro { (value < 0 ? -static_cast<int64_t>(value) : value) * 6 };
+
+  return std::snprintf(text, size, "%0*lld%02lld.%06lld,%c", degreeDigits, static_cast<long long>(micro / 60000000),
+                       static_cast<long long>(micro / 1000000 % 60), static_cast<long long>(micro % 1000000),
+                       value < 0 ? negative : positive);
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+GpsNmeaPty::~GpsNmeaPty() {
+  Close();
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool GpsNmeaPty::Open(GpsStream & stream, const std::string & link) {
+  // Function Variables
+  termios options {};
+
+  Close();
+
+  // Pseudo terminal, raw: the sentences unchanged
+  if ((_master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC)) == -1) {
+    return false;
+  }
+
+  if (::grantpt(_master) != 0 || ::unlockpt(_master) != 0 || ::ptsname(_master) == nullptr) {
+    Close();
+    return false;
+  }
+
+  _port = ::ptsname(_master);
+
+  if ((_slave = ::open(_port.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC)) == -1) {
+    Close();
+    return false;
+  }
+
+  ::tcgetattr(_slave, &options);
+  ::cfmakeraw(&options);
+  ::tcsetattr(_slave, TCSANOW, &options);
+  ::fcntl(_master, F_SETFL, ::fcntl(_master, F_GETFL) | O_NONBLOCK);
+
+  // The link of a previous run points to a slave that doesn't exist anymore
+  if (!link.empty()) {
+    ::unlink(link.c_str());
+
+    if (::symlink(_port.c_str(), link.c_str()) != 0) {
+      Close();
+      return false;
+    }
+    _link = link;
+  }
+
+  if ((_subscription = stream.Subscribe()) == nullptr) {
+    Close();
+    return false;
+  }
+
+  _stream = &stream;
+  _parser.Reset();
+  _sentences = 0;
+  _dropped = 0;
+  _threadRunning = true;
+
+  if ((_process = new std::thread(&GpsNmeaPty::Engine, this)) == nullptr) {
+    Close();
+    return false;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void GpsNmeaPty::Close(void) {
+  if (_process != nullptr) {
+    _threadRunning = false;
+    _process->join();
+    delete _process;
+    _process = nullptr;
+  }
+
+  if (_subscription != nullptr) {
+    _stream->Unsubscribe(_subscription);
+    _subscription = nullptr;
+  }
+
+  if (!_link.empty()) {
+    ::unlink(_link.c_str());
+    _link.clear();
+  }
+
+  if (_slave != -1) {
+    ::close(_slave);
+    _slave = -1;
+  }
+
+  if (_master != -1) {
+    ::close(_master);
+    _master = -1;
+  }
+
+  _port.clear();
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void GpsNmeaPty::Send(const char * text, size_t length) {
+  // Function Variables
+  char    line[NmeaMaxSentence + 8];
+  uint8_t checksum {};
+
+  for (size_t index = 0; index < length; index++) {
+    checksum ^= static_cast<uint8_t>(text[index]);
+  }
+
+  line[0] = '$';
+  std::memcpy(line + 1, text, length);
+  std::snprintf(line + 1 + length, sizeof(line) - 1 - length, "*%02X\r\n", checksum);
+  length += 6;
+
+  // A sentence fits the buffer of the terminal whole or is not written
+  if (::write(_master, line, length) == static_cast<ssize_t>(length)) {
+    _sentences.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Sentences the reader is behind on are flushed, its next read starts on the recent ones
+  ::tcflush(_slave, TCIFLUSH);
+  _dropped.fetch_add(1, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------------
+void GpsNmeaPty::SendPosition(const GpsFix & fix) {
+  // Function Variables
+  char    time[16] {};
+  char    date[12] {};
+  char    latitude[24] { "," };
+  char    longitude[24] { "," };
+  char    hdop[8] {};
+  char    text[NmeaMaxSentence];
+  bool    position { fix.Has(FixHasPosition) && fix.quality != 0 };
+  int32_t length {};
+
+  if (fix.Has(FixHasTime)) {
+    std::snprintf(time, sizeof(time), "%02u%02u%02u.%02u", fix.hour, fix.minute, fix.second, fix.millisecond / 10);
+  }
+  if (fix.Has(FixHasDate)) {
+    std::snprintf(date, sizeof(date), "%02u%02u%02u", fix.day, fix.month, fix.year % 100);
+  }
+  if (position) {
+    format_coordinate(latitude, sizeof(latitude), fix.latitude, 2, 'N', 'S');
+    format_coordinate(longitude, sizeof(longitude), fix.longitude, 3, 'E', 'W');
+  }
+  // NAV-PVT has no HDOP, the GSA the receiver sends once per second does
+  if (_parser.GetFix().Has(FixHasDop)) {
+    std::snprintf(hdop, sizeof(hdop), "%.2f", _parser.GetFix().hdop);
+  }
+
+  length = std::snprintf(text, sizeof(text), "GNRMC,%s,%c,%s,%s,", time, position ? 'A' : 'V', latitude, longitude);
+  if (position) {
+    length += std::snprintf(text + length, sizeof(text) - length, "%.3f,%.2f", fix.speed * KnotsPerMeterPerSecond,
+                            fix.course);
+  } else {
+    length += std::snprintf(text + length, sizeof(text) - length, ",");
+  }
+  length += std::snprintf(text + length, sizeof(text) - length, ",%s,,,%c", date,
+                          !position ? 'N' : (fix.quality == 2 ? 'D' : 'A'));
+  Send(text, static_cast<size_t>(length));
+
+  length = std::snprintf(text, sizeof(text), "GNGGA,%s,%s,%s,%u,%02u,%s,", time, latitude, longitude, fix.quality,
+                         fix.satellitesUsed, hdop);
+  if (position) {
+    length += std::snprintf(text + length, sizeof(text) - length, "%.3f,M,%.3f,M,,", fix.altitude,
+                            fix.geoidSeparation);
+  } else {
+    length += std::snprintf(text + length, sizeof(text) - length, ",M,,M,,");
+  }
+  Send(text, static_cast<size_t>(length));
+}
+//-----------------------------------------------------------------------------
+void GpsNmeaPty::Drain(void) {
+  // Function Variables
+  uint8_t buffer[256];
+
+  while (::read(_master, buffer, sizeof(buffer)) > 0) {
+  }
+}
+//-----------------------------------------------------------------------------
+void GpsNmeaPty::Engine(void) {
+  // Thread Variables
+  GpsChunkRef chunk;
+  uint64_t    expected {};
+  bool        started {};
+
+  while (_threadRunning) {
+    Drain();
+
+    if (!_subscription->Receive(chunk, NmeaPtyPollMS)) {
+      continue;
+    }
+
+    // Chunks lost: the sentence in progress is not the one that continues
+    if (started && chunk.GetSequence() != expected) {
+      _parser.Reset();
+      _ubx.Reset();
+    }
+    expected = chunk.GetSequence() + 1;
+    started = true;
+
+    // Every sentence with a valid checksum, also the ones Gps rejects: the tools have their own rules
+    const uint8_t * data { chunk.GetData() };
+    size_t          length { chunk.GetLength() };
+
+    while (length > 0) {
+      // Up to the end of a UBX message, the sentences completed before it go first
+      size_t used { _ubx.Consume(data, length, chunk.GetArrival()) };
+
+      for (size_t offset = 0; offset < used;) {
+        offset += _parser.Consume(data + offset, used - offset, chunk.GetArrival());
+
+        if (_parser.IsChecksumValid()) {
+          Send(_parser.GetText(), _parser.GetTextLength());
+        }
+      }
+
+      // With UBX the receiver sends no position in NMEA, it is built as the tools expect it
+      if (_ubx.GetMessage() == UbxMessage::NavPvt) {
+        SendPosition(_ubx.GetFix());
+      }
+
+      data += used;
+      length -= used;
+    }
+    chunk.Release();
+  }
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
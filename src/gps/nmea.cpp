@@ -0,0 +1,694 @@
+/*
+ * nmea.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <cstring>
+#include <charconv>
+#include <algorithm>
+#include <gps/nmea.hpp>
+
+namespace Airsoft {
+
+// Powers of ten of the fixed point conversions
+constexpr int64_t Pow10[] { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+
+// Decimals kept converting the float fields
+constexpr uint32_t FloatDecimals = 6;
+
+// Unit conversions of the speeds
+constexpr float MetersPerSecondPerKnot = 1852.0f / 3600.0f;
+constexpr float MetersPerSecondPerKmh = 1000.0f / 3600.0f;
+
+namespace {
+
+// UTC time of a sentence
+struct UtcTime {
+  uint8_t   hour;
+  uint8_t   minute;
+  uint8_t   second;
+  uint16_t  millisecond;
+};
+
+//-----------------------------------------------------------------------------
+int32_t hex_digit(char digit) {
+  if (digit >= '0' && digit <= '9') {
+    return digit - '0';
+  }
+  if (digit >= 'A' && digit <= 'F') {
+    return digit - 'A' + 10;
+  }
+  if (digit >= 'a' && digit <= 'f') {
+    return digit - 'a' + 10;
+  }
+
+  return -1;
+}
+//-----------------------------------------------------------------------------
+bool parse_unsigned(const NmeaField & field, uint32_t & value) {
+  std::from_chars_result result { std::from_chars(field.begin, field.end, value) };
+
+  return !field.Empty() && result.ec == std::errc() && result.ptr == field.end;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Convert a decimal number to fixed point, value = number * 10^decimals. The decimals beyond
+ *        the requested ones are truncated.
+ */
+bool parse_fixed(const NmeaField & field, uint32_t decimals, int64_t & value) {
+  // Function Variables
+  const char *  begin { field.begin };
+  const char *  dot {};
+  bool          negative {};
+  uint64_t      integer {};
+
+  if (begin < field.end && (*begin == '-' || *begin == '+')) {
+    negative = *begin++ == '-';
+  }
+
+  dot = std::find(begin, field.end, '.');
+
+  // At least a digit, before or after the dot
+  if (begin == dot && (dot == field.end || dot + 1 == field.end)) {
+    return false;
+  }
+
+  if (begin != dot) {
+    std::from_chars_result result { std::from_chars(begin, dot, integer) };
+
+    if (result.ec != std::errc() || result.ptr != dot || integer > static_cast<uint64_t>(INT64_MAX / Pow10[decimals])) {
+      return false;
+    }
+  }
+
+  value = static_cast<int64_t>(integer);
+
+  for (const char * digit = (dot == field.end ? dot : dot + 1); digit < field.end; digit++) {
+    if (*digit < '0' || *digit > '9') {
+      return false;
+    }
+
+    if (decimals > 0) {
+      value = value * 10 + (*digit - '0');
+      decimals--;
+    }
+  }
+
+  value *= Pow10[decimals];
+
+  if (negative) {
+    value = -value;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool parse_float(const NmeaField & field, float & value) {
+  // Function Variables
+  int64_t fixed {};
+
+  if (!parse_fixed(field, FloatDecimals, fixed)) {
+    return false;
+  }
+
+  value = static_cast<float>(fixed) / static_cast<float>(Pow10[FloatDecimals]);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Convert a [d]ddmm.mmmm coordinate and its hemisphere to degrees * 1e7.
+ */
+bool parse_coordinate(const NmeaField & field, const NmeaField & hemisphere, int64_t limit, int32_t & value) {
+  // Function Variables
+  int64_t fixed {};
+  int64_t degrees {};
+  int64_t minutes {};
+
+  if (!parse_fixed(field, 7, fixed) || fixed < 0 || hemisphere.end - hemisphere.begin != 1) {
+    return false;
+  }
+
+  degrees = fixed / (100 * Pow10[7]);
+  minutes = fixed % (100 * Pow10[7]);
+
+  if (minutes >= 60 * Pow10[7]) {
+    return false;
+  }
+
+  // Minutes * 1e7 to degrees * 1e7, rounded
+  fixed = degrees * Pow10[7] + (minutes + 30) / 60;
+
+  if (fixed > limit) {
+    return false;
+  }
+
+  switch (*hemisphere.begin) {
+    case 'N':
+    case 'E':
+      value = static_cast<int32_t>(fixed);
+      return true;
+    case 'S':
+    case 'W':
+      value = -static_cast<int32_t>(fixed);
+      return true;
+  }
+
+  return false;
+}
+//-----------------------------------------------------------------------------
+bool parse_time(const NmeaField & field, UtcTime & time) {
+  // Function Variables
+  int64_t fixed {};
+
+  if (!parse_fixed(field, 3, fixed) || fixed < 0) {
+    return false;
+  }
+
+  time.millisecond = static_cast<uint16_t>(fixed % 1000);
+  fixed /= 1000;
+  time.second = static_cast<uint8_t>(fixed % 100);
+  time.minute = static_cast<uint8_t>(fixed / 100 % 100);
+  time.hour = static_cast<uint8_t>(fixed / 10000);
+
+  // 60 seconds is a leap second
+  return time.hour < 24 && time.minute < 60 && time.second <= 60;
+}
+//-----------------------------------------------------------------------------
+void store_time(GpsFix & fix, const UtcTime & time, bool present) {
+  if (!present) {
+    fix.valid &= ~FixHasTime;
+    return;
+  }
+
+  fix.hour = time.hour;
+  fix.minute = time.minute;
+  fix.second = time.second;
+  fix.millisecond = time.millisecond;
+  fix.valid |= FixHasTime;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Constellation of a GSA from its system ID (NMEA 4.10 and later).
+ */
+GpsSystem system_from_id(uint32_t id) {
+  switch (id) {
+    case 1:
+      return GpsSystem::Gps;
+    case 2:
+      return GpsSystem::Glonass;
+    case 3:
+      return GpsSystem::Galileo;
+    case 4:
+      return GpsSystem::Beidou;
+    case 5:
+      return GpsSystem::Qzss;
+  }
+
+  return GpsSystem::Unknown;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+size_t NmeaParser::Consume(const uint8_t * data, size_t length, int64_t timestamp) {
+  // Function Variables
+  size_t used {};
+
+  // Release the sentence returned by the previous call
+  _ready = NmeaSentence::None;
+  _valid = false;
+
+  while (used < length) {
+    char byte { static_cast<char>(data[used++]) };
+
+    // Start of a sentence, whatever the state
+    if (byte == '$') {
+      if (_state != State::Start) {
+        _checksumErrors++;                                // Truncated, the checksum never arrived
+      }
+
+      _state = State::Body;
+      _length = 0;
+      _checksum = 0;
+      _received = 0;
+      _digits = 0;
+      _arrival = timestamp;
+      continue;
+    }
+
+    switch (_state) {
+      case State::Start:
+        break;
+
+      case State::Body:
+        if (byte == '*') {
+          _state = State::Checksum;
+        } else if (byte == '\r' || byte == '\n') {
+          _checksumErrors++;                              // No checksum
+          _state = State::Start;
+        } else if (byte < ' ' || byte > '~') {
+          _state = State::Start;                          // Binary data, e.g. UBX messages on the same port
+        } else if (_length == NmeaMaxSentence) {
+          _overflows++;
+          _state = State::Start;
+        } else {
+          _text[_length++] = byte;
+          _checksum ^= static_cast<uint8_t>(byte);
+        }
+        break;
+
+      case State::Checksum: {
+        // Function Variables
+        int32_t nibble { hex_digit(byte) };
+
+        if (nibble < 0) {
+          _checksumErrors++;
+          _state = State::Start;
+          break;
+        }
+
+        _received = static_cast<uint8_t>(_received << 4 | nibble);
+
+        if (++_digits == 2) {
+          _state = State::Start;
+          Complete();
+
+          if (_valid) {
+            return used;
+          }
+        }
+        break;
+      }
+    }
+  }
+
+  return used;
+}
+//-----------------------------------------------------------------------------
+void NmeaParser::Reset(void) {
+  _fix = GpsFix {};
+  _ready = NmeaSentence::None;
+  _previous = NmeaSentence::None;
+  _valid = false;
+  _state = State::Start;
+  _length = 0;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void NmeaParser::Complete(void) {
+  if (_received != _checksum) {
+    _checksumErrors++;
+    return;
+  }
+
+  _valid = true;
+  _ready = Decode();
+}
+//-----------------------------------------------------------------------------
+NmeaSentence NmeaParser::Decode(void) {
+  // Function Variables
+  NmeaSentence  sentence { NmeaSentence::Other };
+  bool          decoded {};
+
+  Split();
+
+  // Address: talker and type, proprietary sentences start with P
+  NmeaField address { GetField(0) };
+
+  if (address.end - address.begin == 5 && *address.begin != 'P') {
+    const char * type { address.begin + 2 };
+
+    if (memcmp(type, "GGA", 3) == 0) {
+      sentence = NmeaSentence::Gga;
+      decoded = DecodeGga();
+    } else if (memcmp(type, "RMC", 3) == 0) {
+      sentence = NmeaSentence::Rmc;
+      decoded = DecodeRmc();
+    } else if (memcmp(type, "GSA", 3) == 0) {
+      sentence = NmeaSentence::Gsa;
+      decoded = DecodeGsa();
+    } else if (memcmp(type, "VTG", 3) == 0) {
+      sentence = NmeaSentence::Vtg;
+      decoded = DecodeVtg();
+    } else if (memcmp(type, "GSV", 3) == 0) {
+      sentence = NmeaSentence::Gsv;
+      decoded = DecodeGsv();
+    }
+  }
+
+  if (sentence == NmeaSentence::Other) {
+    _unknown++;
+    return sentence;
+  }
+
+  if (!decoded) {
+    _fieldErrors++;
+    return NmeaSentence::None;
+  }
+
+  _sentences++;
+  _previous = sentence;
+  _fix.arrival = _arrival;
+
+  return sentence;
+}
+//-----------------------------------------------------------------------------
+void NmeaParser::Split(void) {
+  // Function Variables
+  const char * begin { _text };
+  const char * end { _text + _length };
+
+  _fieldCount = 0;
+
+  while (_fieldCount < NmeaMaxFields) {
+    const char * comma { std::find(begin, end, ',') };
+
+    _fields[_fieldCount++] = NmeaField { begin, comma };
+
+    if (comma == end) {
+      break;
+    }
+    begin = comma + 1;
+  }
+}
+//-----------------------------------------------------------------------------
+GpsSystem NmeaParser::Talker(void) const {
+  // Function Variables
+  NmeaField address { GetField(0) };
+
+  switch (address.begin[1]) {
+    case 'P':
+      return GpsSystem::Gps;
+    case 'L':
+      return GpsSystem::Glonass;
+    case 'A':
+      return GpsSystem::Galileo;
+    case 'B':
+    case 'D':
+      return GpsSystem::Beidou;
+    case 'Q':
+      return GpsSystem::Qzss;
+  }
+
+  return GpsSystem::Unknown;
+}
+//-----------------------------------------------------------------------------
+bool NmeaParser::DecodeGga(void) {
+  // $--GGA,time,lat,N,lon,E,quality,satellites,hdop,altitude,M,separation,M,age,station
+  // Function Variables
+  UtcTime   time {};
+  int32_t   latitude {};
+  int32_t   longitude {};
+  uint32_t  quality {};
+  uint32_t  satellites {};
+  float     hdop {};
+  float     altitude {};
+  float     separation {};
+  bool      position {};
+
+  if (_fieldCount < 10 || !parse_unsigned(GetField(6), quality)) {
+    return false;
+  }
+
+  // Empty fields are legal while the receiver has no fix
+  if (!GetField(1).Empty() && !parse_time(GetField(1), time)) {
+    return false;
+  }
+  if (!GetField(7).Empty() && !parse_unsigned(GetField(7), satellites)) {
+    return false;
+  }
+  if (!GetField(8).Empty() && !parse_float(GetField(8), hdop)) {
+    return false;
+  }
+
+  position = quality > 0 && !GetField(2).Empty();
+
+  if (position) {
+    if (!parse_coordinate(GetField(2), GetField(3), 90 * Pow10[7], latitude) ||
+        !parse_coordinate(GetField(4), GetField(5), 180 * Pow10[7], longitude) ||
+        !parse_float(GetField(9), altitude)) {
+      return false;
+    }
+    if (!GetField(11).Empty() && !parse_float(GetField(11), separation)) {
+      return false;
+    }
+  }
+
+  // Store
+  store_time(_fix, time, !GetField(1).Empty());
+  _fix.quality = static_cast<uint8_t>(quality);
+  _fix.satellitesUsed = static_cast<uint8_t>(std::min<uint32_t>(satellites, UINT8_MAX));
+  _fix.hdop = hdop;
+
+  if (position) {
+    _fix.latitude = latitude;
+    _fix.longitude = longitude;
+    _fix.altitude = altitude;
+    _fix.geoidSeparation = separation;
+    _fix.valid |= FixHasPosition | FixHasAltitude;
+  } else {
+    _fix.valid &= ~(FixHasPosition | FixHasAltitude);
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool NmeaParser::DecodeRmc(void) {
+  // $--RMC,time,status,lat,N,lon,E,speed,course,date,variation,E,mode
+  // Function Variables
+  UtcTime   time {};
+  int32_t   latitude {};
+  int32_t   longitude {};
+  float     speed {};
+  float     course {};
+  uint32_t  date {};
+  bool      position {};
+
+  if (_fieldCount < 10) {
+    return false;
+  }
+
+  if (!GetField(1).Empty() && !parse_time(GetField(1), time)) {
+    return false;
+  }
+  if (!GetField(9).Empty() && (!parse_unsigned(GetField(9), date) || GetField(9).end - GetField(9).begin != 6)) {
+    return false;
+  }
+  if (!GetField(7).Empty() && !parse_float(GetField(7), speed)) {
+    return false;
+  }
+  if (!GetField(8).Empty() && !parse_float(GetField(8), course)) {
+    return false;
+  }
+
+  // A: valid, V: warning
+  position = GetField(2).end - GetField(2).begin == 1 && *GetField(2).begin == 'A';
+
+  if (position &&
+      (!parse_coordinate(GetField(3), GetField(4), 90 * Pow10[7], latitude) ||
+       !parse_coordinate(GetField(5), GetField(6), 180 * Pow10[7], longitude))) {
+    return false;
+  }
+
+  // Store
+  store_time(_fix, time, !GetField(1).Empty());
+
+  if (date > 0) {
+    _fix.day = static_cast<uint8_t>(date / 10000);
+    _fix.month = static_cast<uint8_t>(date / 100 % 100);
+    _fix.year = static_cast<uint16_t>(2000 + date % 100);
+    _fix.valid |= FixHasDate;
+  } else {
+    _fix.valid &= ~FixHasDate;
+  }
+
+  if (position) {
+    _fix.latitude = latitude;
+    _fix.longitude = longitude;
+    _fix.valid |= FixHasPosition;
+  } else {
+    _fix.valid &= ~FixHasPosition;
+  }
+
+  if (!GetField(7).Empty()) {
+    _fix.speed = speed * MetersPerSecondPerKnot;
+    _fix.valid |= FixHasSpeed;
+  } else {
+    _fix.valid &= ~FixHasSpeed;
+  }
+
+  // The course is empty while standing still
+  if (!GetField(8).Empty()) {
+    _fix.course = course;
+    _fix.valid |= FixHasCourse;
+  } else {
+    _fix.valid &= ~FixHasCourse;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool NmeaParser::DecodeGsa(void) {
+  // $--GSA,selection,mode,prn1,...,prn12,pdop,hdop,vdop[,system]
+  // Function Variables
+  uint32_t  mode {};
+  uint32_t  prn[12] {};
+  size_t    count {};
+  float     pdop {};
+  float     hdop {};
+  float     vdop {};
+  bool      dop {};
+  uint32_t  id {};
+  GpsSystem system { Talker() };
+
+  if (_fieldCount < 18 || !parse_unsigned(GetField(2), mode)) {
+    return false;
+  }
+
+  // The talker of a multi constellation receiver is GN, the system ID tells the constellation of the numbers
+  if (_fieldCount > 18 && !GetField(18).Empty()) {
+    if (!parse_unsigned(GetField(18), id)) {
+      return false;
+    }
+    system = system_from_id(id);
+  }
+
+  for (size_t index = 3; index < 15; index++) {
+    if (GetField(index).Empty()) {
+      continue;
+    }
+    if (!parse_unsigned(GetField(index), prn[count++])) {
+      return false;
+    }
+  }
+
+  dop = !GetField(15).Empty() && !GetField(16).Empty() && !GetField(17).Empty();
+
+  if (dop && (!parse_float(GetField(15), pdop) || !parse_float(GetField(16), hdop) || !parse_float(GetField(17), vdop))) {
+    return false;
+  }
+
+  // Store, a multi constellation receiver sends a GSA per system: a sequence of them lists all the satellites
+  if (_previous != NmeaSentence::Gsa) {
+    _fix.usedCount = 0;
+  }
+
+  for (size_t index = 0; index < count && _fix.usedCount < GpsMaxUsed; index++) {
+    _fix.usedSystem[_fix.usedCount] = system;
+    _fix.used[_fix.usedCount++] = static_cast<uint16_t>(prn[index]);
+  }
+
+  _fix.mode = static_cast<uint8_t>(mode);
+
+  if (dop) {
+    _fix.pdop = pdop;
+    _fix.hdop = hdop;
+    _fix.vdop = vdop;
+    _fix.valid |= FixHasDop;
+  } else {
+    _fix.valid &= ~FixHasDop;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool NmeaParser::DecodeVtg(void) {
+  // $--VTG,course,T,course,M,speed,N,speed,K[,mode]
+  // Function Variables
+  float course {};
+  float speed {};
+
+  if (_fieldCount < 9) {
+    return false;
+  }
+
+  if (!GetField(1).Empty() && !parse_float(GetField(1), course)) {
+    return false;
+  }
+  if (!GetField(7).Empty() && !parse_float(GetField(7), speed)) {
+    return false;
+  }
+
+  // Store
+  if (!GetField(1).Empty()) {
+    _fix.course = course;
+    _fix.valid |= FixHasCourse;
+  } else {
+    _fix.valid &= ~FixHasCourse;
+  }
+
+  if (!GetField(7).Empty()) {
+    _fix.speed = speed * MetersPerSecondPerKmh;
+    _fix.valid |= FixHasSpeed;
+  } else {
+    _fix.valid &= ~FixHasSpeed;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool NmeaParser::DecodeGsv(void) {
+  // $--GSV,messages,message,satellites,{prn,elevation,azimuth,snr}x1..4[,signal]
+  // Function Variables
+  uint32_t      messages {};
+  uint32_t      message {};
+  uint32_t      inView {};
+  GpsSatellite  satellites[4] {};
+  size_t        count {};
+
+  if (_fieldCount < 4 || !parse_unsigned(GetField(1), messages) || !parse_unsigned(GetField(2), message) ||
+      !parse_unsigned(GetField(3), inView) || message == 0 || message > messages) {
+    return false;
+  }
+
+  for (size_t index = 4; index + 3 < _fieldCount && count < 4; index += 4) {
+    // Function Variables
+    uint32_t prn {};
+    uint32_t elevation {};
+    uint32_t azimuth {};
+    uint32_t snr {};
+
+    if (GetField(index).Empty()) {
+      continue;
+    }
+
+    // Elevation and azimuth are empty while the almanac is unknown
+    if (!parse_unsigned(GetField(index), prn) ||
+        (!GetField(index + 1).Empty() && !parse_unsigned(GetField(index + 1), elevation)) ||
+        (!GetField(index + 2).Empty() && !parse_unsigned(GetField(index + 2), azimuth)) ||
+        (!GetField(index + 3).Empty() && !parse_unsigned(GetField(index + 3), snr)) ||
+        elevation > 90 || azimuth > 359 || snr > 99) {
+      return false;
+    }
+
+    satellites[count].prn = static_cast<uint16_t>(prn);
+    satellites[count].elevation = static_cast<int8_t>(elevation);
+    satellites[count].azimuth = static_cast<uint16_t>(azimuth);
+    satellites[count].snr = GetField(index + 3).Empty() ? -1 : static_cast<int8_t>(snr);
+    satellites[count].system = Talker();
+    count++;
+  }
+
+  // Store, a sequence of GSV, one or more constellations, replaces the satellites in view
+  if (_previous != NmeaSentence::Gsv) {
+    _fix.satelliteCount = 0;
+    _fix.valid &= ~FixHasSatellites;
+  }
+
+  for (size_t index = 0; index < count && _fix.satelliteCount < GpsMaxSatellites; index++) {
+    _fix.satellites[_fix.satelliteCount++] = satellites[index];
+  }
+
+  if (message == messages) {
+    _fix.valid |= FixHasSatellites;
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
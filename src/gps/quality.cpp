@@ -0,0 +1,282 @@
+/*
+ * quality.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <algorithm>
+
+#include <drivers/clock.hpp>
+#include <gps/quality.hpp>
+
+namespace Airsoft {
+
+// Weights of the components of the trust
+constexpr float QualitySatellitesWeight = 0.30f;
+constexpr float QualityGeometryWeight = 0.30f;
+constexpr float QualitySignalWeight = 0.25f;
+constexpr float QualityAccuracyWeight = 0.15f;
+
+constexpr float QualityFix2D = 0.7f;                      // A 2D fix, the altitude is assumed
+constexpr float QualityNoFix = 0.2f;                      // Highest trust with less than four satellites
+constexpr float QualityTrendPenalty = 0.25f;              // Per unit of DOP rising
+constexpr float QualityMaxTrendPenalty = 0.3f;
+constexpr float QualityFastDop = 0.5f;                    // Weight of an epoch in the recent DOP
+constexpr float QualitySlowDop = 1.0f / 32.0f;            // Weight of an epoch in the DOP of the last tens of epochs
+constexpr int32_t QualitySnrWeight = 4;                   // A sequence of GSV weighs 1/4 in the average of the SNR
+
+namespace {
+
+//-----------------------------------------------------------------------------
+float unit(float value) {
+  return std::clamp(value, 0.0f, 1.0f);
+}
+//-----------------------------------------------------------------------------
+float between(float value, float poor, float good) {
+  return unit((value - poor) / (good - poor));
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+void GpsQuality::Reset(void) {
+  std::fill(_table, _table + GpsQualitySlots, GpsSatelliteTrack {});
+  _previous = NmeaSentence::None;
+  _satellites = false;
+  _inView = _tracked = _used = _lowUsed = 0;
+  _meanSnr = 0.0f;
+  _started = false;
+  _trust = 0;
+  _hdop = _pdop = _hdopTrend = _pdopTrend = _hdopSlow = _pdopSlow = 0.0f;
+}
+//-----------------------------------------------------------------------------
+void GpsQuality::OnSentence(NmeaSentence sentence, const GpsFix & fix) {
+  // A sequence ends with the first sentence of another type, the parser has it whole
+  if (_previous == NmeaSentence::Gsv && sentence != NmeaSentence::Gsv) {
+    UpdateSatellites(fix);
+  } else if (_previous == NmeaSentence::Gsa && sentence != NmeaSentence::Gsa) {
+    UpdateUsed(fix);
+  }
+
+  _previous = sentence;
+}
+//-----------------------------------------------------------------------------
+uint8_t GpsQuality::Evaluate(GpsFix & fix) {
+  // Function Variables
+  bool    position { fix.Has(FixHasPosition) && fix.quality != 0 };
+  int32_t score {};
+
+  fix.valid |= FixHasTrust;
+
+  // The second sentence of the epoch
+  if (_started && fix.Has(FixHasTime) && fix.TimeOfDay() == _time) {
+    fix.trust = _trust;
+    return _trust;
+  }
+
+  _started = true;
+  _time = fix.TimeOfDay();
+
+  // Trend of the geometry while there is a solution, the DOP without it means nothing
+  if (!position) {
+    _hdopSlow = _pdopSlow = 0.0f;
+  } else if (fix.Has(FixHasDop) && fix.hdop > 0) {
+    if (_hdopSlow == 0.0f) {
+      _hdop = _hdopSlow = fix.hdop;
+      _pdop = _pdopSlow = fix.pdop;
+    }
+
+    _hdop += (fix.hdop - _hdop) * QualityFastDop;
+    _hdopSlow += (fix.hdop - _hdopSlow) * QualitySlowDop;
+    _pdop += (fix.pdop - _pdop) * QualityFastDop;
+    _pdopSlow += (fix.pdop - _pdopSlow) * QualitySlowDop;
+    _hdopTrend = _hdop - _hdopSlow;
+    _pdopTrend = _pdop - _pdopSlow;
+  }
+
+  score = position ? static_cast<int32_t>(Score(fix) * 100.0f + 0.5f) : 0;
+
+  // Down at once, up by an eighth of the difference
+  if (score <= _trust) {
+    _trust = static_cast<uint8_t>(score);
+  } else {
+    _trust = static_cast<uint8_t>(_trust + (score - _trust + 7) / 8);
+  }
+
+  fix.trust = _trust;
+
+  return _trust;
+}
+//-----------------------------------------------------------------------------
+int32_t GpsQuality::Slot(GpsSystem system, uint16_t prn) {
+  // Function Variables
+  int32_t slot { prn };
+
+  switch (system) {
+    case GpsSystem::Glonass:
+      slot = prn >= 1 && prn <= 32 ? prn + 64 : prn;
+      break;
+    case GpsSystem::Galileo:
+      slot = prn >= 1 && prn <= 36 ? prn + 210 : (prn >= 301 && prn <= 336 ? prn - 90 : prn);
+      break;
+    case GpsSystem::Beidou:
+      slot = prn >= 1 && prn <= 63 ? prn + 96 : (prn >= 401 && prn <= 463 ? prn - 304 : -1);
+      break;
+    case GpsSystem::Qzss:
+      slot = prn >= 1 && prn <= 10 ? prn + 192 : prn;
+      break;
+    default:
+      break;
+  }
+
+  return slot >= 1 && slot < static_cast<int32_t>(GpsQualitySlots) ? slot : -1;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void GpsQuality::UpdateSatellites(const GpsFix & fix) {
+  if (!fix.Has(FixHasSatellites)) {
+    return;
+  }
+
+  _round++;
+  _updated = fix.arrival;
+  _satellites = true;
+
+  for (size_t index = 0; index < fix.satelliteCount; index++) {
+    // Function Variables
+    const GpsSatellite  & satellite { fix.satellites[index] };
+    int32_t               slot { Slot(satellite.system, satellite.prn) };
+    int32_t               snr { std::max<int32_t>(satellite.snr, 0) << 4 };
+
+    if (slot < 0) {
+      continue;
+    }
+
+    GpsSatelliteTrack & track { _table[slot] };
+
+    // A satellite back in view starts from its signal, the others follow it
+    if ((track.state & SatelliteInView) == 0) {
+      track.average = static_cast<uint16_t>(snr);
+    } else {
+      track.average = static_cast<uint16_t>(track.average + (snr - track.average) / QualitySnrWeight);
+    }
+
+    track.snr = satellite.snr;
+    track.elevation = satellite.elevation;
+    track.state |= SatelliteInView;
+    track.round = _round;
+  }
+
+  // Set in the sequences before only
+  for (GpsSatelliteTrack & track : _table) {
+    if ((track.state & SatelliteInView) != 0 && track.round != _round) {
+      track.state &= static_cast<uint8_t>(~SatelliteInView);
+      track.snr = -1;
+      track.average = 0;
+    }
+  }
+
+  Summarize();
+}
+//-----------------------------------------------------------------------------
+void GpsQuality::UpdateUsed(const GpsFix & fix) {
+  for (GpsSatelliteTrack & track : _table) {
+    track.state &= static_cast<uint8_t>(~SatelliteUsed);
+  }
+
+  // The constellation from the talker or the system ID, without them the numbers are those of NMEA 4.0
+  for (size_t index = 0; index < fix.usedCount; index++) {
+    int32_t slot { Slot(fix.usedSystem[index], fix.used[index]) };
+
+    if (slot >= 0) {
+      _table[slot].state |= SatelliteUsed;
+    }
+  }
+
+  Summarize();
+}
+//-----------------------------------------------------------------------------
+void GpsQuality::Summarize(void) {
+  // Function Variables
+  uint32_t  inView {};
+  uint32_t  tracked {};
+  uint32_t  used {};
+  uint32_t  low {};
+  uint32_t  signal {};                                    // Of the used ones in view, dBHz * 16
+  uint32_t  signals {};
+
+  for (const GpsSatelliteTrack & track : _table) {
+    if ((track.state & SatelliteInView) != 0) {
+      inView++;
+      tracked += track.snr > 0;
+    }
+
+    if ((track.state & SatelliteUsed) != 0) {
+      used++;
+      low += track.elevation < _settings.minElevation;
+
+      if ((track.state & SatelliteInView) != 0) {
+        signal += track.average;
+        signals++;
+      }
+    }
+  }
+
+  _inView = static_cast<uint8_t>(inView);
+  _tracked = static_cast<uint8_t>(tracked);
+  _used = static_cast<uint8_t>(used);
+  _lowUsed = static_cast<uint8_t>(low);
+  _meanSnr = signals > 0 ? signal / (16.0f * signals) : 0.0f;
+}
+//-----------------------------------------------------------------------------
+float GpsQuality::Score(const GpsFix & fix) const {
+  // Function Variables
+  float   sum {};
+  float   weights {};
+  float   score {};
+  float   trend { std::max(_hdopTrend, _pdopTrend) };
+  uint8_t used { _used > 0 ? _used : fix.satellitesUsed };
+  bool    fresh { _satellites && fix.arrival - _updated <=
+                  static_cast<int64_t>(_settings.staleMS) * Airsoft::Drivers::NanosecondsPerMillisecond };
+
+  sum += QualitySatellitesWeight * unit((used - 3) / 6.0f);
+  weights += QualitySatellitesWeight;
+
+  if (fix.Has(FixHasDop) && fix.hdop > 0) {
+    sum += QualityGeometryWeight * between(fix.hdop, _settings.poorHdop, _settings.goodHdop);
+    weights += QualityGeometryWeight;
+  }
+
+  // Low satellites count half, their signal is often a reflection
+  if (fresh && _used > 0 && _meanSnr > 0) {
+    sum += QualitySignalWeight * between(_meanSnr, _settings.poorSnr, _settings.goodSnr) *
+           (1.0f - 0.5f * _lowUsed / _used);
+    weights += QualitySignalWeight;
+  }
+
+  if (fix.Has(FixHasAccuracy) && fix.horizontalAccuracy > 0) {
+    sum += QualityAccuracyWeight * between(fix.horizontalAccuracy, _settings.poorAccuracy, _settings.goodAccuracy);
+    weights += QualityAccuracyWeight;
+  }
+
+  score = sum / weights;
+
+  if (fix.mode == 2) {
+    score *= QualityFix2D;
+  }
+
+  if (trend > 0) {
+    score -= std::min(trend * QualityTrendPenalty, QualityMaxTrendPenalty);
+  }
+
+  if (used < 4) {
+    score = std::min(score, QualityNoFix);
+  }
+
+  return unit(score);
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
@@ -0,0 +1,312 @@
+/*
+ * replay.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <drivers/clock.hpp>
+#include <gps/nmea.hpp>
+#include <gps/ubx.hpp>
+#include <gps/replay.hpp>
+
+namespace Airsoft {
+
+// Longest wait in a single poll, to see a stop request
+constexpr int64_t ReplayPollNS = 50 * Airsoft::Drivers::NanosecondsPerMillisecond;
+constexpr int64_t MillisecondsPerDay = 86400000;
+
+namespace {
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Speed of the URI: "max" or a number not negative, nothing else.
+ */
+bool parse_speed(const std::string & value, double & speed) {
+  // Function Variables
+  char * end {};
+
+  if (value == "max") {
+    speed = 0.0;
+    return true;
+  }
+
+  // strtod skips spaces and takes "nan" and "inf", the value has to be digits
+  if (value.empty() || (!std::isdigit(static_cast<unsigned char>(value[0])) && value[0] != '.')) {
+    return false;
+  }
+
+  speed = std::strtod(value.c_str(), &end);
+
+  return end == value.c_str() + value.size() && std::isfinite(speed);
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+GpsReplay::~GpsReplay() {
+  Close();
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool GpsReplay::IsReplay(const std::string & port) {
+  return port.compare(0, std::strlen(GpsReplayScheme), GpsReplayScheme) == 0;
+}
+//-----------------------------------------------------------------------------
+bool GpsReplay::Open(const std::string & uri) {
+  // Function Variables
+  std::string path;
+  std::string query;
+  size_t      separator {};
+  termios     options {};
+
+  Close();
+
+  if (!IsReplay(uri)) {
+    return false;
+  }
+
+  path = uri.substr(std::strlen(GpsReplayScheme));
+  _speed = 1.0;
+
+  // Options after the path
+  if ((separator = path.find('?')) != std::string::npos) {
+    query = path.substr(separator + 1);
+    path.resize(separator);
+  }
+
+  if (query.compare(0, 6, "speed=") == 0) {
+    // A typo is an error, not the fastest replay
+    if (!parse_speed(query.substr(6), _speed)) {
+      return false;
+    }
+  } else if (!query.empty()) {
+    return false;
+  }
+
+  if (!Load(path)) {
+    return false;
+  }
+
+  // Pseudo terminal, raw on both sides: the bytes of the log unchanged
+  if ((_master = ::posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC)) == -1) {
+    return false;
+  }
+
+  if (::grantpt(_master) != 0 || ::unlockpt(_master) != 0 || ::ptsname(_master) == nullptr) {
+    Close();
+    return false;
+  }
+
+  _port = ::ptsname(_master);
+
+  if ((_slave = ::open(_port.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC)) == -1) {
+    Close();
+    return false;
+  }
+
+  ::tcgetattr(_slave, &options);
+  ::cfmakeraw(&options);
+  ::tcsetattr(_slave, TCSANOW, &options);
+  ::fcntl(_master, F_SETFL, ::fcntl(_master, F_GETFL) | O_NONBLOCK);
+
+  _played = 0;
+  _finished = false;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool GpsReplay::Start(void) {
+  if (!IsOpen() || _process != nullptr) {
+    return false;
+  }
+
+  _threadRunning = true;
+
+  return (_process = new std::thread(&GpsReplay::Engine, this)) != nullptr;
+}
+//-----------------------------------------------------------------------------
+void GpsReplay::Close(void) {
+  if (_process != nullptr) {
+    _threadRunning = false;
+    _process->join();
+    delete _process;
+    _process = nullptr;
+  }
+
+  if (_slave != -1) {
+    ::close(_slave);
+    _slave = -1;
+  }
+
+  if (_master != -1) {
+    ::close(_master);
+    _master = -1;
+  }
+
+  _port.clear();
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool GpsReplay::Load(const std::string & path) {
+  // Function Variables
+  std::ifstream     file(path, std::ios::binary);
+  std::stringstream content;
+  const uint8_t   * data {};
+  size_t            start {};                             // First byte of the last message seen
+  uint32_t          time {};                              // Of the last epoch
+  int64_t           offset {};
+  UbxParser         ubx;
+  NmeaParser        nmea;
+
+  if (!file) {
+    return false;
+  }
+
+  content << file.rdbuf();
+  _log = content.str();
+  _epochs.clear();
+  data = reinterpret_cast<const uint8_t*>(_log.data());
+
+  // UBX if it holds positions in NAV-PVT, the sentences along with them are played as they are
+  _ubx = false;
+  ubx.Feed(data, _log.size(), 0, [&](UbxMessage message) {
+    _ubx = _ubx || message == UbxMessage::NavPvt;
+  });
+  ubx.Reset();
+
+  // A new epoch starts with the first message of a new time, byte by byte to know where the message starts
+  auto epoch = [&](const GpsFix & fix) {
+    if (!fix.Has(FixHasTime)) {
+      return;
+    }
+
+    if (_epochs.empty()) {
+      _epochs.push_back({ 0, 0 });
+    } else if (fix.TimeOfDay() != time) {
+      int64_t elapsed { static_cast<int64_t>(fix.TimeOfDay()) - time };
+
+      // Across midnight
+      offset += elapsed < 0 ? elapsed + MillisecondsPerDay : elapsed;
+      _epochs.push_back({ start, offset });
+    }
+    time = fix.TimeOfDay();
+  };
+
+  for (size_t index = 0; index < _log.size(); index++) {
+    if (_ubx) {
+      ubx.Feed(data + index, 1, 0, [&](UbxMessage message) {
+        if (message == UbxMessage::NavPvt) {
+          start = index + 1 - UbxOverhead - ubx.GetPayloadLength();
+          epoch(ubx.GetFix());
+        }
+      });
+    } else {
+      if (data[index] == '$') {
+        start = index;
+      }
+
+      nmea.Feed(data + index, 1, 0, [&](NmeaSentence sentence) {
+        if (sentence == NmeaSentence::Rmc || sentence == NmeaSentence::Gga) {
+          epoch(nmea.GetFix());
+        }
+      });
+    }
+  }
+
+  return !_epochs.empty();
+}
+//-----------------------------------------------------------------------------
+bool GpsReplay::Write(const uint8_t * data, size_t length) {
+  while (length > 0 && _threadRunning) {
+    pollfd  fd { _master, POLLOUT | POLLIN, 0 };
+    ssize_t written {};
+
+    if (::poll(&fd, 1, static_cast<int>(ReplayPollNS / Airsoft::Drivers::NanosecondsPerMillisecond)) <= 0) {
+      continue;
+    }
+
+    if (fd.revents & POLLIN) {
+      Drain();
+    }
+
+    if ((fd.revents & POLLOUT) && (written = ::write(_master, data, length)) > 0) {
+      data += written;
+      length -= static_cast<size_t>(written);
+    }
+  }
+
+  return length == 0;
+}
+//-----------------------------------------------------------------------------
+void GpsReplay::Wait(int64_t until) {
+  // Function Variables
+  const Airsoft::Drivers::Clock & clock { Airsoft::Drivers::Clock::Monotonic() };
+  int64_t                         remaining {};
+
+  while (_threadRunning && (remaining = until - clock.Now()) > 0) {
+    pollfd    fd { _master, POLLIN, 0 };
+    timespec  timeout {};
+
+    remaining = std::min(remaining, ReplayPollNS);
+    timeout.tv_sec = remaining / Airsoft::Drivers::NanosecondsPerSecond;
+    timeout.tv_nsec = remaining % Airsoft::Drivers::NanosecondsPerSecond;
+
+    if (::ppoll(&fd, 1, &timeout, nullptr) > 0 && (fd.revents & POLLIN)) {
+      Drain();
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+void GpsReplay::Drain(void) {
+  // Function Variables
+  uint8_t buffer[256];
+
+  while (::read(_master, buffer, sizeof(buffer)) > 0) {
+  }
+}
+//-----------------------------------------------------------------------------
+void GpsReplay::Engine(void) {
+  // Thread Variables
+  const Airsoft::Drivers::Clock & clock { Airsoft::Drivers::Clock::Monotonic() };
+  const uint8_t                 * data { reinterpret_cast<const uint8_t*>(_log.data()) };
+  int64_t                         start { clock.Now() };
+
+  for (size_t index = 0; index < _epochs.size() && _threadRunning; index++) {
+    size_t end { index + 1 < _epochs.size() ? _epochs[index + 1].begin : _log.size() };
+
+    if (_speed > 0) {
+      Wait(start + static_cast<int64_t>(_epochs[index].offset * Airsoft::Drivers::NanosecondsPerMillisecond / _speed));
+    }
+
+    if (!Write(data + _epochs[index].begin, end - _epochs[index].begin)) {
+      break;
+    }
+
+    _played.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  _finished.store(true, std::memory_order_release);
+
+  // The port stays open: what Gps writes is still read
+  while (_threadRunning) {
+    Wait(clock.Now() + ReplayPollNS);
+  }
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
@@ -0,0 +1,155 @@
+/*
+ * state.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstdio>
+#include <gps/state.hpp>
+
+namespace Airsoft {
+
+namespace {
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Days since 1970-01-01 of a date of the proleptic Gregorian calendar.
+ */
+int64_t days_from_civil(int64_t year, uint32_t month, uint32_t day) {
+  year -= month <= 2;
+
+  int64_t   era { (year >= 0 ? year : year - 399) / 400 };
+  uint32_t  yoe { static_cast<uint32_t>(year - era * 400) };
+  uint32_t  doy { (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1 };
+  uint32_t  doe { yoe * 365 + yoe / 4 - yoe / 100 + doy };
+
+  return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+//-----------------------------------------------------------------------------
+bool write_all(int32_t fd, const uint8_t * data, size_t length) {
+  while (length > 0) {
+    ssize_t written { ::write(fd, data, length) };
+
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (written < 0) {
+      return false;
+    }
+
+    data += written;
+    length -= static_cast<size_t>(written);
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+/**
+ * @brief Sync the directory of a file: a rename is on the storage only with its directory.
+ */
+bool sync_directory(const std::string & path) {
+  // Function Variables
+  size_t      slash { path.rfind('/') };
+  std::string directory { slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash)) };
+  int32_t     fd { ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+  bool        synced {};
+
+  if (fd == -1) {
+    return false;
+  }
+
+  synced = ::fsync(fd) == 0;
+  ::close(fd);
+
+  return synced;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+int64_t GpsFixToUtc(const GpsFix & fix) {
+  if (!fix.Has(FixHasDate | FixHasTime) || fix.month < 1 || fix.month > 12 || fix.day < 1 || fix.day > 31) {
+    return 0;
+  }
+
+  return days_from_civil(fix.year, fix.month, fix.day) * 86400000 + fix.TimeOfDay();
+}
+//-----------------------------------------------------------------------------
+bool GpsStateFile::Load(GpsState & state) const {
+  // Function Variables
+  GpsState  loaded;
+  int32_t   fd { -1 };
+  ssize_t   length {};
+
+  if (!IsEnabled() || (fd = ::open(_path.c_str(), O_RDONLY | O_CLOEXEC)) == -1) {
+    return false;
+  }
+
+  length = ::read(fd, &loaded, sizeof(loaded));
+  ::close(fd);
+
+  if (length != static_cast<ssize_t>(sizeof(loaded)) || loaded.magic != GpsStateMagic ||
+      loaded.version != GpsStateVersion || loaded.size != sizeof(GpsState) || loaded.checksum != Checksum(loaded)) {
+    return false;
+  }
+
+  state = loaded;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool GpsStateFile::Save(const GpsState & state) const {
+  // Function Variables
+  GpsState    saved { state };
+  std::string temporary { _path + ".tmp" };
+  int32_t     fd { -1 };
+  bool        written {};
+
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  saved.magic = GpsStateMagic;
+  saved.version = GpsStateVersion;
+  saved.size = sizeof(GpsState);
+  saved.checksum = Checksum(saved);
+
+  if ((fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1) {
+    return false;
+  }
+
+  written = write_all(fd, reinterpret_cast<const uint8_t*>(&saved), sizeof(saved)) && ::fsync(fd) == 0;
+  ::close(fd);
+
+  // The rename replaces the old state only with a complete file
+  if (!written || ::rename(temporary.c_str(), _path.c_str()) != 0) {
+    ::unlink(temporary.c_str());
+    return false;
+  }
+
+  return sync_directory(_path);
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+uint32_t GpsStateFile::Checksum(const GpsState & state) {
+  // Function Variables
+  const uint8_t * data { reinterpret_cast<const uint8_t*>(&state) };
+  uint32_t        sum1 { 0xFFFF };
+  uint32_t        sum2 { 0xFFFF };
+
+  for (size_t index = 0; index < offsetof(GpsState, checksum); index++) {
+    sum1 = (sum1 + data[index]) % 0xFFFF;
+    sum2 = (sum2 + sum1) % 0xFFFF;
+  }
+
+  return sum2 << 16 | sum1;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
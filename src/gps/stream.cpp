@@ -0,0 +1,262 @@
+/*
+ * stream.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <thread>
+
+#include <drivers/clock.hpp>
+#include <gps/stream.hpp>
+
+namespace Airsoft {
+
+static_assert((GpsSubscriptionCapacity & (GpsSubscriptionCapacity - 1)) == 0, "Capacity must be a power of two");
+
+//-----------------------------------------------------------------------------
+GpsSubscription::~GpsSubscription() {
+  if (_event != -1) {
+    ::close(_event);
+  }
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool GpsSubscription::TryReceive(GpsChunkRef & chunk) {
+  // Either Close sees the consumer in here and waits, or the consumer sees it closing and takes nothing
+  _consuming.fetch_add(1, std::memory_order_seq_cst);
+
+  // Function Variables
+  bool received { !_closing.load(std::memory_order_seq_cst) && Pop(chunk) };
+
+  _consuming.fetch_sub(1, std::memory_order_release);
+
+  return received;
+}
+//-----------------------------------------------------------------------------
+bool GpsSubscription::Receive(GpsChunkRef & chunk, uint32_t timeoutMS) {
+  // Function Variables
+  const Airsoft::Drivers::Clock & clock { Airsoft::Drivers::Clock::Monotonic() };
+  Airsoft::Drivers::Deadline      deadline { Airsoft::Drivers::Deadline::FromMilliseconds(timeoutMS, clock) };
+
+  while (!TryReceive(chunk)) {
+    pollfd    fd { _event, POLLIN, 0 };
+
+    if (_closing.load(std::memory_order_relaxed)) {
+      return false;
+    }
+
+    timespec  timeout { deadline.RemainingTimespec() };
+    uint64_t  events {};
+
+    // Either the producer sees the flag or the check below sees the chunk
+    _waiting.store(true, std::memory_order_seq_cst);
+
+    if (TryReceive(chunk)) {
+      _waiting.store(false, std::memory_order_relaxed);
+      return true;
+    }
+
+    if (::ppoll(&fd, 1, &timeout, nullptr) > 0) {
+      ::read(_event, &events, sizeof(events));
+    }
+
+    _waiting.store(false, std::memory_order_relaxed);
+
+    if (deadline.Expired()) {
+      return TryReceive(chunk);
+    }
+  }
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool GpsSubscription::Open(void) {
+  // Function Variables
+  uint64_t events {};
+
+  if (_event == -1) {
+    _event = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  } else {
+    // The wake up of the previous Close
+    ::read(_event, &events, sizeof(events));
+  }
+
+  _received = 0;
+  _dropped = 0;
+  _closing = false;
+
+  return _event != -1;
+}
+//-----------------------------------------------------------------------------
+bool GpsSubscription::Pop(GpsChunkRef & chunk) {
+  // Function Variables
+  uint32_t tail { _tail.load(std::memory_order_relaxed) };
+
+  if (tail == _head.load(std::memory_order_acquire)) {
+    return false;
+  }
+
+  chunk = GpsChunkRef(_ring[tail % GpsSubscriptionCapacity]);
+  _tail.store(tail + 1, std::memory_order_release);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void GpsSubscription::Push(GpsChunk * chunk) {
+  // Function Variables
+  uint32_t head { _head.load(std::memory_order_relaxed) };
+  uint64_t event { 1 };
+
+  if (head - _tail.load(std::memory_order_acquire) == GpsSubscriptionCapacity) {
+    Drop();
+    return;
+  }
+
+  chunk->references.fetch_add(1, std::memory_order_relaxed);
+  _ring[head % GpsSubscriptionCapacity] = chunk;
+  _head.store(head + 1, std::memory_order_seq_cst);
+  _received.fetch_add(1, std::memory_order_relaxed);
+
+  // A system call only when the consumer sleeps
+  if (_waiting.load(std::memory_order_seq_cst)) {
+    ::write(_event, &event, sizeof(event));
+  }
+}
+//-----------------------------------------------------------------------------
+void GpsSubscription::Close(void) {
+  // Function Variables
+  GpsChunkRef chunk;
+  uint64_t    event { 1 };
+
+  _closing.store(true, std::memory_order_seq_cst);
+
+  // A consumer waiting for a chunk returns, one taking a chunk is let out: the queue has no consumer after
+  ::write(_event, &event, sizeof(event));
+
+  while (_consuming.load(std::memory_order_seq_cst) != 0) {
+    std::this_thread::yield();
+  }
+
+  while (Pop(chunk)) {
+    chunk.Release();
+  }
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+GpsStream::~GpsStream() {
+  for (GpsSubscription & subscription : _subscriptions) {
+    if (subscription._used) {
+      Unsubscribe(&subscription);
+    }
+  }
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+GpsChunk * GpsStream::Acquire(void) {
+  // A free chunk stays free until it is published, only the releases run on other threads
+  for (size_t count = 0; count < GpsStreamPoolSize; count++) {
+    GpsChunk * chunk { &_pool[_next] };
+
+    _next = _next + 1 < GpsStreamPoolSize ? _next + 1 : 0;
+
+    if (chunk->references.load(std::memory_order_acquire) == 0) {
+      return chunk;
+    }
+  }
+
+  return &_spare;
+}
+//-----------------------------------------------------------------------------
+void GpsStream::Publish(GpsChunk * chunk) {
+  chunk->sequence = _sequence.load(std::memory_order_relaxed);
+
+  // Held by the publication, a subscriber releasing it meanwhile doesn't free it
+  if (chunk != &_spare) {
+    chunk->references.store(1, std::memory_order_relaxed);
+  }
+
+  // Unsubscribe waits for the end of a publication that may have seen the subscription active
+  _publishing.fetch_add(1, std::memory_order_seq_cst);
+
+  for (GpsSubscription & subscription : _subscriptions) {
+    if (!subscription._active.load(std::memory_order_seq_cst)) {
+      continue;
+    }
+
+    if (chunk == &_spare) {
+      subscription.Drop();
+    } else {
+      subscription.Push(chunk);
+    }
+  }
+
+  _publishing.fetch_add(1, std::memory_order_seq_cst);
+
+  if (chunk == &_spare) {
+    _exhausted.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    chunk->references.fetch_sub(1, std::memory_order_release);
+  }
+
+  _bytes.fetch_add(chunk->length, std::memory_order_relaxed);
+  _sequence.store(chunk->sequence + 1, std::memory_order_relaxed);
+}
+//-----------------------------------------------------------------------------
+GpsSubscription * GpsStream::Subscribe(void) {
+  for (GpsSubscription & subscription : _subscriptions) {
+    if (subscription._used.exchange(true)) {
+      continue;
+    }
+
+    if (!subscription.Open()) {
+      subscription._used = false;
+      return nullptr;
+    }
+
+    subscription._active.store(true, std::memory_order_seq_cst);
+    return &subscription;
+  }
+
+  return nullptr;
+}
+//-----------------------------------------------------------------------------
+void GpsStream::Unsubscribe(GpsSubscription * subscription) {
+  if (subscription == nullptr || !subscription->_used) {
+    return;
+  }
+
+  subscription->_active.store(false, std::memory_order_seq_cst);
+
+  // Function Variables
+  uint64_t publishing { _publishing.load(std::memory_order_seq_cst) };
+
+  // A publication started before may still be queueing to it
+  while ((publishing & 1) != 0 && _publishing.load(std::memory_order_seq_cst) == publishing) {
+    std::this_thread::yield();
+  }
+
+  subscription->Close();
+  subscription->_used = false;
+}
+//-----------------------------------------------------------------------------
+size_t GpsStream::GetInUse(void) const {
+  // Function Variables
+  size_t count {};
+
+  for (const GpsChunk & chunk : _pool) {
+    count += chunk.references.load(std::memory_order_relaxed) != 0;
+  }
+
+  return count;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
@@ -0,0 +1,407 @@
+/*
+ * track-log.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include <gps/state.hpp>
+#include <gps/track-log.hpp>
+
+namespace Airsoft {
+
+namespace {
+
+//-----------------------------------------------------------------------------
+uint64_t zigzag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+//-----------------------------------------------------------------------------
+int64_t unzigzag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+//-----------------------------------------------------------------------------
+size_t put_varint(uint8_t * out, uint64_t value) {
+  // Function Variables
+  size_t length {};
+
+  while (value >= 0x80) {
+    out[length++] = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  out[length++] = static_cast<uint8_t>(value);
+
+  return length;
+}
+//-----------------------------------------------------------------------------
+bool get_varint(const uint8_t * data, size_t end, size_t & position, uint64_t & value) {
+  value = 0;
+
+  for (uint32_t shift = 0; shift < 64 && position < end; shift += 7) {
+    uint8_t byte { data[position++] };
+
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+TrackLog::~TrackLog() {
+  Close();
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+bool TrackLog::Open(const std::string & path, size_t size) {
+  // Function Variables
+  struct stat status {};
+  Header      header {};
+
+  Close();
+
+  size -= size % TrackLogBlockSize;
+  if (path.empty() || size < TrackLogMinSize) {
+    return false;
+  }
+
+  if ((_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)) == -1) {
+    return false;
+  }
+
+  // A file of another size is started again, the blocks are zeros
+  if (::fstat(_fd, &status) != 0 ||
+      (static_cast<size_t>(status.st_size) != size && (::ftruncate(_fd, 0) != 0 || ::ftruncate(_fd, size) != 0))) {
+    Close();
+    return false;
+  }
+
+  if ((_map = static_cast<uint8_t*>(::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0))) == MAP_FAILED) {
+    _map = nullptr;
+    Close();
+    return false;
+  }
+
+  _size = size;
+  _blocks = static_cast<uint32_t>(size / TrackLogBlockSize - 1);
+  _started = false;
+  _points = 0;
+  _bytes = 0;
+
+  std::memcpy(&header, _map, sizeof(header));
+
+  if (header.magic == TrackLogMagic && header.version == TrackLogVersion && header.size == sizeof(Header) &&
+      header.blockSize == TrackLogBlockSize && header.blocks == _blocks && header.checksum == Checksum(header)) {
+    if (Resume()) {
+      return true;
+    }
+  }
+
+  // New log: the header is on disk before the first block is used
+  std::memset(_map, 0, _size);
+
+  header.magic = TrackLogMagic;
+  header.version = TrackLogVersion;
+  header.size = sizeof(Header);
+  header.blockSize = TrackLogBlockSize;
+  header.blocks = _blocks;
+  header.checksum = Checksum(header);
+  std::memcpy(_map, &header, sizeof(header));
+
+  if (::msync(_map, TrackLogBlockSize, MS_SYNC) != 0) {
+    Close();
+    return false;
+  }
+
+  StartBlock(0);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+void TrackLog::Close(void) {
+  if (_map != nullptr) {
+    ::msync(_map, _size, MS_SYNC);
+    ::munmap(_map, _size);
+    _map = nullptr;
+  }
+
+  if (_fd != -1) {
+    ::close(_fd);
+    _fd = -1;
+  }
+
+  _block = nullptr;
+  _size = 0;
+}
+//-----------------------------------------------------------------------------
+bool TrackLog::Append(const TrackPoint & point) {
+  // Function Variables
+  uint8_t record[MaxRecord];
+  size_t  length {};
+  bool    keyframe {};
+
+  if (!IsOpen() || (_started && point.utc <= _last.utc)) {
+    return false;
+  }
+
+  if (_position == TrackLogBlockSize) {
+    StartBlock(_sequence + 1);
+  }
+
+  keyframe = !_started || _position == sizeof(BlockHeader) || _sinceKeyframe >= TrackLogKeyframeInterval;
+  length = Encode(point, keyframe, record);
+
+  // Records don't cross sectors: the rest of the sector is skipped, a new block starts with a keyframe
+  if (_position % TrackLogSectorSize + 1 + length > TrackLogSectorSize) {
+    _block[_position] = LapTag(TagPad, _sequence, _blocks);
+    _position += TrackLogSectorSize - _position % TrackLogSectorSize;
+
+    if (_position == TrackLogBlockSize) {
+      StartBlock(_sequence + 1);
+      keyframe = true;
+      length = Encode(point, keyframe, record);
+    }
+  }
+
+  // The fields first, the tag after them, as seen from the other cores too: a record is read only once complete
+  std::memcpy(_block + _position + 1, record, length);
+  std::atomic_thread_fence(std::memory_order_release);
+  _block[_position] = LapTag(keyframe ? TagKeyframe : TagDelta, _sequence, _blocks);
+
+  _interval = keyframe ? 0 : point.utc - _last.utc;
+  _sinceKeyframe = keyframe ? 0 : _sinceKeyframe + 1;
+  _position += 1 + length;
+  _last = point;
+  _started = true;
+  _points++;
+  _bytes += 1 + length;
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+bool TrackLog::Append(const GpsFix & fix) {
+  // Function Variables
+  TrackPoint point {};
+
+  if (!fix.Has(FixHasPosition) || fix.quality == 0 || (point.utc = GpsFixToUtc(fix)) == 0) {
+    return false;
+  }
+
+  point.latitude = fix.latitude;
+  point.longitude = fix.longitude;
+  // Without altitude the last one, not a jump to zero
+  point.altitude = fix.Has(FixHasAltitude) ? static_cast<int32_t>(std::lround(fix.altitude * 10)) : _last.altitude;
+
+  return Append(point);
+}
+//-----------------------------------------------------------------------------
+void TrackLog::Flush(void) {
+  if (IsOpen()) {
+    ::msync(_map, _size, MS_ASYNC);
+  }
+}
+//-----------------------------------------------------------------------------
+int64_t TrackLog::Read(const std::string & path, const std::function<void(const TrackPoint &)> & handler) {
+  // Function Variables
+  struct stat                                 status {};
+  Header                                      header {};
+  int32_t                                     fd { -1 };
+  const uint8_t                             * map {};
+  std::vector<std::pair<uint32_t, uint32_t>>  valid;      // Sequence and index of the valid blocks
+  int64_t                                     points {};
+
+  if ((fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC)) == -1) {
+    return -1;
+  }
+
+  if (::fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < TrackLogMinSize ||
+      (map = static_cast<const uint8_t*>(::mmap(nullptr, status.st_size, PROT_READ, MAP_SHARED, fd, 0))) ==
+      MAP_FAILED) {
+    ::close(fd);
+    return -1;
+  }
+  ::close(fd);
+
+  std::memcpy(&header, map, sizeof(header));
+
+  if (header.magic != TrackLogMagic || header.version != TrackLogVersion || header.size != sizeof(Header) ||
+      header.blockSize != TrackLogBlockSize || header.checksum != Checksum(header) || header.blocks == 0 ||
+      (static_cast<size_t>(header.blocks) + 1) * TrackLogBlockSize > static_cast<size_t>(status.st_size)) {
+    ::munmap(const_cast<uint8_t*>(map), status.st_size);
+    return -1;
+  }
+
+  for (uint32_t index = 0; index < header.blocks; index++) {
+    BlockHeader block {};
+
+    std::memcpy(&block, map + (index + 1) * TrackLogBlockSize, sizeof(block));
+    if (block.magic == TrackLogBlockMagic && block.check == ~block.sequence &&
+        block.sequence % header.blocks == index) {
+      valid.emplace_back(block.sequence, index);
+    }
+  }
+
+  std::sort(valid.begin(), valid.end());
+
+  for (const auto & [sequence, index] : valid) {
+    const uint8_t * data { map + (index + 1) * TrackLogBlockSize };
+    size_t          position { sizeof(BlockHeader) };
+    uint8_t         lap { LapTag(0, sequence, header.blocks) };
+    TrackPoint      point {};
+    int64_t         interval {};
+    bool            started {};
+
+    while (position < TrackLogBlockSize) {
+      uint8_t   tag { data[position] };
+      uint64_t  fields[4] {};
+      size_t    next { position + 1 };
+      bool      complete { true };
+
+      // End of the block, a record not complete or left by the previous lap
+      if (tag == 0 || (tag & ~TagType) != lap) {
+        break;
+      }
+
+      if ((tag & TagType) == TagPad) {
+        position += TrackLogSectorSize - position % TrackLogSectorSize;
+        continue;
+      }
+
+      if ((tag & TagType) != TagKeyframe && !started) {
+        break;
+      }
+
+      // Within the sector of the tag
+      for (size_t field = 0; field < 4 && complete; field++) {
+        complete = get_varint(data, position - position % TrackLogSectorSize + TrackLogSectorSize, next,
+                              fields[field]);
+      }
+
+      if (!complete) {
+        break;
+      }
+
+      if ((tag & TagType) == TagKeyframe) {
+        point.utc = static_cast<int64_t>(fields[0]);
+        point.latitude = static_cast<int32_t>(unzigzag(fields[1]));
+        point.longitude = static_cast<int32_t>(unzigzag(fields[2]));
+        point.altitude = static_cast<int32_t>(unzigzag(fields[3]));
+        interval = 0;
+        started = true;
+      } else if ((tag & TagType) == TagDelta) {
+        interval += unzigzag(fields[0]);
+        point.utc += interval;
+        point.latitude = static_cast<int32_t>(point.latitude + unzigzag(fields[1]));
+        point.longitude = static_cast<int32_t>(point.longitude + unzigzag(fields[2]));
+        point.altitude = static_cast<int32_t>(point.altitude + unzigzag(fields[3]));
+      } else {
+        break;
+      }
+
+      handler(point);
+      points++;
+      position = next;
+    }
+  }
+
+  ::munmap(const_cast<uint8_t*>(map), status.st_size);
+
+  return points;
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+size_t TrackLog::Encode(const TrackPoint & point, bool keyframe, uint8_t * record) const {
+  // Function Variables
+  size_t length {};
+
+  if (keyframe) {
+    length += put_varint(record + length, static_cast<uint64_t>(point.utc));
+    length += put_varint(record + length, zigzag(point.latitude));
+    length += put_varint(record + length, zigzag(point.longitude));
+    length += put_varint(record + length, zigzag(point.altitude));
+  } else {
+    length += put_varint(record + length, zigzag(point.utc - _last.utc - _interval));
+    length += put_varint(record + length, zigzag(static_cast<int64_t>(point.latitude) - _last.latitude));
+    length += put_varint(record + length, zigzag(static_cast<int64_t>(point.longitude) - _last.longitude));
+    length += put_varint(record + length, zigzag(static_cast<int64_t>(point.altitude) - _last.altitude));
+  }
+
+  return length;
+}
+//-----------------------------------------------------------------------------
+void TrackLog::StartBlock(uint32_t sequence) {
+  // Function Variables
+  BlockHeader * header {};
+
+  _block = _map + (1 + sequence % _blocks) * TrackLogBlockSize;
+  _sequence = sequence;
+  _position = sizeof(BlockHeader);
+  header = reinterpret_cast<BlockHeader*>(_block);
+
+  // The previous lap is invalid before the block is cleared, the new one valid once its header is complete
+  header->magic = 0;
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memset(_block, 0, TrackLogBlockSize);
+  header->sequence = sequence;
+  header->check = ~sequence;
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = TrackLogBlockMagic;
+}
+//-----------------------------------------------------------------------------
+bool TrackLog::Resume(void) {
+  // Function Variables
+  bool      found {};
+  uint32_t  newest {};
+
+  for (uint32_t index = 0; index < _blocks; index++) {
+    const BlockHeader * header { reinterpret_cast<const BlockHeader*>(_map + (index + 1) * TrackLogBlockSize) };
+
+    if (header->magic == TrackLogBlockMagic && header->check == ~header->sequence &&
+        header->sequence % _blocks == index && (!found || header->sequence > newest)) {
+      newest = header->sequence;
+      found = true;
+    }
+  }
+
+  if (!found) {
+    return false;
+  }
+
+  // The block of the last session is left as it is
+  StartBlock(newest + 1);
+
+  return true;
+}
+//-----------------------------------------------------------------------------
+uint32_t TrackLog::Checksum(const Header & header) {
+  // Function Variables
+  const uint8_t * data { reinterpret_cast<const uint8_t*>(&header) };
+  uint32_t        sum1 { 0xFFFF };
+  uint32_t        sum2 { 0xFFFF };
+
+  for (size_t index = 0; index < offsetof(Header, checksum); index++) {
+    sum1 = (sum1 + data[index]) % 0xFFFF;
+    sum2 = (sum2 + sum1) % 0xFFFF;
+  }
+
+  return sum2 << 16 | sum1;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
@@ -0,0 +1,354 @@
+/*
+ * ubx.cpp
+ *
+ *  Created on: Oct 16, 2026
+ *      Author: ccroci
+ */
+#include <cstring>
+#include <gps/ubx.hpp>
+
+namespace Airsoft {
+
+// NAV-PVT fix types and flags
+constexpr uint8_t PvtFix2D = 2;
+constexpr uint8_t PvtFix3D = 3;
+constexpr uint8_t PvtFixGnssDeadReckoning = 4;
+constexpr uint8_t PvtValidDate = 0x01;
+constexpr uint8_t PvtValidTime = 0x02;
+constexpr uint8_t PvtGnssFixOk = 0x01;
+constexpr uint8_t PvtDifferential = 0x02;
+constexpr uint8_t PvtCarrierFloat = 0x40;
+constexpr uint8_t PvtCarrierFixed = 0x80;
+
+// MGA-INI message types
+constexpr uint8_t MgaIniPositionLlh = 0x01;
+constexpr uint8_t MgaIniTimeUtc = 0x10;
+constexpr int8_t  MgaLeapSecondsUnknown = -128;
+
+namespace {
+
+// Little endian fields of the payloads
+//-----------------------------------------------------------------------------
+uint16_t get_u16(const uint8_t * data) {
+  return static_cast<uint16_t>(data[0] | data[1] << 8);
+}
+//-----------------------------------------------------------------------------
+uint32_t get_u32(const uint8_t * data) {
+  return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+         static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+//-----------------------------------------------------------------------------
+int32_t get_i32(const uint8_t * data) {
+  return static_cast<int32_t>(get_u32(data));
+}
+//-----------------------------------------------------------------------------
+void put_u16(uint8_t * data, uint16_t value) {
+  data[0] = static_cast<uint8_t>(value);
+  data[1] = static_cast<uint8_t>(value >> 8);
+}
+//-----------------------------------------------------------------------------
+void put_u32(uint8_t * data, uint32_t value) {
+  put_u16(data, static_cast<uint16_t>(value));
+  put_u16(data + 2, static_cast<uint16_t>(value >> 16));
+}
+//-----------------------------------------------------------------------------
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+size_t UbxParser::Consume(const uint8_t * data, size_t length, int64_t timestamp) {
+  // Function Variables
+  size_t used {};
+
+  // Release the message returned by the previous call
+  _ready = UbxMessage::None;
+
+  while (used < length) {
+    uint8_t byte { data[used++] };
+
+    switch (_state) {
+      case State::Sync1:
+        if (byte == UbxSync1) {
+          _state = State::Sync2;
+          _arrival = timestamp;
+        }
+        break;
+
+      case State::Sync2:
+        if (byte == UbxSync2) {
+          _state = State::Class;
+          _checksumA = 0;
+          _checksumB = 0;
+        } else {
+          _state = byte == UbxSync1 ? State::Sync2 : State::Sync1;
+        }
+        break;
+
+      case State::Class:
+        _class = byte;
+        Checksum(byte);
+        _state = State::Id;
+        break;
+
+      case State::Id:
+        _id = byte;
+        Checksum(byte);
+        _state = State::Length1;
+        break;
+
+      case State::Length1:
+        _expected = byte;
+        Checksum(byte);
+        _state = State::Length2;
+        break;
+
+      case State::Length2:
+        _expected |= static_cast<size_t>(byte) << 8;
+        Checksum(byte);
+        _length = 0;
+
+        if (_expected > UbxMaxPayload) {
+          // Long message or a false sync in the noise: the length can't be trusted, search the next sync
+          _overflows++;
+          _state = State::Sync1;
+        } else {
+          _state = _expected > 0 ? State::Payload : State::ChecksumA;
+        }
+        break;
+
+      case State::Payload:
+        _payload[_length++] = byte;
+        Checksum(byte);
+
+        if (_length == _expected) {
+          _state = State::ChecksumA;
+        }
+        break;
+
+      case State::ChecksumA:
+        if (byte != _checksumA) {
+          _checksumErrors++;
+          _state = byte == UbxSync1 ? State::Sync2 : State::Sync1;
+          break;
+        }
+        _state = State::ChecksumB;
+        break;
+
+      case State::ChecksumB:
+        _state = State::Sync1;
+
+        if (byte != _checksumB) {
+          _checksumErrors++;
+          _state = byte == UbxSync1 ? State::Sync2 : State::Sync1;
+          break;
+        }
+
+        Complete();
+        return used;
+    }
+  }
+
+  return used;
+}
+//-----------------------------------------------------------------------------
+void UbxParser::Reset(void) {
+  _fix = GpsFix {};
+  _ready = UbxMessage::None;
+  _state = State::Sync1;
+  _length = 0;
+}
+//-----------------------------------------------------------------------------
+size_t UbxParser::Build(uint8_t messageClass, uint8_t messageId, const uint8_t * payload, size_t length,
+                        uint8_t * output, size_t size) {
+  // Function Variables
+  uint8_t checksumA {};
+  uint8_t checksumB {};
+
+  if (size < length + UbxOverhead || length > UINT16_MAX) {
+    return 0;
+  }
+
+  output[0] = UbxSync1;
+  output[1] = UbxSync2;
+  output[2] = messageClass;
+  output[3] = messageId;
+  put_u16(output + 4, static_cast<uint16_t>(length));
+
+  if (length > 0) {
+    memcpy(output + 6, payload, length);
+  }
+
+  // Fletcher checksum of class, id, length and payload
+  for (size_t index = 2; index < length + 6; index++) {
+    checksumA = static_cast<uint8_t>(checksumA + output[index]);
+    checksumB = static_cast<uint8_t>(checksumB + checksumA);
+  }
+
+  output[length + 6] = checksumA;
+  output[length + 7] = checksumB;
+
+  return length + UbxOverhead;
+}
+//-----------------------------------------------------------------------------
+size_t UbxParser::BuildConfigPort(uint32_t baudrate, uint16_t inProtocols, uint16_t outProtocols,
+                                  uint8_t * output, size_t size) {
+  // Function Variables
+  uint8_t payload[20] {};
+
+  payload[0] = 1;                                         // UART1
+  put_u32(payload + 4, 0x000008C0);                       // 8 bits, no parity, 1 stop bit
+  put_u32(payload + 8, baudrate);
+  put_u16(payload + 12, inProtocols);
+  put_u16(payload + 14, outProtocols);
+
+  return Build(UbxClassCfg, UbxIdCfgPrt, payload, sizeof(payload), output, size);
+}
+//-----------------------------------------------------------------------------
+size_t UbxParser::BuildConfigRate(uint16_t periodMS, uint8_t * output, size_t size) {
+  // Function Variables
+  uint8_t payload[6] {};
+
+  put_u16(payload, periodMS);
+  put_u16(payload + 2, 1);                                // A solution every measurement
+  put_u16(payload + 4, 1);                                // GPS time
+
+  return Build(UbxClassCfg, UbxIdCfgRate, payload, sizeof(payload), output, size);
+}
+//-----------------------------------------------------------------------------
+size_t UbxParser::BuildConfigMessage(uint8_t messageClass, uint8_t messageId, uint8_t rate,
+                                     uint8_t * output, size_t size) {
+  // Function Variables
+  uint8_t payload[3] { messageClass, messageId, rate };
+
+  return Build(UbxClassCfg, UbxIdCfgMsg, payload, sizeof(payload), output, size);
+}
+//-----------------------------------------------------------------------------
+size_t UbxParser::BuildAidPosition(int32_t latitude, int32_t longitude, int32_t altitude, uint32_t accuracy,
+                                   uint8_t * output, size_t size) {
+  // Function Variables
+  uint8_t payload[20] {};
+
+  payload[0] = MgaIniPositionLlh;
+  put_u32(payload + 4, static_cast<uint32_t>(latitude));
+  put_u32(payload + 8, static_cast<uint32_t>(longitude));
+  put_u32(payload + 12, static_cast<uint32_t>(altitude));
+  put_u32(payload + 16, accuracy);
+
+  return Build(UbxClassMga, UbxIdMgaIni, payload, sizeof(payload), output, size);
+}
+//-----------------------------------------------------------------------------
+size_t UbxParser::BuildAidTime(int64_t utc, uint16_t accuracyS, uint8_t * output, size_t size) {
+  // Function Variables
+  uint8_t payload[24] {};
+  int64_t days { utc / 86400000 };
+  int64_t milliseconds { utc % 86400000 };
+
+  if (utc <= 0) {
+    return 0;
+  }
+
+  // Civil date of the days since the epoch
+  int64_t   z { days + 719468 };
+  int64_t   era { z / 146097 };
+  uint32_t  doe { static_cast<uint32_t>(z - era * 146097) };
+  uint32_t  yoe { (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365 };
+  uint32_t  doy { doe - (365 * yoe + yoe / 4 - yoe / 100) };
+  uint32_t  mp { (5 * doy + 2) / 153 };
+  uint32_t  day { doy - (153 * mp + 2) / 5 + 1 };
+  uint32_t  month { mp < 10 ? mp + 3 : mp - 9 };
+  int64_t   year { static_cast<int64_t>(yoe) + era * 400 + (month <= 2) };
+
+  payload[0] = MgaIniTimeUtc;
+  payload[2] = 0;                                         // Valid on receipt of the message
+  payload[3] = static_cast<uint8_t>(MgaLeapSecondsUnknown);
+  put_u16(payload + 4, static_cast<uint16_t>(year));
+  payload[6] = static_cast<uint8_t>(month);
+  payload[7] = static_cast<uint8_t>(day);
+  payload[8] = static_cast<uint8_t>(milliseconds / 3600000);
+  payload[9] = static_cast<uint8_t>(milliseconds / 60000 % 60);
+  payload[10] = static_cast<uint8_t>(milliseconds / 1000 % 60);
+  put_u32(payload + 12, static_cast<uint32_t>(milliseconds % 1000 * 1000000));
+  put_u16(payload + 16, accuracyS);
+
+  return Build(UbxClassMga, UbxIdMgaIni, payload, sizeof(payload), output, size);
+}
+//-----------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+void UbxParser::Checksum(uint8_t byte) {
+  _checksumA = static_cast<uint8_t>(_checksumA + byte);
+  _checksumB = static_cast<uint8_t>(_checksumB + _checksumA);
+}
+//-----------------------------------------------------------------------------
+void UbxParser::Complete(void) {
+  _messages++;
+  _ready = UbxMessage::Other;
+
+  if (_class == UbxClassNav && _id == UbxIdNavPvt && _length >= UbxNavPvtLength) {
+    DecodeNavPvt();
+    _ready = UbxMessage::NavPvt;
+  } else if (_class == UbxClassAck && _length >= 2) {
+    _ackClass = _payload[0];
+    _ackId = _payload[1];
+    _ready = _id == UbxIdAckAck ? UbxMessage::Ack : UbxMessage::Nak;
+  }
+}
+//-----------------------------------------------------------------------------
+void UbxParser::DecodeNavPvt(void) {
+  // Function Variables
+  const uint8_t * pvt { _payload };
+  uint8_t         valid { pvt[11] };
+  uint8_t         fixType { pvt[20] };
+  uint8_t         flags { pvt[21] };
+  bool            position { (flags & PvtGnssFixOk) != 0 &&
+                             (fixType == PvtFix2D || fixType == PvtFix3D || fixType == PvtFixGnssDeadReckoning) };
+
+  _fix.arrival = _arrival;
+  _fix.valid = 0;
+
+  // UTC, the milliseconds of the time of week are those of the epoch
+  if (valid & PvtValidDate) {
+    _fix.year = get_u16(pvt + 4);
+    _fix.month = pvt[6];
+    _fix.day = pvt[7];
+    _fix.valid |= FixHasDate;
+  }
+
+  if (valid & PvtValidTime) {
+    _fix.hour = pvt[8];
+    _fix.minute = pvt[9];
+    _fix.second = pvt[10];
+    _fix.millisecond = static_cast<uint16_t>(get_u32(pvt) % 1000);
+    _fix.valid |= FixHasTime;
+  }
+
+  _fix.satellitesUsed = pvt[23];
+  _fix.mode = fixType == PvtFix3D || fixType == PvtFixGnssDeadReckoning ? 3 : (fixType == PvtFix2D ? 2 : 1);
+  _fix.pdop = get_u16(pvt + 76) * 0.01f;
+
+  if (!position) {
+    _fix.quality = 0;
+    return;
+  }
+
+  if (flags & PvtCarrierFixed) {
+    _fix.quality = 4;
+  } else if (flags & PvtCarrierFloat) {
+    _fix.quality = 5;
+  } else {
+    _fix.quality = (flags & PvtDifferential) ? 2 : 1;
+  }
+
+  _fix.longitude = get_i32(pvt + 24);
+  _fix.latitude = get_i32(pvt + 28);
+  _fix.altitude = get_i32(pvt + 36) * 0.001f;
+  _fix.geoidSeparation = (get_i32(pvt + 32) - get_i32(pvt + 36)) * 0.001f;
+  _fix.horizontalAccuracy = get_u32(pvt + 40) * 0.001f;
+  _fix.verticalAccuracy = get_u32(pvt + 44) * 0.001f;
+  _fix.speed = get_i32(pvt + 60) * 0.001f;
+  _fix.course = get_i32(pvt + 64) * 1e-5f;
+  _fix.valid |= FixHasPosition | FixHasAltitude | FixHasAccuracy | FixHasSpeed | FixHasCourse;
+}
+//-----------------------------------------------------------------------------
+
+} // namespace Airsoft
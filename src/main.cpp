@@ -43,6 +43,10 @@ int main(int argc, char *argv[]) {
         manager.Terminate();
         break;
       }
+
+      if (str == "stats") {
+        manager.PrintStatistics(std::cout);
+      }
     }
   }
 
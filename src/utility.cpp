@@ -49,9 +49,5 @@ std::string Utility::Trim(const std::string & source) {
   return Utility::TrimLeft(Utility::TrimRight(source));
 }
 //-----------------------------------------------------------------------------
-uint64_t Utility::TimeSinceEpochMillisec(void) {
-  using namespace std::chrono;
-  return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
-}
 
 }
@@ -42,6 +42,23 @@ using namespace std::chrono_literals;
 
 namespace Airsoft {
 
+// Baud rate of the port, the one of the configuration mode
+constexpr uint32_t BaudRate = 9600;
+
+// Transmit queue of the port, room for a few full packets
+constexpr size_t TransmitQueueSize = 1024;
+
+// The module outputs a packet without pauses: a few byte times of silence end it (10 bits a byte)
+constexpr uint32_t PacketGapBytes = 4;
+constexpr uint32_t PacketGapMS = (PacketGapBytes * 10 * 1000 + BaudRate - 1) / BaudRate;
+
+// The module buffers about two packets, so they are handed over one at a time: the next one once AUX is back
+// high, checked every few milliseconds up to the timeout of the blocking send, or without AUX after the air
+// time of a full packet at the default 2.4 kbps
+constexpr uint32_t TransmitAuxPollMS = 5;
+constexpr uint32_t TransmitAuxTimeoutMS = 5000;
+constexpr uint32_t TransmitNoAuxMS = 1000;
+
 Wireless::Wireless() {
 
 }
@@ -51,7 +68,8 @@ Wireless::~Wireless() {
 }
 
 //------------------------------------------------------------------------------
-bool Wireless::Init(std::string port, int32_t auxPin, int32_t m0Pin, int32_t m1Pin) {
+bool Wireless::Init(std::string port, Airsoft::Drivers::UartReactor & reactor, int32_t auxPin, int32_t m0Pin,
+                    int32_t m1Pin) {
   // Check valid port
   if (port.empty()) {
     return false;
@@ -62,40 +80,114 @@ bool Wireless::Init(std::string port, int32_t auxPin, int32_t m0Pin, int32_t m1P
   _auxPin = auxPin;
   _m0Pin = m0Pin;
   _m1Pin = m1Pin;
+  _reactor = &reactor;
+  _txPacing = false;
+  _terminating = false;
+
+  _serial = new Airsoft::Drivers::Uarts(_port, BaudRate);
+  // Command/ack exchanges with the module are latency bound
+  _serial->SetLowLatency();
+  // Packets are stamped when read, not when processed
+  _serial->SetTimestamping();
+  _lora = new Airsoft::Devices::EByteLoRaE220(_serial, _auxPin, _m0Pin, _m1Pin);
+
+  try {
+    // Open serial
+    _serial->Open();
+  } catch (...) {
+    std::cout << "Wireless : Error open serial port." << std::endl;
+    Terminate();
+    return false;
+  }
 
-  // Set flag of thread running
-  _threadRunning = true;
+  // Packets are queued and trickle out while the reactor keeps receiving
+  _serial->SetTransmitQueue(TransmitQueueSize);
 
-  // Create Engine Thread
-  return ((_process = new std::thread(std::bind(&Wireless::Engine, this))) != nullptr);
+  // Messages are read when the port becomes readable, and sent when a full transmit queue has drained
+  if (!_reactor->Register(*_serial, std::bind(&Wireless::OnReadable, this), std::bind(&Wireless::Transmit, this))) {
+    std::cout << "Wireless : Error register serial port." << std::endl;
+    Terminate();
+    return false;
+  }
+
+  std::cout << "Wireless Engine: Started." << std::endl;
+
+  // Initialize module, ready when the configuration ends (or at once, without a module to configure)
+  if (!Configure()) {
+    Configured();
+  }
+
+  return true;
 }
 //------------------------------------------------------------------------------
 void Wireless::Terminate(void) {
-  // Check valid thread
-  if (_process != nullptr) {
-    // Reset thread flag
-    _threadRunning = false;
+  // Reset ready flag, a configuration still running doesn't set it again
+  _configureLock.lock();
+  _terminating = true;
+  _ready = false;
+  _configureLock.unlock();
+
+  // Check valid port
+  if (_serial != nullptr) {
+    // Remove from the reactor, no handler is running after this
+    _reactor->Unregister(*_serial);
+
+    // The configuration fails fast without the port, the module is in use until it has ended
+    std::unique_lock<std::mutex> lock(_configureLock);
+    _configureDone.wait(lock, [this]() { return !_configuring; });
+    lock.unlock();
+
+    if (_serial->IsOpen()) {
+      _serial->Close();
+    }
 
-    // Wait 1.5 second for thread terminate
-    std::this_thread::sleep_for(1500ms);
+    delete _lora;
+    _lora = nullptr;
 
-    _process = nullptr;
+    delete _serial;
+    _serial = nullptr;
+
+    std::cout << "Wireless Engine: Terminated." << std::endl;
+  }
+}
+//------------------------------------------------------------------------------
+bool Wireless::GetStatistics(Airsoft::Drivers::UartStatistics & statistics) const {
+  // Check valid port
+  if (_serial == nullptr || !_serial->IsOpen()) {
+    return false;
   }
+
+  statistics = _serial->GetStatistics();
+
+  return true;
 }
 //------------------------------------------------------------------------------
 void Wireless::SendMessage(std::string message) {
   _outLock.lock();
   _out.push(message);
   _outLock.unlock();
+
+  // Transmit from the reactor thread
+  if (_ready) {
+    _reactor->Post(std::bind(&Wireless::Transmit, this));
+  }
 }
 //------------------------------------------------------------------------------
 bool Wireless::ReceiveMessage(std::string & message) {
+  // Function variables
+  int64_t timestamp {};
+
+  return ReceiveMessage(message, timestamp);
+}
+//------------------------------------------------------------------------------
+bool Wireless::ReceiveMessage(std::string & message, int64_t & timestamp) {
   // Function variables
   bool ret {};
 
   _inLock.lock();
   if (!_in.empty()) {
-    message = _in.front();
+    message = std::move(_in.front().message);
+    timestamp = _in.front().timestamp;
    _in.pop();
    ret = true;
   }
@@ -108,78 +200,192 @@ bool Wireless::ReceiveMessage(std::string & message) {
 
 
 //------------------------------------------------------------------------------
-void Wireless::Engine(void) {
-  // Thread Variables
-  Airsoft::Drivers::Uarts         serial(_port, 9600);
-  Airsoft::Devices::EByteLoRaE220 lora(&serial, _auxPin, _m0Pin, _m1Pin);
+bool Wireless::Configure(void) {
+  // Initialize module
+  if (!_lora->Begin()) {
+    return false;
+  }
 
-  std::cout << "Wireless Engine: Started." << std::endl;
+  // The exchange runs on the reactor thread, the port keeps being serviced meanwhile
+  _configuring = true;
+  _lora->GetConfigurationAsync(*_reactor, std::bind(&Wireless::OnConfiguration, this, std::placeholders::_1,
+                                                    std::placeholders::_2));
 
-  serial.Open();
+  return true;
+}
+//------------------------------------------------------------------------------
+void Wireless::OnConfiguration(Airsoft::Devices::ResponseStatus status, Airsoft::Devices::Configuration & config) {
+  // Function variables
+  bool terminating {};
 
-  // Initialize module
-  if (lora.Begin()) {
-    Airsoft::Devices::ResponseStructContainer currentConfig = lora.GetConfiguration();
-
-    // Check if command success
-    if (currentConfig.status.code == E220_SUCCESS) {
-      Airsoft::Devices::Configuration * config = reinterpret_cast<Airsoft::Devices::Configuration*>(currentConfig.data);
-
-      // Verify configuration
-      if (config != nullptr) {
-        // Verify address
-        if ((config->AddrH == 0 && config->AddrL == 0) ||
-            (config->AddrH != Configuration.AddressH && config->AddrL != Configuration.AddressL)){
-
-          // Set new address
-          config->AddrH = Configuration.AddressH;
-          config->AddrL = Configuration.AddressL;
-
-          // Set new configuration
-          Airsoft::Devices::ResponseStatus status = lora.SetConfiguration(*config);
-          if (status.code == E220_SUCCESS) {
-            std::cout << "Wireless: New address configured...." << std::endl;
-          } else {
-            std::cout << "Wireless: ERROR to configure wireless module...." << std::endl;
-          }
-        }
-
-        delete static_cast<uint8_t*>(currentConfig.data);
-      }
-    }
+  std::cout << status.code << std::endl;
+
+  _configureLock.lock();
+  terminating = _terminating;
+  _configureLock.unlock();
+
+  // Check if command success and verify address, nothing more to do once terminated
+  if (status.code == E220_SUCCESS && !terminating && ((config.AddrH == 0 && config.AddrL == 0) ||
+      (config.AddrH != Configuration.AddressH && config.AddrL != Configuration.AddressL))) {
+    // Set new address
+    config.AddrH = Configuration.AddressH;
+    config.AddrL = Configuration.AddressL;
+
+    // Set new configuration
+    _lora->SetConfigurationAsync(*_reactor, config, std::bind(&Wireless::OnConfigurationSet, this,
+                                                              std::placeholders::_1, std::placeholders::_2));
+    return;
+  }
 
-    std::cout << currentConfig.status.code << std::endl;
+  Configured();
+}
+//------------------------------------------------------------------------------
+void Wireless::OnConfigurationSet(Airsoft::Devices::ResponseStatus status, Airsoft::Devices::Configuration &) {
+  if (status.code == E220_SUCCESS) {
+    std::cout << "Wireless: New address configured...." << std::endl;
+  } else {
+    std::cout << "Wireless: ERROR to configure wireless module...." << std::endl;
+  }
+
+  Configured();
+}
+//------------------------------------------------------------------------------
+void Wireless::Configured(void) {
+  std::lock_guard<std::mutex> lock(_configureLock);
+
+  _configuring = false;
+  _configureDone.notify_all();
+
+  // Terminated meanwhile, the module is released
+  if (_terminating) {
+    return;
   }
 
   // Set ready flag
   _ready = true;
 
-  // Thread loop
-  while(_threadRunning) {
-    Airsoft::Devices::ResponseContainer response;
-    try {
-      response = lora.ReceiveMessage();
-      if (response.status.code == E220_SUCCESS) {
-        _inLock.lock();
-        _in.push(response.data);
-        _inLock.unlock();
+  // Send what has been queued during the configuration
+  _reactor->Post(std::bind(&Wireless::Transmit, this));
+}
+//------------------------------------------------------------------------------
+void Wireless::OnReadable(void) {
+  // Function variables
+  Status status { _lora->ReceivePart(_rxMessage, &_rxTimestamp).code };
+
+  if (status == ERR_E220_HARDWARE) {
+    // Unplugged, the port would be reported readable forever
+    std::cout << "Wireless : Serial port error, receive stopped." << std::endl;
+    _reactor->Unregister(*_serial);
+    return;
+  }
+
+  // First bytes of a packet, the rest follows within a few milliseconds
+  if (!_rxMessage.empty() && !_rxCollecting) {
+    _rxCollecting = true;
+    CollectPacket();
+  }
+}
+//------------------------------------------------------------------------------
+void Wireless::CollectPacket(void) {
+  // Full packet, nothing more to wait for
+  if (_rxMessage.size() >= Airsoft::Devices::MaxSizeRxPacket) {
+    DeliverPacket();
+    return;
+  }
+
+  // The rest of the packet, the read ends with what has arrived when the port stays quiet for the gap
+  _reactor->ReadAsync(*_serial, Airsoft::Devices::MaxSizeRxPacket - _rxMessage.size(), PacketGapMS,
+                      std::bind(&Wireless::OnPacketData, this, std::placeholders::_1, std::placeholders::_2));
+}
+//------------------------------------------------------------------------------
+void Wireless::OnPacketData(std::string & data, bool completed) {
+  // Terminated, the port and the module are gone
+  if (!_ready) {
+    _rxMessage.clear();
+    _rxCollecting = false;
+    return;
+  }
+
+  _rxMessage.append(data);
+
+  // Nothing during the gap, or AUX back high: the module has output the whole packet
+  if (data.empty() || completed || _lora->IsAuxHigh()) {
+    DeliverPacket();
+  } else {
+    CollectPacket();
+  }
+}
+//------------------------------------------------------------------------------
+void Wireless::DeliverPacket(void) {
+  _inLock.lock();
+  _in.push(Received { _rxMessage, _rxTimestamp });
+  _inLock.unlock();
+
+  _rxMessage.clear();
+  _rxCollecting = false;
+
+  // The port buffer can hold the start of the next packet, no readable notification would come for it
+  if (_serial->TryAvailable().Value() > 0) {
+    _reactor->Post([this]() {
+      if (_ready) {
+        OnReadable();
       }
-    } catch(...) { }
+    });
+  }
+}
+//------------------------------------------------------------------------------
+void Wireless::Transmit(void) {
+  // Function variables
+  std::string dataOut;
 
+  // One packet at a time, OnTransmitted sends the next
+  while (_ready && !_txPacing) {
     _outLock.lock();
-    if (!_out.empty()) {
-      std::string dataOut = _out.front();
-     _out.pop();
-     if (lora.SendBroadcastFixedMessage(0x04, dataOut).code == E220_SUCCESS) {
+    if (_out.empty()) {
+      _outLock.unlock();
+      break;
+    }
+    dataOut = _out.front();
+    _outLock.unlock();
 
-     }
+    // Transmit queue full, the message stays first in line until the port has drained
+    if (_lora->SendBroadcastFixedMessage(0x04, dataOut).code == ERR_E220_BUF_TOO_SMALL) {
+      _reactor->SetWritable(*_serial, true);
+      return;
     }
+
+    _outLock.lock();
+    _out.pop();
     _outLock.unlock();
 
-    std::this_thread::sleep_for(100ms);
+    // The packet reaches the module in its byte times (3 bytes of header), then the module is busy sending it
+    _txPacing = true;
+    _txPolls = 0;
+    _reactor->PostAfter(((dataOut.size() + 3) * 10 * 1000 + BaudRate - 1) / BaudRate +
+                        (_auxPin == -1 ? TransmitNoAuxMS : 0), std::bind(&Wireless::OnTransmitted, this));
+  }
+
+  // Nothing that can be sent now, no more writable notifications
+  if (_ready) {
+    _reactor->SetWritable(*_serial, false);
+  }
+}
+//------------------------------------------------------------------------------
+void Wireless::OnTransmitted(void) {
+  // Terminated, the module is gone
+  if (!_ready) {
+    _txPacing = false;
+    return;
+  }
+
+  // Still sending, checked again later; a stuck AUX doesn't stop the transmission for good
+  if (_auxPin != -1 && !_lora->IsAuxHigh() && ++_txPolls < TransmitAuxTimeoutMS / TransmitAuxPollMS) {
+    _reactor->PostAfter(TransmitAuxPollMS, std::bind(&Wireless::OnTransmitted, this));
+    return;
   }
 
-  std::cout << "Wireless Engine: Terminated." << std::endl;
+  _txPacing = false;
+  Transmit();
 }
 //------------------------------------------------------------------------------
 